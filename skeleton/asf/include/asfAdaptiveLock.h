@@ -0,0 +1,138 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfAdaptiveLock.h
+// Desc : Spin-then-park Lock.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+#include <asfSpinLock.h>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+//! @brief      値が expected と異なるまでスレッドを待機状態にします.
+//!
+//! @param[in]      value       監視する値.
+//! @param[in]      expected    待機を継続する値.
+//! @note       Linux では futex, Windows では WaitOnAddress() を使用します.
+//!             偽の起床があり得るため, 呼び出し側で値を再確認してください.
+//-----------------------------------------------------------------------------
+void WaitAddress(std::atomic<uint32_t>& value, uint32_t expected);
+
+//-----------------------------------------------------------------------------
+//! @brief      WaitAddress() で待機しているスレッドを1つ起床させます.
+//!
+//! @param[in]      value       監視されている値.
+//-----------------------------------------------------------------------------
+void WakeAddressOne(std::atomic<uint32_t>& value);
+
+//-----------------------------------------------------------------------------
+//! @brief      WaitAddress() で待機している全てのスレッドを起床させます.
+//!
+//! @param[in]      value       監視されている値.
+//-----------------------------------------------------------------------------
+void WakeAddressAll(std::atomic<uint32_t>& value);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AdaptiveLock class
+///////////////////////////////////////////////////////////////////////////////
+class AdaptiveLock
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static constexpr uint32_t DEFAULT_SPIN_COUNT = 4096;   //!< 既定のスピン回数 (pause命令の回数).
+    static constexpr uint32_t MAX_BACKOFF        = 64;     //!< 1回のバックオフでの最大pause回数.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //!
+    //! @param[in]      spinCount       待機状態に入るまでのスピン回数.
+    //-------------------------------------------------------------------------
+    explicit AdaptiveLock(uint32_t spinCount = DEFAULT_SPIN_COUNT)
+    : m_SpinCount(spinCount)
+    { /* DO_NOTHING */ }
+
+    AdaptiveLock(const AdaptiveLock&) = delete;
+    AdaptiveLock& operator = (const AdaptiveLock&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ロックします.
+    //!
+    //! @details    指数バックオフ付きでスピンし, 規定回数を超えた場合は
+    //!             ロックが解放されるまでスレッドを待機状態にします.
+    //-------------------------------------------------------------------------
+    void lock()
+    {
+        uint32_t expected = UNLOCKED;
+        if (m_State.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+        { return; }
+
+        LockSlow();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ロックを試みます.
+    //!
+    //! @retval true    ロックを取得できました.
+    //! @retval false   ロックを取得できませんでした.
+    //-------------------------------------------------------------------------
+    bool try_lock()
+    {
+        uint32_t expected = UNLOCKED;
+        return m_State.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ロックを解除します.
+    //-------------------------------------------------------------------------
+    void unlock()
+    {
+        if (m_State.exchange(UNLOCKED, std::memory_order_release) == CONTENDED)
+        { WakeAddressOne(m_State); }
+    }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    static constexpr uint32_t UNLOCKED  = 0;    //!< 未ロック.
+    static constexpr uint32_t LOCKED    = 1;    //!< ロック中 (待機スレッド無し).
+    static constexpr uint32_t CONTENDED = 2;    //!< ロック中 (待機スレッドの可能性あり).
+
+    std::atomic<uint32_t>   m_State     = { UNLOCKED };
+    uint32_t                m_SpinCount = DEFAULT_SPIN_COUNT;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      競合時のロック処理を行います.
+    //-------------------------------------------------------------------------
+    void LockSlow();
+};
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using ScopedAdaptiveLock = LockGuard<AdaptiveLock>;
+
+} // namespace asf
@@ -0,0 +1,222 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfAsyncLogger.h
+// Desc : Asynchronous Logger.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <asfLogger.h>
+#include <asfCacheLine.h>
+#include <asfLogRecord.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// ASYNC_LOG_POLICY enum
+///////////////////////////////////////////////////////////////////////////////
+enum ASYNC_LOG_POLICY
+{
+    ASYNC_LOG_POLICY_DROP = 0,      //!< バッファが満杯の場合はログを破棄します.
+    ASYNC_LOG_POLICY_BLOCK,         //!< バッファが満杯の場合は空くまで待機します.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncLoggerDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct AsyncLoggerDesc
+{
+    uint32_t            Capacity            = 512;                      //!< 保持できるログ数 (2のべき乗に切り上げ).
+    ASYNC_LOG_POLICY    Policy              = ASYNC_LOG_POLICY_DROP;    //!< バッファが満杯の場合の動作.
+    ILogger*            pSink               = nullptr;                  //!< 出力先. nullptr の場合はデフォルトロガー.
+    bool                InstallCrashHandler = false;                    //!< クラッシュ時に残りのログを標準エラー出力に書き出すかどうか.
+    const char*         RecordPath          = nullptr;                  //!< バイナリログの出力先. 指定時はログレコードをフォーマットせずに書き出します.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncLogger class
+///////////////////////////////////////////////////////////////////////////////
+class AsyncLogger : public ILogger, public ILogRecordWriter
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static constexpr uint32_t SLOT_SIZE = 2048;     //!< 1ログ当たりのバイト数.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    AsyncLogger() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator = (const AsyncLogger&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      desc        構成設定.
+    //! @retval true    初期化に成功しました.
+    //! @retval false   初期化に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(const AsyncLoggerDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います. 残っているログは全て出力されます.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ログを出力します.
+    //!
+    //! @details    呼び出しスレッドではリングバッファへのフォーマットのみを行い,
+    //!             出力先への書き込みはバックグラウンドスレッドで行います.
+    //!             SLOT_SIZE を超えるメッセージは切り詰められます.
+    //-------------------------------------------------------------------------
+    void WriteA(LOG_LEVEL level, const char* format, ...) override;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ログを出力します.
+    //-------------------------------------------------------------------------
+    void WriteW(LOG_LEVEL level, const wchar_t* format, ...) override;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ログレコードを書き込みます.
+    //!
+    //! @details    エンコード済みの引数をコピーするのみで, フォーマットは
+    //!             バックグラウンドスレッドで行います. RecordPath が指定されている場合は
+    //!             フォーマットせずにバイナリログファイルに書き出します.
+    //-------------------------------------------------------------------------
+    void WriteRecord(const LogSite& site, uint64_t timestamp, const void* pArgs, uint32_t argSize) override;
+
+    //-------------------------------------------------------------------------
+    //! @brief      呼び出し時点までに書き込まれたログが出力されるまで待機します.
+    //-------------------------------------------------------------------------
+    void Flush();
+
+    //-------------------------------------------------------------------------
+    //! @brief      クラッシュ時に残っているログを呼び出しスレッドで出力します.
+    //!
+    //! @details    出力先を経由せず, フォーマット済みのバイト列を初期化時に取得した
+    //!             標準エラー出力のハンドルへ write(2) / WriteFile で書き出すのみで,
+    //!             メモリ確保やロックは行いません. ログレコードは書式文字列のみを,
+    //!             ワイド文字列は ASCII 以外を '?' に置き換えて出力します.
+    //! @note       バックグラウンドスレッドが出力中のまま一定時間内に排他を取得できない場合
+    //!             (クラッシュしたのがバックグラウンドスレッド自身の場合など) は何も出力しません.
+    //-------------------------------------------------------------------------
+    void FlushOnCrash();
+
+    //-------------------------------------------------------------------------
+    //! @brief      破棄されたログ数を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetDropCount() const
+    { return m_DropCount.load(std::memory_order_relaxed); }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // SLOT_KIND enum
+    ///////////////////////////////////////////////////////////////////////////
+    enum SLOT_KIND : uint8_t
+    {
+        SLOT_KIND_TEXT_A = 0,   //!< マルチバイト文字列.
+        SLOT_KIND_TEXT_W,       //!< ワイド文字列.
+        SLOT_KIND_RECORD,       //!< ログレコード (RecordHeader + 引数).
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // RecordHeader structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct RecordHeader
+    {
+        const LogSite*  pSite;
+        uint64_t        Timestamp;
+        uint32_t        ArgSize;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Slot structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Slot
+    {
+        std::atomic<uint64_t>   Sequence;
+        LOG_LEVEL               Level;
+        SLOT_KIND               Kind;
+        uint8_t                 Data[SLOT_SIZE];
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    Slot*                   m_pSlots        = nullptr;
+    uint64_t                m_Mask          = 0;
+    ASYNC_LOG_POLICY        m_Policy        = ASYNC_LOG_POLICY_DROP;
+    ILogger*                m_pSink         = nullptr;
+    bool                    m_CrashHandler  = false;
+    std::thread             m_Thread;
+    std::atomic<bool>       m_Running       = { false };
+    std::atomic<uint32_t>   m_Sleeping      = { 0 };
+    std::atomic<bool>       m_Consuming     = { false };
+    std::atomic<uint64_t>   m_DropCount     = { 0 };
+    uint64_t                m_DropReported  = 0;
+    FILE*                   m_pRecordFile   = nullptr;
+    std::vector<bool>       m_SiteWritten;
+
+    uint8_t                 m_PaddingHead[CACHE_LINE_SIZE];    //!< 上記のメンバと m_EnqueuePos を別のキャッシュラインに置く詰め物.
+    std::atomic<uint64_t>   m_EnqueuePos    = { 0 };
+    uint8_t                 m_PaddingPos[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)]; //!< m_EnqueuePos と m_DequeuePos を別のキャッシュラインに置く詰め物.
+    std::atomic<uint64_t>   m_DequeuePos    = { 0 };
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      書き込み先のスロットを確保します.
+    //-------------------------------------------------------------------------
+    Slot* Acquire(uint64_t& pos);
+
+    //-------------------------------------------------------------------------
+    //! @brief      スロットを公開し, バックグラウンドスレッドを起床させます.
+    //-------------------------------------------------------------------------
+    void Publish(Slot* pSlot, uint64_t pos);
+
+    //-------------------------------------------------------------------------
+    //! @brief      公開済みのスロットを全て出力します.
+    //-------------------------------------------------------------------------
+    bool Drain();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ログレコードを出力します.
+    //-------------------------------------------------------------------------
+    void OutputRecord(const Slot* pSlot);
+
+    //-------------------------------------------------------------------------
+    //! @brief      バックグラウンドスレッドの処理です.
+    //-------------------------------------------------------------------------
+    void Run();
+};
+
+} // namespace asf
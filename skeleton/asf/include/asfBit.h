@@ -253,7 +253,7 @@ inline void DecodeMorton2(uint32_t code, uint32_t& x, uint32_t& y)
 //-----------------------------------------------------------------------------
 //      3次元のモートンコードをデコードします.
 //-----------------------------------------------------------------------------
-inline void DecodeMorton3(uint32_t code, uint32_t& x, uint32_t& y, uint32_t z)
+inline void DecodeMorton3(uint32_t code, uint32_t& x, uint32_t& y, uint32_t& z)
 {
     x = Compact1By2(code >> 0);
     y = Compact1By2(code >> 1);
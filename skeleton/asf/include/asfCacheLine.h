@@ -0,0 +1,23 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfCacheLine.h
+// Desc : Cache Line Constants.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstddef>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+//! キャッシュラインサイズ.
+//! C++14 の new は alignas を保証しないため, 偽共有の回避にはこのサイズの詰め物を使用します.
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+} // namespace asf
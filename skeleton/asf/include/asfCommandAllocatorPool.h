@@ -0,0 +1,179 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfCommandAllocatorPool.h
+// Desc : Fence-tracked Command Allocator Pool.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <asfD3D12.h>
+#include <asfCommandQueue.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// COMMAND_ALLOCATOR_CLASS enum
+///////////////////////////////////////////////////////////////////////////////
+enum COMMAND_ALLOCATOR_CLASS
+{
+    COMMAND_ALLOCATOR_CLASS_SMALL = 0,      //!< コマンド数の少ないリスト用.
+    COMMAND_ALLOCATOR_CLASS_LARGE,          //!< コマンド数の多いリスト用.
+    COMMAND_ALLOCATOR_CLASS_COUNT,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CommandAllocatorPoolDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct CommandAllocatorPoolDesc
+{
+    ID3D12Device*           pDevice         = nullptr;                          //!< デバイス. nullptr の場合はソフトウェアコマンドリスト用のハンドルを生成します.
+    D3D12_COMMAND_LIST_TYPE Type            = D3D12_COMMAND_LIST_TYPE_DIRECT;   //!< コマンドリストタイプ.
+    uint32_t                InitialCount[COMMAND_ALLOCATOR_CLASS_COUNT] = {};   //!< 初期化時に生成しておく数.
+    uint32_t                MaxCount        = 64;                               //!< クラスごとの最大数. 超える場合は最も古いアロケータの完了を待ちます.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CommandAllocatorPoolStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct CommandAllocatorPoolStats
+{
+    uint64_t    CreateCount = 0;    //!< 生成したアロケータ数.
+    uint64_t    ReuseCount  = 0;    //!< 完了済みのアロケータを再利用した回数.
+    uint64_t    StallCount  = 0;    //!< MaxCount に達したためGPUの完了を待った回数.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CommandAllocatorPool class
+///////////////////////////////////////////////////////////////////////////////
+class CommandAllocatorPool
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    CommandAllocatorPool() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~CommandAllocatorPool();
+
+    CommandAllocatorPool(const CommandAllocatorPool&) = delete;
+    CommandAllocatorPool& operator = (const CommandAllocatorPool&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      desc        構成設定.
+    //! @retval true    初期化に成功しました.
+    //! @retval false   初期化に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(const CommandAllocatorPoolDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //!
+    //! @note       返却されたアロケータのGPUでの完了は待機しません.
+    //!             全てのアロケータを返却し, GPUの完了を待ってから呼び出してください.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      リセット済みのアロケータを取得します.
+    //!
+    //! @details    返却されたアロケータのうち, 待機点が完了しているものを返却順 (LRU) に再利用します.
+    //!             完了しているものが無い場合は新たに生成し, MaxCount に達している場合は
+    //!             最も古いアロケータの完了を待ちます. 任意のスレッドから呼び出せます.
+    //!
+    //! @param[in]      allocatorClass  アロケータのクラス.
+    //! @return     アロケータを返却します. 全て使用中で待機できない場合は nullptr を返却します.
+    //-------------------------------------------------------------------------
+    ID3D12CommandAllocator* Acquire(COMMAND_ALLOCATOR_CLASS allocatorClass);
+
+    //-------------------------------------------------------------------------
+    //! @brief      アロケータを返却します.
+    //!
+    //! @param[in]      pAllocator      Acquire() で取得したアロケータ.
+    //! @param[in]      allocatorClass  取得時に指定したクラス.
+    //! @param[in]      point           アロケータで記録したリストを実行した Signal() の待機点.
+    //!                                 pFence が nullptr の場合は完了済みとして扱うため,
+    //!                                 GPUに投入していないアロケータの場合のみ指定してください.
+    //!                                 フェンスはプールより先に解放しないでください.
+    //-------------------------------------------------------------------------
+    void Release(ID3D12CommandAllocator* pAllocator, COMMAND_ALLOCATOR_CLASS allocatorClass, const WaitPoint& point);
+
+    //-------------------------------------------------------------------------
+    //! @brief      コマンドリストタイプを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_COMMAND_LIST_TYPE GetType() const
+    { return m_Type; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    CommandAllocatorPoolStats GetStats() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        ID3D12CommandAllocator* pAllocator;
+        WaitPoint               Point;
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    ID3D12Device*               m_pDevice   = nullptr;
+    D3D12_COMMAND_LIST_TYPE     m_Type      = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    uint32_t                    m_MaxCount  = 0;
+    bool                        m_IsInit    = false;
+    mutable std::mutex          m_Mutex;
+    std::deque<Entry>           m_Retired[COMMAND_ALLOCATOR_CLASS_COUNT];   //!< 返却順に並んだアロケータ. 先頭が最も古い.
+    uint32_t                    m_Count  [COMMAND_ALLOCATOR_CLASS_COUNT] = {};
+    CommandAllocatorPoolStats   m_Stats;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      アロケータを生成します.
+    //-------------------------------------------------------------------------
+    ID3D12CommandAllocator* CreateAllocator();
+
+    //-------------------------------------------------------------------------
+    //! @brief      アロケータを破棄します.
+    //-------------------------------------------------------------------------
+    void DestroyAllocator(ID3D12CommandAllocator* pAllocator);
+
+    //-------------------------------------------------------------------------
+    //! @brief      アロケータをリセットします.
+    //-------------------------------------------------------------------------
+    bool ResetAllocator(ID3D12CommandAllocator* pAllocator);
+};
+
+} // namespace asf
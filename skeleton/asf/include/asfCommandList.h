@@ -8,7 +8,11 @@
 //-----------------------------------------------------------------------------
 // Includes
 //-----------------------------------------------------------------------------
-#include <d3d12.h>
+#include <asfD3D12.h>
+#include <asfCommandQueue.h>
+#include <asfCommandAllocatorPool.h>
+#include <asfCommandStateCache.h>
+#include <asfResourceStateTracker.h>
 
 
 namespace asf {
@@ -36,18 +40,137 @@ struct ICommandList
     //-------------------------------------------------------------------------
     //! @brief      リセット処理を行います.
     //! 
+    //! @details    使用中のアロケータを SetFencePoint() で設定した待機点とともにプールへ返却し,
+    //!             GPUでの実行が完了したアロケータを取得して記録を開始します.
+    //!             前回の Reset() 以降に SetFencePoint() が呼び出されていない場合は,
+    //!             アロケータが実行中の可能性があるため返却せずに失敗します.
+    //! 
     //! @return     D3D12グラフィックスコマンドリストを返却します.
+    //!             待機点が未設定の場合やアロケータを取得できない場合は nullptr を返却します.
     //-------------------------------------------------------------------------
     virtual ID3D12GraphicsCommandList6* Reset() = 0;
 
+    //-------------------------------------------------------------------------
+    //! @brief      記録した内容を実行した Signal() の待機点を設定します.
+    //! 
+    //! @details    次の Reset() でアロケータを再利用してよいかの判定に使用します.
+    //!             Reset() の前に必ず呼び出してください. ExecuteCommandLists() で投入した場合は自動で設定されます.
+    //!             記録した内容を投入しなかった場合は WaitPoint() を設定すると, アロケータは直ちに再利用されます.
+    //! 
+    //! @param[in]      point       GPU待機点.
+    //-------------------------------------------------------------------------
+    virtual void SetFencePoint(const WaitPoint& point) = 0;
+
     //-------------------------------------------------------------------------
     //! @brief      D3D12グラフィックスコマンドリストを取得します.
     //! 
     //! @return     D3D12グラフィックスコマンドリストを返却します.
     //-------------------------------------------------------------------------
     virtual ID3D12GraphicsCommandList6* GetD3D12GraphicsCommandList() const = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      リソースステートトラッカーを取得します.
+    //! 
+    //! @details    Reset() で記録した状態は破棄されます. 投入前に Close() し,
+    //!             ResourceStateRegistry::Resolve() で投入時の状態を解決してください.
+    //! 
+    //! @return     このコマンドリスト専用のトラッカーを返却します.
+    //-------------------------------------------------------------------------
+    virtual ResourceStateTracker* GetStateTracker() = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      パイプラインステートを設定します.
+    //! 
+    //! @details    以下の状態設定メソッドは直前に設定した状態と同じ場合は破棄され,
+    //!             D3D12グラフィックスコマンドリストには転送されません. キャッシュは Reset() で無効化されます.
+    //!             GetD3D12GraphicsCommandList() で直接状態を変更した場合は InvalidateStateCache() を呼び出してください.
+    //-------------------------------------------------------------------------
+    virtual void SetPipelineState(ID3D12PipelineState* pPipelineState) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフィックス用ルートシグニチャを設定します.
+    //-------------------------------------------------------------------------
+    virtual void SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンピュート用ルートシグニチャを設定します.
+    //-------------------------------------------------------------------------
+    virtual void SetComputeRootSignature(ID3D12RootSignature* pRootSignature) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディスクリプタヒープを設定します.
+    //-------------------------------------------------------------------------
+    virtual void SetDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* ppHeaps) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      レンダーターゲットと深度ステンシルを設定します.
+    //-------------------------------------------------------------------------
+    virtual void OMSetRenderTargets
+    (
+        uint32_t                            count,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pRenderTargets,
+        bool                                singleHandle,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pDepthStencil
+    ) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフィックス用ルート定数を設定します.
+    //-------------------------------------------------------------------------
+    virtual void SetGraphicsRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンピュート用ルート定数を設定します.
+    //-------------------------------------------------------------------------
+    virtual void SetComputeRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      状態キャッシュを無効化します.
+    //-------------------------------------------------------------------------
+    virtual void InvalidateStateCache() = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      状態キャッシュの統計情報を取得します.
+    //! 
+    //! @return     破棄した呼び出し回数などを返却します. Reset() ではリセットされません.
+    //-------------------------------------------------------------------------
+    virtual const CommandStateCacheStats& GetStateCacheStats() const = 0;
 };
 
+//-----------------------------------------------------------------------------
+//! @brief      コマンドリストを投入し, 発行した待機点を各コマンドリストに設定します.
+//! 
+//! @details    ICommandQueue::Execute() と Signal() を呼び出し, 返却された待機点を
+//!             各コマンドリストの SetFencePoint() に渡します.
+//! 
+//! @param[in]      pQueue      投入先のキューです.
+//! @param[in]      count       コマンドリスト数です.
+//! @param[in]      ppLists     クローズ済みのコマンドリストです.
+//! @return     GPU待機点を返却します.
+//-----------------------------------------------------------------------------
+inline WaitPoint ExecuteCommandLists(ICommandQueue* pQueue, uint32_t count, ICommandList* const* ppLists)
+{
+    if (pQueue == nullptr || (count > 0 && ppLists == nullptr))
+    { return WaitPoint(); }
+
+    // 固定長の配列に詰めて投入する. 超える分は続けて投入してもキュー上の順序は変わらない.
+    const uint32_t BATCH_SIZE = 16;
+    ID3D12CommandList* pBatch[BATCH_SIZE];
+    for(uint32_t i=0; i<count; i+=BATCH_SIZE)
+    {
+        auto batchCount = (count - i < BATCH_SIZE) ? count - i : BATCH_SIZE;
+        for(uint32_t j=0; j<batchCount; ++j)
+        { pBatch[j] = ppLists[i + j]->GetD3D12GraphicsCommandList(); }
+
+        pQueue->Execute(batchCount, pBatch);
+    }
+
+    auto point = pQueue->Signal();
+    for(uint32_t i=0; i<count; ++i)
+    { ppLists[i]->SetFencePoint(point); }
+
+    return point;
+}
+
 //-----------------------------------------------------------------------------
 //! @brief      コマンドリストを生成します.
 //! 
@@ -59,4 +182,25 @@ struct ICommandList
 //-----------------------------------------------------------------------------
 bool CreateCommandList(ID3D12Device* pDevice, D3D12_COMMAND_LIST_TYPE type, ICommandList** ppCmdList);
 
+//-----------------------------------------------------------------------------
+//! @brief      アロケータプールを共有するコマンドリストを生成します.
+//! 
+//! @details    コマンドリストタイプはプールのタイプを使用します.
+//!             プールはコマンドリストより先に破棄しないでください.
+//! 
+//! @param[in]      pDevice         デバイスです.
+//! @param[in]      pPool           アロケータプールです.
+//! @param[in]      allocatorClass  取得するアロケータのクラスです.
+//! @param[out]     ppCmdList       コマンドリストの格納先です.
+//! @retval true    コマンドリストの生成に成功.
+//! @retval false   コマンドリストの生成に失敗.
+//-----------------------------------------------------------------------------
+bool CreateCommandList
+(
+    ID3D12Device*           pDevice,
+    CommandAllocatorPool*   pPool,
+    COMMAND_ALLOCATOR_CLASS allocatorClass,
+    ICommandList**          ppCmdList
+);
+
 } // namespace asf
@@ -9,15 +9,40 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <cstdint>
-#include <d3d12.h>
+#include <asfD3D12.h>
 
 
 namespace asf {
 
 //-----------------------------------------------------------------------------
-// Type Definitions.
+// Forward Declarations.
 //-----------------------------------------------------------------------------
-using WaitPoint = uint64_t;
+struct IFence;
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t WAIT_INFINITE = 0xFFFFFFFF;   //!< IFence::Wait() などで無期限に待機します (INFINITE と同値).
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FENCE_WAIT_POLICY enum
+///////////////////////////////////////////////////////////////////////////////
+enum FENCE_WAIT_POLICY
+{
+    FENCE_WAIT_POLICY_BLOCK = 0,            //!< 完了していなければ直ちにイベントで待機します.
+    FENCE_WAIT_POLICY_SPIN_THEN_BLOCK,      //!< 一定時間ポーリングし, 完了しなければイベントで待機します.
+    FENCE_WAIT_POLICY_POLL,                 //!< イベントを使用せず, ポーリングのみで待機します.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// WaitPoint structure
+///////////////////////////////////////////////////////////////////////////////
+struct WaitPoint
+{
+    uint64_t    FenceValue  = 0;        //!< フェンス値.
+    IFence*     pFence      = nullptr;  //!< フェンス値を更新するフェンス (参照は保持しません). nullptr の場合は待機するキュー自身のフェンスです.
+};
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -58,6 +83,9 @@ struct ICommandQueue
     //-------------------------------------------------------------------------
     //! @brief      GPUでの待機点を設定します.
     //! 
+    //! @details    他のキューの Signal() が返却した待機点を指定すると, そのキューの
+    //!             フェンスを待機します. CPUを介さずにキュー間の依存関係を設定できます.
+    //! 
     //! @param[in]      value       GPU待機点.
     //! @retval true    処理に成功.
     //! @retval false   処理に失敗.
@@ -68,7 +96,7 @@ struct ICommandQueue
     //! @brief      CPU上でコマンドの完了を待機します.
     //! 
     //! @param[in]      value       GPU待機点
-    //! @param[in]      msec        待機時間をミリ秒単位で設定します.
+    //! @param[in]      msec        待機時間をミリ秒単位で設定します. WAIT_INFINITE の場合は無期限です.
     //-------------------------------------------------------------------------
     virtual void Sync(const WaitPoint& value, uint32_t msec) = 0;
 
@@ -79,6 +107,13 @@ struct ICommandQueue
     //-------------------------------------------------------------------------
     virtual uint64_t GetTimeStampFrequency() const = 0;
 
+    //-------------------------------------------------------------------------
+    //! @brief      Signal() で更新されるフェンスを取得します.
+    //! 
+    //! @return     フェンスを返却します. 参照カウントは増えません.
+    //-------------------------------------------------------------------------
+    virtual IFence* GetFence() const = 0;
+
     //-------------------------------------------------------------------------
     //! @brief      D3D12コマンドキューを取得します.
     //! 
@@ -111,10 +146,29 @@ struct IFence
     //! @brief      フェンスが指定された値に達するまで待機します.
     //! 
     //! @param[in]      fenceValue      待機カウンタ.
-    //! @param[in]      msec            タイムアウト時間(ミリ秒).
+    //! @param[in]      msec            タイムアウト時間(ミリ秒). WAIT_INFINITE の場合は無期限です.
     //-------------------------------------------------------------------------
     virtual void Wait(uint64_t fenceValue, uint32_t msec) = 0;
 
+    //-------------------------------------------------------------------------
+    //! @brief      Wait() の待機方法を設定します.
+    //! 
+    //! @details    イベントによる待機はカーネル遷移とスケジューラの起床遅延を伴うため,
+    //!             完了直前での待機が多い場合はポーリングを併用すると遅延を短縮できます.
+    //!             既定値は FENCE_WAIT_POLICY_BLOCK です.
+    //! 
+    //! @param[in]      policy          待機方法.
+    //! @param[in]      spinUsec        FENCE_WAIT_POLICY_SPIN_THEN_BLOCK でポーリングする最大時間(マイクロ秒).
+    //-------------------------------------------------------------------------
+    virtual void SetWaitPolicy(FENCE_WAIT_POLICY policy, uint32_t spinUsec) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      完了したフェンス値を取得します.
+    //! 
+    //! @return     完了したフェンス値を返却します.
+    //-------------------------------------------------------------------------
+    virtual uint64_t GetCompletedValue() const = 0;
+
     //-------------------------------------------------------------------------
     //! @brief      D3D12フェンスを取得します.
     //! 
@@ -0,0 +1,355 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfCommandStateCache.h
+// Desc : Redundant State Filtering for Command Lists.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <cstring>
+#include <asfD3D12.h>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t STATE_CACHE_MAX_RENDER_TARGETS    = 8;    //!< キャッシュするレンダーターゲット数.
+static constexpr uint32_t STATE_CACHE_MAX_DESCRIPTOR_HEAPS  = 2;    //!< キャッシュするディスクリプタヒープ数.
+static constexpr uint32_t STATE_CACHE_MAX_ROOT_PARAMETERS   = 16;   //!< 定数をキャッシュするルートパラメータ数.
+static constexpr uint32_t STATE_CACHE_MAX_ROOT_CONSTANTS    = 16;   //!< ルートパラメータごとにキャッシュする定数の数.
+
+///////////////////////////////////////////////////////////////////////////////
+// CommandStateCacheStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct CommandStateCacheStats
+{
+    uint64_t    CallCount               = 0;    //!< 状態設定の呼び出し回数.
+    uint64_t    PipelineStateCount      = 0;    //!< 破棄した SetPipelineState() の回数.
+    uint64_t    RootSignatureCount      = 0;    //!< 破棄した SetGraphicsRootSignature() / SetComputeRootSignature() の回数.
+    uint64_t    DescriptorHeapsCount    = 0;    //!< 破棄した SetDescriptorHeaps() の回数.
+    uint64_t    RenderTargetsCount      = 0;    //!< 破棄した OMSetRenderTargets() の回数.
+    uint64_t    RootConstantsCount      = 0;    //!< 破棄した SetGraphicsRoot32BitConstants() / SetComputeRoot32BitConstants() の回数.
+
+    //-------------------------------------------------------------------------
+    //! @brief      破棄した呼び出し回数の合計を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetFilterCount() const
+    { return PipelineStateCount + RootSignatureCount + DescriptorHeapsCount + RenderTargetsCount + RootConstantsCount; }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CommandStateCache class
+///////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class CommandStateCache
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    CommandStateCache()
+    { Invalidate(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      転送先を設定します. キャッシュは無効化されます.
+    //!
+    //! @param[in]      pTarget     ID3D12GraphicsCommandList6 など, 同名のメソッドを持つ転送先.
+    //-------------------------------------------------------------------------
+    void SetTarget(T* pTarget)
+    {
+        m_pTarget = pTarget;
+        Invalidate();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャッシュを無効化します.
+    //!
+    //! @details    コマンドリストのリセット時や, 転送先を直接操作した後に呼び出します.
+    //!             次の呼び出しは状態によらず転送されます.
+    //-------------------------------------------------------------------------
+    void Invalidate()
+    {
+        m_pPipelineState             = nullptr;
+        m_pGraphicsRootSignature     = nullptr;
+        m_pComputeRootSignature      = nullptr;
+        m_PipelineStateValid         = false;
+        m_GraphicsRootSignatureValid = false;
+        m_ComputeRootSignatureValid  = false;
+        m_DescriptorHeapsValid       = false;
+        m_RenderTargetsValid         = false;
+        m_DescriptorHeapCount        = 0;
+        m_RenderTargetCount          = 0;
+        m_HasDepthStencil            = false;
+        m_GraphicsConstants.Invalidate();
+        m_ComputeConstants.Invalidate();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    const CommandStateCacheStats& GetStats() const
+    { return m_Stats; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      パイプラインステートを設定します.
+    //-------------------------------------------------------------------------
+    void SetPipelineState(ID3D12PipelineState* pPipelineState)
+    {
+        m_Stats.CallCount++;
+        if (m_PipelineStateValid && m_pPipelineState == pPipelineState)
+        {
+            m_Stats.PipelineStateCount++;
+            return;
+        }
+
+        m_pPipelineState     = pPipelineState;
+        m_PipelineStateValid = true;
+        m_pTarget->SetPipelineState(pPipelineState);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフィックス用ルートシグニチャを設定します.
+    //!
+    //! @note       ルートシグニチャが変わるとルート引数は未定義になるため, ルート定数のキャッシュも無効化します.
+    //-------------------------------------------------------------------------
+    void SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature)
+    {
+        m_Stats.CallCount++;
+        if (m_GraphicsRootSignatureValid && m_pGraphicsRootSignature == pRootSignature)
+        {
+            m_Stats.RootSignatureCount++;
+            return;
+        }
+
+        m_pGraphicsRootSignature     = pRootSignature;
+        m_GraphicsRootSignatureValid = true;
+        m_GraphicsConstants.Invalidate();
+        m_pTarget->SetGraphicsRootSignature(pRootSignature);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンピュート用ルートシグニチャを設定します.
+    //-------------------------------------------------------------------------
+    void SetComputeRootSignature(ID3D12RootSignature* pRootSignature)
+    {
+        m_Stats.CallCount++;
+        if (m_ComputeRootSignatureValid && m_pComputeRootSignature == pRootSignature)
+        {
+            m_Stats.RootSignatureCount++;
+            return;
+        }
+
+        m_pComputeRootSignature     = pRootSignature;
+        m_ComputeRootSignatureValid = true;
+        m_ComputeConstants.Invalidate();
+        m_pTarget->SetComputeRootSignature(pRootSignature);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディスクリプタヒープを設定します.
+    //-------------------------------------------------------------------------
+    void SetDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* ppHeaps)
+    {
+        m_Stats.CallCount++;
+        if (m_DescriptorHeapsValid
+         && m_DescriptorHeapCount == count
+         && memcmp(m_pDescriptorHeaps, ppHeaps, sizeof(ID3D12DescriptorHeap*) * count) == 0)
+        {
+            m_Stats.DescriptorHeapsCount++;
+            return;
+        }
+
+        m_DescriptorHeapsValid = (count <= STATE_CACHE_MAX_DESCRIPTOR_HEAPS);
+        if (m_DescriptorHeapsValid)
+        {
+            m_DescriptorHeapCount = count;
+            memcpy(m_pDescriptorHeaps, ppHeaps, sizeof(ID3D12DescriptorHeap*) * count);
+        }
+
+        m_pTarget->SetDescriptorHeaps(count, ppHeaps);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      レンダーターゲットと深度ステンシルを設定します.
+    //!
+    //! @note       singleHandle が true の場合は連続したディスクリプタの範囲を指すため, キャッシュしません.
+    //-------------------------------------------------------------------------
+    void OMSetRenderTargets
+    (
+        uint32_t                            count,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pRenderTargets,
+        bool                                singleHandle,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pDepthStencil
+    )
+    {
+        m_Stats.CallCount++;
+        const auto cacheable = !singleHandle && count <= STATE_CACHE_MAX_RENDER_TARGETS;
+        if (cacheable && m_RenderTargetsValid && IsSameRenderTargets(count, pRenderTargets, pDepthStencil))
+        {
+            m_Stats.RenderTargetsCount++;
+            return;
+        }
+
+        m_RenderTargetsValid = cacheable;
+        if (cacheable)
+        {
+            m_RenderTargetCount = count;
+            for(auto i=0u; i<count; ++i)
+            { m_RenderTargets[i] = pRenderTargets[i]; }
+
+            m_HasDepthStencil = (pDepthStencil != nullptr);
+            if (m_HasDepthStencil)
+            { m_DepthStencil = *pDepthStencil; }
+        }
+
+        m_pTarget->OMSetRenderTargets(count, pRenderTargets, singleHandle, pDepthStencil);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフィックス用ルート定数を設定します.
+    //-------------------------------------------------------------------------
+    void SetGraphicsRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset)
+    {
+        m_Stats.CallCount++;
+        if (m_GraphicsConstants.Update(rootIndex, count, static_cast<const uint32_t*>(pData), destOffset))
+        {
+            m_Stats.RootConstantsCount++;
+            return;
+        }
+
+        m_pTarget->SetGraphicsRoot32BitConstants(rootIndex, count, pData, destOffset);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンピュート用ルート定数を設定します.
+    //-------------------------------------------------------------------------
+    void SetComputeRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset)
+    {
+        m_Stats.CallCount++;
+        if (m_ComputeConstants.Update(rootIndex, count, static_cast<const uint32_t*>(pData), destOffset))
+        {
+            m_Stats.RootConstantsCount++;
+            return;
+        }
+
+        m_pTarget->SetComputeRoot32BitConstants(rootIndex, count, pData, destOffset);
+    }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // RootConstants structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct RootConstants
+    {
+        uint32_t    Values[STATE_CACHE_MAX_ROOT_PARAMETERS][STATE_CACHE_MAX_ROOT_CONSTANTS];
+        uint32_t    ValidMask[STATE_CACHE_MAX_ROOT_PARAMETERS];     //!< 値が確定している定数のビットマスク.
+
+        //---------------------------------------------------------------------
+        //! @brief      全ての値を未確定にします.
+        //---------------------------------------------------------------------
+        void Invalidate()
+        { memset(ValidMask, 0, sizeof(ValidMask)); }
+
+        //---------------------------------------------------------------------
+        //! @brief      値を更新します.
+        //!
+        //! @retval true    全ての値が設定済みの値と一致するため, 呼び出しは不要です.
+        //! @retval false   呼び出しが必要です.
+        //---------------------------------------------------------------------
+        bool Update(uint32_t rootIndex, uint32_t count, const uint32_t* pValues, uint32_t destOffset)
+        {
+            if (rootIndex >= STATE_CACHE_MAX_ROOT_PARAMETERS)
+            { return false; }
+
+            // destOffset + count は桁あふれするため, 引き算で範囲を判定する.
+            if (count == 0 || count > STATE_CACHE_MAX_ROOT_CONSTANTS || destOffset > STATE_CACHE_MAX_ROOT_CONSTANTS - count)
+            {
+                // 範囲外の定数は追跡しないため, このパラメータは未確定にする.
+                ValidMask[rootIndex] = 0;
+                return false;
+            }
+
+            const auto mask = ((1u << count) - 1) << destOffset;
+            auto pCache = &Values[rootIndex][destOffset];
+            if ((ValidMask[rootIndex] & mask) == mask && memcmp(pCache, pValues, sizeof(uint32_t) * count) == 0)
+            { return true; }
+
+            memcpy(pCache, pValues, sizeof(uint32_t) * count);
+            ValidMask[rootIndex] |= mask;
+            return false;
+        }
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    T*                          m_pTarget                    = nullptr;
+    ID3D12PipelineState*        m_pPipelineState             = nullptr;
+    ID3D12RootSignature*        m_pGraphicsRootSignature     = nullptr;
+    ID3D12RootSignature*        m_pComputeRootSignature      = nullptr;
+    ID3D12DescriptorHeap*       m_pDescriptorHeaps[STATE_CACHE_MAX_DESCRIPTOR_HEAPS];
+    D3D12_CPU_DESCRIPTOR_HANDLE m_RenderTargets[STATE_CACHE_MAX_RENDER_TARGETS];
+    D3D12_CPU_DESCRIPTOR_HANDLE m_DepthStencil;
+    uint32_t                    m_DescriptorHeapCount        = 0;
+    uint32_t                    m_RenderTargetCount          = 0;
+    bool                        m_PipelineStateValid         = false;
+    bool                        m_GraphicsRootSignatureValid = false;
+    bool                        m_ComputeRootSignatureValid  = false;
+    bool                        m_DescriptorHeapsValid       = false;
+    bool                        m_RenderTargetsValid         = false;
+    bool                        m_HasDepthStencil            = false;
+    RootConstants               m_GraphicsConstants;
+    RootConstants               m_ComputeConstants;
+    CommandStateCacheStats      m_Stats;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      設定済みのレンダーターゲットと一致するかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsSameRenderTargets
+    (
+        uint32_t                            count,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pRenderTargets,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pDepthStencil
+    ) const
+    {
+        if (m_RenderTargetCount != count || m_HasDepthStencil != (pDepthStencil != nullptr))
+        { return false; }
+
+        if (pDepthStencil != nullptr && pDepthStencil->ptr != m_DepthStencil.ptr)
+        { return false; }
+
+        for(auto i=0u; i<count; ++i)
+        {
+            if (m_RenderTargets[i].ptr != pRenderTargets[i].ptr)
+            { return false; }
+        }
+
+        return true;
+    }
+};
+
+} // namespace asf
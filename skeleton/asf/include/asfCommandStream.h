@@ -0,0 +1,899 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfCommandStream.h
+// Desc : Backend-agnostic Recorded Command Stream.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <asfD3D12.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// COMMAND_TYPE enum
+///////////////////////////////////////////////////////////////////////////////
+enum COMMAND_TYPE : uint16_t
+{
+    COMMAND_TYPE_SET_PIPELINE_STATE = 0,
+    COMMAND_TYPE_SET_GRAPHICS_ROOT_SIGNATURE,
+    COMMAND_TYPE_SET_COMPUTE_ROOT_SIGNATURE,
+    COMMAND_TYPE_SET_DESCRIPTOR_HEAPS,
+    COMMAND_TYPE_SET_GRAPHICS_ROOT_DESCRIPTOR_TABLE,
+    COMMAND_TYPE_SET_COMPUTE_ROOT_DESCRIPTOR_TABLE,
+    COMMAND_TYPE_SET_GRAPHICS_ROOT_CONSTANT_BUFFER_VIEW,
+    COMMAND_TYPE_SET_COMPUTE_ROOT_CONSTANT_BUFFER_VIEW,
+    COMMAND_TYPE_SET_GRAPHICS_ROOT_32BIT_CONSTANTS,
+    COMMAND_TYPE_SET_COMPUTE_ROOT_32BIT_CONSTANTS,
+    COMMAND_TYPE_IA_SET_PRIMITIVE_TOPOLOGY,
+    COMMAND_TYPE_IA_SET_VERTEX_BUFFERS,
+    COMMAND_TYPE_IA_SET_INDEX_BUFFER,
+    COMMAND_TYPE_RS_SET_VIEWPORTS,
+    COMMAND_TYPE_RS_SET_SCISSOR_RECTS,
+    COMMAND_TYPE_OM_SET_RENDER_TARGETS,
+    COMMAND_TYPE_CLEAR_RENDER_TARGET_VIEW,
+    COMMAND_TYPE_CLEAR_DEPTH_STENCIL_VIEW,
+    COMMAND_TYPE_DRAW_INSTANCED,
+    COMMAND_TYPE_DRAW_INDEXED_INSTANCED,
+    COMMAND_TYPE_DISPATCH,
+    COMMAND_TYPE_RESOURCE_BARRIER,
+    COMMAND_TYPE_COUNT,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CommandHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct CommandHeader
+{
+    uint16_t    Type;       //!< COMMAND_TYPE.
+    uint16_t    Reserved;   //!< 予約領域.
+    uint32_t    Size;       //!< 後続の配列を含むバイト数 (8の倍数).
+};
+
+//-----------------------------------------------------------------------------
+// Command structures.
+// 配列を持つコマンドは, 構造体の直後に Count 個の要素が続きます.
+//-----------------------------------------------------------------------------
+struct CmdSetPipelineState
+{
+    CommandHeader           Header;
+    ID3D12PipelineState*    pPipelineState;
+};
+
+struct CmdSetRootSignature
+{
+    CommandHeader           Header;
+    ID3D12RootSignature*    pRootSignature;
+};
+
+struct CmdSetDescriptorHeaps
+{
+    CommandHeader           Header;
+    uint32_t                Count;      //!< ID3D12DescriptorHeap* が続きます.
+};
+
+struct CmdSetRootDescriptorTable
+{
+    CommandHeader               Header;
+    uint32_t                    RootIndex;
+    D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor;
+};
+
+struct CmdSetRootConstantBufferView
+{
+    CommandHeader               Header;
+    uint32_t                    RootIndex;
+    D3D12_GPU_VIRTUAL_ADDRESS   BufferLocation;
+};
+
+struct CmdSetRoot32BitConstants
+{
+    CommandHeader           Header;
+    uint32_t                RootIndex;
+    uint32_t                Count;      //!< uint32_t が続きます.
+    uint32_t                DestOffset;
+};
+
+struct CmdIASetPrimitiveTopology
+{
+    CommandHeader               Header;
+    D3D12_PRIMITIVE_TOPOLOGY    Topology;
+};
+
+struct CmdIASetVertexBuffers
+{
+    CommandHeader           Header;
+    uint32_t                StartSlot;
+    uint32_t                Count;      //!< D3D12_VERTEX_BUFFER_VIEW が続きます.
+};
+
+struct CmdIASetIndexBuffer
+{
+    CommandHeader           Header;
+    D3D12_INDEX_BUFFER_VIEW View;
+};
+
+struct CmdRSSetViewports
+{
+    CommandHeader           Header;
+    uint32_t                Count;      //!< D3D12_VIEWPORT が続きます.
+};
+
+struct CmdRSSetScissorRects
+{
+    CommandHeader           Header;
+    uint32_t                Count;      //!< D3D12_RECT が続きます.
+};
+
+struct CmdOMSetRenderTargets
+{
+    CommandHeader               Header;
+    uint32_t                    Count;      //!< D3D12_CPU_DESCRIPTOR_HANDLE が続きます.
+    uint32_t                    HasDepth;
+    D3D12_CPU_DESCRIPTOR_HANDLE DepthStencil;
+};
+
+struct CmdClearRenderTargetView
+{
+    CommandHeader               Header;
+    D3D12_CPU_DESCRIPTOR_HANDLE View;
+    float                       Color[4];
+    uint32_t                    RectCount;  //!< D3D12_RECT が続きます.
+};
+
+struct CmdClearDepthStencilView
+{
+    CommandHeader               Header;
+    D3D12_CPU_DESCRIPTOR_HANDLE View;
+    D3D12_CLEAR_FLAGS           Flags;
+    float                       Depth;
+    uint8_t                     Stencil;
+    uint32_t                    RectCount;  //!< D3D12_RECT が続きます.
+};
+
+struct CmdDrawInstanced
+{
+    CommandHeader           Header;
+    uint32_t                VertexCount;
+    uint32_t                InstanceCount;
+    uint32_t                StartVertex;
+    uint32_t                StartInstance;
+};
+
+struct CmdDrawIndexedInstanced
+{
+    CommandHeader           Header;
+    uint32_t                IndexCount;
+    uint32_t                InstanceCount;
+    uint32_t                StartIndex;
+    int32_t                 BaseVertex;
+    uint32_t                StartInstance;
+};
+
+struct CmdDispatch
+{
+    CommandHeader           Header;
+    uint32_t                X;
+    uint32_t                Y;
+    uint32_t                Z;
+};
+
+struct CmdResourceBarrier
+{
+    CommandHeader           Header;
+    uint32_t                Count;      //!< D3D12_RESOURCE_BARRIER が続きます.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CommandStreamDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct CommandStreamDesc
+{
+    uint32_t    BlockSize   = 64 * 1024;    //!< 1ブロックのバイト数. これを超えるコマンドは専用のブロックに格納します.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CommandStream class
+///////////////////////////////////////////////////////////////////////////////
+class CommandStream
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    CommandStream() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~CommandStream();
+
+    CommandStream(const CommandStream&) = delete;
+    CommandStream& operator = (const CommandStream&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います. 最初のブロックを確保します.
+    //!
+    //! @param[in]      desc        構成設定.
+    //! @retval true    初期化に成功しました.
+    //! @retval false   初期化に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(const CommandStreamDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      記録した内容を破棄します. 確保済みのブロックは再利用されます.
+    //-------------------------------------------------------------------------
+    void Reset();
+
+    //-------------------------------------------------------------------------
+    //! @brief      記録したコマンドを順に pTarget の同名メソッドへ変換します.
+    //!
+    //! @details    ID3D12GraphicsCommandList6 や HeadlessCommandList など, D3D12 と同じ
+    //!             シグネチャのメソッドを持つ型に対して使用できます. 記録内容は変更しないため,
+    //!             静的なストリームは一度記録しておけば何度でも再生できます.
+    //!             記録中のストリームを他のスレッドから再生しないでください.
+    //!
+    //! @param[in]      pTarget     変換先.
+    //-------------------------------------------------------------------------
+    template<typename T>
+    void Replay(T* pTarget) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      記録したコマンド数を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetCommandCount() const
+    { return m_CommandCount; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      記録したコマンドのバイト数を取得します.
+    //-------------------------------------------------------------------------
+    size_t GetSize() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      確保済みのブロックの合計バイト数を取得します.
+    //-------------------------------------------------------------------------
+    size_t GetCapacity() const;
+
+    //-------------------------------------------------------------------------
+    // 以下は ID3D12GraphicsCommandList と同じ引数でコマンドを記録します.
+    // 配列の引数はストリームにコピーされるため, 呼び出し後に破棄して構いません.
+    //-------------------------------------------------------------------------
+    void SetPipelineState(ID3D12PipelineState* pPipelineState)
+    {
+        auto pCmd = Push<CmdSetPipelineState>(COMMAND_TYPE_SET_PIPELINE_STATE);
+        pCmd->pPipelineState = pPipelineState;
+    }
+
+    void SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature)
+    {
+        auto pCmd = Push<CmdSetRootSignature>(COMMAND_TYPE_SET_GRAPHICS_ROOT_SIGNATURE);
+        pCmd->pRootSignature = pRootSignature;
+    }
+
+    void SetComputeRootSignature(ID3D12RootSignature* pRootSignature)
+    {
+        auto pCmd = Push<CmdSetRootSignature>(COMMAND_TYPE_SET_COMPUTE_ROOT_SIGNATURE);
+        pCmd->pRootSignature = pRootSignature;
+    }
+
+    void SetDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* ppHeaps)
+    {
+        auto pCmd = Push<CmdSetDescriptorHeaps>(COMMAND_TYPE_SET_DESCRIPTOR_HEAPS, ppHeaps, count);
+        pCmd->Count = count;
+    }
+
+    void SetGraphicsRootDescriptorTable(uint32_t rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+    {
+        auto pCmd = Push<CmdSetRootDescriptorTable>(COMMAND_TYPE_SET_GRAPHICS_ROOT_DESCRIPTOR_TABLE);
+        pCmd->RootIndex      = rootIndex;
+        pCmd->BaseDescriptor = baseDescriptor;
+    }
+
+    void SetComputeRootDescriptorTable(uint32_t rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+    {
+        auto pCmd = Push<CmdSetRootDescriptorTable>(COMMAND_TYPE_SET_COMPUTE_ROOT_DESCRIPTOR_TABLE);
+        pCmd->RootIndex      = rootIndex;
+        pCmd->BaseDescriptor = baseDescriptor;
+    }
+
+    void SetGraphicsRootConstantBufferView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+    {
+        auto pCmd = Push<CmdSetRootConstantBufferView>(COMMAND_TYPE_SET_GRAPHICS_ROOT_CONSTANT_BUFFER_VIEW);
+        pCmd->RootIndex      = rootIndex;
+        pCmd->BufferLocation = bufferLocation;
+    }
+
+    void SetComputeRootConstantBufferView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+    {
+        auto pCmd = Push<CmdSetRootConstantBufferView>(COMMAND_TYPE_SET_COMPUTE_ROOT_CONSTANT_BUFFER_VIEW);
+        pCmd->RootIndex      = rootIndex;
+        pCmd->BufferLocation = bufferLocation;
+    }
+
+    void SetGraphicsRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset)
+    {
+        auto pCmd = Push<CmdSetRoot32BitConstants>(COMMAND_TYPE_SET_GRAPHICS_ROOT_32BIT_CONSTANTS, static_cast<const uint32_t*>(pData), count);
+        pCmd->RootIndex  = rootIndex;
+        pCmd->Count      = count;
+        pCmd->DestOffset = destOffset;
+    }
+
+    void SetComputeRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset)
+    {
+        auto pCmd = Push<CmdSetRoot32BitConstants>(COMMAND_TYPE_SET_COMPUTE_ROOT_32BIT_CONSTANTS, static_cast<const uint32_t*>(pData), count);
+        pCmd->RootIndex  = rootIndex;
+        pCmd->Count      = count;
+        pCmd->DestOffset = destOffset;
+    }
+
+    void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+    {
+        auto pCmd = Push<CmdIASetPrimitiveTopology>(COMMAND_TYPE_IA_SET_PRIMITIVE_TOPOLOGY);
+        pCmd->Topology = topology;
+    }
+
+    void IASetVertexBuffers(uint32_t startSlot, uint32_t count, const D3D12_VERTEX_BUFFER_VIEW* pViews)
+    {
+        auto pCmd = Push<CmdIASetVertexBuffers>(COMMAND_TYPE_IA_SET_VERTEX_BUFFERS, pViews, count);
+        pCmd->StartSlot = startSlot;
+        pCmd->Count     = count;
+    }
+
+    void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView)
+    {
+        auto pCmd = Push<CmdIASetIndexBuffer>(COMMAND_TYPE_IA_SET_INDEX_BUFFER);
+        pCmd->View = *pView;
+    }
+
+    void RSSetViewports(uint32_t count, const D3D12_VIEWPORT* pViewports)
+    {
+        auto pCmd = Push<CmdRSSetViewports>(COMMAND_TYPE_RS_SET_VIEWPORTS, pViewports, count);
+        pCmd->Count = count;
+    }
+
+    void RSSetScissorRects(uint32_t count, const D3D12_RECT* pRects)
+    {
+        auto pCmd = Push<CmdRSSetScissorRects>(COMMAND_TYPE_RS_SET_SCISSOR_RECTS, pRects, count);
+        pCmd->Count = count;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @note       RTsSingleHandleToDescriptorRange は常に FALSE として記録します.
+    //-------------------------------------------------------------------------
+    void OMSetRenderTargets
+    (
+        uint32_t                            count,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pRenderTargets,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pDepthStencil
+    )
+    {
+        auto pCmd = Push<CmdOMSetRenderTargets>(COMMAND_TYPE_OM_SET_RENDER_TARGETS, pRenderTargets, count);
+        pCmd->Count    = count;
+        pCmd->HasDepth = (pDepthStencil != nullptr) ? 1 : 0;
+        if (pDepthStencil != nullptr)
+        { pCmd->DepthStencil = *pDepthStencil; }
+    }
+
+    void ClearRenderTargetView
+    (
+        D3D12_CPU_DESCRIPTOR_HANDLE view,
+        const float                 color[4],
+        uint32_t                    rectCount,
+        const D3D12_RECT*           pRects
+    )
+    {
+        auto pCmd = Push<CmdClearRenderTargetView>(COMMAND_TYPE_CLEAR_RENDER_TARGET_VIEW, pRects, rectCount);
+        pCmd->View      = view;
+        pCmd->Color[0]  = color[0];
+        pCmd->Color[1]  = color[1];
+        pCmd->Color[2]  = color[2];
+        pCmd->Color[3]  = color[3];
+        pCmd->RectCount = rectCount;
+    }
+
+    void ClearDepthStencilView
+    (
+        D3D12_CPU_DESCRIPTOR_HANDLE view,
+        D3D12_CLEAR_FLAGS           flags,
+        float                       depth,
+        uint8_t                     stencil,
+        uint32_t                    rectCount,
+        const D3D12_RECT*           pRects
+    )
+    {
+        auto pCmd = Push<CmdClearDepthStencilView>(COMMAND_TYPE_CLEAR_DEPTH_STENCIL_VIEW, pRects, rectCount);
+        pCmd->View      = view;
+        pCmd->Flags     = flags;
+        pCmd->Depth     = depth;
+        pCmd->Stencil   = stencil;
+        pCmd->RectCount = rectCount;
+    }
+
+    void DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance)
+    {
+        auto pCmd = Push<CmdDrawInstanced>(COMMAND_TYPE_DRAW_INSTANCED);
+        pCmd->VertexCount   = vertexCount;
+        pCmd->InstanceCount = instanceCount;
+        pCmd->StartVertex   = startVertex;
+        pCmd->StartInstance = startInstance;
+    }
+
+    void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+    {
+        auto pCmd = Push<CmdDrawIndexedInstanced>(COMMAND_TYPE_DRAW_INDEXED_INSTANCED);
+        pCmd->IndexCount    = indexCount;
+        pCmd->InstanceCount = instanceCount;
+        pCmd->StartIndex    = startIndex;
+        pCmd->BaseVertex    = baseVertex;
+        pCmd->StartInstance = startInstance;
+    }
+
+    void Dispatch(uint32_t x, uint32_t y, uint32_t z)
+    {
+        auto pCmd = Push<CmdDispatch>(COMMAND_TYPE_DISPATCH);
+        pCmd->X = x;
+        pCmd->Y = y;
+        pCmd->Z = z;
+    }
+
+    void ResourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER* pBarriers)
+    {
+        auto pCmd = Push<CmdResourceBarrier>(COMMAND_TYPE_RESOURCE_BARRIER, pBarriers, count);
+        pCmd->Count = count;
+    }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Block structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]>  pData;
+        size_t                      Size;
+        size_t                      Used;   //!< 現在のブロック以外で有効です.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<Block>  m_Blocks;
+    size_t              m_BlockSize     = 0;
+    size_t              m_Current       = 0;        //!< 記録中のブロック.
+    uint8_t*            m_pCursor       = nullptr;
+    uint8_t*            m_pEnd          = nullptr;
+    uint32_t            m_CommandCount  = 0;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      8バイト境界に切り上げます.
+    //-------------------------------------------------------------------------
+    static size_t AlignSize(size_t size)
+    { return (size + 7) & ~size_t(7); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コマンドの直後に続く配列を取得します.
+    //-------------------------------------------------------------------------
+    template<typename T, typename Cmd>
+    static const T* GetPayload(const Cmd* pCmd)
+    { return reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(pCmd) + AlignSize(sizeof(Cmd))); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      次のブロックに切り替えて領域を確保します.
+    //-------------------------------------------------------------------------
+    uint8_t* AllocateSlow(size_t size);
+
+    //-------------------------------------------------------------------------
+    //! @brief      コマンドの領域を確保します.
+    //-------------------------------------------------------------------------
+    uint8_t* Allocate(size_t size)
+    {
+        if (size > size_t(m_pEnd - m_pCursor))
+        { return AllocateSlow(size); }
+
+        auto ptr = m_pCursor;
+        m_pCursor += size;
+        return ptr;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コマンドを追加します.
+    //-------------------------------------------------------------------------
+    template<typename Cmd>
+    Cmd* Push(COMMAND_TYPE type)
+    {
+        const auto size = AlignSize(sizeof(Cmd));
+        auto pCmd = reinterpret_cast<Cmd*>(Allocate(size));
+        pCmd->Header.Type     = type;
+        pCmd->Header.Reserved = 0;
+        pCmd->Header.Size     = uint32_t(size);
+        m_CommandCount++;
+        return pCmd;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      配列を持つコマンドを追加します.
+    //-------------------------------------------------------------------------
+    template<typename Cmd, typename T>
+    Cmd* Push(COMMAND_TYPE type, const T* pItems, uint32_t count)
+    {
+        const auto head = AlignSize(sizeof(Cmd));
+        const auto size = AlignSize(head + sizeof(T) * count);
+        auto ptr  = Allocate(size);
+        auto pCmd = reinterpret_cast<Cmd*>(ptr);
+        pCmd->Header.Type     = type;
+        pCmd->Header.Reserved = 0;
+        pCmd->Header.Size     = uint32_t(size);
+        if (count > 0)
+        { memcpy(ptr + head, pItems, sizeof(T) * count); }
+        m_CommandCount++;
+        return pCmd;
+    }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HeadlessCommandList class
+///////////////////////////////////////////////////////////////////////////////
+class HeadlessCommandList
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    HeadlessCommandList()
+    { Reset(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測値をリセットします.
+    //-------------------------------------------------------------------------
+    void Reset()
+    {
+        memset(m_Counts, 0, sizeof(m_Counts));
+        m_Checksum = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      受け取ったコマンド数を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetCount(COMMAND_TYPE type) const
+    { return m_Counts[type]; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      受け取った引数のチェックサムを取得します.
+    //!
+    //! @details    記録と再生で内容が一致するかの確認に使用します.
+    //-------------------------------------------------------------------------
+    uint64_t GetChecksum() const
+    { return m_Checksum; }
+
+    //-------------------------------------------------------------------------
+    // 以下は ID3D12GraphicsCommandList と同じシグネチャで呼び出し回数を記録します.
+    //-------------------------------------------------------------------------
+    void SetPipelineState(ID3D12PipelineState* pPipelineState)
+    { Count(COMMAND_TYPE_SET_PIPELINE_STATE, uint64_t(uintptr_t(pPipelineState))); }
+
+    void SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature)
+    { Count(COMMAND_TYPE_SET_GRAPHICS_ROOT_SIGNATURE, uint64_t(uintptr_t(pRootSignature))); }
+
+    void SetComputeRootSignature(ID3D12RootSignature* pRootSignature)
+    { Count(COMMAND_TYPE_SET_COMPUTE_ROOT_SIGNATURE, uint64_t(uintptr_t(pRootSignature))); }
+
+    void SetDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* ppHeaps)
+    { Count(COMMAND_TYPE_SET_DESCRIPTOR_HEAPS, (count > 0) ? uint64_t(uintptr_t(ppHeaps[0])) : 0); }
+
+    void SetGraphicsRootDescriptorTable(uint32_t rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+    { Count(COMMAND_TYPE_SET_GRAPHICS_ROOT_DESCRIPTOR_TABLE, rootIndex + baseDescriptor.ptr); }
+
+    void SetComputeRootDescriptorTable(uint32_t rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+    { Count(COMMAND_TYPE_SET_COMPUTE_ROOT_DESCRIPTOR_TABLE, rootIndex + baseDescriptor.ptr); }
+
+    void SetGraphicsRootConstantBufferView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+    { Count(COMMAND_TYPE_SET_GRAPHICS_ROOT_CONSTANT_BUFFER_VIEW, rootIndex + bufferLocation); }
+
+    void SetComputeRootConstantBufferView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+    { Count(COMMAND_TYPE_SET_COMPUTE_ROOT_CONSTANT_BUFFER_VIEW, rootIndex + bufferLocation); }
+
+    void SetGraphicsRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset)
+    { Count(COMMAND_TYPE_SET_GRAPHICS_ROOT_32BIT_CONSTANTS, rootIndex + destOffset + Sum(static_cast<const uint32_t*>(pData), count)); }
+
+    void SetComputeRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset)
+    { Count(COMMAND_TYPE_SET_COMPUTE_ROOT_32BIT_CONSTANTS, rootIndex + destOffset + Sum(static_cast<const uint32_t*>(pData), count)); }
+
+    void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+    { Count(COMMAND_TYPE_IA_SET_PRIMITIVE_TOPOLOGY, uint64_t(topology)); }
+
+    void IASetVertexBuffers(uint32_t startSlot, uint32_t count, const D3D12_VERTEX_BUFFER_VIEW* pViews)
+    { Count(COMMAND_TYPE_IA_SET_VERTEX_BUFFERS, startSlot + ((count > 0) ? pViews[0].BufferLocation : 0)); }
+
+    void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView)
+    { Count(COMMAND_TYPE_IA_SET_INDEX_BUFFER, (pView != nullptr) ? pView->BufferLocation : 0); }
+
+    void RSSetViewports(uint32_t count, const D3D12_VIEWPORT*)
+    { Count(COMMAND_TYPE_RS_SET_VIEWPORTS, count); }
+
+    void RSSetScissorRects(uint32_t count, const D3D12_RECT*)
+    { Count(COMMAND_TYPE_RS_SET_SCISSOR_RECTS, count); }
+
+    void OMSetRenderTargets(uint32_t count, const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargets, bool, const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencil)
+    { Count(COMMAND_TYPE_OM_SET_RENDER_TARGETS, ((count > 0) ? pRenderTargets[0].ptr : 0) + ((pDepthStencil != nullptr) ? pDepthStencil->ptr : 0)); }
+
+    void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE view, const float*, uint32_t rectCount, const D3D12_RECT*)
+    { Count(COMMAND_TYPE_CLEAR_RENDER_TARGET_VIEW, view.ptr + rectCount); }
+
+    void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE view, D3D12_CLEAR_FLAGS flags, float, uint8_t stencil, uint32_t rectCount, const D3D12_RECT*)
+    { Count(COMMAND_TYPE_CLEAR_DEPTH_STENCIL_VIEW, view.ptr + uint64_t(flags) + stencil + rectCount); }
+
+    void DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance)
+    { Count(COMMAND_TYPE_DRAW_INSTANCED, uint64_t(vertexCount) + instanceCount + startVertex + startInstance); }
+
+    void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+    { Count(COMMAND_TYPE_DRAW_INDEXED_INSTANCED, uint64_t(indexCount) + instanceCount + startIndex + uint64_t(baseVertex) + startInstance); }
+
+    void Dispatch(uint32_t x, uint32_t y, uint32_t z)
+    { Count(COMMAND_TYPE_DISPATCH, uint64_t(x) + y + z); }
+
+    void ResourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER*)
+    { Count(COMMAND_TYPE_RESOURCE_BARRIER, count); }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    uint64_t    m_Counts[COMMAND_TYPE_COUNT];
+    uint64_t    m_Checksum;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      呼び出しを記録します.
+    //-------------------------------------------------------------------------
+    void Count(COMMAND_TYPE type, uint64_t value)
+    {
+        m_Counts[type]++;
+        m_Checksum = (m_Checksum ^ (value + type)) * 0x100000001B3ull;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      配列の合計を求めます.
+    //-------------------------------------------------------------------------
+    static uint64_t Sum(const uint32_t* pValues, uint32_t count)
+    {
+        uint64_t sum = 0;
+        for(auto i=0u; i<count; ++i)
+        { sum += pValues[i]; }
+        return sum;
+    }
+};
+
+
+//-----------------------------------------------------------------------------
+//      記録したコマンドを順に pTarget の同名メソッドへ変換します.
+//-----------------------------------------------------------------------------
+template<typename T>
+void CommandStream::Replay(T* pTarget) const
+{
+    for(size_t i=0; i<m_Blocks.size() && i<=m_Current; ++i)
+    {
+        auto ptr = m_Blocks[i].pData.get();
+        auto end = (i == m_Current) ? m_pCursor : ptr + m_Blocks[i].Used;
+
+        while (ptr < end)
+        {
+            auto pHeader = reinterpret_cast<const CommandHeader*>(ptr);
+            switch(pHeader->Type)
+            {
+            case COMMAND_TYPE_SET_PIPELINE_STATE:
+                {
+                    auto pCmd = reinterpret_cast<const CmdSetPipelineState*>(ptr);
+                    pTarget->SetPipelineState(pCmd->pPipelineState);
+                }
+                break;
+
+            case COMMAND_TYPE_SET_GRAPHICS_ROOT_SIGNATURE:
+                {
+                    auto pCmd = reinterpret_cast<const CmdSetRootSignature*>(ptr);
+                    pTarget->SetGraphicsRootSignature(pCmd->pRootSignature);
+                }
+                break;
+
+            case COMMAND_TYPE_SET_COMPUTE_ROOT_SIGNATURE:
+                {
+                    auto pCmd = reinterpret_cast<const CmdSetRootSignature*>(ptr);
+                    pTarget->SetComputeRootSignature(pCmd->pRootSignature);
+                }
+                break;
+
+            case COMMAND_TYPE_SET_DESCRIPTOR_HEAPS:
+                {
+                    auto pCmd = reinterpret_cast<const CmdSetDescriptorHeaps*>(ptr);
+                    pTarget->SetDescriptorHeaps(pCmd->Count, GetPayload<ID3D12DescriptorHeap* const>(pCmd));
+                }
+                break;
+
+            case COMMAND_TYPE_SET_GRAPHICS_ROOT_DESCRIPTOR_TABLE:
+                {
+                    auto pCmd = reinterpret_cast<const CmdSetRootDescriptorTable*>(ptr);
+                    pTarget->SetGraphicsRootDescriptorTable(pCmd->RootIndex, pCmd->BaseDescriptor);
+                }
+                break;
+
+            case COMMAND_TYPE_SET_COMPUTE_ROOT_DESCRIPTOR_TABLE:
+                {
+                    auto pCmd = reinterpret_cast<const CmdSetRootDescriptorTable*>(ptr);
+                    pTarget->SetComputeRootDescriptorTable(pCmd->RootIndex, pCmd->BaseDescriptor);
+                }
+                break;
+
+            case COMMAND_TYPE_SET_GRAPHICS_ROOT_CONSTANT_BUFFER_VIEW:
+                {
+                    auto pCmd = reinterpret_cast<const CmdSetRootConstantBufferView*>(ptr);
+                    pTarget->SetGraphicsRootConstantBufferView(pCmd->RootIndex, pCmd->BufferLocation);
+                }
+                break;
+
+            case COMMAND_TYPE_SET_COMPUTE_ROOT_CONSTANT_BUFFER_VIEW:
+                {
+                    auto pCmd = reinterpret_cast<const CmdSetRootConstantBufferView*>(ptr);
+                    pTarget->SetComputeRootConstantBufferView(pCmd->RootIndex, pCmd->BufferLocation);
+                }
+                break;
+
+            case COMMAND_TYPE_SET_GRAPHICS_ROOT_32BIT_CONSTANTS:
+                {
+                    auto pCmd = reinterpret_cast<const CmdSetRoot32BitConstants*>(ptr);
+                    pTarget->SetGraphicsRoot32BitConstants(pCmd->RootIndex, pCmd->Count, GetPayload<uint32_t>(pCmd), pCmd->DestOffset);
+                }
+                break;
+
+            case COMMAND_TYPE_SET_COMPUTE_ROOT_32BIT_CONSTANTS:
+                {
+                    auto pCmd = reinterpret_cast<const CmdSetRoot32BitConstants*>(ptr);
+                    pTarget->SetComputeRoot32BitConstants(pCmd->RootIndex, pCmd->Count, GetPayload<uint32_t>(pCmd), pCmd->DestOffset);
+                }
+                break;
+
+            case COMMAND_TYPE_IA_SET_PRIMITIVE_TOPOLOGY:
+                {
+                    auto pCmd = reinterpret_cast<const CmdIASetPrimitiveTopology*>(ptr);
+                    pTarget->IASetPrimitiveTopology(pCmd->Topology);
+                }
+                break;
+
+            case COMMAND_TYPE_IA_SET_VERTEX_BUFFERS:
+                {
+                    auto pCmd = reinterpret_cast<const CmdIASetVertexBuffers*>(ptr);
+                    pTarget->IASetVertexBuffers(pCmd->StartSlot, pCmd->Count, GetPayload<D3D12_VERTEX_BUFFER_VIEW>(pCmd));
+                }
+                break;
+
+            case COMMAND_TYPE_IA_SET_INDEX_BUFFER:
+                {
+                    auto pCmd = reinterpret_cast<const CmdIASetIndexBuffer*>(ptr);
+                    pTarget->IASetIndexBuffer(&pCmd->View);
+                }
+                break;
+
+            case COMMAND_TYPE_RS_SET_VIEWPORTS:
+                {
+                    auto pCmd = reinterpret_cast<const CmdRSSetViewports*>(ptr);
+                    pTarget->RSSetViewports(pCmd->Count, GetPayload<D3D12_VIEWPORT>(pCmd));
+                }
+                break;
+
+            case COMMAND_TYPE_RS_SET_SCISSOR_RECTS:
+                {
+                    auto pCmd = reinterpret_cast<const CmdRSSetScissorRects*>(ptr);
+                    pTarget->RSSetScissorRects(pCmd->Count, GetPayload<D3D12_RECT>(pCmd));
+                }
+                break;
+
+            case COMMAND_TYPE_OM_SET_RENDER_TARGETS:
+                {
+                    auto pCmd = reinterpret_cast<const CmdOMSetRenderTargets*>(ptr);
+                    pTarget->OMSetRenderTargets(
+                        pCmd->Count,
+                        GetPayload<D3D12_CPU_DESCRIPTOR_HANDLE>(pCmd),
+                        false,
+                        (pCmd->HasDepth != 0) ? &pCmd->DepthStencil : nullptr);
+                }
+                break;
+
+            case COMMAND_TYPE_CLEAR_RENDER_TARGET_VIEW:
+                {
+                    auto pCmd = reinterpret_cast<const CmdClearRenderTargetView*>(ptr);
+                    pTarget->ClearRenderTargetView(pCmd->View, pCmd->Color, pCmd->RectCount, (pCmd->RectCount > 0) ? GetPayload<D3D12_RECT>(pCmd) : nullptr);
+                }
+                break;
+
+            case COMMAND_TYPE_CLEAR_DEPTH_STENCIL_VIEW:
+                {
+                    auto pCmd = reinterpret_cast<const CmdClearDepthStencilView*>(ptr);
+                    pTarget->ClearDepthStencilView(pCmd->View, pCmd->Flags, pCmd->Depth, pCmd->Stencil, pCmd->RectCount, (pCmd->RectCount > 0) ? GetPayload<D3D12_RECT>(pCmd) : nullptr);
+                }
+                break;
+
+            case COMMAND_TYPE_DRAW_INSTANCED:
+                {
+                    auto pCmd = reinterpret_cast<const CmdDrawInstanced*>(ptr);
+                    pTarget->DrawInstanced(pCmd->VertexCount, pCmd->InstanceCount, pCmd->StartVertex, pCmd->StartInstance);
+                }
+                break;
+
+            case COMMAND_TYPE_DRAW_INDEXED_INSTANCED:
+                {
+                    auto pCmd = reinterpret_cast<const CmdDrawIndexedInstanced*>(ptr);
+                    pTarget->DrawIndexedInstanced(pCmd->IndexCount, pCmd->InstanceCount, pCmd->StartIndex, pCmd->BaseVertex, pCmd->StartInstance);
+                }
+                break;
+
+            case COMMAND_TYPE_DISPATCH:
+                {
+                    auto pCmd = reinterpret_cast<const CmdDispatch*>(ptr);
+                    pTarget->Dispatch(pCmd->X, pCmd->Y, pCmd->Z);
+                }
+                break;
+
+            case COMMAND_TYPE_RESOURCE_BARRIER:
+                {
+                    auto pCmd = reinterpret_cast<const CmdResourceBarrier*>(ptr);
+                    pTarget->ResourceBarrier(pCmd->Count, GetPayload<D3D12_RESOURCE_BARRIER>(pCmd));
+                }
+                break;
+
+            default:
+                break;
+            }
+
+            ptr += pHeader->Size;
+        }
+    }
+}
+
+} // namespace asf
@@ -0,0 +1,173 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfD3D12.h
+// Desc : d3d12.h wrapper.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+#if defined(_WIN32)
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+
+#else
+//-----------------------------------------------------------------------------
+// d3d12.h が利用できない環境向けの最小限の宣言です.
+// ソフトウェアバックエンド (asfSoftBackend.h) を使用したヘッドレス実行でのみ使用し,
+// メソッドを持たないためD3D12の機能を呼び出すことはできません.
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+struct ID3D12Device                 { };
+struct ID3D12Fence                  { };
+struct ID3D12CommandQueue           { };
+struct ID3D12CommandAllocator       { };
+struct ID3D12CommandList            { };
+struct ID3D12GraphicsCommandList6   : public ID3D12CommandList { };
+struct ID3D12PipelineState          { };
+struct ID3D12RootSignature          { };
+struct ID3D12DescriptorHeap         { };
+struct ID3D12Resource               { };
+
+typedef uint64_t D3D12_GPU_VIRTUAL_ADDRESS;
+
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN                     = 0,
+    DXGI_FORMAT_R32_UINT                    = 42,
+    DXGI_FORMAT_R16_UINT                    = 57,
+};
+
+enum D3D12_PRIMITIVE_TOPOLOGY
+{
+    D3D_PRIMITIVE_TOPOLOGY_UNDEFINED        = 0,
+    D3D_PRIMITIVE_TOPOLOGY_POINTLIST        = 1,
+    D3D_PRIMITIVE_TOPOLOGY_LINELIST         = 2,
+    D3D_PRIMITIVE_TOPOLOGY_LINESTRIP        = 3,
+    D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST     = 4,
+    D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP    = 5,
+};
+
+enum D3D12_CLEAR_FLAGS
+{
+    D3D12_CLEAR_FLAG_DEPTH                  = 0x1,
+    D3D12_CLEAR_FLAG_STENCIL                = 0x2,
+};
+
+enum D3D12_RESOURCE_STATES
+{
+    D3D12_RESOURCE_STATE_COMMON                         = 0,
+    D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER     = 0x1,
+    D3D12_RESOURCE_STATE_INDEX_BUFFER                   = 0x2,
+    D3D12_RESOURCE_STATE_RENDER_TARGET                  = 0x4,
+    D3D12_RESOURCE_STATE_UNORDERED_ACCESS               = 0x8,
+    D3D12_RESOURCE_STATE_DEPTH_WRITE                    = 0x10,
+    D3D12_RESOURCE_STATE_DEPTH_READ                     = 0x20,
+    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE      = 0x40,
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE          = 0x80,
+    D3D12_RESOURCE_STATE_STREAM_OUT                     = 0x100,
+    D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT              = 0x200,
+    D3D12_RESOURCE_STATE_COPY_DEST                      = 0x400,
+    D3D12_RESOURCE_STATE_COPY_SOURCE                    = 0x800,
+    D3D12_RESOURCE_STATE_RESOLVE_DEST                   = 0x1000,
+    D3D12_RESOURCE_STATE_RESOLVE_SOURCE                 = 0x2000,
+    D3D12_RESOURCE_STATE_GENERIC_READ                   = 0x1 | 0x2 | 0x40 | 0x80 | 0x200 | 0x800,
+    D3D12_RESOURCE_STATE_PRESENT                        = 0,
+};
+
+enum D3D12_RESOURCE_BARRIER_TYPE
+{
+    D3D12_RESOURCE_BARRIER_TYPE_TRANSITION  = 0,
+    D3D12_RESOURCE_BARRIER_TYPE_ALIASING    = 1,
+    D3D12_RESOURCE_BARRIER_TYPE_UAV         = 2,
+};
+
+enum D3D12_RESOURCE_BARRIER_FLAGS
+{
+    D3D12_RESOURCE_BARRIER_FLAG_NONE        = 0,
+    D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY  = 0x1,
+    D3D12_RESOURCE_BARRIER_FLAG_END_ONLY    = 0x2,
+};
+
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ( 0xffffffff )
+
+struct D3D12_CPU_DESCRIPTOR_HANDLE  { size_t ptr; };
+struct D3D12_GPU_DESCRIPTOR_HANDLE  { uint64_t ptr; };
+
+struct D3D12_VIEWPORT
+{
+    float   TopLeftX;
+    float   TopLeftY;
+    float   Width;
+    float   Height;
+    float   MinDepth;
+    float   MaxDepth;
+};
+
+struct D3D12_RECT
+{
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+};
+
+struct D3D12_VERTEX_BUFFER_VIEW
+{
+    D3D12_GPU_VIRTUAL_ADDRESS   BufferLocation;
+    uint32_t                    SizeInBytes;
+    uint32_t                    StrideInBytes;
+};
+
+struct D3D12_INDEX_BUFFER_VIEW
+{
+    D3D12_GPU_VIRTUAL_ADDRESS   BufferLocation;
+    uint32_t                    SizeInBytes;
+    DXGI_FORMAT                 Format;
+};
+
+struct D3D12_RESOURCE_TRANSITION_BARRIER
+{
+    ID3D12Resource*         pResource;
+    uint32_t                Subresource;
+    D3D12_RESOURCE_STATES   StateBefore;
+    D3D12_RESOURCE_STATES   StateAfter;
+};
+
+struct D3D12_RESOURCE_ALIASING_BARRIER
+{
+    ID3D12Resource*         pResourceBefore;
+    ID3D12Resource*         pResourceAfter;
+};
+
+struct D3D12_RESOURCE_UAV_BARRIER
+{
+    ID3D12Resource*         pResource;
+};
+
+struct D3D12_RESOURCE_BARRIER
+{
+    D3D12_RESOURCE_BARRIER_TYPE     Type;
+    D3D12_RESOURCE_BARRIER_FLAGS    Flags;
+    union
+    {
+        D3D12_RESOURCE_TRANSITION_BARRIER   Transition;
+        D3D12_RESOURCE_ALIASING_BARRIER     Aliasing;
+        D3D12_RESOURCE_UAV_BARRIER          UAV;
+    };
+};
+
+enum D3D12_COMMAND_LIST_TYPE
+{
+    D3D12_COMMAND_LIST_TYPE_DIRECT          = 0,
+    D3D12_COMMAND_LIST_TYPE_BUNDLE          = 1,
+    D3D12_COMMAND_LIST_TYPE_COMPUTE         = 2,
+    D3D12_COMMAND_LIST_TYPE_COPY            = 3,
+    D3D12_COMMAND_LIST_TYPE_VIDEO_DECODE    = 4,
+    D3D12_COMMAND_LIST_TYPE_VIDEO_PROCESS   = 5,
+    D3D12_COMMAND_LIST_TYPE_VIDEO_ENCODE    = 6,
+};
+
+#endif
@@ -0,0 +1,200 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfFenceDispatcher.h
+// Desc : Fence Completion Callback Dispatcher.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <asfCommandQueue.h>
+#include <asfIndexPool.h>
+#include <asfSoftBackend.h>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+//! @brief      フェンス完了時に呼び出されるコールバックです.
+//!
+//! @param[in]      pUser       登録時に指定したユーザーデータ.
+//!                             コルーチンの継続は std::coroutine_handle<>::address() を渡し,
+//!                             from_address() で復元して resume() します.
+//-----------------------------------------------------------------------------
+using FenceCallback = void (*)(void* pUser);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FenceDispatcherDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct FenceDispatcherDesc
+{
+    uint32_t    MaxCallbacks    = 4096;     //!< 同時に登録できるコールバック数.
+    uint32_t    PollIntervalUs  = 50;       //!< ポーリングで待機する場合の確認間隔 (マイクロ秒).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FenceDispatcher class
+///////////////////////////////////////////////////////////////////////////////
+class FenceDispatcher
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    FenceDispatcher() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~FenceDispatcher();
+
+    FenceDispatcher(const FenceDispatcher&) = delete;
+    FenceDispatcher& operator = (const FenceDispatcher&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      desc        構成設定.
+    //! @retval true    初期化に成功しました.
+    //! @retval false   初期化に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(const FenceDispatcherDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //!
+    //! @note       完了していないコールバックは呼び出されずに破棄されます.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      フェンスが指定された値に達したときに呼び出すコールバックを登録します.
+    //!
+    //! @details    任意のスレッドから呼び出せます. 事前に確保したプールからロックフリーで
+    //!             取得するため, ヒープ確保は発生しません. コールバックはディスパッチスレッドで
+    //!             フェンスごとに値の昇順でまとめて呼び出されます. 同じ待機点のコールバックは
+    //!             登録順に呼び出されます. 登録時点で完了している場合もディスパッチスレッドで呼び出されます.
+    //!
+    //! @param[in]      point       待機点. pFence に nullptr は指定できません.
+    //!                             フェンスは登録が完了するまで解放しないでください.
+    //! @param[in]      callback    コールバック.
+    //! @param[in]      pUser       コールバックに渡すユーザーデータ.
+    //! @retval true    登録に成功しました.
+    //! @retval false   プールが枯渇しているか, 引数が不正です.
+    //-------------------------------------------------------------------------
+    bool Register(const WaitPoint& point, FenceCallback callback, void* pUser);
+
+    //-------------------------------------------------------------------------
+    //! @brief      呼び出したコールバック数を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetDispatchCount() const
+    { return m_DispatchCount.load(std::memory_order_relaxed); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディスパッチスレッドの起床回数を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetWakeCount() const
+    { return m_WakeCount.load(std::memory_order_relaxed); }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Node structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Node
+    {
+        IFence*                 pFence;
+        uint64_t                Value;
+        FenceCallback           Callback;
+        void*                   pUser;
+        std::atomic<uint32_t>   Next;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FenceEntry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct FenceEntry
+    {
+        IFence*     pFence;     //!< 参照を保持しています.
+        uint32_t    Head;       //!< 値の昇順に並んだノードの先頭.
+        uint32_t    Tail;       //!< 値の昇順に並んだノードの末尾.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    Node*                       m_pNodes        = nullptr;
+    uint32_t                    m_NodeCount     = 0;
+    IndexPool                   m_FreeNodes;                //!< 未使用のノード.
+    IndexStack                  m_Pending;                  //!< 登録待ちのノード (LIFO).
+    std::vector<FenceEntry>     m_Entries;                  //!< ディスパッチスレッドのみが使用します.
+    SoftFenceListener           m_Listener;
+    bool                        m_WakeRequested = false;    //!< m_Listener.Mutex で保護します.
+    uint32_t                    m_PollIntervalUs = 0;
+    std::thread                 m_Thread;
+    std::atomic<bool>           m_Running       = { false };
+    std::atomic<uint64_t>       m_DispatchCount = { 0 };
+    std::atomic<uint64_t>       m_WakeCount     = { 0 };
+    void*                       m_WakeEvent     = nullptr;
+    std::vector<void*>          m_Events;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      ノードをフェンスごとのリストに値の昇順で挿入します.
+    //-------------------------------------------------------------------------
+    void Insert(uint32_t index);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディスパッチスレッドを起床させます.
+    //-------------------------------------------------------------------------
+    void Wake();
+
+    //-------------------------------------------------------------------------
+    //! @brief      登録待ちのノードをフェンスごとのリストに移動します.
+    //-------------------------------------------------------------------------
+    void Collect();
+
+    //-------------------------------------------------------------------------
+    //! @brief      完了したコールバックを呼び出します.
+    //-------------------------------------------------------------------------
+    void Dispatch();
+
+    //-------------------------------------------------------------------------
+    //! @brief      いずれかのフェンスが完了するか, 起床要求があるまで待機します.
+    //-------------------------------------------------------------------------
+    void WaitAny();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディスパッチスレッドの処理です.
+    //-------------------------------------------------------------------------
+    void Run();
+};
+
+} // namespace asf
@@ -0,0 +1,54 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfFenceWait.h
+// Desc : Fence Wait Utilities.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <asfCommandQueue.h>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t MAX_WAIT_FENCE_COUNT = 64;   //!< WaitForFences() で一度に待機できるフェンスの最大数.
+
+//-----------------------------------------------------------------------------
+//! @brief      フェンスが指定された値に達するまでポーリングします.
+//!
+//! @details    GetCompletedValue() をpause命令によるバックオフを挟みながら確認し,
+//!             バックオフが上限に達した後はスレッドを譲りながら確認を続けます.
+//!
+//! @param[in]      pFence          フェンスです.
+//! @param[in]      fenceValue      待機カウンタ.
+//! @param[in]      timeoutUsec     タイムアウト時間(マイクロ秒). UINT64_MAX の場合は無期限です.
+//! @retval true    フェンスが指定された値に達しました.
+//! @retval false   タイムアウトしました.
+//-----------------------------------------------------------------------------
+bool PollFence(const IFence* pFence, uint64_t fenceValue, uint64_t timeoutUsec);
+
+//-----------------------------------------------------------------------------
+//! @brief      複数のフェンスが指定された値に達するまで待機します.
+//!
+//! @details    全てのフェンスがD3D12フェンスの場合は ID3D12Device1::SetEventOnMultipleFenceCompletion() を,
+//!             全てがソフトウェアフェンスの場合は共有のリスナーを使用し, 1回の待機で完了を待ちます.
+//!             それ以外の組み合わせではポーリングで待機します.
+//!             キューごとに ICommandQueue::Sync() を呼び出す場合と異なり, 起床遅延は1回分で済みます.
+//!
+//! @param[in]      count           待機点の数 (MAX_WAIT_FENCE_COUNT 以下).
+//! @param[in]      pPoints         待機点の配列です. pFence に nullptr は指定できません.
+//! @param[in]      waitAll         true の場合は全ての待機点, false の場合はいずれかの待機点の完了を待機します.
+//! @param[in]      msec            タイムアウト時間(ミリ秒). WAIT_INFINITE の場合は無期限です.
+//! @param[out]     pIndex          完了した待機点の最小のインデックスの格納先です. nullptr を指定できます.
+//! @retval true    待機条件を満たしました.
+//! @retval false   タイムアウトしたか, 引数が不正です.
+//-----------------------------------------------------------------------------
+bool WaitForFences(uint32_t count, const WaitPoint* pPoints, bool waitAll, uint32_t msec, uint32_t* pIndex = nullptr);
+
+} // namespace asf
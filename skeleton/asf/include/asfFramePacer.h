@@ -0,0 +1,169 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfFramePacer.h
+// Desc : Frame-in-flight Pacing Controller.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <asfCommandQueue.h>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 8;    //!< 先行フレーム数の上限.
+
+///////////////////////////////////////////////////////////////////////////////
+// FramePacerDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct FramePacerDesc
+{
+    ICommandQueue*  pQueue              = nullptr;  //!< フレーム終端でシグナルするキュー.
+    uint32_t        MaxFramesInFlight   = 2;        //!< GPUに対して先行できる最大フレーム数 (1 ～ MAX_FRAMES_IN_FLIGHT).
+    uint32_t        MinFramesInFlight   = 1;        //!< Adaptive が有効な場合の最小フレーム数.
+    bool            Adaptive            = false;    //!< 待機状況に応じて先行フレーム数を調整するかどうか.
+    uint32_t        AdaptWindow         = 60;       //!< 調整の判断に使用するフレーム数.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// FramePacerStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct FramePacerStats
+{
+    uint64_t    FrameCount      = 0;    //!< 終了したフレーム数.
+    uint64_t    LastWaitNs      = 0;    //!< 直前の BeginFrame() でCPUが待機した時間 (ナノ秒).
+    uint64_t    TotalWaitNs     = 0;    //!< BeginFrame() でCPUが待機した時間の合計 (ナノ秒).
+    uint64_t    WaitCount       = 0;    //!< BeginFrame() で待機したフレーム数.
+    uint64_t    StarveCount     = 0;    //!< GPUが前フレームまでの処理を終えて待機していたフレーム数.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FramePacer class
+///////////////////////////////////////////////////////////////////////////////
+class FramePacer
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    FramePacer() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator = (const FramePacer&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      desc        構成設定.
+    //! @retval true    初期化に成功しました.
+    //! @retval false   初期化に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(const FramePacerDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います. GPUの完了を待機します.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      フレームを開始します.
+    //!
+    //! @details    CPUが先行フレーム数を超えてGPUより先行している場合のみ,
+    //!             先行フレーム数前のフレームが完了するまで待機します.
+    //!
+    //! @return     このフレームで使用するリソースのインデックス (0 ～ MaxFramesInFlight - 1) を返却します.
+    //!             返却したインデックスを前回使用したフレームはGPUで完了しています.
+    //-------------------------------------------------------------------------
+    uint32_t BeginFrame();
+
+    //-------------------------------------------------------------------------
+    //! @brief      フレームを終了します. キューにシグナルを発行します.
+    //!
+    //! @return     このフレームの待機点を返却します.
+    //-------------------------------------------------------------------------
+    WaitPoint EndFrame();
+
+    //-------------------------------------------------------------------------
+    //! @brief      発行済みの全てのフレームが完了するまで待機します.
+    //-------------------------------------------------------------------------
+    void WaitIdle();
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定したリソースインデックスを最後に使用したフレームの待機点を取得します.
+    //!
+    //! @param[in]      index       BeginFrame() が返却したインデックス.
+    //-------------------------------------------------------------------------
+    WaitPoint GetFrameWaitPoint(uint32_t index) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      現在の先行フレーム数を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetFramesInFlight() const
+    { return m_FramesInFlight; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    const FramePacerStats& GetStats() const
+    { return m_Stats; }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    ICommandQueue*      m_pQueue            = nullptr;
+    WaitPoint           m_Frames[MAX_FRAMES_IN_FLIGHT];
+    uint32_t            m_MaxFramesInFlight = 0;
+    uint32_t            m_MinFramesInFlight = 0;
+    uint32_t            m_FramesInFlight    = 0;
+    bool                m_Adaptive          = false;
+    uint32_t            m_AdaptWindow       = 0;
+    uint64_t            m_FrameNumber       = 0;
+    bool                m_InFrame           = false;
+    uint64_t            m_BeginTime         = 0;
+    FramePacerStats     m_Stats;
+
+    // 調整用の集計 (AdaptWindow フレームごとにリセット).
+    uint32_t            m_WindowFrames      = 0;
+    uint32_t            m_WindowWaits       = 0;
+    uint32_t            m_WindowStarves     = 0;
+    uint64_t            m_WindowWorkNs      = 0;
+    uint64_t            m_WindowPeriodNs    = 0;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      先行フレーム数を調整します.
+    //-------------------------------------------------------------------------
+    void Adapt();
+};
+
+} // namespace asf
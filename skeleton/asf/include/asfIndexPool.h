@@ -0,0 +1,184 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfIndexPool.h
+// Desc : Lock-free Node Index Pool and Pending Stack.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t INVALID_NODE_INDEX = 0xFFFFFFFF;  //!< 無効なノード番号.
+
+///////////////////////////////////////////////////////////////////////////////
+// IndexPool class
+///////////////////////////////////////////////////////////////////////////////
+//! @brief      ノード配列の未使用番号を管理するロックフリーのフリーリストです.
+//!
+//! @details    FenceDispatcher, SubmitThread の内部で使用します.
+//!             ノードは std::atomic<uint32_t> 型の Next メンバーを持つ必要があり,
+//!             取得したノードの Next は返却するまで自由に使用できます.
+///////////////////////////////////////////////////////////////////////////////
+class IndexPool
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      全てのノードを未使用として連結します.
+    //!
+    //! @param[in]      pNodes      ノード配列.
+    //! @param[in]      count       ノード数. INVALID_NODE_INDEX 未満である必要があります.
+    //-------------------------------------------------------------------------
+    template<typename Node>
+    void Init(Node* pNodes, uint32_t count)
+    {
+        for(auto i=0u; i<count; ++i)
+        { pNodes[i].Next.store((i + 1 < count) ? i + 1 : INVALID_NODE_INDEX, std::memory_order_relaxed); }
+
+        m_Head.store((count > 0) ? 0 : INVALID_NODE_INDEX, std::memory_order_relaxed);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      未使用のノードを取得します.
+    //!
+    //! @return     ノード番号を返却します. 空の場合は INVALID_NODE_INDEX を返却します.
+    //-------------------------------------------------------------------------
+    template<typename Node>
+    uint32_t Alloc(Node* pNodes)
+    {
+        auto head = m_Head.load(std::memory_order_acquire);
+        for(;;)
+        {
+            auto index = uint32_t(head & 0xFFFFFFFF);
+            if (index == INVALID_NODE_INDEX)
+            { return INVALID_NODE_INDEX; }
+
+            // 取得と返却が入れ違ってもタグが変わるため, 古い Next で更新されることはない.
+            auto next    = pNodes[index].Next.load(std::memory_order_relaxed);
+            auto newHead = ((head >> 32) + 1) << 32 | next;
+            if (m_Head.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire))
+            { return index; }
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ノードを返却します.
+    //-------------------------------------------------------------------------
+    template<typename Node>
+    void Free(Node* pNodes, uint32_t index)
+    {
+        auto head = m_Head.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            pNodes[index].Next.store(uint32_t(head & 0xFFFFFFFF), std::memory_order_relaxed);
+            auto newHead = ((head >> 32) + 1) << 32 | index;
+            if (m_Head.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed))
+            { return; }
+        }
+    }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::atomic<uint64_t>   m_Head  = { INVALID_NODE_INDEX };   //!< 下位32bit: ノード番号, 上位32bit: ABA対策のタグ.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    /* NOTHING */
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// IndexStack class
+///////////////////////////////////////////////////////////////////////////////
+//! @brief      複数スレッドから積み, 1スレッドがまとめて取り出すロックフリーのスタックです.
+//!
+//! @details    FenceDispatcher, SubmitThread の内部で使用します.
+//!             積んだノードは Next で LIFO 順に連結されます.
+///////////////////////////////////////////////////////////////////////////////
+class IndexStack
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      空にします.
+    //-------------------------------------------------------------------------
+    void Reset()
+    { m_Head.store(INVALID_NODE_INDEX, std::memory_order_relaxed); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ノードを積みます. 複数スレッドから呼び出せます.
+    //!
+    //! @retval true    空のスタックに積みました. 取り出し側の起床が必要です.
+    //! @retval false   既にノードが積まれていました.
+    //-------------------------------------------------------------------------
+    template<typename Node>
+    bool Push(Node* pNodes, uint32_t index)
+    {
+        auto head = m_Head.load(std::memory_order_relaxed);
+        do
+        {
+            pNodes[index].Next.store(head, std::memory_order_relaxed);
+        }
+        while(!m_Head.compare_exchange_weak(head, index, std::memory_order_release, std::memory_order_relaxed));
+
+        return head == INVALID_NODE_INDEX;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      積まれている全てのノードを取り出します.
+    //!
+    //! @return     最後に積まれたノード番号を返却します. 以降は Next で積まれた逆順に連結されています.
+    //-------------------------------------------------------------------------
+    uint32_t Steal()
+    { return m_Head.exchange(INVALID_NODE_INDEX, std::memory_order_acquire); }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::atomic<uint32_t>   m_Head  = { INVALID_NODE_INDEX };   //!< 最後に積まれたノード番号.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    /* NOTHING */
+};
+
+} // namespace asf
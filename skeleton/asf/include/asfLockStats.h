@@ -0,0 +1,157 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfLockStats.h
+// Desc : Lock Contention Statistics.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <asfTime.h>
+
+
+namespace asf {
+
+// 前方宣言.
+struct ILogger;
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t LOCK_STATS_HISTOGRAM_COUNT = 24;  //!< 待機時間ヒストグラムのビン数.
+
+///////////////////////////////////////////////////////////////////////////////
+// LockStatsSnapshot structure
+///////////////////////////////////////////////////////////////////////////////
+struct LockStatsSnapshot
+{
+    const char* Name                  = nullptr;    //!< ロック名.
+    uint64_t    Acquisitions          = 0;          //!< ロック取得回数.
+    uint64_t    ContendedAcquisitions = 0;          //!< 競合が発生したロック取得回数.
+    uint64_t    SpinCount             = 0;          //!< 総スピン回数.
+    uint64_t    WaitTimeNs            = 0;          //!< 総待機時間 (ナノ秒).
+
+    //! 競合時の待機時間ヒストグラム.
+    //! ビン0 は 2マイクロ秒未満, ビン i は [2^i, 2^(i+1)) マイクロ秒, 最後のビンはそれ以上.
+    uint64_t    Histogram[LOCK_STATS_HISTOGRAM_COUNT] = {};
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LockStats class
+///////////////////////////////////////////////////////////////////////////////
+class LockStats
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    friend class LockStatsRegistry;
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです. グローバルレジストリに登録されます.
+    //!
+    //! @param[in]      name        ロック名. 文字列の寿命はロックより長くしてください.
+    //-------------------------------------------------------------------------
+    explicit LockStats(const char* name);
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです. グローバルレジストリから登録解除されます.
+    //-------------------------------------------------------------------------
+    ~LockStats();
+
+    LockStats(const LockStats&) = delete;
+    LockStats& operator = (const LockStats&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      競合なしのロック取得を記録します.
+    //-------------------------------------------------------------------------
+    void RecordUncontended()
+    { m_Acquisitions.fetch_add(1, std::memory_order_relaxed); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      競合ありのロック取得を記録します.
+    //!
+    //! @param[in]      spinCount   スピン回数.
+    //! @param[in]      waitTimeNs  待機時間 (ナノ秒).
+    //-------------------------------------------------------------------------
+    void RecordContended(uint64_t spinCount, uint64_t waitTimeNs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //!
+    //! @param[out]     result      統計情報の格納先.
+    //-------------------------------------------------------------------------
+    void GetSnapshot(LockStatsSnapshot& result) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報をリセットします.
+    //-------------------------------------------------------------------------
+    void Reset();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ロック名を取得します.
+    //-------------------------------------------------------------------------
+    const char* GetName() const
+    { return m_pName; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      待機時間計測用の現在時刻を取得します.
+    //!
+    //! @return     現在時刻をナノ秒単位で返却します.
+    //-------------------------------------------------------------------------
+    static uint64_t Now()
+    { return GetSteadyTimeNs(); }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    const char*             m_pName = nullptr;
+    std::atomic<uint64_t>   m_Acquisitions          = { 0 };
+    std::atomic<uint64_t>   m_ContendedAcquisitions = { 0 };
+    std::atomic<uint64_t>   m_SpinCount             = { 0 };
+    std::atomic<uint64_t>   m_WaitTimeNs            = { 0 };
+    std::atomic<uint64_t>   m_Histogram[LOCK_STATS_HISTOGRAM_COUNT];
+    LockStats*              m_pPrev = nullptr;
+    LockStats*              m_pNext = nullptr;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    /* NOTHING */
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      登録されている全ロックの統計情報を取得します.
+//!
+//! @param[out]     result      統計情報の格納先.
+//-----------------------------------------------------------------------------
+void SampleLockStats(std::vector<LockStatsSnapshot>& result);
+
+//-----------------------------------------------------------------------------
+//! @brief      登録されている全ロックの統計情報をリセットします.
+//-----------------------------------------------------------------------------
+void ResetLockStats();
+
+//-----------------------------------------------------------------------------
+//! @brief      登録されている全ロックの統計情報をログに出力します.
+//!
+//! @param[in]      pLogger     出力先ロガー. nullptr の場合は GetLogger() のロガーに出力します.
+//-----------------------------------------------------------------------------
+void DumpLockStats(ILogger* pLogger = nullptr);
+
+} // namespace asf
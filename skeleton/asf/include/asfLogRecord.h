@@ -0,0 +1,264 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfLogRecord.h
+// Desc : Deferred-formatting Binary Log Record.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <type_traits>
+#include <asfLogger.h>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t LOG_RECORD_ARGS_SIZE  = 512;          //!< 1レコードの引数の最大バイト数.
+static constexpr uint32_t LOG_FILE_MAGIC        = 0x4C465341;   //!< バイナリログファイルの識別子 ('ASFL').
+static constexpr uint32_t LOG_FILE_VERSION      = 1;            //!< バイナリログファイルのバージョン.
+
+///////////////////////////////////////////////////////////////////////////////
+// LOG_SITE_FLAG enum
+///////////////////////////////////////////////////////////////////////////////
+enum LOG_SITE_FLAG : uint32_t
+{
+    LOG_SITE_FLAG_NONE      = 0,
+    LOG_SITE_FLAG_LOCATION  = 0x1,  //!< "[File: %s, Line: %d] " を先頭に付加します.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// LOG_ARG_TYPE enum
+///////////////////////////////////////////////////////////////////////////////
+enum LOG_ARG_TYPE : uint8_t
+{
+    LOG_ARG_INT = 1,    //!< int64_t.
+    LOG_ARG_UINT,       //!< uint64_t.
+    LOG_ARG_DOUBLE,     //!< double.
+    LOG_ARG_STRING,     //!< uint16_t 長さ + 文字列 + 終端文字.
+    LOG_ARG_WSTRING,    //!< uint16_t 長さ + UTF-32 文字列.
+    LOG_ARG_POINTER,    //!< uint64_t.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// LOG_FILE_CHUNK enum
+///////////////////////////////////////////////////////////////////////////////
+enum LOG_FILE_CHUNK : uint8_t
+{
+    LOG_FILE_CHUNK_SITE   = 1,  //!< 呼び出し元の定義 (id, level, line, flags, file, format).
+    LOG_FILE_CHUNK_RECORD = 2,  //!< ログレコード (id, timestamp, args).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LogSite structure
+///////////////////////////////////////////////////////////////////////////////
+struct LogSite
+{
+    LOG_LEVEL               Level;      //!< ログレベル.
+    const char*             Format;     //!< フォーマット文字列.
+    const char*             File;       //!< ファイル名.
+    int                     Line;       //!< 行番号.
+    uint32_t                Flags;      //!< LOG_SITE_FLAG の組み合わせ.
+    std::atomic<uint32_t>   Id;         //!< 識別番号 (0 の場合は未登録).
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //!
+    //! @note       定数初期化されるため, 関数内 static として宣言しても初期化ガードは発生しません.
+    //-------------------------------------------------------------------------
+    constexpr LogSite(LOG_LEVEL level, const char* format, const char* file, int line, uint32_t flags)
+    : Level (level)
+    , Format(format)
+    , File  (file)
+    , Line  (line)
+    , Flags (flags)
+    , Id    (0)
+    { /* DO_NOTHING */ }
+
+    LogSite(const LogSite&) = delete;
+    LogSite& operator = (const LogSite&) = delete;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LogArgBuffer structure
+///////////////////////////////////////////////////////////////////////////////
+struct LogArgBuffer
+{
+    uint8_t     Data[LOG_RECORD_ARGS_SIZE];     //!< エンコード済みの引数.
+    uint32_t    Size = 0;                       //!< 使用バイト数.
+
+    //-------------------------------------------------------------------------
+    //! @brief      値を追加します. 容量を超える場合は破棄されます.
+    //-------------------------------------------------------------------------
+    bool Put(const void* pData, size_t size)
+    {
+        if (Size + size > LOG_RECORD_ARGS_SIZE)
+        { return false; }
+
+        memcpy(Data + Size, pData, size);
+        Size += uint32_t(size);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      型タグと値を追加します.
+    //-------------------------------------------------------------------------
+    template<typename T>
+    void PutValue(LOG_ARG_TYPE type, T value)
+    {
+        if (Size + 1 + sizeof(T) > LOG_RECORD_ARGS_SIZE)
+        { return; }
+
+        Data[Size++] = type;
+        memcpy(Data + Size, &value, sizeof(T));
+        Size += uint32_t(sizeof(T));
+    }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ILogRecordWriter interface
+///////////////////////////////////////////////////////////////////////////////
+struct ILogRecordWriter
+{
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    virtual ~ILogRecordWriter() {}
+
+    //-------------------------------------------------------------------------
+    //! @brief      ログレコードを書き込みます.
+    //!
+    //! @param[in]      site        呼び出し元.
+    //! @param[in]      timestamp   タイムスタンプ (ナノ秒).
+    //! @param[in]      pArgs       エンコード済みの引数.
+    //! @param[in]      argSize     引数のバイト数.
+    //-------------------------------------------------------------------------
+    virtual void WriteRecord(const LogSite& site, uint64_t timestamp, const void* pArgs, uint32_t argSize) = 0;
+};
+
+//-----------------------------------------------------------------------------
+// Argument Encoders.
+//-----------------------------------------------------------------------------
+inline void EncodeLogArg(LogArgBuffer& buffer, bool               value) { buffer.PutValue(LOG_ARG_INT,    int64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, char               value) { buffer.PutValue(LOG_ARG_INT,    int64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, signed char        value) { buffer.PutValue(LOG_ARG_INT,    int64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, unsigned char      value) { buffer.PutValue(LOG_ARG_UINT,   uint64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, short              value) { buffer.PutValue(LOG_ARG_INT,    int64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, unsigned short     value) { buffer.PutValue(LOG_ARG_UINT,   uint64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, int                value) { buffer.PutValue(LOG_ARG_INT,    int64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, unsigned int       value) { buffer.PutValue(LOG_ARG_UINT,   uint64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, long               value) { buffer.PutValue(LOG_ARG_INT,    int64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, unsigned long      value) { buffer.PutValue(LOG_ARG_UINT,   uint64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, long long          value) { buffer.PutValue(LOG_ARG_INT,    int64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, unsigned long long value) { buffer.PutValue(LOG_ARG_UINT,   uint64_t(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, float              value) { buffer.PutValue(LOG_ARG_DOUBLE, double(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, double             value) { buffer.PutValue(LOG_ARG_DOUBLE, value); }
+inline void EncodeLogArg(LogArgBuffer& buffer, long double        value) { buffer.PutValue(LOG_ARG_DOUBLE, double(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, std::nullptr_t          ) { buffer.PutValue(LOG_ARG_POINTER, uint64_t(0)); }
+
+void EncodeLogArg(LogArgBuffer& buffer, wchar_t        value);
+void EncodeLogArg(LogArgBuffer& buffer, const char*    value);
+void EncodeLogArg(LogArgBuffer& buffer, const wchar_t* value);
+
+inline void EncodeLogArg(LogArgBuffer& buffer, char*    value) { EncodeLogArg(buffer, static_cast<const char*>(value)); }
+inline void EncodeLogArg(LogArgBuffer& buffer, wchar_t* value) { EncodeLogArg(buffer, static_cast<const wchar_t*>(value)); }
+
+template<typename T>
+inline void EncodeLogArg(LogArgBuffer& buffer, T* value)
+{ buffer.PutValue(LOG_ARG_POINTER, uint64_t(reinterpret_cast<uintptr_t>(value))); }
+
+template<typename T>
+inline typename std::enable_if<std::is_enum<T>::value>::type EncodeLogArg(LogArgBuffer& buffer, T value)
+{ EncodeLogArg(buffer, static_cast<typename std::underlying_type<T>::type>(value)); }
+
+//-----------------------------------------------------------------------------
+//! @brief      呼び出し元を登録し, 識別番号を取得します.
+//!
+//! @param[in]      site        呼び出し元.
+//! @return     識別番号を返却します.
+//-----------------------------------------------------------------------------
+uint32_t RegisterLogSite(LogSite& site);
+
+//-----------------------------------------------------------------------------
+//! @brief      エンコード済みの引数でログレコードを送信します.
+//!
+//! @details    ログレコードライターが設定されていない場合は,
+//!             その場でフォーマットしてデフォルトロガーに出力します.
+//-----------------------------------------------------------------------------
+void SubmitLogRecord(LogSite& site, const LogArgBuffer& args);
+
+//-----------------------------------------------------------------------------
+//! @brief      ログレコードを書き込みます.
+//!
+//! @details    引数は型タグ付きの生データとしてコピーされ, フォーマットは行いません.
+//!             フォーマットはログレコードライター側, またはデコーダで行います.
+//-----------------------------------------------------------------------------
+template<typename... Args>
+inline void WriteLogRecord(LogSite& site, const Args&... args)
+{
+    LogArgBuffer buffer;
+    int dummy[] = { 0, (EncodeLogArg(buffer, args), 0)... };
+    (void)dummy;
+    SubmitLogRecord(site, buffer);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief      ログレコードライターを設定します.
+//!
+//! @param[in]      pWriter     ログレコードライター. nullptr の場合は同期出力に戻ります.
+//-----------------------------------------------------------------------------
+void SetLogRecordWriter(ILogRecordWriter* pWriter);
+
+//-----------------------------------------------------------------------------
+//! @brief      ログレコードライターを取得します.
+//-----------------------------------------------------------------------------
+ILogRecordWriter* GetLogRecordWriter();
+
+//-----------------------------------------------------------------------------
+//! @brief      エンコード済みの引数を使ってフォーマットします.
+//!
+//! @param[in]      format      フォーマット文字列.
+//! @param[in]      pArgs       エンコード済みの引数.
+//! @param[in]      argSize     引数のバイト数.
+//! @param[out]     buffer      出力先.
+//! @param[in]      bufferSize  出力先のバイト数.
+//! @return     出力した文字数を返却します (終端文字を除く).
+//-----------------------------------------------------------------------------
+size_t FormatLogArgs(const char* format, const void* pArgs, uint32_t argSize, char* buffer, size_t bufferSize);
+
+//-----------------------------------------------------------------------------
+//! @brief      ログレコードをフォーマットします.
+//!
+//! @param[in]      format      フォーマット文字列.
+//! @param[in]      file        ファイル名.
+//! @param[in]      line        行番号.
+//! @param[in]      flags       LOG_SITE_FLAG の組み合わせ.
+//! @param[in]      pArgs       エンコード済みの引数.
+//! @param[in]      argSize     引数のバイト数.
+//! @param[out]     buffer      出力先.
+//! @param[in]      bufferSize  出力先のバイト数.
+//! @return     出力した文字数を返却します (終端文字を除く).
+//-----------------------------------------------------------------------------
+size_t FormatLogRecord
+(
+    const char* format,
+    const char* file,
+    int         line,
+    uint32_t    flags,
+    const void* pArgs,
+    uint32_t    argSize,
+    char*       buffer,
+    size_t      bufferSize
+);
+
+} // namespace asf
@@ -5,6 +5,12 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+
 
 namespace asf {
 
@@ -20,6 +26,19 @@ enum LOG_LEVEL
     LOG_ERROR,                //!< ERRORレベル   (赤).
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// LOG_CATEGORY enum
+///////////////////////////////////////////////////////////////////////////////
+enum LOG_CATEGORY
+{
+    LOG_CATEGORY_GENERAL = 0,   //!< 汎用.
+    LOG_CATEGORY_GRAPHICS,      //!< デバイス, コマンドキュー, フェンスなど.
+    LOG_CATEGORY_RESOURCE,      //!< テクスチャ, バッファ, ディスクリプタなど.
+    LOG_CATEGORY_THREAD,        //!< スレッド, 同期オブジェクトなど.
+    LOG_CATEGORY_APP,           //!< アプリケーション.
+    LOG_CATEGORY_COUNT,
+};
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // ILogger interface
@@ -50,9 +69,124 @@ struct ILogger
 
 //-----------------------------------------------------------------------------
 //! @brief      デフォルトロガーを取得します.
+//!
+//! @details    標準出力に同期出力する組み込みのロガーです. SetLogger() の設定に関わらず常に同じロガーを返却するため,
+//!             AsyncLogger などの出力先として使用できます.
 //-----------------------------------------------------------------------------
 ILogger* GetDefaultLogger();
 
+//-----------------------------------------------------------------------------
+//! @brief      ログマクロが使用するロガーを設定します.
+//!
+//! @details    設定したロガーは SetLogger(nullptr) で解除するまで破棄しないでください.
+//!
+//! @param[in]      pLogger     ロガー. nullptr の場合はデフォルトロガーに戻ります.
+//-----------------------------------------------------------------------------
+void SetLogger(ILogger* pLogger);
+
+//-----------------------------------------------------------------------------
+//! @brief      ログマクロが使用するロガーを取得します.
+//!
+//! @return     SetLogger() で設定したロガーを返却します. 未設定の場合はデフォルトロガーを返却します.
+//-----------------------------------------------------------------------------
+ILogger* GetLogger();
+
+///////////////////////////////////////////////////////////////////////////////
+// LogLimiter structure
+///////////////////////////////////////////////////////////////////////////////
+struct LogLimiter
+{
+    uint32_t                Burst;          //!< 1区間で出力する最大数.
+    uint64_t                IntervalNs;     //!< 区間の長さ (ナノ秒).
+    std::atomic<uint64_t>   WindowStart;    //!< 現在の区間の開始時刻 (ナノ秒).
+    std::atomic<uint32_t>   Count;          //!< 現在の区間での呼び出し数.
+    std::atomic<uint64_t>   Suppressed;     //!< 前回の報告以降に抑制した数.
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //!
+    //! @note       定数初期化されるため, 関数内 static として宣言してもメモリ確保や初期化ガードは発生しません.
+    //-------------------------------------------------------------------------
+    constexpr LogLimiter(uint32_t burst, uint32_t intervalMs)
+    : Burst      (burst)
+    , IntervalNs (uint64_t(intervalMs) * 1000000)
+    , WindowStart(0)
+    , Count      (0)
+    , Suppressed (0)
+    { /* DO_NOTHING */ }
+
+    LogLimiter(const LogLimiter&) = delete;
+    LogLimiter& operator = (const LogLimiter&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      出力可否を判定します.
+    //!
+    //! @details    区間が切り替わった場合は, 前の区間で抑制した数と経過時間を返却します.
+    //!             区間の切り替わりと同時に呼び出された場合は Burst をわずかに超えることがあります.
+    //!
+    //! @param[out]     suppressed  抑制した数 (報告不要の場合は 0).
+    //! @param[out]     elapsedNs   抑制した数を集計した時間 (ナノ秒).
+    //! @retval true    出力してください.
+    //! @retval false   抑制されました.
+    //-------------------------------------------------------------------------
+    bool Acquire(uint64_t& suppressed, uint64_t& elapsedNs);
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      抑制したログの件数を出力します.
+//!
+//! @param[in]      level       ログレベルです.
+//! @param[in]      file        ファイル名です.
+//! @param[in]      line        行番号です.
+//! @param[in]      format      抑制したログのフォーマットです.
+//! @param[in]      count       抑制した数です.
+//! @param[in]      elapsedNs   集計した時間 (ナノ秒) です.
+//-----------------------------------------------------------------------------
+void ReportSuppressedLog(LOG_LEVEL level, const char* file, int line, const char* format, uint64_t count, uint64_t elapsedNs);
+
+//-----------------------------------------------------------------------------
+//! @brief      抑制したログの件数を出力します.
+//-----------------------------------------------------------------------------
+void ReportSuppressedLog(LOG_LEVEL level, const wchar_t* file, int line, const wchar_t* format, uint64_t count, uint64_t elapsedNs);
+
+//-----------------------------------------------------------------------------
+// Global Variables.
+//-----------------------------------------------------------------------------
+//! カテゴリ別の出力ログレベル. IsLogEnabled() からインライン参照するため公開しています.
+//! 変更は SetLogLevel() で行ってください.
+extern std::atomic<int> g_LogLevels[LOG_CATEGORY_COUNT];
+
+//-----------------------------------------------------------------------------
+//! @brief      ログが出力対象かどうかを判定します.
+//!
+//! @param[in]      category    カテゴリです.
+//! @param[in]      level       ログレベルです.
+//! @retval true    出力対象です.
+//! @retval false   出力対象外です.
+//-----------------------------------------------------------------------------
+inline bool IsLogEnabled(LOG_CATEGORY category, LOG_LEVEL level)
+{ return int(level) >= g_LogLevels[category].load(std::memory_order_relaxed); }
+
+//-----------------------------------------------------------------------------
+//! @brief      カテゴリの出力ログレベルを設定します.
+//!
+//! @param[in]      category    カテゴリです.
+//! @param[in]      level       このレベル以上のログのみ出力されます.
+//-----------------------------------------------------------------------------
+void SetLogLevel(LOG_CATEGORY category, LOG_LEVEL level);
+
+//-----------------------------------------------------------------------------
+//! @brief      全カテゴリの出力ログレベルを設定します.
+//!
+//! @param[in]      level       このレベル以上のログのみ出力されます.
+//-----------------------------------------------------------------------------
+void SetLogLevel(LOG_LEVEL level);
+
+//-----------------------------------------------------------------------------
+//! @brief      カテゴリの出力ログレベルを取得します.
+//-----------------------------------------------------------------------------
+LOG_LEVEL GetLogLevel(LOG_CATEGORY category);
+
 } // namespace asf
 
 
@@ -67,64 +201,244 @@ ILogger* GetDefaultLogger();
 #define ASF_WIDE( _string )        __ASF_WIDE( _string )
 #endif//ASF_WIDE
 
-#ifndef DLOGA
-  #if defined(DEBUG) || defined(_DEBUG)
-    #define DLOGA( fmt, ... )      asf::GetDefaultLogger()->WriteA( asf::LOG_DEBUG, "[File: %s, Line: %d] "fmt"\n", __FILE__, __LINE__, ##__VA_ARGS__ )
-  #else
-    #define DLOGA( fmt, ... )      ((void)0)
-  #endif//defined(DEBUG) || defined(_DEBUG)
-#endif//DLOGA
-
-#ifndef DLOGW
-  #if defined(DEBUG) || defined(_DEBUG)
-    #define DLOGW( fmt, ... )      asf::GetDefaultLogger()->WriteW( asf::LOG_DEBUG, ASDX_WIDE("[File: %s, Line: %d] ") ASF_WIDE(fmt) ASF_WIDE("\n"), ASF_WIDE(__FILE__), __LINE__, ##__VA_ARGS__ )
-  #else
-    #define DLOGW( fmt, ... )      ((void)0)
-  #endif//defined(DEBUG) || defined(_DEBUG)
-#endif//DLOGW
-
-#ifndef VLOGA
-#define VLOGA( fmt, ... )   asf::GetDefaultLogger()->WriteA( asf::LOG_VERBOSE, fmt "\n", ##__VA_ARGS__ )
-#endif//VLOGA
-
-#ifndef VLOGW
-#define VLOGW( fmt, ... )   asf::GetDefaultLogger()->WriteW( asf::LOG_VERBOSE, ASF_WIDE(fmt) ASF_WIDE("\n"), ##__VA_ARGS__ )
-#endif//VLOGW
-
-#ifndef ILOGA
-#define ILOGA( fmt, ... )   asf::GetDefaultLogger()->WriteA( asf::LOG_INFO, fmt "\n", ##__VA_ARGS__ )
-#endif//ILOGA
-
-#ifndef ILOGW
-#define ILOGW( fmt, ... )   asf::GetDefaultLogger()->WriteW( asf::LOG_INFO, ASF_WIDE(fmt) ASF_WIDE("\n"), ##__VA_ARGS__ );
-#endif//ILOGW
-
-#ifndef WLOGA
-#define WLOGA( fmt, ... )   asf::GetDefaultLogger()->WriteA( asf::LOG_WARNING, fmt "\n", ##__VA_ARGS__ )
-#endif//WLOGA
-
-#ifndef WLOGW
-#define WLOGW( fmt, ... )   asf::GetDefaultLogger()->WriteW( asf::LOG_WARNING, ASF_WIDE(fmt) ASF_WIDE("\n"), ##__VA_ARGS__ )
-#endif//WLOGW
-
-#ifndef ELOGA
-#define ELOGA( fmt, ... )   asf::GetDefaultLogger()->WriteA( asf::LOG_ERROR, "[File: %s, Line: %d] " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__ )
-#endif//ELOGA
-
-#ifndef ELOGW
-#define ELOGW( fmt, ... )   asf::GetDefaultLogger()->WriteW( asf::LOG_ERROR, ASF_WIDE("[File: %s, Line: %d] ") ASF_WIDE(fmt) ASF_WIDE("\n"), ASF_WIDE(__FILE__), __LINE__, ##__VA_ARGS__ )
-#endif//ELOGW
-
-#if defined(UNICODE) || defined(_UNICODE)
+// コンパイル時の最小ログレベル (asf::LOG_LEVEL の値). これ未満のログマクロは呼び出しごと除去されます.
+#ifndef ASF_LOG_MIN_LEVEL
+#define ASF_LOG_MIN_LEVEL           0
+#endif//ASF_LOG_MIN_LEVEL
+
+// VLOG などのカテゴリ指定なしのマクロが使用するカテゴリ. インクルード前に定義すると翻訳単位ごとに変更できます.
+#ifndef ASF_LOG_CATEGORY
+#define ASF_LOG_CATEGORY            asf::LOG_CATEGORY_GENERAL
+#endif//ASF_LOG_CATEGORY
+
+// 実行時のフィルタは分岐1つで判定し, 出力対象外の場合は引数を評価しません.
+#define ASF_LOG_ENABLED( category, level ) \
+    ( int(level) >= ASF_LOG_MIN_LEVEL && asf::IsLogEnabled( category, level ) )
+
+#if defined(ASF_ENABLE_BINARY_LOG)
+  // マルチバイト版のログはフォーマットせずに引数をバイナリのまま記録します (asfLogRecord.h 参照).
+  #include <asfLogRecord.h>
+
+  #define __ASF_LOGA( category, level, flags, fmt, ... ) \
+    do { \
+        if ( ASF_LOG_ENABLED( category, level ) ) { \
+            static asf::LogSite s_LogSite( level, fmt "\n", __FILE__, __LINE__, flags ); \
+            asf::WriteLogRecord( s_LogSite, ##__VA_ARGS__ ); \
+        } \
+    } while(0)
+
+  #define ASF_LOGA( category, level, fmt, ... ) \
+    __ASF_LOGA( category, level, asf::LOG_SITE_FLAG_NONE, fmt, ##__VA_ARGS__ )
+
+  #define ASF_LOGA_LOCATION( category, level, fmt, ... ) \
+    __ASF_LOGA( category, level, asf::LOG_SITE_FLAG_LOCATION, fmt, ##__VA_ARGS__ )
+#else
+  #define ASF_LOGA( category, level, fmt, ... ) \
+    do { \
+        if ( ASF_LOG_ENABLED( category, level ) ) \
+        { asf::GetLogger()->WriteA( level, fmt "\n", ##__VA_ARGS__ ); } \
+    } while(0)
+
+  #define ASF_LOGA_LOCATION( category, level, fmt, ... ) \
+    ASF_LOGA( category, level, "[File: %s, Line: %d] " fmt, __FILE__, __LINE__, ##__VA_ARGS__ )
+#endif//defined(ASF_ENABLE_BINARY_LOG)
+
+#define ASF_LOGW( category, level, fmt, ... ) \
+    do { \
+        if ( ASF_LOG_ENABLED( category, level ) ) \
+        { asf::GetLogger()->WriteW( level, ASF_WIDE(fmt) ASF_WIDE("\n"), ##__VA_ARGS__ ); } \
+    } while(0)
+
+#define ASF_LOGW_LOCATION( category, level, fmt, ... ) \
+    do { \
+        if ( ASF_LOG_ENABLED( category, level ) ) \
+        { asf::GetLogger()->WriteW( level, ASF_WIDE("[File: %ls, Line: %d] ") ASF_WIDE(fmt) ASF_WIDE("\n"), ASF_WIDE(__FILE__), __LINE__, ##__VA_ARGS__ ); } \
+    } while(0)
+
+// 呼び出し元ごとに intervalMs ミリ秒あたり burst 件まで出力し, 超過分は件数のみを次の区間で報告します.
+#define ASF_LOGA_LIMIT( category, level, burst, intervalMs, fmt, ... ) \
+    do { \
+        if ( ASF_LOG_ENABLED( category, level ) ) { \
+            static asf::LogLimiter s_LogLimiter( burst, intervalMs ); \
+            uint64_t suppressed_ = 0; \
+            uint64_t elapsed_    = 0; \
+            if ( s_LogLimiter.Acquire( suppressed_, elapsed_ ) ) { \
+                if ( suppressed_ > 0 ) \
+                { asf::ReportSuppressedLog( level, __FILE__, __LINE__, fmt, suppressed_, elapsed_ ); } \
+                ASF_LOGA_LOCATION( category, level, fmt, ##__VA_ARGS__ ); \
+            } \
+        } \
+    } while(0)
+
+#define ASF_LOGW_LIMIT( category, level, burst, intervalMs, fmt, ... ) \
+    do { \
+        if ( ASF_LOG_ENABLED( category, level ) ) { \
+            static asf::LogLimiter s_LogLimiter( burst, intervalMs ); \
+            uint64_t suppressed_ = 0; \
+            uint64_t elapsed_    = 0; \
+            if ( s_LogLimiter.Acquire( suppressed_, elapsed_ ) ) { \
+                if ( suppressed_ > 0 ) \
+                { asf::ReportSuppressedLog( level, ASF_WIDE(__FILE__), __LINE__, ASF_WIDE(fmt), suppressed_, elapsed_ ); } \
+                ASF_LOGW_LOCATION( category, level, fmt, ##__VA_ARGS__ ); \
+            } \
+        } \
+    } while(0)
+
+// WLOG_LIMIT, ELOG_LIMIT の既定値.
+#ifndef ASF_LOG_LIMIT_BURST
+#define ASF_LOG_LIMIT_BURST         5
+#endif//ASF_LOG_LIMIT_BURST
+
+#ifndef ASF_LOG_LIMIT_INTERVAL_MS
+#define ASF_LOG_LIMIT_INTERVAL_MS   10000
+#endif//ASF_LOG_LIMIT_INTERVAL_MS
+
+#if (defined(DEBUG) || defined(_DEBUG)) && (ASF_LOG_MIN_LEVEL <= 2)
+  #ifndef DLOGA
+  #define DLOGA( fmt, ... )   ASF_LOGA_LOCATION( ASF_LOG_CATEGORY, asf::LOG_DEBUG, fmt, ##__VA_ARGS__ )
+  #endif//DLOGA
+
+  #ifndef DLOGW
+  #define DLOGW( fmt, ... )   ASF_LOGW_LOCATION( ASF_LOG_CATEGORY, asf::LOG_DEBUG, fmt, ##__VA_ARGS__ )
+  #endif//DLOGW
+#else
+  #ifndef DLOGA
+  #define DLOGA( fmt, ... )   ((void)0)
+  #endif//DLOGA
+
+  #ifndef DLOGW
+  #define DLOGW( fmt, ... )   ((void)0)
+  #endif//DLOGW
+#endif//(defined(DEBUG) || defined(_DEBUG)) && (ASF_LOG_MIN_LEVEL <= 2)
+
+#if ASF_LOG_MIN_LEVEL <= 0
+  #ifndef VLOGA
+  #define VLOGA( fmt, ... )   ASF_LOGA( ASF_LOG_CATEGORY, asf::LOG_VERBOSE, fmt, ##__VA_ARGS__ )
+  #endif//VLOGA
+
+  #ifndef VLOGW
+  #define VLOGW( fmt, ... )   ASF_LOGW( ASF_LOG_CATEGORY, asf::LOG_VERBOSE, fmt, ##__VA_ARGS__ )
+  #endif//VLOGW
+#else
+  #ifndef VLOGA
+  #define VLOGA( fmt, ... )   ((void)0)
+  #endif//VLOGA
+
+  #ifndef VLOGW
+  #define VLOGW( fmt, ... )   ((void)0)
+  #endif//VLOGW
+#endif//ASF_LOG_MIN_LEVEL <= 0
+
+#if ASF_LOG_MIN_LEVEL <= 1
+  #ifndef ILOGA
+  #define ILOGA( fmt, ... )   ASF_LOGA( ASF_LOG_CATEGORY, asf::LOG_INFO, fmt, ##__VA_ARGS__ )
+  #endif//ILOGA
+
+  #ifndef ILOGW
+  #define ILOGW( fmt, ... )   ASF_LOGW( ASF_LOG_CATEGORY, asf::LOG_INFO, fmt, ##__VA_ARGS__ )
+  #endif//ILOGW
+#else
+  #ifndef ILOGA
+  #define ILOGA( fmt, ... )   ((void)0)
+  #endif//ILOGA
+
+  #ifndef ILOGW
+  #define ILOGW( fmt, ... )   ((void)0)
+  #endif//ILOGW
+#endif//ASF_LOG_MIN_LEVEL <= 1
+
+#if ASF_LOG_MIN_LEVEL <= 3
+  #ifndef WLOGA
+  #define WLOGA( fmt, ... )   ASF_LOGA( ASF_LOG_CATEGORY, asf::LOG_WARNING, fmt, ##__VA_ARGS__ )
+  #endif//WLOGA
+
+  #ifndef WLOGW
+  #define WLOGW( fmt, ... )   ASF_LOGW( ASF_LOG_CATEGORY, asf::LOG_WARNING, fmt, ##__VA_ARGS__ )
+  #endif//WLOGW
+
+  #ifndef WLOGA_LIMIT
+  #define WLOGA_LIMIT( fmt, ... )   ASF_LOGA_LIMIT( ASF_LOG_CATEGORY, asf::LOG_WARNING, ASF_LOG_LIMIT_BURST, ASF_LOG_LIMIT_INTERVAL_MS, fmt, ##__VA_ARGS__ )
+  #endif//WLOGA_LIMIT
+
+  #ifndef WLOGW_LIMIT
+  #define WLOGW_LIMIT( fmt, ... )   ASF_LOGW_LIMIT( ASF_LOG_CATEGORY, asf::LOG_WARNING, ASF_LOG_LIMIT_BURST, ASF_LOG_LIMIT_INTERVAL_MS, fmt, ##__VA_ARGS__ )
+  #endif//WLOGW_LIMIT
+#else
+  #ifndef WLOGA
+  #define WLOGA( fmt, ... )   ((void)0)
+  #endif//WLOGA
+
+  #ifndef WLOGW
+  #define WLOGW( fmt, ... )   ((void)0)
+  #endif//WLOGW
+
+  #ifndef WLOGA_LIMIT
+  #define WLOGA_LIMIT( fmt, ... )   ((void)0)
+  #endif//WLOGA_LIMIT
+
+  #ifndef WLOGW_LIMIT
+  #define WLOGW_LIMIT( fmt, ... )   ((void)0)
+  #endif//WLOGW_LIMIT
+#endif//ASF_LOG_MIN_LEVEL <= 3
+
+#if ASF_LOG_MIN_LEVEL <= 4
+  #ifndef ELOGA
+  #define ELOGA( fmt, ... )   ASF_LOGA_LOCATION( ASF_LOG_CATEGORY, asf::LOG_ERROR, fmt, ##__VA_ARGS__ )
+  #endif//ELOGA
+
+  #ifndef ELOGW
+  #define ELOGW( fmt, ... )   ASF_LOGW_LOCATION( ASF_LOG_CATEGORY, asf::LOG_ERROR, fmt, ##__VA_ARGS__ )
+  #endif//ELOGW
+
+  #ifndef ELOGA_LIMIT
+  #define ELOGA_LIMIT( fmt, ... )   ASF_LOGA_LIMIT( ASF_LOG_CATEGORY, asf::LOG_ERROR, ASF_LOG_LIMIT_BURST, ASF_LOG_LIMIT_INTERVAL_MS, fmt, ##__VA_ARGS__ )
+  #endif//ELOGA_LIMIT
+
+  #ifndef ELOGW_LIMIT
+  #define ELOGW_LIMIT( fmt, ... )   ASF_LOGW_LIMIT( ASF_LOG_CATEGORY, asf::LOG_ERROR, ASF_LOG_LIMIT_BURST, ASF_LOG_LIMIT_INTERVAL_MS, fmt, ##__VA_ARGS__ )
+  #endif//ELOGW_LIMIT
+#else
+  #ifndef ELOGA
+  #define ELOGA( fmt, ... )   ((void)0)
+  #endif//ELOGA
+
+  #ifndef ELOGW
+  #define ELOGW( fmt, ... )   ((void)0)
+  #endif//ELOGW
+
+  #ifndef ELOGA_LIMIT
+  #define ELOGA_LIMIT( fmt, ... )   ((void)0)
+  #endif//ELOGA_LIMIT
+
+  #ifndef ELOGW_LIMIT
+  #define ELOGW_LIMIT( fmt, ... )   ((void)0)
+  #endif//ELOGW_LIMIT
+#endif//ASF_LOG_MIN_LEVEL <= 4
+
+#if defined(ASF_ENABLE_BINARY_LOG)
+    // 文字セットに関わらずログレコードとして記録します. 文字列引数は型タグで区別されるため,
+    // %s に wchar_t* を渡しても UTF-8 として出力されます.
+    #define VLOG        VLOGA
+    #define DLOG        DLOGA
+    #define ILOG        ILOGA
+    #define WLOG        WLOGA
+    #define ELOG        ELOGA
+    #define WLOG_LIMIT  WLOGA_LIMIT
+    #define ELOG_LIMIT  ELOGA_LIMIT
+#elif defined(UNICODE) || defined(_UNICODE)
     #define VLOG        VLOGW
     #define DLOG        DLOGW
     #define ILOG        ILOGW
     #define WLOG        WLOGW
     #define ELOG        ELOGW
+    #define WLOG_LIMIT  WLOGW_LIMIT
+    #define ELOG_LIMIT  ELOGW_LIMIT
 #else
     #define VLOG        VLOGA 
     #define DLOG        DLOGA
     #define ILOG        ILOGA
     #define WLOG        WLOGA 
     #define ELOG        ELOGA
-#endif
\ No newline at end of file
+    #define WLOG_LIMIT  WLOGA_LIMIT
+    #define ELOG_LIMIT  ELOGA_LIMIT
+#endif
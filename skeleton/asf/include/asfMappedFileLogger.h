@@ -0,0 +1,178 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfMappedFileLogger.h
+// Desc : Memory-mapped Structured Log File Sink.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <asfLogger.h>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t MAPPED_LOG_MAGIC          = 0x4D465341;   //!< ファイル識別子 ('ASFM').
+static constexpr uint32_t MAPPED_LOG_VERSION        = 2;            //!< ファイルバージョン.
+static constexpr uint32_t MAPPED_LOG_MESSAGE_SIZE   = 232;          //!< 1レコードのメッセージの最大バイト数 (終端文字を含む).
+static constexpr uint64_t MAPPED_LOG_SEQUENCE_BUSY  = 1ull << 63;   //!< 書き込み途中のレコードの Sequence に立つビット.
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedLogHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct MappedLogHeader
+{
+    uint32_t    Magic;          //!< MAPPED_LOG_MAGIC.
+    uint32_t    Version;        //!< MAPPED_LOG_VERSION.
+    uint32_t    RecordSize;     //!< sizeof(MappedLogRecord).
+    uint32_t    RecordCount;    //!< レコード数.
+    uint8_t     Reserved[48];   //!< 予約領域.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedLogRecord structure
+///////////////////////////////////////////////////////////////////////////////
+struct MappedLogRecord
+{
+    uint64_t    Sequence;       //!< 書き込み番号 + 1. 0 の場合は未書き込み, MAPPED_LOG_SEQUENCE_BUSY が立っている場合は書き込み途中です.
+    uint64_t    Timestamp;      //!< UNIX 時刻 (ナノ秒).
+    uint32_t    ThreadId;       //!< スレッドID.
+    uint16_t    Level;          //!< LOG_LEVEL.
+    uint16_t    Length;         //!< メッセージのバイト数 (終端文字を除く).
+    char        Message[MAPPED_LOG_MESSAGE_SIZE];   //!< UTF-8 メッセージ.
+};
+
+static_assert(sizeof(MappedLogHeader) == 64,  "MappedLogHeader Size Not Match");
+static_assert(sizeof(MappedLogRecord) == 256, "MappedLogRecord Size Not Match");
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedFileLoggerDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct MappedFileLoggerDesc
+{
+    const char*     Path        = nullptr;  //!< 出力ファイルパス.
+    uint32_t        RecordCount = 65536;    //!< 保持するレコード数. 超過すると古いレコードから上書きされます.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedFileLogger class
+///////////////////////////////////////////////////////////////////////////////
+class MappedFileLogger : public ILogger
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    MappedFileLogger() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~MappedFileLogger();
+
+    MappedFileLogger(const MappedFileLogger&) = delete;
+    MappedFileLogger& operator = (const MappedFileLogger&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @details    ファイルを RecordCount 分の固定サイズで作成し, メモリにマップします.
+    //!             既存のファイルは上書きされます.
+    //!
+    //! @param[in]      desc        構成設定.
+    //! @retval true    初期化に成功しました.
+    //! @retval false   初期化に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(const MappedFileLoggerDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ログを出力します.
+    //!
+    //! @details    マップされたレコードへ直接フォーマットするため, システムコールは発生しません.
+    //!             プロセスがクラッシュしても書き込み済みのレコードはファイルに残ります.
+    //!             MAPPED_LOG_MESSAGE_SIZE を超えるメッセージは切り詰められます.
+    //-------------------------------------------------------------------------
+    void WriteA(LOG_LEVEL level, const char* format, ...) override;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ログを出力します. メッセージは UTF-8 に変換して格納されます.
+    //-------------------------------------------------------------------------
+    void WriteW(LOG_LEVEL level, const wchar_t* format, ...) override;
+
+    //-------------------------------------------------------------------------
+    //! @brief      書き込み済みのレコードをディスクに書き出します.
+    //!
+    //! @note       プロセスのクラッシュに対しては不要です. OSの停止に備える場合に呼び出してください.
+    //-------------------------------------------------------------------------
+    void Flush();
+
+    //-------------------------------------------------------------------------
+    //! @brief      書き込んだレコード数を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetWriteCount() const
+    { return m_WriteIndex.load(std::memory_order_relaxed); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      破棄したレコード数を取得します.
+    //!
+    //! @details    書き込み中にリングが一周し, 同じレコードを他のスレッドが使用していた場合に破棄されます.
+    //-------------------------------------------------------------------------
+    uint64_t GetDropCount() const
+    { return m_DropCount.load(std::memory_order_relaxed); }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    uint8_t*                m_pMapped       = nullptr;
+    MappedLogRecord*        m_pRecords      = nullptr;
+    uint64_t                m_MappedSize    = 0;
+    uint32_t                m_RecordCount   = 0;
+    std::atomic<uint64_t>   m_WriteIndex    = { 0 };
+    std::atomic<uint64_t>   m_DropCount     = { 0 };
+    void*                   m_File          = nullptr;
+    void*                   m_Mapping       = nullptr;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      書き込み先のレコードを確保します. 確保できない場合は nullptr を返却します.
+    //-------------------------------------------------------------------------
+    MappedLogRecord* Acquire(LOG_LEVEL level, uint64_t& sequence);
+
+    //-------------------------------------------------------------------------
+    //! @brief      レコードを公開します.
+    //-------------------------------------------------------------------------
+    void Publish(MappedLogRecord* pRecord, uint64_t sequence, size_t length);
+};
+
+} // namespace asf
@@ -0,0 +1,191 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfMergingLogger.h
+// Desc : Per-thread Log Buffers Merged by Timestamp.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <asfLogger.h>
+#include <asfCacheLine.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// MergingLoggerDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct MergingLoggerDesc
+{
+    uint32_t    BufferSize      = 64 * 1024;    //!< スレッドごとのバッファサイズ (2のべき乗に切り上げ).
+    uint32_t    IntervalMs      = 1;            //!< マージ間隔 (ミリ秒). 0 の場合はマージスレッドを作成せず, Flush() 時のみ出力します.
+    ILogger*    pSink           = nullptr;      //!< 出力先. nullptr の場合はデフォルトロガー.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MergingLogger class
+///////////////////////////////////////////////////////////////////////////////
+class MergingLogger : public ILogger
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    MergingLogger() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~MergingLogger();
+
+    MergingLogger(const MergingLogger&) = delete;
+    MergingLogger& operator = (const MergingLogger&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      desc        構成設定.
+    //! @retval true    初期化に成功しました.
+    //! @retval false   初期化に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(const MergingLoggerDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います. 残っているログは全て出力されます.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ログを出力します.
+    //!
+    //! @details    呼び出しスレッド専用のバッファにタイムスタンプ付きで追記するのみで,
+    //!             他のスレッドとの排他は発生しません. バッファが満杯の場合は破棄されます.
+    //!             バッファは各スレッドの初回呼び出し時に確保され, Term() まで保持されます.
+    //-------------------------------------------------------------------------
+    void WriteA(LOG_LEVEL level, const char* format, ...) override;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ログを出力します.
+    //-------------------------------------------------------------------------
+    void WriteW(LOG_LEVEL level, const wchar_t* format, ...) override;
+
+    //-------------------------------------------------------------------------
+    //! @brief      呼び出し時点より前に書き込まれたログを時刻順に出力します.
+    //-------------------------------------------------------------------------
+    void Flush();
+
+    //-------------------------------------------------------------------------
+    //! @brief      バッファに残っている全てのログを時刻順に出力します.
+    //!
+    //! @note       マージ中の場合は完了を待機します. 書き込み途中のスレッドは待機しません.
+    //-------------------------------------------------------------------------
+    void Dump();
+
+    //-------------------------------------------------------------------------
+    //! @brief      致命的なエラーの報告時に, 残っているログを可能な範囲で出力します.
+    //!
+    //! @details    呼び出しスレッドがマージ中の場合は, 他にマージするスレッドがないため
+    //!             ロックを取得せずに続きを出力します. それ以外はマージの完了を一定時間待機し,
+    //!             完了しない場合は出力しません.
+    //!
+    //! @note       ロックの取得とメモリ確保を行うため, シグナルハンドラや例外フィルタからは呼び出せません.
+    //!             std::terminate のハンドラやエラー終了の直前など, 通常のコンテキストから呼び出してください.
+    //-------------------------------------------------------------------------
+    void DumpOnCrash();
+
+    //-------------------------------------------------------------------------
+    //! @brief      破棄されたログ数を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetDropCount() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // ThreadBuffer structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct ThreadBuffer
+    {
+        std::atomic<uint64_t>   Tail;           //!< 書き込み位置 (書き込みスレッドのみ更新).
+        std::atomic<uint32_t>   Busy;           //!< 書き込み中かどうか.
+        std::atomic<uint64_t>   DropCount;      //!< 破棄したログ数.
+        std::thread::id         ThreadId;       //!< 所有スレッド.
+        uint8_t                 Padding[CACHE_LINE_SIZE];   //!< Head を書き込み側と別のキャッシュラインに置く詰め物.
+        std::atomic<uint64_t>   Head;           //!< 読み込み位置 (マージ側のみ更新).
+        std::vector<uint8_t>    Data;           //!< リングバッファ.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    uint64_t                        m_Id            = 0;
+    uint64_t                        m_BufferSize    = 0;
+    ILogger*                        m_pSink         = nullptr;
+    uint32_t                        m_IntervalMs    = 0;
+    mutable std::mutex              m_BufferLock;
+    std::vector<ThreadBuffer*>      m_Buffers;
+    std::mutex                      m_MergeLock;
+    std::atomic<std::thread::id>    m_MergeOwner    = { std::thread::id() };
+    std::thread                     m_Thread;
+    std::atomic<bool>               m_Running       = { false };
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      呼び出しスレッドのバッファを取得します.
+    //-------------------------------------------------------------------------
+    ThreadBuffer* GetBuffer();
+
+    //-------------------------------------------------------------------------
+    //! @brief      レコードを追記します.
+    //-------------------------------------------------------------------------
+    void Append(LOG_LEVEL level, uint8_t kind, const void* pData, size_t size);
+
+    //-------------------------------------------------------------------------
+    //! @brief      バッファの先頭レコードを取得します. 空の場合は nullptr を返却します.
+    //-------------------------------------------------------------------------
+    const uint8_t* Peek(ThreadBuffer* pBuffer);
+
+    //-------------------------------------------------------------------------
+    //! @brief      m_MergeLock を取得してバッファのログを時刻順に出力します.
+    //-------------------------------------------------------------------------
+    void LockAndMerge(uint64_t limit, bool waitBusy);
+
+    //-------------------------------------------------------------------------
+    //! @brief      バッファのログを時刻順に出力します. m_MergeLock を取得して呼び出します.
+    //!
+    //! @param[in]      limit       このタイムスタンプより前のログのみ出力します.
+    //! @param[in]      waitBusy    書き込み中のスレッドを待機するかどうか.
+    //-------------------------------------------------------------------------
+    void Merge(uint64_t limit, bool waitBusy);
+
+    //-------------------------------------------------------------------------
+    //! @brief      マージスレッドの処理です.
+    //-------------------------------------------------------------------------
+    void Run();
+};
+
+} // namespace asf
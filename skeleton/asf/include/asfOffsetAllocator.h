@@ -15,6 +15,14 @@
 
 namespace asf {
 
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+// LockedOffsetAllocator で使用する場合は asfAdaptiveLock.h, asfQueueLock.h をインクルードしてください.
+class AdaptiveLock;
+class TicketLock;
+class McsLock;
+
 ///////////////////////////////////////////////////////////////////////////////
 // OffsetHandle class
 ///////////////////////////////////////////////////////////////////////////////
@@ -47,6 +55,11 @@ public:
     //-------------------------------------------------------------------------
     OffsetHandle(const OffsetHandle& handle);
 
+    //-------------------------------------------------------------------------
+    //! @brief      代入演算子です.
+    //-------------------------------------------------------------------------
+    OffsetHandle& operator = (const OffsetHandle&) = default;
+
     //-------------------------------------------------------------------------
     //! @brief      オフセット値を取得します.
     //! 
@@ -236,15 +249,16 @@ private:
 };
 
 ///////////////////////////////////////////////////////////////////////////////
-// ThreadSafeOffsetAllocator class
+// LockedOffsetAllocator class
 ///////////////////////////////////////////////////////////////////////////////
-class ThreadSafeOffsetAllocator
+template<typename LockType>
+class LockedOffsetAllocator
 {
 public:
     //-------------------------------------------------------------------------
     //! @brief      コンストラクタです.
     //-------------------------------------------------------------------------
-    ThreadSafeOffsetAllocator() = default;
+    LockedOffsetAllocator() = default;
 
     //-------------------------------------------------------------------------
     //! @brief      初期化処理を行います.
@@ -304,7 +318,7 @@ private:
     //=========================================================================
     // private variables.
     //=========================================================================
-    SpinLock        m_Lock;
+    LockType        m_Lock;
     OffsetAllocator m_Allocator;
 
     //=========================================================================
@@ -313,4 +327,15 @@ private:
     /* NOTHING */
 };
 
+// AdaptiveLock, TicketLock, McsLock 版は前方宣言のみのため, 明示的インスタンス化は asfOffsetAllocator.cpp にのみ記述します.
+extern template class LockedOffsetAllocator<SpinLock>;
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using ThreadSafeOffsetAllocator = LockedOffsetAllocator<SpinLock>;
+using AdaptiveOffsetAllocator   = LockedOffsetAllocator<AdaptiveLock>;
+using TicketOffsetAllocator     = LockedOffsetAllocator<TicketLock>;
+using McsOffsetAllocator        = LockedOffsetAllocator<McsLock>;
+
 } // namespace asf
@@ -0,0 +1,182 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfParallelRecorder.h
+// Desc : Parallel Command List Recording.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <asfCommandList.h>
+#include <asfCommandQueue.h>
+#include <asfCommandAllocatorPool.h>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+//! @brief      記録関数です.
+//!
+//! @details    状態の設定は ICommandList のメソッドを使用すると重複が破棄され, ステートトラッカーも
+//!             範囲ごとに使用できます. Reset() と SetFencePoint() は ParallelRecorder が行うため呼び出さないでください.
+//!
+//! @param[in]      pCmdList    記録先のコマンドリスト. リセット済みで, 呼び出し後にクローズされます.
+//! @param[in]      begin       記録する作業項目の先頭.
+//! @param[in]      end         記録する作業項目の終端 (含まない).
+//! @param[in]      pUser       ユーザーデータ.
+//-----------------------------------------------------------------------------
+using RecordFunc = void(*)(ICommandList* pCmdList, uint32_t begin, uint32_t end, void* pUser);
+
+///////////////////////////////////////////////////////////////////////////////
+// ParallelRecorderDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct ParallelRecorderDesc
+{
+    ID3D12Device*           pDevice         = nullptr;  //!< デバイス. nullptr の場合はソフトウェアコマンドリストを使用します.
+    CommandAllocatorPool*   pPool           = nullptr;  //!< アロケータプール. コマンドリストタイプはプールのタイプを使用します.
+    COMMAND_ALLOCATOR_CLASS AllocatorClass  = COMMAND_ALLOCATOR_CLASS_SMALL;    //!< 取得するアロケータのクラス.
+    uint32_t                ThreadCount     = 4;        //!< 記録に使用するスレッド数 (呼び出しスレッドを含む).
+    uint32_t                MaxChunks       = 64;       //!< 1回の Record() で分割できる最大数.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ParallelRecorder class
+///////////////////////////////////////////////////////////////////////////////
+class ParallelRecorder
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    ParallelRecorder() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~ParallelRecorder();
+
+    ParallelRecorder(const ParallelRecorder&) = delete;
+    ParallelRecorder& operator = (const ParallelRecorder&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います. ThreadCount - 1 個のワーカースレッドを起動します.
+    //!
+    //! @param[in]      desc        構成設定.
+    //! @retval true    初期化に成功しました.
+    //! @retval false   初期化に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(const ParallelRecorderDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //!
+    //! @note       Submit() したコマンドリストのGPUでの完了を待ってから呼び出してください.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      作業項目を分割し, 並列に記録します.
+    //!
+    //! @details    [0, itemCount) を chunkCount 個の連続した範囲に分割し, 範囲ごとに専用の
+    //!             コマンドリストとアロケータで記録します. 分割はスレッド数に依存しないため,
+    //!             どのスレッドが記録しても同じ内容になります. 全ての記録が終わるまで戻りません.
+    //!
+    //! @param[in]      itemCount   作業項目の数.
+    //! @param[in]      chunkCount  分割数 (MaxChunks 以下). 0 の場合は ThreadCount で分割します.
+    //! @param[in]      func        記録関数. 複数のスレッドから同時に呼び出されます.
+    //! @param[in]      pUser       記録関数に渡すユーザーデータ.
+    //! @retval true    記録に成功しました.
+    //! @retval false   記録に失敗しました. 記録済みのリストはクローズした上で投入せずに破棄され,
+    //!                 アロケータは次の Record() で直ちに再利用されます.
+    //-------------------------------------------------------------------------
+    bool Record(uint32_t itemCount, uint32_t chunkCount, RecordFunc func, void* pUser);
+
+    //-------------------------------------------------------------------------
+    //! @brief      記録したコマンドリストを範囲の順に1回の Execute() で投入し, シグナルを発行します.
+    //!
+    //! @details    返却する待機点は各コマンドリストに設定され, 次の Record() でアロケータの再利用判定に使用されます.
+    //!
+    //! @param[in]      pQueue      投入先のキュー.
+    //! @return     GPU待機点を返却します.
+    //-------------------------------------------------------------------------
+    WaitPoint Submit(ICommandQueue* pQueue);
+
+    //-------------------------------------------------------------------------
+    //! @brief      記録に使用するスレッド数を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetThreadCount() const
+    { return m_ThreadCount; }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    ID3D12Device*                       m_pDevice       = nullptr;
+    CommandAllocatorPool*               m_pPool         = nullptr;
+    COMMAND_ALLOCATOR_CLASS             m_Class         = COMMAND_ALLOCATOR_CLASS_SMALL;
+    uint32_t                            m_ThreadCount   = 0;
+    uint32_t                            m_MaxChunks     = 0;
+    std::vector<ICommandList*>          m_Lists;            //!< 範囲ごとのコマンドリスト. 必要になった時点で生成します.
+    std::vector<ID3D12CommandList*>     m_Recorded;         //!< 直前の Record() でリセットしたリスト. 未投入の間は SetFencePoint() していません.
+    std::vector<std::thread>            m_Threads;
+    std::mutex                          m_Mutex;
+    std::condition_variable             m_StartCond;
+    std::condition_variable             m_DoneCond;
+    uint64_t                            m_Generation    = 0;        //!< m_Mutex で保護します.
+    uint32_t                            m_ActiveCount   = 0;        //!< 記録中のワーカー数. m_Mutex で保護します.
+    bool                                m_Running       = false;    //!< m_Mutex で保護します.
+    RecordFunc                          m_Func          = nullptr;
+    void*                               m_pUser         = nullptr;
+    uint32_t                            m_ItemCount     = 0;
+    uint32_t                            m_ChunkCount    = 0;
+    std::atomic<uint32_t>               m_NextChunk     = { 0 };
+    std::atomic<bool>                   m_Failed        = { false };
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コマンドリストを生成します.
+    //-------------------------------------------------------------------------
+    bool CreateList(ICommandList** ppCmdList);
+
+    //-------------------------------------------------------------------------
+    //! @brief      未記録の範囲がなくなるまで記録します.
+    //-------------------------------------------------------------------------
+    void RecordChunks();
+
+    //-------------------------------------------------------------------------
+    //! @brief      投入せずに破棄する記録のアロケータを再利用可能にします.
+    //-------------------------------------------------------------------------
+    void ReleaseRecorded();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ワーカースレッドの処理です.
+    //-------------------------------------------------------------------------
+    void Run();
+};
+
+} // namespace asf
@@ -0,0 +1,193 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfQueueLock.h
+// Desc : Fair Queue Locks (Ticket Lock / MCS Lock).
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <asfSpinLock.h>
+#include <asfCacheLine.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// TicketLock class
+///////////////////////////////////////////////////////////////////////////////
+class TicketLock
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static constexpr uint32_t BACKOFF_PER_WAITER = 32;     //!< 待ち順1つ当たりのpause回数.
+    static constexpr uint32_t YIELD_THRESHOLD    = 1024;   //!< スレッドを譲るまでのスピン回数.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    TicketLock() = default;
+
+    TicketLock(const TicketLock&) = delete;
+    TicketLock& operator = (const TicketLock&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ロックします.
+    //!
+    //! @details    整理券を取得し, 自分の番になるまで待機します.
+    //!             ロックは要求順 (FIFO) に取得されます.
+    //! @note       待機順の先頭スレッドがプリエンプトされると後続も全て停滞するため,
+    //!             スレッド数がコア数を超える場合は AdaptiveLock を使用してください.
+    //-------------------------------------------------------------------------
+    void lock()
+    {
+        auto ticket = m_Next.fetch_add(1, std::memory_order_relaxed);
+        if (m_Serving.load(std::memory_order_acquire) == ticket)
+        { return; }
+
+        LockSlow(ticket);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ロックを試みます.
+    //!
+    //! @retval true    ロックを取得できました.
+    //! @retval false   ロックを取得できませんでした.
+    //-------------------------------------------------------------------------
+    bool try_lock()
+    {
+        auto serving = m_Serving.load(std::memory_order_acquire);
+        auto expected = serving;
+        return m_Next.compare_exchange_strong(expected, serving + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ロックを解除します.
+    //-------------------------------------------------------------------------
+    void unlock()
+    {
+        // 書き込むのはロック保持スレッドのみなので, fetch_add は不要.
+        auto serving = m_Serving.load(std::memory_order_relaxed);
+        m_Serving.store(serving + 1, std::memory_order_release);
+    }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::atomic<uint32_t>   m_Next      = { 0 };    //!< 次に発行する整理券.
+    uint8_t                 m_Padding[CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>)]; //!< m_Next と m_Serving を別のキャッシュラインに置く詰め物.
+    std::atomic<uint32_t>   m_Serving   = { 0 };    //!< 現在処理中の整理券.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      自分の番になるまで待機します.
+    //-------------------------------------------------------------------------
+    void LockSlow(uint32_t ticket);
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// McsLock class
+///////////////////////////////////////////////////////////////////////////////
+class McsLock
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static constexpr uint32_t MAX_NODES       = 16;     //!< 1スレッドが同時に保持できるロック数.
+    static constexpr uint32_t YIELD_THRESHOLD = 1024;   //!< スレッドを譲るまでのスピン回数.
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Node structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Node
+    {
+        std::atomic<Node*>  pNext   = { nullptr };  //!< 後続の待機ノード.
+        Node*               pFree   = nullptr;      //!< フリーリスト.
+        std::atomic<bool>   Waiting = { false };    //!< 待機中なら true.
+        uint8_t             Padding[CACHE_LINE_SIZE - sizeof(std::atomic<Node*>) - sizeof(Node*) - sizeof(std::atomic<bool>)]; //!< 隣接ノードと別のキャッシュラインに置く詰め物.
+    };
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    McsLock() = default;
+
+    McsLock(const McsLock&) = delete;
+    McsLock& operator = (const McsLock&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ロックします.
+    //!
+    //! @details    待機キューの末尾に自スレッドのノードを連結し, 自分のノードのみを
+    //!             監視して待機します. ロックは要求順 (FIFO) に取得されます.
+    //!             ノードはスレッドローカルなプールから取得するため,
+    //!             1スレッドが同時に保持できる McsLock は MAX_NODES 個までです.
+    //! @note       待機順の先頭スレッドがプリエンプトされると後続も全て停滞するため,
+    //!             スレッド数がコア数を超える場合は AdaptiveLock を使用してください.
+    //-------------------------------------------------------------------------
+    void lock();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ロックを試みます.
+    //!
+    //! @retval true    ロックを取得できました.
+    //! @retval false   ロックを取得できませんでした.
+    //-------------------------------------------------------------------------
+    bool try_lock();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ロックを解除します.
+    //-------------------------------------------------------------------------
+    void unlock();
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::atomic<Node*>  m_pTail     = { nullptr };  //!< 待機キューの末尾.
+    Node*               m_pOwner    = nullptr;      //!< ロック保持スレッドのノード.
+    uint8_t             m_Padding[CACHE_LINE_SIZE - sizeof(std::atomic<Node*>) - sizeof(Node*)];   //!< 隣接するロックと別のキャッシュラインに置く詰め物.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    /* NOTHING */
+};
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using ScopedTicketLock = LockGuard<TicketLock>;
+using ScopedMcsLock    = LockGuard<McsLock>;
+
+} // namespace asf
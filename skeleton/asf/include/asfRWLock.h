@@ -0,0 +1,269 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfRWLock.h
+// Desc : Reader-Writer Spin Locks.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+#include <asfSpinLock.h>
+#include <asfCacheLine.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// RWSpinLock class
+///////////////////////////////////////////////////////////////////////////////
+class RWSpinLock
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    RWSpinLock() = default;
+
+    RWSpinLock(const RWSpinLock&) = delete;
+    RWSpinLock& operator = (const RWSpinLock&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      書き込みロックします.
+    //!
+    //! @details    待機中は書き込み待ちフラグを立て, 新たな読み取りロックを抑止します.
+    //-------------------------------------------------------------------------
+    void lock()
+    {
+        uint32_t expected = 0;
+        if (m_State.compare_exchange_strong(expected, WRITER, std::memory_order_acquire, std::memory_order_relaxed))
+        { return; }
+
+        LockSlow();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      書き込みロックを解除します.
+    //-------------------------------------------------------------------------
+    void unlock()
+    { m_State.fetch_and(~WRITER, std::memory_order_release); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      読み取りロックします.
+    //!
+    //! @details    書き込み中または書き込み待ちのスレッドがいる間は待機します.
+    //-------------------------------------------------------------------------
+    void lock_shared()
+    {
+        auto state = m_State.load(std::memory_order_relaxed);
+        if ((state & (WRITER | WRITER_WAITING)) == 0
+         && m_State.compare_exchange_weak(state, state + READER, std::memory_order_acquire, std::memory_order_relaxed))
+        { return; }
+
+        LockSharedSlow();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      読み取りロックを解除します.
+    //-------------------------------------------------------------------------
+    void unlock_shared()
+    { m_State.fetch_sub(READER, std::memory_order_release); }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    static constexpr uint32_t WRITER         = 0x80000000u;    //!< 書き込み中.
+    static constexpr uint32_t WRITER_WAITING = 0x40000000u;    //!< 書き込み待ち.
+    static constexpr uint32_t READER         = 0x00000001u;    //!< 読み取りスレッド1つ分.
+
+    std::atomic<uint32_t>   m_State = { 0 };
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      競合時の書き込みロック処理を行います.
+    //-------------------------------------------------------------------------
+    void LockSlow();
+
+    //-------------------------------------------------------------------------
+    //! @brief      競合時の読み取りロック処理を行います.
+    //-------------------------------------------------------------------------
+    void LockSharedSlow();
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DistributedRWLock class
+///////////////////////////////////////////////////////////////////////////////
+class DistributedRWLock
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static constexpr uint32_t SLOT_COUNT = 64;  //!< 読み取りカウンタのスロット数.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    DistributedRWLock() = default;
+
+    DistributedRWLock(const DistributedRWLock&) = delete;
+    DistributedRWLock& operator = (const DistributedRWLock&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      書き込みロックします.
+    //!
+    //! @details    書き込みフラグを立ててから全スロットの読み取りカウンタが
+    //!             0 になるまで待機します. 書き込みの負荷は SLOT_COUNT に比例します.
+    //-------------------------------------------------------------------------
+    void lock();
+
+    //-------------------------------------------------------------------------
+    //! @brief      書き込みロックを解除します.
+    //-------------------------------------------------------------------------
+    void unlock()
+    { m_Writer.store(false, std::memory_order_release); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      読み取りロックします.
+    //!
+    //! @details    スレッドごとに割り当てられたスロットのカウンタのみを更新するため,
+    //!             読み取りスレッド間でキャッシュラインを共有しません.
+    //!             書き込み中または書き込み待ちのスレッドがいる間は待機します.
+    //-------------------------------------------------------------------------
+    void lock_shared()
+    {
+        auto& slot = m_Slots[GetSlotIndex()];
+        slot.Readers.fetch_add(1, std::memory_order_seq_cst);
+        if (!m_Writer.load(std::memory_order_seq_cst))
+        { return; }
+
+        LockSharedSlow(slot);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      読み取りロックを解除します.
+    //-------------------------------------------------------------------------
+    void unlock_shared()
+    { m_Slots[GetSlotIndex()].Readers.fetch_sub(1, std::memory_order_release); }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Slot structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Slot
+    {
+        std::atomic<uint32_t>   Readers = { 0 };    //!< 読み取り中のスレッド数.
+        uint8_t                 Padding[CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>)];  //!< 隣接スロットと別のキャッシュラインに置く詰め物.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::atomic<bool>   m_Writer    = { false };    //!< 書き込み中または書き込み待ち.
+    uint8_t             m_Padding[CACHE_LINE_SIZE - sizeof(std::atomic<bool>)];    //!< m_Writer とスロットを別のキャッシュラインに置く詰め物.
+    Slot                m_Slots[SLOT_COUNT];
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      呼び出しスレッドのスロット番号を取得します.
+    //-------------------------------------------------------------------------
+    static uint32_t GetSlotIndex();
+
+    //-------------------------------------------------------------------------
+    //! @brief      競合時の読み取りロック処理を行います.
+    //-------------------------------------------------------------------------
+    void LockSharedSlow(Slot& slot);
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SharedLockGuard class
+///////////////////////////////////////////////////////////////////////////////
+template<typename LockType>
+class SharedLockGuard
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SharedLockGuard(LockType& value)
+    : m_Lock(value)
+    { m_Lock.lock_shared(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~SharedLockGuard()
+    { m_Lock.unlock_shared(); }
+
+    SharedLockGuard(const SharedLockGuard&) = delete;
+    SharedLockGuard& operator = (const SharedLockGuard&) = delete;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    LockType&   m_Lock;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    /* NOTHING */
+};
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using ScopedReadLock             = SharedLockGuard<RWSpinLock>;
+using ScopedWriteLock            = LockGuard<RWSpinLock>;
+using ScopedDistributedReadLock  = SharedLockGuard<DistributedRWLock>;
+using ScopedDistributedWriteLock = LockGuard<DistributedRWLock>;
+
+} // namespace asf
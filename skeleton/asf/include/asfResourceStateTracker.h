@@ -0,0 +1,301 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfResourceStateTracker.h
+// Desc : Resource State Tracking and Barrier Batching.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <asfD3D12.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// ResourceStateTrackerStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct ResourceStateTrackerStats
+{
+    uint64_t    RequestCount    = 0;    //!< Transition() / BeginTransition() / UAVBarrier() の呼び出し回数.
+    uint64_t    SkipCount       = 0;    //!< 状態が変わらないため破棄した要求数.
+    uint64_t    MergeCount      = 0;    //!< 同じバッチ内の遷移に統合した要求数.
+    uint64_t    DeferCount      = 0;    //!< 初回使用のため投入時の解決に回した要求数.
+    uint64_t    SplitCount      = 0;    //!< 分割バリアとして発行した遷移数.
+    uint64_t    BarrierCount    = 0;    //!< 発行したバリア数.
+    uint64_t    CallCount       = 0;    //!< ResourceBarrier() の呼び出し回数.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ResourceStateTracker class
+///////////////////////////////////////////////////////////////////////////////
+class ResourceStateTracker
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    friend class ResourceStateRegistry;
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    ResourceStateTracker() = default;
+
+    ResourceStateTracker(const ResourceStateTracker&) = delete;
+    ResourceStateTracker& operator = (const ResourceStateTracker&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      記録した状態を破棄します. コマンドリストのリセット時に呼び出します.
+    //!
+    //! @note       確保済みの領域は再利用されます. 統計情報はリセットされません.
+    //-------------------------------------------------------------------------
+    void Reset();
+
+    //-------------------------------------------------------------------------
+    //! @brief      リソースの状態遷移を要求します.
+    //!
+    //! @details    このコマンドリストで初めて使用するリソースはバリアを発行せず,
+    //!             ResourceStateRegistry::Resolve() で投入時の状態から遷移させます.
+    //!             現在の状態と同じか, 読み取り状態に既に含まれる場合は破棄します.
+    //!             Flush() 前に同じリソースの遷移が続いた場合は1つのバリアに統合し,
+    //!             元の状態に戻った場合はバリアを発行しません.
+    //!
+    //! @param[in]      pResource   リソース.
+    //! @param[in]      state       遷移後の状態.
+    //-------------------------------------------------------------------------
+    void Transition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state);
+
+    //-------------------------------------------------------------------------
+    //! @brief      分割バリアによる状態遷移を開始します.
+    //!
+    //! @details    BEGIN_ONLY のバリアを発行し, 同じ状態への Transition() か Close() で
+    //!             END_ONLY のバリアを発行します. 間に実行される描画と遷移を重ねられます.
+    //!             初回使用のリソースや, 開始と終了が同じバッチになった場合は通常の遷移になります.
+    //!             開始から終了までの間はリソースを使用しないでください.
+    //!
+    //! @param[in]      pResource   リソース.
+    //! @param[in]      state       遷移後の状態.
+    //-------------------------------------------------------------------------
+    void BeginTransition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state);
+
+    //-------------------------------------------------------------------------
+    //! @brief      UAVバリアを要求します. 同じバッチ内の重複は1つにまとめます.
+    //!
+    //! @param[in]      pResource   リソース. nullptr の場合は全てのUAVアクセスが対象です.
+    //-------------------------------------------------------------------------
+    void UAVBarrier(ID3D12Resource* pResource);
+
+    //-------------------------------------------------------------------------
+    //! @brief      溜めたバリアを1回の ResourceBarrier() で発行します.
+    //!
+    //! @details    描画やコピーなど, リソースを使用するコマンドの記録前に呼び出します.
+    //!             ID3D12GraphicsCommandList6 や CommandStream など, ResourceBarrier() を持つ型に発行できます.
+    //!
+    //! @param[in]      pTarget     発行先.
+    //-------------------------------------------------------------------------
+    template<typename T>
+    void Flush(T* pTarget)
+    {
+        uint32_t count = 0;
+        auto pBarriers = Prepare(count);
+        if (count > 0)
+        { pTarget->ResourceBarrier(count, pBarriers); }
+        m_Batch.clear();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了していない分割バリアを終了させ, 溜めたバリアを発行します.
+    //!
+    //! @details    コマンドリストを閉じる前に呼び出します.
+    //!
+    //! @param[in]      pTarget     発行先.
+    //-------------------------------------------------------------------------
+    template<typename T>
+    void Close(T* pTarget)
+    {
+        EndSplits();
+        Flush(pTarget);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      記録中の状態を取得します.
+    //!
+    //! @param[in]      pResource   リソース.
+    //! @param[out]     state       記録中の状態.
+    //! @retval true    このコマンドリストで使用されています.
+    //! @retval false   このコマンドリストでは使用されていません.
+    //-------------------------------------------------------------------------
+    bool GetState(ID3D12Resource* pResource, D3D12_RESOURCE_STATES& state) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    const ResourceStateTrackerStats& GetStats() const
+    { return m_Stats; }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        ID3D12Resource*         pResource;
+        D3D12_RESOURCE_STATES   FirstState;     //!< このコマンドリストで最初に要求された状態.
+        D3D12_RESOURCE_STATES   State;          //!< 記録中の状態.
+        D3D12_RESOURCE_STATES   SplitState;     //!< 分割バリアの遷移後の状態.
+        int32_t                 BatchIndex;     //!< 未発行のバリアの位置. ない場合は -1.
+        bool                    Split;          //!< 分割バリアを開始済みかどうか.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<Entry>                      m_Entries;
+    std::vector<int32_t>                    m_Slots;    //!< リソースから m_Entries の位置を引くハッシュテーブル.
+    std::vector<D3D12_RESOURCE_BARRIER>     m_Batch;
+    ResourceStateTrackerStats               m_Stats;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      リソースのエントリを検索します. ない場合は追加し, created に true を設定します.
+    //-------------------------------------------------------------------------
+    Entry& FindOrAdd(ID3D12Resource* pResource, bool& created);
+
+    //-------------------------------------------------------------------------
+    //! @brief      リソースのエントリの位置を検索します. ない場合は -1 を返却します.
+    //-------------------------------------------------------------------------
+    int32_t FindIndex(ID3D12Resource* pResource) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ハッシュテーブルを再構築します.
+    //-------------------------------------------------------------------------
+    void Rehash(size_t slotCount);
+
+    //-------------------------------------------------------------------------
+    //! @brief      遷移バリアを追加します.
+    //-------------------------------------------------------------------------
+    void Push(Entry& entry, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after, D3D12_RESOURCE_BARRIER_FLAGS flags);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了していない分割バリアを終了させます.
+    //-------------------------------------------------------------------------
+    void EndSplits();
+
+    //-------------------------------------------------------------------------
+    //! @brief      統合により不要になったバリアを取り除き, 発行するバリアを返却します.
+    //-------------------------------------------------------------------------
+    const D3D12_RESOURCE_BARRIER* Prepare(uint32_t& count);
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ResourceStateRegistry class
+///////////////////////////////////////////////////////////////////////////////
+class ResourceStateRegistry
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    ResourceStateRegistry() = default;
+
+    ResourceStateRegistry(const ResourceStateRegistry&) = delete;
+    ResourceStateRegistry& operator = (const ResourceStateRegistry&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      リソースを登録します.
+    //!
+    //! @details    ColorTarget や DepthTarget は GetD3D12Resource() と GetDesc().InitState を渡します.
+    //!
+    //! @param[in]      pResource   リソース.
+    //! @param[in]      state       現在の状態.
+    //-------------------------------------------------------------------------
+    void Register(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state);
+
+    //-------------------------------------------------------------------------
+    //! @brief      リソースの登録を解除します.
+    //-------------------------------------------------------------------------
+    void Unregister(ID3D12Resource* pResource);
+
+    //-------------------------------------------------------------------------
+    //! @brief      投入済みのコマンドリストの実行後の状態を取得します.
+    //!
+    //! @retval true    登録されています.
+    //! @retval false   登録されていません.
+    //-------------------------------------------------------------------------
+    bool GetState(ID3D12Resource* pResource, D3D12_RESOURCE_STATES& state) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      コマンドリストが前提とする状態への遷移を解決し, 実行後の状態を反映します.
+    //!
+    //! @details    コマンドリストを投入する順に, 投入の直前に呼び出してください.
+    //!             必要なバリアは pFixup に1回の ResourceBarrier() で発行されるため,
+    //!             pFixup を対象のコマンドリストの直前に実行します.
+    //!             未登録のリソースは最初に要求された状態にあるものとして登録します.
+    //!
+    //! @param[in]      tracker     投入するコマンドリストのトラッカー. Close() 済みである必要があります.
+    //! @param[in]      pFixup      遷移バリアの発行先.
+    //! @return     発行したバリア数を返却します.
+    //-------------------------------------------------------------------------
+    template<typename T>
+    uint32_t Resolve(const ResourceStateTracker& tracker, T* pFixup)
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        auto count = Resolve(tracker);
+        if (count > 0)
+        { pFixup->ResourceBarrier(count, m_Fixups.data()); }
+        return count;
+    }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    mutable std::mutex                                              m_Mutex;
+    std::unordered_map<ID3D12Resource*, D3D12_RESOURCE_STATES>      m_States;
+    std::vector<D3D12_RESOURCE_BARRIER>                             m_Fixups;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      遷移バリアを m_Fixups に作成します. m_Mutex を取得して呼び出します.
+    //-------------------------------------------------------------------------
+    uint32_t Resolve(const ResourceStateTracker& tracker);
+};
+
+} // namespace asf
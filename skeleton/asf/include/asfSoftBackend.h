@@ -0,0 +1,146 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfSoftBackend.h
+// Desc : CPU-emulated Command Queue / Fence / Command List.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <asfCommandQueue.h>
+#include <asfCommandList.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftCommandQueueDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct SoftCommandQueueDesc
+{
+    D3D12_COMMAND_LIST_TYPE Type            = D3D12_COMMAND_LIST_TYPE_DIRECT;   //!< コマンドリストタイプ.
+    uint32_t                LatencyUs       = 100;      //!< ソフトウェアコマンドリスト以外を実行した場合の1リスト当たりの実行時間 (マイクロ秒).
+    uint32_t                SubmitCostUs    = 0;        //!< Execute() 1回当たりに呼び出しスレッドで消費するCPU時間 (マイクロ秒). ドライバのオーバーヘッドを模擬します.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftCommandListDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct SoftCommandListDesc
+{
+    D3D12_COMMAND_LIST_TYPE Type            = D3D12_COMMAND_LIST_TYPE_DIRECT;   //!< コマンドリストタイプ.
+    uint32_t                LatencyUs       = 100;      //!< 1回の実行に掛かる時間 (マイクロ秒).
+    CommandAllocatorPool*   pPool           = nullptr;  //!< Reset() でアロケータを取得するプール. nullptr の場合はアロケータを使用しません.
+    COMMAND_ALLOCATOR_CLASS AllocatorClass  = COMMAND_ALLOCATOR_CLASS_SMALL;    //!< 取得するアロケータのクラス.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftFenceListener structure
+///////////////////////////////////////////////////////////////////////////////
+struct SoftFenceListener
+{
+    std::atomic<int32_t>    Pending = { 0 };    //!< 通知までに完了が必要な登録数. 登録前に設定します.
+    std::mutex              Mutex;              //!< 通知と待機を排他します.
+    std::condition_variable Cond;               //!< Pending が 0 になると通知されます.
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      CPU上でGPUの実行をエミュレートするコマンドキューを生成します.
+//!
+//! @details    Execute() されたコマンドリストはワーカースレッド上の仮想GPUタイムラインで
+//!             順番に "実行" され, 各リストのレイテンシ分だけ時間が経過します.
+//!             Signal() によるフェンスの完了もワーカースレッドで行われます.
+//!             D3D12デバイスを必要としないため, スケジューリングや同期処理をヘッドレスで検証できます.
+//!             GetD3D12CommandQueue() は nullptr を返却します.
+//!
+//! @param[in]      desc        構成設定です.
+//! @param[out]     ppQueue     コマンドキューの格納先です.
+//! @retval true    生成に成功.
+//! @retval false   生成に失敗.
+//-----------------------------------------------------------------------------
+bool CreateSoftCommandQueue(const SoftCommandQueueDesc& desc, ICommandQueue** ppQueue);
+
+//-----------------------------------------------------------------------------
+//! @brief      CPU上で完了値を管理するフェンスを生成します.
+//!
+//! @details    GetD3D12Fence() は nullptr を返却します.
+//!
+//! @param[out]     ppFence     フェンスの格納先です.
+//! @retval true    生成に成功.
+//! @retval false   生成に失敗.
+//-----------------------------------------------------------------------------
+bool CreateSoftFence(IFence** ppFence);
+
+//-----------------------------------------------------------------------------
+//! @brief      ソフトウェアコマンドキューで実行するコマンドリストを生成します.
+//!
+//! @details    Reset() と GetD3D12GraphicsCommandList() はソフトウェアコマンドキューの
+//!             Execute() に渡すためのハンドルを返却します. ハンドルに対してD3D12のメソッドを
+//!             呼び出してはいけません.
+//!             SoftCommandListDesc::pPool を指定した場合は, Reset() でD3D12のコマンドリストと
+//!             同様にアロケータの返却と取得を行います.
+//!
+//! @param[in]      desc        構成設定です.
+//! @param[out]     ppCmdList   コマンドリストの格納先です.
+//! @retval true    生成に成功.
+//! @retval false   生成に失敗.
+//-----------------------------------------------------------------------------
+bool CreateSoftCommandList(const SoftCommandListDesc& desc, ICommandList** ppCmdList);
+
+//-----------------------------------------------------------------------------
+//! @brief      ソフトウェアコマンドリストの実行時間を設定します.
+//!
+//! @details    次に Execute() されたときから反映されます. 負荷の異なるパスを模擬する場合に使用します.
+//!
+//! @param[in]      pCmdList    CreateSoftCommandList() で生成したコマンドリストです.
+//! @param[in]      latencyUs   1回の実行に掛かる時間 (マイクロ秒).
+//! @retval true    設定に成功.
+//! @retval false   ソフトウェアコマンドリストではありません.
+//-----------------------------------------------------------------------------
+bool SetSoftCommandListLatency(ICommandList* pCmdList, uint32_t latencyUs);
+
+//-----------------------------------------------------------------------------
+//! @brief      フェンスの完了値をCPUから更新します.
+//!
+//! @details    ID3D12Fence::Signal() に相当します.
+//!
+//! @param[in]      pFence      CreateSoftFence() で生成したフェンスです.
+//! @param[in]      value       完了値です.
+//! @retval true    更新に成功.
+//! @retval false   ソフトウェアフェンスではありません.
+//-----------------------------------------------------------------------------
+bool SignalSoftFence(IFence* pFence, uint64_t value);
+
+//-----------------------------------------------------------------------------
+//! @brief      ソフトウェアフェンスにリスナーを登録します.
+//!
+//! @details    フェンスが fenceValue に達すると pListener->Pending を1つ減らし, 0 になった時点で
+//!             pListener->Cond に通知します. 登録は通知と同時に解除されます.
+//!             Pending に登録数を設定すれば全ての完了を, 1 を設定すればいずれかの完了を
+//!             1回の起床で待機できます. Pending は pListener->Mutex を保持した状態で確認してください.
+//!
+//! @param[in]      pFence      CreateSoftFence() で生成したフェンスです.
+//! @param[in]      fenceValue  通知するフェンス値です.
+//! @param[in]      pListener   登録するリスナーです.
+//! @retval true    登録に成功.
+//! @retval false   ソフトウェアフェンスではありません.
+//-----------------------------------------------------------------------------
+bool AddSoftFenceListener(IFence* pFence, uint64_t fenceValue, SoftFenceListener* pListener);
+
+//-----------------------------------------------------------------------------
+//! @brief      ソフトウェアフェンスからリスナーの登録を解除します.
+//!
+//! @details    通知済みの登録は既に解除されているため, 何もしません.
+//!
+//! @param[in]      pFence      CreateSoftFence() で生成したフェンスです.
+//! @param[in]      pListener   登録を解除するリスナーです.
+//-----------------------------------------------------------------------------
+void RemoveSoftFenceListener(IFence* pFence, SoftFenceListener* pListener);
+
+} // namespace asf
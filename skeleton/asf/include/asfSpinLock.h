@@ -10,6 +10,16 @@
 //-----------------------------------------------------------------------------
 #include <atomic>
 
+#if defined(ASF_ENABLE_LOCK_STATS)
+#include <asfLockStats.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>     // for _mm_pause().
+#else
+#include <immintrin.h>  // for _mm_pause().
+#endif
+
 
 namespace asf {
 
@@ -33,13 +43,49 @@ public:
     // public methods.
     //=========================================================================
 
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SpinLock() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //!
+    //! @param[in]      name        ロック名. ASF_ENABLE_LOCK_STATS 定義時に統計情報の識別に使用します.
+    //-------------------------------------------------------------------------
+#if defined(ASF_ENABLE_LOCK_STATS)
+    explicit SpinLock(const char* name)
+    : m_Stats(name)
+    { /* DO_NOTHING */ }
+#else
+    explicit SpinLock(const char*)
+    { /* DO_NOTHING */ }
+#endif
+
     //-------------------------------------------------------------------------
     //! @brief      ロックします.
     //-------------------------------------------------------------------------
     void lock()
     {
+#if defined(ASF_ENABLE_LOCK_STATS)
+        if (!m_State.test_and_set(std::memory_order_acquire))
+        {
+            m_Stats.RecordUncontended();
+            return;
+        }
+
+        uint64_t spin  = 0;
+        auto     begin = LockStats::Now();
+        while (m_State.test_and_set(std::memory_order_acquire))
+        {
+            _mm_pause();
+            spin++;
+        }
+        m_Stats.RecordContended(spin, LockStats::Now() - begin);
+#else
         while (m_State.test_and_set(std::memory_order_acquire))
         { _mm_pause(); }
+#endif
     }
 
     //-------------------------------------------------------------------------
@@ -53,6 +99,9 @@ private:
     // private variables.
     //=========================================================================
     std::atomic_flag    m_State = ATOMIC_FLAG_INIT;
+#if defined(ASF_ENABLE_LOCK_STATS)
+    LockStats           m_Stats { nullptr };
+#endif
 
     //=========================================================================
     // private methods.
@@ -62,9 +111,10 @@ private:
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// ScopedLock class
+// LockGuard class
 ///////////////////////////////////////////////////////////////////////////////
-class ScopedLock
+template<typename LockType>
+class LockGuard
 {
     //=========================================================================
     // list of friend classes and methods.
@@ -84,21 +134,24 @@ public:
     //-------------------------------------------------------------------------
     //! @brief      コンストラクタです.
     //-------------------------------------------------------------------------
-    ScopedLock(SpinLock& value)
-    : m_SpinLock(value)
-    { m_SpinLock.lock(); }
+    LockGuard(LockType& value)
+    : m_Lock(value)
+    { m_Lock.lock(); }
 
     //-------------------------------------------------------------------------
     //! @brief      デストラクタです.
     //-------------------------------------------------------------------------
-    ~ScopedLock()
-    { m_SpinLock.unlock(); }
+    ~LockGuard()
+    { m_Lock.unlock(); }
+
+    LockGuard(const LockGuard&) = delete;
+    LockGuard& operator = (const LockGuard&) = delete;
 
 private:
     //=========================================================================
     // private variables.
     //=========================================================================
-    SpinLock&   m_SpinLock;
+    LockType&   m_Lock;
 
     //=========================================================================
     // private methods.
@@ -106,4 +159,9 @@ private:
     /* NOTHING */
 };
 
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using ScopedLock = LockGuard<SpinLock>;
+
 } // namespace asf
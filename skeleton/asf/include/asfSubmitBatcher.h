@@ -0,0 +1,148 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfSubmitBatcher.h
+// Desc : Command List Submission Batcher.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <asfCommandQueue.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// SubmitBatcherDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct SubmitBatcherDesc
+{
+    ICommandQueue*  pQueue      = nullptr;  //!< 投入先のキュー.
+    uint32_t        MaxLists    = 32;       //!< 溜まったリスト数がこの値に達すると投入します.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SubmitBatcherStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct SubmitBatcherStats
+{
+    uint64_t    RequestCount    = 0;    //!< Execute() の呼び出し回数 (バッチ化しない場合の投入回数).
+    uint64_t    ListCount       = 0;    //!< 受け付けたコマンドリスト数.
+    uint64_t    SubmitCount     = 0;    //!< キューの Execute() を呼び出した回数.
+    uint64_t    SizeFlushCount  = 0;    //!< MaxLists に達したことによる投入回数.
+    uint64_t    SubmitTimeNs    = 0;    //!< キューの Execute() に掛かった時間の合計 (ナノ秒).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SubmitBatcher class
+///////////////////////////////////////////////////////////////////////////////
+class SubmitBatcher
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SubmitBatcher() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~SubmitBatcher();
+
+    SubmitBatcher(const SubmitBatcher&) = delete;
+    SubmitBatcher& operator = (const SubmitBatcher&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      desc        構成設定.
+    //! @retval true    初期化に成功しました.
+    //! @retval false   初期化に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(const SubmitBatcherDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います. 溜まっているリストは投入されます.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      クローズ済みのコマンドリストを溜めます.
+    //!
+    //! @details    溜まったリスト数が MaxLists に達した場合のみ, 1回の Execute() でキューに投入します.
+    //!             リストは投入されるまで再利用しないでください.
+    //!
+    //! @param[in]      count       コマンドリストの数.
+    //! @param[in]      ppLists     コマンドリストの配列です.
+    //-------------------------------------------------------------------------
+    void Execute(uint32_t count, ID3D12CommandList** ppLists);
+
+    //-------------------------------------------------------------------------
+    //! @brief      溜まっているリストを投入してから, フェンスの値を更新します.
+    //!
+    //! @details    フェンス値はキューが発行するため, 返却する待機点が確定するよう Signal() を投入点とします.
+    //!             連続する Execute() はまとめて投入されるため, 順序は直接呼び出した場合と変わりません.
+    //-------------------------------------------------------------------------
+    WaitPoint Signal();
+
+    //-------------------------------------------------------------------------
+    //! @brief      溜まっているリストを投入してから, GPUでの待機点を設定します.
+    //-------------------------------------------------------------------------
+    bool Wait(const WaitPoint& value);
+
+    //-------------------------------------------------------------------------
+    //! @brief      溜まっているリストを投入してから, CPU上で完了を待機します.
+    //-------------------------------------------------------------------------
+    void Sync(const WaitPoint& value, uint32_t msec);
+
+    //-------------------------------------------------------------------------
+    //! @brief      溜まっているリストを投入します.
+    //-------------------------------------------------------------------------
+    void Flush();
+
+    //-------------------------------------------------------------------------
+    //! @brief      溜まっているリスト数を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetPendingCount() const
+    { return uint32_t(m_Pending.size()); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    const SubmitBatcherStats& GetStats() const
+    { return m_Stats; }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    ICommandQueue*                  m_pQueue    = nullptr;
+    uint32_t                        m_MaxLists  = 0;
+    std::vector<ID3D12CommandList*> m_Pending;
+    SubmitBatcherStats              m_Stats;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    /* NOTHING */
+};
+
+} // namespace asf
@@ -0,0 +1,188 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfSubmitThread.h
+// Desc : Dedicated Command List Submission Thread.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <asfCommandQueue.h>
+#include <asfIndexPool.h>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t MAX_SUBMIT_LISTS = 8;     //!< 1回の Submit() で渡せるコマンドリストの最大数.
+
+///////////////////////////////////////////////////////////////////////////////
+// SubmitThreadDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct SubmitThreadDesc
+{
+    ICommandQueue*  pQueue      = nullptr;  //!< 投入先のキュー. 投入スレッドのみが使用します.
+    uint32_t        MaxRequests = 1024;     //!< 投入待ちにできる要求数.
+    uint32_t        MaxLists    = 32;       //!< 1回の Execute() にまとめる最大リスト数.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SubmitThread class
+///////////////////////////////////////////////////////////////////////////////
+class SubmitThread
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SubmitThread() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~SubmitThread();
+
+    SubmitThread(const SubmitThread&) = delete;
+    SubmitThread& operator = (const SubmitThread&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います. 順序キーは 0 から始まります.
+    //!
+    //! @param[in]      desc        構成設定.
+    //! @retval true    初期化に成功しました.
+    //! @retval false   初期化に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(const SubmitThreadDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います. 順序キーが連続している要求は全て投入されます.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      クローズ済みのコマンドリストの投入を要求します.
+    //!
+    //! @details    任意のスレッドから呼び出せます. 事前に確保したプールからロックフリーで
+    //!             取得するため, ヒープ確保やキューのドライバ処理は呼び出しスレッドで発生しません.
+    //!             投入スレッドは順序キーの昇順に投入し, 抜けているキューがあれば揃うまで待ちます.
+    //!             各キーは一度だけ使用してください.
+    //!
+    //! @param[in]      key         順序キー. 投入済みのキーから MaxRequests の範囲で指定します.
+    //! @param[in]      count       コマンドリストの数 (MAX_SUBMIT_LISTS 以下).
+    //! @param[in]      ppLists     コマンドリストの配列です. 空の要求にする場合は count に 0 を指定します.
+    //! @retval true    要求に成功しました.
+    //! @retval false   プールが枯渇しているか, キーが範囲外か, 引数が不正です.
+    //!                 投入スレッドが追いついていない場合は, 時間をおいて再試行できます.
+    //-------------------------------------------------------------------------
+    bool Submit(uint64_t key, uint32_t count, ID3D12CommandList* const* ppLists);
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定した順序キーまでが投入されるまで待機します.
+    //!
+    //! @details    投入スレッドは連続したキーをまとめて投入した後にシグナルを発行します.
+    //!             返却する待機点は指定したキー以降のシグナルであるため, GPUでの完了待ちに使用できます.
+    //!
+    //! @param[in]      key         順序キー.
+    //! @return     指定したキーのリストを含むシグナルの待機点を返却します.
+    //-------------------------------------------------------------------------
+    WaitPoint WaitSubmitted(uint64_t key);
+
+    //-------------------------------------------------------------------------
+    //! @brief      次に投入する順序キーを取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetNextKey() const
+    { return m_NextKey.load(std::memory_order_acquire); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      キューの Execute() を呼び出した回数を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetSubmitCount() const
+    { return m_SubmitCount.load(std::memory_order_relaxed); }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Node structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Node
+    {
+        uint64_t                Key;
+        uint32_t                Count;
+        ID3D12CommandList*      pLists[MAX_SUBMIT_LISTS];
+        std::atomic<uint32_t>   Next;
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    ICommandQueue*                  m_pQueue        = nullptr;
+    Node*                           m_pNodes        = nullptr;
+    uint32_t                        m_NodeCount     = 0;
+    uint32_t                        m_MaxLists      = 0;
+    IndexPool                       m_FreeNodes;                //!< 未使用のノード.
+    IndexStack                      m_Pending;                  //!< 投入待ちのノード (LIFO).
+    std::vector<uint32_t>           m_Reorder;                  //!< キー順に並べたノード番号. 投入スレッドのみが使用します.
+    std::vector<ID3D12CommandList*> m_Batch;                    //!< 投入スレッドのみが使用します.
+    std::mutex                      m_WakeMutex;
+    std::condition_variable         m_WakeCond;
+    bool                            m_WakeRequested = false;    //!< m_WakeMutex で保護します.
+    std::mutex                      m_DoneMutex;
+    std::condition_variable         m_DoneCond;
+    WaitPoint                       m_LastPoint;                //!< m_DoneMutex で保護します.
+    std::atomic<uint64_t>           m_NextKey       = { 0 };
+    std::atomic<uint64_t>           m_SubmitCount   = { 0 };
+    std::atomic<bool>               m_Running       = { false };
+    std::thread                     m_Thread;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      投入スレッドを起床させます.
+    //-------------------------------------------------------------------------
+    void Wake();
+
+    //-------------------------------------------------------------------------
+    //! @brief      投入待ちのノードをキー順に並べます.
+    //-------------------------------------------------------------------------
+    void Collect();
+
+    //-------------------------------------------------------------------------
+    //! @brief      連続したキーのリストをまとめて投入し, シグナルを発行します.
+    //!
+    //! @retval true    1件以上投入しました.
+    //! @retval false   投入可能な要求がありません.
+    //-------------------------------------------------------------------------
+    bool Drain();
+
+    //-------------------------------------------------------------------------
+    //! @brief      投入スレッドの処理です.
+    //-------------------------------------------------------------------------
+    void Run();
+};
+
+} // namespace asf
@@ -0,0 +1,29 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfTime.h
+// Desc : Time Utilities.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <chrono>
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+//! @brief      単調増加する現在時刻をナノ秒単位で取得します.
+//!
+//! @details    std::chrono::steady_clock を使用します. 経過時間の計測やスレッド間の順序付けに使用し,
+//!             実時刻 (UNIX 時刻) が必要な場合は system_clock を使用してください.
+//-----------------------------------------------------------------------------
+inline uint64_t GetSteadyTimeNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace asf
@@ -0,0 +1,113 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfAdaptiveLock.cpp
+// Desc : Spin-then-park Lock.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfAdaptiveLock.h>
+
+#if defined(_WIN32)
+  #include <Windows.h>
+  #pragma comment(lib, "Synchronization.lib")
+#elif defined(__linux__)
+  #include <climits>
+  #include <unistd.h>
+  #include <sys/syscall.h>
+  #include <linux/futex.h>
+#else
+  #include <thread>
+#endif
+
+
+namespace asf {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "std::atomic<uint32_t> Size Not Match");
+
+//-----------------------------------------------------------------------------
+//      値が変化するまで待機します.
+//-----------------------------------------------------------------------------
+void WaitAddress(std::atomic<uint32_t>& value, uint32_t expected)
+{
+#if defined(_WIN32)
+    WaitOnAddress(&value, &expected, sizeof(expected), INFINITE);
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&value), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    if (value.load(std::memory_order_relaxed) == expected)
+    { std::this_thread::yield(); }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      待機しているスレッドを1つ起床させます.
+//-----------------------------------------------------------------------------
+void WakeAddressOne(std::atomic<uint32_t>& value)
+{
+#if defined(_WIN32)
+    WakeByAddressSingle(&value);
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&value), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    (void)value;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      待機している全てのスレッドを起床させます.
+//-----------------------------------------------------------------------------
+void WakeAddressAll(std::atomic<uint32_t>& value)
+{
+#if defined(_WIN32)
+    WakeByAddressAll(&value);
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&value), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)value;
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AdaptiveLock class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      競合時のロック処理を行います.
+//-----------------------------------------------------------------------------
+void AdaptiveLock::LockSlow()
+{
+    // 指数バックオフ付きでスピン.
+    uint32_t spin    = 0;
+    uint32_t backoff = 1;
+    while (spin < m_SpinCount)
+    {
+        for(auto i=0u; i<backoff; ++i)
+        { _mm_pause(); }
+
+        spin += backoff;
+        if (backoff < MAX_BACKOFF)
+        { backoff <<= 1; }
+
+        // 読み取りのみで空くのを待ち, キャッシュラインの奪い合いを避ける.
+        auto state = m_State.load(std::memory_order_relaxed);
+        if (state == UNLOCKED)
+        {
+            if (m_State.compare_exchange_weak(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+            { return; }
+        }
+        else if (state == CONTENDED)
+        {
+            // 既に待機スレッドがいる場合はスピンを打ち切る.
+            break;
+        }
+    }
+
+    // 待機状態に入る. 解放時に起床させてもらえるよう CONTENDED を設定する.
+    while (m_State.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED)
+    { WaitAddress(m_State, CONTENDED); }
+}
+
+} // namespace asf
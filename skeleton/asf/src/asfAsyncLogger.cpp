@@ -0,0 +1,673 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfAsyncLogger.cpp
+// Desc : Asynchronous Logger.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdarg>
+#include <cwchar>
+#include <cstring>
+#include <new>
+#include <chrono>
+#include <asfAsyncLogger.h>
+#include <asfAdaptiveLock.h>
+
+#if defined(_WIN32)
+  #include <Windows.h>
+#else
+  #include <cerrno>
+  #include <csignal>
+  #include <unistd.h>
+#endif
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t CRASH_WAIT_COUNT = 1u << 20;  // クラッシュ時にバックグラウンドスレッドを待つスピン回数.
+static constexpr char     CRASH_SKIPPED[]  = "AsyncLogger : crash flush skipped. consumer is busy.\n";
+static constexpr uint32_t IDLE_POLL_USEC   = 500;       // 空の場合のポーリング間隔 (マイクロ秒).
+static constexpr uint32_t IDLE_POLL_COUNT  = 200;       // 待機状態に入るまでのポーリング回数.
+
+//-----------------------------------------------------------------------------
+// Global Variables.
+//-----------------------------------------------------------------------------
+std::atomic<asf::AsyncLogger*>  g_pCrashLogger = { nullptr };
+
+#if defined(_WIN32)
+LPTOP_LEVEL_EXCEPTION_FILTER    g_PrevFilter  = nullptr;
+HANDLE                          g_CrashOutput = INVALID_HANDLE_VALUE;
+
+//-----------------------------------------------------------------------------
+//      クラッシュ時の出力先に書き込みます.
+//-----------------------------------------------------------------------------
+void WriteCrashOutput(const char* pData, size_t size)
+{
+    if (g_CrashOutput == INVALID_HANDLE_VALUE || g_CrashOutput == nullptr)
+    { return; }
+
+    DWORD written = 0;
+    WriteFile(g_CrashOutput, pData, DWORD(size), &written, nullptr);
+}
+
+//-----------------------------------------------------------------------------
+//      未処理例外フィルタです.
+//-----------------------------------------------------------------------------
+LONG WINAPI CrashFilter(EXCEPTION_POINTERS* pInfo)
+{
+    auto pLogger = g_pCrashLogger.exchange(nullptr);
+    if (pLogger != nullptr)
+    { pLogger->FlushOnCrash(); }
+
+    return (g_PrevFilter != nullptr) ? g_PrevFilter(pInfo) : EXCEPTION_CONTINUE_SEARCH;
+}
+
+//-----------------------------------------------------------------------------
+//      クラッシュハンドラを登録します.
+//-----------------------------------------------------------------------------
+void InstallCrashHandler()
+{
+    static std::atomic<bool> s_Installed = { false };
+    if (s_Installed.exchange(true))
+    { return; }
+
+    g_CrashOutput = GetStdHandle(STD_ERROR_HANDLE);
+    g_PrevFilter  = SetUnhandledExceptionFilter(CrashFilter);
+}
+
+#else
+const int           g_Signals[]     = { SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS };
+struct sigaction    g_PrevActions[sizeof(g_Signals) / sizeof(g_Signals[0])] = {};
+int                 g_CrashOutput   = -1;
+
+//-----------------------------------------------------------------------------
+//      クラッシュ時の出力先に書き込みます. シグナルハンドラから呼び出せます.
+//-----------------------------------------------------------------------------
+void WriteCrashOutput(const char* pData, size_t size)
+{
+    if (g_CrashOutput < 0)
+    { return; }
+
+    while (size > 0)
+    {
+        auto written = write(g_CrashOutput, pData, size);
+        if (written < 0 && errno == EINTR)
+        { continue; }
+        if (written <= 0)
+        { return; }
+
+        pData += written;
+        size  -= size_t(written);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      シグナルハンドラです.
+//-----------------------------------------------------------------------------
+void CrashHandler(int sig)
+{
+    auto pLogger = g_pCrashLogger.exchange(nullptr);
+    if (pLogger != nullptr)
+    { pLogger->FlushOnCrash(); }
+
+    // 登録前のハンドラに戻してから再送出する. 既定の動作の場合はプロセスが終了する.
+    for(size_t i=0; i<sizeof(g_Signals) / sizeof(g_Signals[0]); ++i)
+    {
+        if (g_Signals[i] == sig)
+        {
+            sigaction(sig, &g_PrevActions[i], nullptr);
+            break;
+        }
+    }
+
+    raise(sig);
+}
+
+//-----------------------------------------------------------------------------
+//      クラッシュハンドラを登録します.
+//-----------------------------------------------------------------------------
+void InstallCrashHandler()
+{
+    static std::atomic<bool> s_Installed = { false };
+    if (s_Installed.exchange(true))
+    { return; }
+
+    // 後から標準エラー出力が閉じられても書き出せるよう, 複製を保持しておく.
+    g_CrashOutput = dup(STDERR_FILENO);
+
+    struct sigaction action = {};
+    action.sa_handler = CrashHandler;
+    action.sa_flags   = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+
+    for(size_t i=0; i<sizeof(g_Signals) / sizeof(g_Signals[0]); ++i)
+    { sigaction(g_Signals[i], &action, &g_PrevActions[i]); }
+}
+#endif
+
+//-----------------------------------------------------------------------------
+//      終端文字までの長さを取得します. シグナルハンドラから呼び出せます.
+//-----------------------------------------------------------------------------
+size_t GetCrashLength(const char* pText, size_t maxLength)
+{
+    size_t length = 0;
+    while (length < maxLength && pText[length] != '\0')
+    { length++; }
+    return length;
+}
+
+//-----------------------------------------------------------------------------
+//      2のべき乗に切り上げます.
+//-----------------------------------------------------------------------------
+uint64_t RoundUpPow2(uint64_t value)
+{
+    uint64_t result = 1;
+    while (result < value)
+    { result <<= 1; }
+    return result;
+}
+
+#if !defined(_WIN32)
+//-----------------------------------------------------------------------------
+//      セキュア版フォーマット関数の代替です.
+//-----------------------------------------------------------------------------
+int vsnprintf_s(char* buffer, size_t size, size_t, const char* format, va_list arg)
+{ return vsnprintf(buffer, size, format, arg); }
+
+int _vsnwprintf_s(wchar_t* buffer, size_t size, size_t, const wchar_t* format, va_list arg)
+{ return vswprintf(buffer, size, format, arg); }
+
+#ifndef _TRUNCATE
+#define _TRUNCATE   (size_t(-1))
+#endif
+#endif
+
+} // namespace
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncLogger class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+AsyncLogger::~AsyncLogger()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool AsyncLogger::Init(const AsyncLoggerDesc& desc)
+{
+    if (desc.Capacity == 0)
+    {
+        ELOGA("Error : Invalid Argument. Capacity = 0.");
+        return false;
+    }
+
+    auto capacity = RoundUpPow2(desc.Capacity);
+    m_pSlots = new (std::nothrow) Slot[size_t(capacity)];
+    if (m_pSlots == nullptr)
+    {
+        ELOGA("Error : Out of Memory. capacity = %llu", static_cast<unsigned long long>(capacity));
+        return false;
+    }
+
+    for(uint64_t i=0; i<capacity; ++i)
+    { m_pSlots[i].Sequence.store(i, std::memory_order_relaxed); }
+
+    m_Mask          = capacity - 1;
+    m_Policy        = desc.Policy;
+    m_pSink         = (desc.pSink != nullptr) ? desc.pSink : GetDefaultLogger();
+    m_DropReported  = 0;
+    m_EnqueuePos.store(0, std::memory_order_relaxed);
+    m_DequeuePos.store(0, std::memory_order_relaxed);
+    m_DropCount .store(0, std::memory_order_relaxed);
+
+    if (desc.RecordPath != nullptr)
+    {
+        m_pRecordFile = fopen(desc.RecordPath, "wb");
+        if (m_pRecordFile == nullptr)
+        {
+            ELOGA("Error : Record File Open Failed. path = %s", desc.RecordPath);
+            delete[] m_pSlots;
+            m_pSlots = nullptr;
+            return false;
+        }
+
+        const uint32_t header[2] = { LOG_FILE_MAGIC, LOG_FILE_VERSION };
+        fwrite(header, sizeof(header), 1, m_pRecordFile);
+        m_SiteWritten.clear();
+    }
+
+    m_Running.store(true, std::memory_order_release);
+    m_Thread = std::thread(&AsyncLogger::Run, this);
+
+    m_CrashHandler = desc.InstallCrashHandler;
+    if (m_CrashHandler)
+    {
+        InstallCrashHandler();
+        g_pCrashLogger.store(this);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void AsyncLogger::Term()
+{
+    if (GetLogRecordWriter() == this)
+    { SetLogRecordWriter(nullptr); }
+
+    if (m_CrashHandler)
+    {
+        auto pThis = this;
+        g_pCrashLogger.compare_exchange_strong(pThis, nullptr);
+        m_CrashHandler = false;
+    }
+
+    if (m_Thread.joinable())
+    {
+        m_Running.store(false, std::memory_order_seq_cst);
+        m_Sleeping.store(0, std::memory_order_seq_cst);
+        WakeAddressOne(m_Sleeping);
+        m_Thread.join();
+    }
+
+    if (m_pSlots != nullptr)
+    {
+        Drain();
+        delete[] m_pSlots;
+        m_pSlots = nullptr;
+    }
+
+    if (m_pRecordFile != nullptr)
+    {
+        fclose(m_pRecordFile);
+        m_pRecordFile = nullptr;
+    }
+
+    m_pSink = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      ログを出力します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::WriteA(LOG_LEVEL level, const char* format, ...)
+{
+    uint64_t pos  = 0;
+    auto pSlot = Acquire(pos);
+    if (pSlot == nullptr)
+    { return; }
+
+    pSlot->Level = level;
+    pSlot->Kind  = SLOT_KIND_TEXT_A;
+
+    auto msg = reinterpret_cast<char*>(pSlot->Data);
+    va_list arg;
+    va_start(arg, format);
+    vsnprintf_s(msg, SLOT_SIZE, _TRUNCATE, format, arg);
+    va_end(arg);
+
+    Publish(pSlot, pos);
+}
+
+//-----------------------------------------------------------------------------
+//      ログを出力します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::WriteW(LOG_LEVEL level, const wchar_t* format, ...)
+{
+    uint64_t pos  = 0;
+    auto pSlot = Acquire(pos);
+    if (pSlot == nullptr)
+    { return; }
+
+    pSlot->Level = level;
+    pSlot->Kind  = SLOT_KIND_TEXT_W;
+
+    const auto count = SLOT_SIZE / sizeof(wchar_t);
+    auto msg = reinterpret_cast<wchar_t*>(pSlot->Data);
+    msg[0] = L'\0';
+
+    va_list arg;
+    va_start(arg, format);
+    _vsnwprintf_s(msg, count, _TRUNCATE, format, arg);
+    va_end(arg);
+    msg[count - 1] = L'\0';
+
+    Publish(pSlot, pos);
+}
+
+//-----------------------------------------------------------------------------
+//      ログレコードを書き込みます.
+//-----------------------------------------------------------------------------
+void AsyncLogger::WriteRecord(const LogSite& site, uint64_t timestamp, const void* pArgs, uint32_t argSize)
+{
+    static_assert(sizeof(RecordHeader) + LOG_RECORD_ARGS_SIZE <= SLOT_SIZE, "Slot Size Too Small");
+
+    uint64_t pos  = 0;
+    auto pSlot = Acquire(pos);
+    if (pSlot == nullptr)
+    { return; }
+
+    pSlot->Level = site.Level;
+    pSlot->Kind  = SLOT_KIND_RECORD;
+
+    RecordHeader header;
+    header.pSite     = &site;
+    header.Timestamp = timestamp;
+    header.ArgSize   = argSize;
+    memcpy(pSlot->Data, &header, sizeof(header));
+    memcpy(pSlot->Data + sizeof(header), pArgs, argSize);
+
+    Publish(pSlot, pos);
+}
+
+//-----------------------------------------------------------------------------
+//      呼び出し時点までに書き込まれたログが出力されるまで待機します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::Flush()
+{
+    if (m_pSlots == nullptr)
+    { return; }
+
+    auto target = m_EnqueuePos.load(std::memory_order_acquire);
+    while (m_DequeuePos.load(std::memory_order_acquire) < target)
+    {
+        if (m_Sleeping.exchange(0, std::memory_order_seq_cst) != 0)
+        { WakeAddressOne(m_Sleeping); }
+        std::this_thread::yield();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      クラッシュ時に残っているログを呼び出しスレッドで出力します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::FlushOnCrash()
+{
+    if (m_pSlots == nullptr)
+    { return; }
+
+    // バックグラウンドスレッドの出力が終わるのを一定時間だけ待つ.
+    // 排他を取得できない場合は出力中のスロットと競合するため, スロットには触れない.
+    auto acquired = false;
+    for(auto i=0u; i<CRASH_WAIT_COUNT && !acquired; ++i)
+    {
+        bool expected = false;
+        acquired = m_Consuming.compare_exchange_weak(expected, true, std::memory_order_acquire);
+        if (!acquired)
+        { _mm_pause(); }
+    }
+
+    if (!acquired)
+    {
+        WriteCrashOutput(CRASH_SKIPPED, sizeof(CRASH_SKIPPED) - 1);
+        return;
+    }
+
+    auto pos = m_DequeuePos.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        auto pSlot = &m_pSlots[pos & m_Mask];
+        if (pSlot->Sequence.load(std::memory_order_acquire) != pos + 1)
+        { break; }
+
+        switch(pSlot->Kind)
+        {
+        case SLOT_KIND_TEXT_A:
+            {
+                auto msg = reinterpret_cast<const char*>(pSlot->Data);
+                WriteCrashOutput(msg, GetCrashLength(msg, SLOT_SIZE));
+            }
+            break;
+
+        case SLOT_KIND_TEXT_W:
+            {
+                // ロケールに依存する変換は行わず, ASCII のみをそのまま出力する.
+                const auto count = SLOT_SIZE / sizeof(wchar_t);
+                auto msg = reinterpret_cast<const wchar_t*>(pSlot->Data);
+                char text[count];
+                size_t length = 0;
+                while (length < count && msg[length] != L'\0')
+                {
+                    auto c = msg[length];
+                    text[length] = (0 < c && c < 0x80) ? char(c) : '?';
+                    length++;
+                }
+                WriteCrashOutput(text, length);
+            }
+            break;
+
+        case SLOT_KIND_RECORD:
+            {
+                // 引数のフォーマットはメモリ確保を伴う可能性があるため, 書式文字列のみを出力する.
+                RecordHeader header;
+                memcpy(&header, pSlot->Data, sizeof(header));
+                auto format = header.pSite->Format;
+                WriteCrashOutput(format, GetCrashLength(format, SLOT_SIZE));
+            }
+            break;
+        }
+
+        pSlot->Sequence.store(pos + m_Mask + 1, std::memory_order_release);
+        pos++;
+        m_DequeuePos.store(pos, std::memory_order_release);
+    }
+
+    m_Consuming.store(false, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+//      書き込み先のスロットを確保します.
+//-----------------------------------------------------------------------------
+AsyncLogger::Slot* AsyncLogger::Acquire(uint64_t& result)
+{
+    if (m_pSlots == nullptr)
+    { return nullptr; }
+
+    auto pos = m_EnqueuePos.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        auto pSlot = &m_pSlots[pos & m_Mask];
+        auto seq   = pSlot->Sequence.load(std::memory_order_acquire);
+        auto diff  = int64_t(seq) - int64_t(pos);
+
+        if (diff == 0)
+        {
+            if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                result = pos;
+                return pSlot;
+            }
+        }
+        else if (diff < 0)
+        {
+            // 満杯.
+            if (m_Policy == ASYNC_LOG_POLICY_DROP)
+            {
+                m_DropCount.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            if (m_Sleeping.exchange(0, std::memory_order_seq_cst) != 0)
+            { WakeAddressOne(m_Sleeping); }
+            std::this_thread::yield();
+            pos = m_EnqueuePos.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            pos = m_EnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      スロットを公開し, バックグラウンドスレッドを起床させます.
+//-----------------------------------------------------------------------------
+void AsyncLogger::Publish(Slot* pSlot, uint64_t pos)
+{
+    pSlot->Sequence.store(pos + 1, std::memory_order_seq_cst);
+
+    // 待機中の場合のみシステムコールを発行する.
+    if (m_Sleeping.load(std::memory_order_seq_cst) != 0
+     && m_Sleeping.exchange(0, std::memory_order_seq_cst) != 0)
+    { WakeAddressOne(m_Sleeping); }
+}
+
+//-----------------------------------------------------------------------------
+//      公開済みのスロットを全て出力します.
+//-----------------------------------------------------------------------------
+bool AsyncLogger::Drain()
+{
+    auto processed = false;
+    auto pos = m_DequeuePos.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        auto pSlot = &m_pSlots[pos & m_Mask];
+        if (pSlot->Sequence.load(std::memory_order_acquire) != pos + 1)
+        { break; }
+
+        switch(pSlot->Kind)
+        {
+        case SLOT_KIND_TEXT_A:
+            m_pSink->WriteA(pSlot->Level, "%s", reinterpret_cast<const char*>(pSlot->Data));
+            break;
+
+        case SLOT_KIND_TEXT_W:
+            m_pSink->WriteW(pSlot->Level, L"%ls", reinterpret_cast<const wchar_t*>(pSlot->Data));
+            break;
+
+        case SLOT_KIND_RECORD:
+            OutputRecord(pSlot);
+            break;
+        }
+
+        pSlot->Sequence.store(pos + m_Mask + 1, std::memory_order_release);
+        pos++;
+        m_DequeuePos.store(pos, std::memory_order_release);
+        processed = true;
+    }
+
+    auto dropCount = m_DropCount.load(std::memory_order_relaxed);
+    if (dropCount != m_DropReported)
+    {
+        m_pSink->WriteA(LOG_WARNING, "AsyncLogger : %llu messages dropped.\n",
+            static_cast<unsigned long long>(dropCount - m_DropReported));
+        m_DropReported = dropCount;
+    }
+
+    return processed;
+}
+
+//-----------------------------------------------------------------------------
+//      ログレコードを出力します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::OutputRecord(const Slot* pSlot)
+{
+    RecordHeader header;
+    memcpy(&header, pSlot->Data, sizeof(header));
+
+    auto pSite = header.pSite;
+    auto pArgs = pSlot->Data + sizeof(header);
+
+    if (m_pRecordFile == nullptr)
+    {
+        char msg[SLOT_SIZE];
+        FormatLogRecord(pSite->Format, pSite->File, pSite->Line, pSite->Flags, pArgs, header.ArgSize, msg, sizeof(msg));
+        m_pSink->WriteA(pSlot->Level, "%s", msg);
+        return;
+    }
+
+    // 初出の呼び出し元は定義を先に書き出す.
+    auto id = pSite->Id.load(std::memory_order_relaxed);
+    if (id >= m_SiteWritten.size())
+    { m_SiteWritten.resize(id + 1, false); }
+
+    if (!m_SiteWritten[id])
+    {
+        auto fileLength   = uint16_t(strnlen(pSite->File,   UINT16_MAX));
+        auto formatLength = uint16_t(strnlen(pSite->Format, UINT16_MAX));
+        auto level        = uint32_t(pSite->Level);
+        auto line         = uint32_t(pSite->Line);
+        auto flags        = pSite->Flags;
+        auto chunk        = uint8_t(LOG_FILE_CHUNK_SITE);
+
+        fwrite(&chunk,          sizeof(chunk),          1, m_pRecordFile);
+        fwrite(&id,             sizeof(id),             1, m_pRecordFile);
+        fwrite(&level,          sizeof(level),          1, m_pRecordFile);
+        fwrite(&line,           sizeof(line),           1, m_pRecordFile);
+        fwrite(&flags,          sizeof(flags),          1, m_pRecordFile);
+        fwrite(&fileLength,     sizeof(fileLength),     1, m_pRecordFile);
+        fwrite(&formatLength,   sizeof(formatLength),   1, m_pRecordFile);
+        fwrite(pSite->File,     1, fileLength,             m_pRecordFile);
+        fwrite(pSite->Format,   1, formatLength,           m_pRecordFile);
+
+        m_SiteWritten[id] = true;
+    }
+
+    auto chunk   = uint8_t(LOG_FILE_CHUNK_RECORD);
+    auto argSize = uint16_t(header.ArgSize);
+    fwrite(&chunk,              sizeof(chunk),              1, m_pRecordFile);
+    fwrite(&id,                 sizeof(id),                 1, m_pRecordFile);
+    fwrite(&header.Timestamp,   sizeof(header.Timestamp),   1, m_pRecordFile);
+    fwrite(&argSize,            sizeof(argSize),            1, m_pRecordFile);
+    fwrite(pArgs,               1, argSize,                    m_pRecordFile);
+}
+
+//-----------------------------------------------------------------------------
+//      バックグラウンドスレッドの処理です.
+//-----------------------------------------------------------------------------
+void AsyncLogger::Run()
+{
+    uint32_t idleCount = 0;
+    while (m_Running.load(std::memory_order_acquire))
+    {
+        // クラッシュ時の出力と同時に出力しないよう排他する.
+        while (m_Consuming.exchange(true, std::memory_order_acquire))
+        { std::this_thread::yield(); }
+
+        auto processed = Drain();
+        m_Consuming.store(false, std::memory_order_release);
+
+        if (processed)
+        {
+            idleCount = 0;
+            continue;
+        }
+
+        // 書き込みが続いている間は短い間隔でポーリングし, 書き込み側のシステムコールを避ける.
+        if (idleCount < IDLE_POLL_COUNT)
+        {
+            idleCount++;
+            std::this_thread::sleep_for(std::chrono::microseconds(IDLE_POLL_USEC));
+            continue;
+        }
+
+        // 一定時間空のままなら待機する. 書き込み側は m_Sleeping を見て起床させる.
+        m_Sleeping.store(1, std::memory_order_seq_cst);
+
+        auto pos = m_DequeuePos.load(std::memory_order_relaxed);
+        if (m_pSlots[pos & m_Mask].Sequence.load(std::memory_order_seq_cst) == pos + 1
+        || !m_Running.load(std::memory_order_seq_cst))
+        {
+            m_Sleeping.store(0, std::memory_order_relaxed);
+            continue;
+        }
+
+        WaitAddress(m_Sleeping, 1);
+        idleCount = 0;
+    }
+}
+
+} // namespace asf
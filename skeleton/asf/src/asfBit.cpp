@@ -21,6 +21,8 @@
 namespace asf {
 namespace impl {
 
+#if !_HAS_CXX20
+
 static int CountBit8(uint8_t v)
 {
     uint8_t count = v;
@@ -30,6 +32,21 @@ static int CountBit8(uint8_t v)
     return int(count);
 }
 
+static int CountZeroL(uint8_t value)
+{
+    value |= (value >> 1);
+    value |= (value >> 2);
+    value |= (value >> 4);
+    return CountBit8(~value); 
+}
+
+static int CountZeroR(uint8_t  value) { return CountBit8 ((~value) & (value - 1)); }
+
+#endif
+
+#if !_HAS_CXX20 && !defined(__clang__) && !defined(__GNUC__) && !defined(_MSC_VER)
+// Fallback でのみ使用します.
+
 static int CountBit16(uint16_t v)
 {
     uint16_t count = v;
@@ -63,14 +80,6 @@ static int CountBit64(uint64_t v)
     return int(count);
 }
 
-static int CountZeroL(uint8_t value)
-{
-    value |= (value >> 1);
-    value |= (value >> 2);
-    value |= (value >> 4);
-    return CountBit8(~value); 
-}
-
 static int CountZeroL(uint16_t value)
 {
     value |= (value >> 1);
@@ -101,11 +110,12 @@ static int CountZeroL(uint64_t value)
     return CountBit64(~value);
 }
 
-static int CountZeroR(uint8_t  value) { return CountBit8 ((~value) & (value - 1)); }
 static int CountZeroR(uint16_t value) { return CountBit16((~value) & (value - 1)); }
 static int CountZeroR(uint32_t value) { return CountBit32((~value) & (value - 1)); }
 static int CountZeroR(uint64_t value) { return CountBit64((~value) & (value - 1)); }
 
+#endif
+
 } // namespace impl
 
 #if !_HAS_CXX20
@@ -137,16 +147,15 @@ int CountZeroR(uint64_t value) { return std::countr_zero(value); }
 #elif defined(__clang__) || defined(__GNUC__)
 // GCC or clang.
 
-int CountBit(uint8_t  value) { return __builtin_popcount(value); }
 int CountBit(uint16_t value) { return __builtin_popcount(value); }
 int CountBit(uint32_t value) { return __builtin_popcount(value); }
 int CountBit(uint64_t value) { return __builtin_popcountll(value); }
 
-int CountZeroL(uint16_t value) { return __builtin_clzs(value); }
+int CountZeroL(uint16_t value) { return __builtin_clz(uint32_t(value)) - 16; }
 int CountZeroL(uint32_t value) { return __builtin_clz(value); }
 int CountZeroL(uint64_t value) { return __builtin_clzll(value); }
 
-int CountZeroR(uint16_t value) { return __builtin_ctzs(value); }
+int CountZeroR(uint16_t value) { return __builtin_ctz(uint32_t(value)); }
 int CountZeroR(uint32_t value) { return __builtin_ctz(value); }
 int CountZeroR(uint64_t value) { return __builtin_ctzll(value); }
 
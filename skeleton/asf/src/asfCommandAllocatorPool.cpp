@@ -0,0 +1,305 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfCommandAllocatorPool.cpp
+// Desc : Fence-tracked Command Allocator Pool.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfCommandAllocatorPool.h>
+#include <asfLogger.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t SOFT_ALLOCATOR_MAGIC  = 0x41534641;   // ソフトウェアアロケータの識別子 ('AFSA').
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftAllocatorHandle structure
+///////////////////////////////////////////////////////////////////////////////
+struct SoftAllocatorHandle
+{
+    uint32_t    Magic;      //!< SOFT_ALLOCATOR_MAGIC.
+};
+
+//-----------------------------------------------------------------------------
+//      待機点が完了しているかどうか.
+//-----------------------------------------------------------------------------
+bool IsCompleted(const asf::WaitPoint& point)
+{ return point.pFence == nullptr || point.pFence->GetCompletedValue() >= point.FenceValue; }
+
+} // namespace
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// CommandAllocatorPool class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+CommandAllocatorPool::~CommandAllocatorPool()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool CommandAllocatorPool::Init(const CommandAllocatorPoolDesc& desc)
+{
+    if (desc.MaxCount == 0)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    for(auto i=0; i<COMMAND_ALLOCATOR_CLASS_COUNT; ++i)
+    {
+        if (desc.InitialCount[i] > desc.MaxCount)
+        {
+            ELOG("Error : Invalid Argument. InitialCount[%d] = %u, MaxCount = %u", i, desc.InitialCount[i], desc.MaxCount);
+            return false;
+        }
+    }
+
+    if (m_IsInit)
+    {
+        ELOG("Error : Already Initialized.");
+        return false;
+    }
+
+    m_pDevice  = desc.pDevice;
+    m_Type     = desc.Type;
+    m_MaxCount = desc.MaxCount;
+    m_Stats    = CommandAllocatorPoolStats();
+    m_IsInit   = true;
+
+    for(auto i=0; i<COMMAND_ALLOCATOR_CLASS_COUNT; ++i)
+    {
+        m_Count[i] = 0;
+        for(auto j=0u; j<desc.InitialCount[i]; ++j)
+        {
+            auto pAllocator = CreateAllocator();
+            if (pAllocator == nullptr)
+            {
+                Term();
+                return false;
+            }
+
+            Entry entry = {};
+            entry.pAllocator = pAllocator;
+            m_Retired[i].push_back(entry);
+            m_Count[i]++;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void CommandAllocatorPool::Term()
+{
+    if (!m_IsInit)
+    { return; }
+
+    for(auto i=0; i<COMMAND_ALLOCATOR_CLASS_COUNT; ++i)
+    {
+        if (m_Retired[i].size() != m_Count[i])
+        { ELOG("Error : CommandAllocator Not Returned. class = %d, count = %u", i, uint32_t(m_Count[i] - m_Retired[i].size())); }
+
+        for(auto& entry : m_Retired[i])
+        { DestroyAllocator(entry.pAllocator); }
+
+        m_Retired[i].clear();
+        m_Count[i] = 0;
+    }
+
+    m_pDevice = nullptr;
+    m_IsInit  = false;
+}
+
+//-----------------------------------------------------------------------------
+//      リセット済みのアロケータを取得します.
+//-----------------------------------------------------------------------------
+ID3D12CommandAllocator* CommandAllocatorPool::Acquire(COMMAND_ALLOCATOR_CLASS allocatorClass)
+{
+    if (uint32_t(allocatorClass) >= COMMAND_ALLOCATOR_CLASS_COUNT)
+    {
+        ELOG_LIMIT("Error : Invalid Argument.");
+        return nullptr;
+    }
+
+    Entry entry    = {};
+    bool  isReused = false;
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        if (!m_IsInit)
+        {
+            ELOG_LIMIT("Error : CommandAllocatorPool Is Not Initialized.");
+            return nullptr;
+        }
+
+        // 異なるキューの待機点が混在していても, 完了済みのものを古い順に探す.
+        auto& retired = m_Retired[allocatorClass];
+        for(auto itr = retired.begin(); itr != retired.end(); ++itr)
+        {
+            if (IsCompleted(itr->Point))
+            {
+                entry = *itr;
+                retired.erase(itr);
+                isReused = true;
+                m_Stats.ReuseCount++;
+                break;
+            }
+        }
+
+        if (!isReused)
+        {
+            if (m_Count[allocatorClass] < m_MaxCount)
+            {
+                // 生成はロック外で行うため, 先に数だけ確保しておく.
+                m_Count[allocatorClass]++;
+                m_Stats.CreateCount++;
+            }
+            else if (!retired.empty())
+            {
+                entry = retired.front();
+                retired.pop_front();
+                isReused = true;
+                m_Stats.ReuseCount++;
+                m_Stats.StallCount++;
+            }
+            else
+            {
+                ELOG_LIMIT("Error : CommandAllocator Pool Exhausted. class = %d, MaxCount = %u", int(allocatorClass), m_MaxCount);
+                return nullptr;
+            }
+        }
+    }
+
+    if (!isReused)
+    {
+        auto pAllocator = CreateAllocator();
+        if (pAllocator == nullptr)
+        {
+            std::lock_guard<std::mutex> locker(m_Mutex);
+            m_Count[allocatorClass]--;
+            m_Stats.CreateCount--;
+        }
+        return pAllocator;
+    }
+
+    if (!IsCompleted(entry.Point))
+    { entry.Point.pFence->Wait(entry.Point.FenceValue, WAIT_INFINITE); }
+
+    if (!ResetAllocator(entry.pAllocator))
+    {
+        // リセットできないアロケータは破棄し, 呼び出し側には新しいものを渡さない.
+        DestroyAllocator(entry.pAllocator);
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        m_Count[allocatorClass]--;
+        return nullptr;
+    }
+
+    return entry.pAllocator;
+}
+
+//-----------------------------------------------------------------------------
+//      アロケータを返却します.
+//-----------------------------------------------------------------------------
+void CommandAllocatorPool::Release(ID3D12CommandAllocator* pAllocator, COMMAND_ALLOCATOR_CLASS allocatorClass, const WaitPoint& point)
+{
+    if (pAllocator == nullptr || uint32_t(allocatorClass) >= COMMAND_ALLOCATOR_CLASS_COUNT)
+    {
+        ELOG_LIMIT("Error : Invalid Argument.");
+        return;
+    }
+
+    Entry entry = {};
+    entry.pAllocator = pAllocator;
+    entry.Point      = point;
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_Retired[allocatorClass].push_back(entry);
+}
+
+//-----------------------------------------------------------------------------
+//      統計情報を取得します.
+//-----------------------------------------------------------------------------
+CommandAllocatorPoolStats CommandAllocatorPool::GetStats() const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    return m_Stats;
+}
+
+//-----------------------------------------------------------------------------
+//      アロケータを生成します.
+//-----------------------------------------------------------------------------
+ID3D12CommandAllocator* CommandAllocatorPool::CreateAllocator()
+{
+#if defined(_WIN32)
+    if (m_pDevice != nullptr)
+    {
+        ID3D12CommandAllocator* pAllocator = nullptr;
+        auto hr = m_pDevice->CreateCommandAllocator(m_Type, IID_PPV_ARGS(&pAllocator));
+        if (FAILED(hr))
+        {
+            ELOG("Error : ID3D12Device::CreateCommandAllocator() Failed. errcode = 0x%x", hr);
+            return nullptr;
+        }
+        return pAllocator;
+    }
+#endif
+
+    auto pHandle = new SoftAllocatorHandle();
+    pHandle->Magic = SOFT_ALLOCATOR_MAGIC;
+    return reinterpret_cast<ID3D12CommandAllocator*>(pHandle);
+}
+
+//-----------------------------------------------------------------------------
+//      アロケータを破棄します.
+//-----------------------------------------------------------------------------
+void CommandAllocatorPool::DestroyAllocator(ID3D12CommandAllocator* pAllocator)
+{
+#if defined(_WIN32)
+    if (m_pDevice != nullptr)
+    {
+        pAllocator->Release();
+        return;
+    }
+#endif
+
+    auto pHandle = reinterpret_cast<SoftAllocatorHandle*>(pAllocator);
+    pHandle->Magic = 0;
+    delete pHandle;
+}
+
+//-----------------------------------------------------------------------------
+//      アロケータをリセットします.
+//-----------------------------------------------------------------------------
+bool CommandAllocatorPool::ResetAllocator(ID3D12CommandAllocator* pAllocator)
+{
+#if defined(_WIN32)
+    if (m_pDevice != nullptr)
+    {
+        auto hr = pAllocator->Reset();
+        if (FAILED(hr))
+        {
+            ELOG_LIMIT("Error : ID3D12CommandAllocator::Reset() Failed. errcode = 0x%x", hr);
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    return reinterpret_cast<SoftAllocatorHandle*>(pAllocator)->Magic == SOFT_ALLOCATOR_MAGIC;
+}
+
+} // namespace asf
@@ -37,7 +37,14 @@ public:
     //-------------------------------------------------------------------------
     //! @brief      生成処理を行います.
     //-------------------------------------------------------------------------
-    static bool Create(ID3D12Device* pDevice, D3D12_COMMAND_LIST_TYPE type, ICommandList** ppCmdList)
+    static bool Create
+    (
+        ID3D12Device*           pDevice,
+        CommandAllocatorPool*   pPool,
+        D3D12_COMMAND_LIST_TYPE type,
+        COMMAND_ALLOCATOR_CLASS allocatorClass,
+        ICommandList**          ppCmdList
+    )
     {
         if (pDevice == nullptr || ppCmdList == nullptr)
         {
@@ -46,7 +53,7 @@ public:
         }
 
         auto instance = new CommandList();
-        if (!instance->Init(pDevice, type))
+        if (!instance->Init(pDevice, pPool, type, allocatorClass))
         {
             instance->Release();
             ELOG("Error : CommandList::Init() Failed.");
@@ -78,32 +85,129 @@ public:
     //-------------------------------------------------------------------------
     ID3D12GraphicsCommandList6* Reset() override
     {
-        // ダブルバッファリング.
-        m_Index = (m_Index + 1) & 0x1;
+        // 投入したかどうか分からないアロケータは再利用できない.
+        if (!m_FenceSet)
+        {
+            ELOG_LIMIT("Error : Fence Point Is Not Set. Call SetFencePoint() Before Reset().");
+            return nullptr;
+        }
 
-        // コマンドアロケータをリセット.
-        m_pAllocator[m_Index]->Reset();
+        // 使用中のアロケータを返却し, GPUでの実行が完了したものを取得する.
+        auto pAllocator = m_pPool->Acquire(m_Class);
+        if (pAllocator == nullptr)
+        {
+            ELOG_LIMIT("Error : CommandAllocatorPool::Acquire() Failed.");
+            return nullptr;
+        }
+
+        m_pPool->Release(m_pAllocator, m_Class, m_FencePoint);
+        m_pAllocator = pAllocator;
+        m_FencePoint = WaitPoint();
+        m_FenceSet   = false;
+        m_Tracker.Reset();
+        m_StateCache.Invalidate();
 
         // コマンドリストをリセット.
-        m_pCmdList->Reset(m_pAllocator[m_Index], nullptr);
+        m_pCmdList->Reset(m_pAllocator, nullptr);
 
         return m_pCmdList;
     }
 
+    //-------------------------------------------------------------------------
+    //! @brief      記録した内容を実行した Signal() の待機点を設定します.
+    //-------------------------------------------------------------------------
+    void SetFencePoint(const WaitPoint& point) override
+    {
+        m_FencePoint = point;
+        m_FenceSet   = true;
+    }
+
     //-------------------------------------------------------------------------
     //! @brief      D3D12グラフィックスコマンドリストを取得します.
     //-------------------------------------------------------------------------
     ID3D12GraphicsCommandList6* GetD3D12GraphicsCommandList() const override
     { return m_pCmdList; }
 
+    //-------------------------------------------------------------------------
+    //! @brief      リソースステートトラッカーを取得します.
+    //-------------------------------------------------------------------------
+    ResourceStateTracker* GetStateTracker() override
+    { return &m_Tracker; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      パイプラインステートを設定します.
+    //-------------------------------------------------------------------------
+    void SetPipelineState(ID3D12PipelineState* pPipelineState) override
+    { m_StateCache.SetPipelineState(pPipelineState); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフィックス用ルートシグニチャを設定します.
+    //-------------------------------------------------------------------------
+    void SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature) override
+    { m_StateCache.SetGraphicsRootSignature(pRootSignature); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンピュート用ルートシグニチャを設定します.
+    //-------------------------------------------------------------------------
+    void SetComputeRootSignature(ID3D12RootSignature* pRootSignature) override
+    { m_StateCache.SetComputeRootSignature(pRootSignature); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディスクリプタヒープを設定します.
+    //-------------------------------------------------------------------------
+    void SetDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* ppHeaps) override
+    { m_StateCache.SetDescriptorHeaps(count, ppHeaps); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      レンダーターゲットと深度ステンシルを設定します.
+    //-------------------------------------------------------------------------
+    void OMSetRenderTargets
+    (
+        uint32_t                            count,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pRenderTargets,
+        bool                                singleHandle,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pDepthStencil
+    ) override
+    { m_StateCache.OMSetRenderTargets(count, pRenderTargets, singleHandle, pDepthStencil); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフィックス用ルート定数を設定します.
+    //-------------------------------------------------------------------------
+    void SetGraphicsRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset) override
+    { m_StateCache.SetGraphicsRoot32BitConstants(rootIndex, count, pData, destOffset); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンピュート用ルート定数を設定します.
+    //-------------------------------------------------------------------------
+    void SetComputeRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset) override
+    { m_StateCache.SetComputeRoot32BitConstants(rootIndex, count, pData, destOffset); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      状態キャッシュを無効化します.
+    //-------------------------------------------------------------------------
+    void InvalidateStateCache() override
+    { m_StateCache.Invalidate(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      状態キャッシュの統計情報を取得します.
+    //-------------------------------------------------------------------------
+    const CommandStateCacheStats& GetStateCacheStats() const override
+    { return m_StateCache.GetStats(); }
+
 private:
     //=========================================================================
     // private variables.
     //=========================================================================
-    std::atomic<uint32_t>       m_RefCount      = {};
-    ID3D12GraphicsCommandList6* m_pCmdList      = nullptr;
-    ID3D12CommandAllocator*     m_pAllocator[2] = {};
-    uint8_t                     m_Index         = 0;
+    std::atomic<uint32_t>                         m_RefCount      = {};
+    ID3D12GraphicsCommandList6*                   m_pCmdList      = nullptr;
+    ID3D12CommandAllocator*                       m_pAllocator    = nullptr;
+    CommandAllocatorPool*                         m_pPool         = nullptr;
+    CommandAllocatorPool                          m_LocalPool;
+    COMMAND_ALLOCATOR_CLASS                       m_Class         = COMMAND_ALLOCATOR_CLASS_SMALL;
+    WaitPoint                                     m_FencePoint;
+    bool                                          m_FenceSet      = true;
+    ResourceStateTracker                          m_Tracker;
+    CommandStateCache<ID3D12GraphicsCommandList6> m_StateCache;
 
     //=========================================================================
     // private methods.
@@ -113,9 +217,11 @@ private:
     //! @brief      コンストラクタです.
     //-------------------------------------------------------------------------
     CommandList()
-    : m_RefCount(1)
-    , m_pCmdList(nullptr)
-    , m_Index   (0)
+    : m_RefCount    (1)
+    , m_pCmdList    (nullptr)
+    , m_pAllocator  (nullptr)
+    , m_pPool       (nullptr)
+    , m_Class       (COMMAND_ALLOCATOR_CLASS_SMALL)
     { /* DO_NOTHING */ }
 
     //-------------------------------------------------------------------------
@@ -127,7 +233,13 @@ private:
     //-------------------------------------------------------------------------
     //! @brief      初期化処理を行います.
     //-------------------------------------------------------------------------
-    bool Init(ID3D12Device* pDevice, D3D12_COMMAND_LIST_TYPE type)
+    bool Init
+    (
+        ID3D12Device*           pDevice,
+        CommandAllocatorPool*   pPool,
+        D3D12_COMMAND_LIST_TYPE type,
+        COMMAND_ALLOCATOR_CLASS allocatorClass
+    )
     {
         // 引数チェック.
         if (pDevice == nullptr)
@@ -136,19 +248,36 @@ private:
             return false;
         }
 
-        for(auto i=0; i<2; ++i)
+        // プールが指定されない場合は, 従来のダブルバッファリングと同様に2つ確保しておく.
+        if (pPool == nullptr)
         {
-            // コマンドアロケータを生成.
-            auto hr = pDevice->CreateCommandAllocator(type, IID_PPV_ARGS(&m_pAllocator[i]));
-            if (FAILED(hr))
+            CommandAllocatorPoolDesc desc;
+            desc.pDevice = pDevice;
+            desc.Type    = type;
+            desc.InitialCount[allocatorClass] = 2;
+
+            if (!m_LocalPool.Init(desc))
             {
-                ELOG("Error : ID3D12Device::CreateCommandAllocator() Failed. errcode = 0x%x", hr);
+                ELOG("Error : CommandAllocatorPool::Init() Failed.");
                 return false;
             }
+
+            pPool = &m_LocalPool;
+        }
+
+        m_pPool = pPool;
+        m_Class = allocatorClass;
+
+        // コマンドアロケータを取得.
+        m_pAllocator = m_pPool->Acquire(m_Class);
+        if (m_pAllocator == nullptr)
+        {
+            ELOG("Error : CommandAllocatorPool::Acquire() Failed.");
+            return false;
         }
 
         // コマンドリストを生成.
-        auto hr = pDevice->CreateCommandList(0, type, m_pAllocator[0], nullptr, IID_PPV_ARGS(&m_pCmdList));
+        auto hr = pDevice->CreateCommandList(0, m_pPool->GetType(), m_pAllocator, nullptr, IID_PPV_ARGS(&m_pCmdList));
         if (FAILED(hr))
         {
             ELOG("Error : ID3D12Device::CreateCommandList() Failed. errcode = 0x%x", hr);
@@ -158,7 +287,7 @@ private:
         // 生成直後は開きっぱなしの扱いになっているので閉じておく.
         m_pCmdList->Close();
 
-        m_Index = 0;
+        m_StateCache.SetTarget(m_pCmdList);
 
         // 正常終了.
         return true;
@@ -175,16 +304,15 @@ private:
             m_pCmdList = nullptr;
         }
 
-        for(auto i=0; i<2; ++i)
+        if (m_pAllocator != nullptr)
         {
-            if (m_pAllocator[i] != nullptr)
-            {
-                m_pAllocator[i]->Release();
-                m_pAllocator[i] = nullptr;
-            }
+            m_pPool->Release(m_pAllocator, m_Class, m_FencePoint);
+            m_pAllocator = nullptr;
         }
 
-        m_Index = 0;
+        m_LocalPool.Term();
+        m_pPool      = nullptr;
+        m_FencePoint = WaitPoint();
     }
 };
 
@@ -192,6 +320,26 @@ private:
 //      コマンドリストを生成します.
 //-----------------------------------------------------------------------------
 bool CreateCommandList(ID3D12Device* pDevice, D3D12_COMMAND_LIST_TYPE type, ICommandList** ppCmdList)
-{ return CommandList::Create(pDevice, type, ppCmdList); }
+{ return CommandList::Create(pDevice, nullptr, type, COMMAND_ALLOCATOR_CLASS_SMALL, ppCmdList); }
+
+//-----------------------------------------------------------------------------
+//      アロケータプールを共有するコマンドリストを生成します.
+//-----------------------------------------------------------------------------
+bool CreateCommandList
+(
+    ID3D12Device*           pDevice,
+    CommandAllocatorPool*   pPool,
+    COMMAND_ALLOCATOR_CLASS allocatorClass,
+    ICommandList**          ppCmdList
+)
+{
+    if (pPool == nullptr)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    return CommandList::Create(pDevice, pPool, pPool->GetType(), allocatorClass, ppCmdList);
+}
 
 } // namespace asf
@@ -9,6 +9,7 @@
 //-----------------------------------------------------------------------------
 #include <atomic>
 #include <asfCommandQueue.h>
+#include <asfFenceWait.h>
 #include <asfLogger.h>
 
 
@@ -78,19 +79,50 @@ public:
     //-------------------------------------------------------------------------
     void Wait(uint64_t fenceValue, uint32_t msec) override
     {
-        if (m_pFence->GetCompletedValue() < fenceValue)
+        if (m_pFence->GetCompletedValue() >= fenceValue)
+        { return; }
+
+        if (m_Policy == FENCE_WAIT_POLICY_POLL)
+        {
+            PollFence(this, fenceValue, (msec == WAIT_INFINITE) ? UINT64_MAX : uint64_t(msec) * 1000);
+            return;
+        }
+
+        if (m_Policy == FENCE_WAIT_POLICY_SPIN_THEN_BLOCK)
         {
-            auto hr = m_pFence->SetEventOnCompletion(fenceValue, m_Handle);
-            if (FAILED(hr))
-            {
-                ELOG("Error : ID3D12Fence::SetEventOnCompletation() Failed. errcode = 0x%x", hr);
-                return;
-            }
-
-            WaitForSingleObject(m_Handle, msec);
+            auto spinUsec = uint64_t(m_SpinUsec);
+            if (msec != WAIT_INFINITE && spinUsec > uint64_t(msec) * 1000)
+            { spinUsec = uint64_t(msec) * 1000; }
+
+            if (PollFence(this, fenceValue, spinUsec))
+            { return; }
         }
+
+        auto hr = m_pFence->SetEventOnCompletion(fenceValue, m_Handle);
+        if (FAILED(hr))
+        {
+            ELOG_LIMIT("Error : ID3D12Fence::SetEventOnCompletation() Failed. errcode = 0x%x", hr);
+            return;
+        }
+
+        WaitForSingleObject(m_Handle, msec);
     }
 
+    //-------------------------------------------------------------------------
+    //! @brief      待機方法を設定します.
+    //-------------------------------------------------------------------------
+    void SetWaitPolicy(FENCE_WAIT_POLICY policy, uint32_t spinUsec) override
+    {
+        m_Policy   = policy;
+        m_SpinUsec = spinUsec;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      完了したフェンス値を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetCompletedValue() const override
+    { return m_pFence->GetCompletedValue(); }
+
     //-------------------------------------------------------------------------
     //! @brief      D3D12フェンスを取得します.
     //-------------------------------------------------------------------------
@@ -104,6 +136,8 @@ private:
     std::atomic<uint32_t>   m_RefCount  = {};
     ID3D12Fence*            m_pFence    = nullptr;
     HANDLE                  m_Handle    = nullptr;
+    FENCE_WAIT_POLICY       m_Policy    = FENCE_WAIT_POLICY_BLOCK;
+    uint32_t                m_SpinUsec  = 0;
 
     //=========================================================================
     // private methods.
@@ -255,11 +289,12 @@ public:
         auto hr = m_pQueue->Signal(m_pFence->GetD3D12Fence(), fence);
         if (FAILED(hr))
         {
-            ELOG("Error : ID3D12CommandQueue::Signal() Failed. errcode = 0x%x", hr);
+            ELOG_LIMIT("Error : ID3D12CommandQueue::Signal() Failed. errcode = 0x%x", hr);
             return result;
         }
         m_FenceValue++;
-        result = fence;
+        result.FenceValue = fence;
+        result.pFence     = m_pFence;
 
         return result;
     }
@@ -269,13 +304,23 @@ public:
     //-------------------------------------------------------------------------
     bool Wait(const WaitPoint& value) override
     {
-        auto hr = m_pQueue->Wait(m_pFence->GetD3D12Fence(), value);
+        auto pFence = (value.pFence != nullptr) ? value.pFence : m_pFence;
+        if (pFence->GetD3D12Fence() == nullptr)
+        {
+            ELOG_LIMIT("Error : Invalid Argument. D3D12 fence is required.");
+            return false;
+        }
+
+        auto hr = m_pQueue->Wait(pFence->GetD3D12Fence(), value.FenceValue);
         if (FAILED(hr))
         {
-            ELOG("Error : ID3D12CommandQueue::Wait() Failed. errcode = 0x%x", hr);
+            ELOG_LIMIT("Error : ID3D12CommandQueue::Wait() Failed. errcode = 0x%x", hr);
             return false;
         }
 
+        // キュー間の待機のみを投入した場合も Sync() で完了を待てるようにする.
+        m_IsExecuted = true;
+
         return true;
     }
 
@@ -284,10 +329,11 @@ public:
     //-------------------------------------------------------------------------
     void Sync(const WaitPoint& value, uint32_t msec) override
     {
-        if (!m_IsExecuted)
+        auto pFence = (value.pFence != nullptr) ? value.pFence : m_pFence;
+        if (pFence == m_pFence && !m_IsExecuted)
         { return; }
 
-        m_pFence->Wait(value, msec);
+        pFence->Wait(value.FenceValue, msec);
     }
 
     //-------------------------------------------------------------------------
@@ -304,6 +350,12 @@ public:
         return result;
     }
 
+    //-------------------------------------------------------------------------
+    //! @brief      フェンスを取得します.
+    //-------------------------------------------------------------------------
+    IFence* GetFence() const override
+    { return m_pFence; }
+
     //-------------------------------------------------------------------------
     //! @brief      D3D12コマンドキューを取得します.
     //-------------------------------------------------------------------------
@@ -0,0 +1,148 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfCommandStream.cpp
+// Desc : Backend-agnostic Recorded Command Stream.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfCommandStream.h>
+#include <asfLogger.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// CommandStream class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+CommandStream::~CommandStream()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool CommandStream::Init(const CommandStreamDesc& desc)
+{
+    if (desc.BlockSize < sizeof(CommandHeader))
+    {
+        ELOGA("Error : Invalid Argument. BlockSize = %u", desc.BlockSize);
+        return false;
+    }
+
+    Term();
+
+    m_BlockSize = AlignSize(desc.BlockSize);
+
+    Block block;
+    block.pData.reset(new uint8_t[m_BlockSize]);
+    block.Size = m_BlockSize;
+    block.Used = 0;
+    m_Blocks.push_back(std::move(block));
+
+    Reset();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void CommandStream::Term()
+{
+    m_Blocks.clear();
+    m_Blocks.shrink_to_fit();
+
+    m_Current      = 0;
+    m_pCursor      = nullptr;
+    m_pEnd         = nullptr;
+    m_CommandCount = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      記録した内容を破棄します.
+//-----------------------------------------------------------------------------
+void CommandStream::Reset()
+{
+    for(auto& block : m_Blocks)
+    { block.Used = 0; }
+
+    m_Current      = 0;
+    m_CommandCount = 0;
+
+    if (m_Blocks.empty())
+    {
+        m_pCursor = nullptr;
+        m_pEnd    = nullptr;
+        return;
+    }
+
+    m_pCursor = m_Blocks[0].pData.get();
+    m_pEnd    = m_pCursor + m_Blocks[0].Size;
+}
+
+//-----------------------------------------------------------------------------
+//      記録したコマンドのバイト数を取得します.
+//-----------------------------------------------------------------------------
+size_t CommandStream::GetSize() const
+{
+    if (m_pCursor == nullptr)
+    { return 0; }
+
+    size_t size = 0;
+    for(size_t i=0; i<m_Current; ++i)
+    { size += m_Blocks[i].Used; }
+
+    return size + size_t(m_pCursor - m_Blocks[m_Current].pData.get());
+}
+
+//-----------------------------------------------------------------------------
+//      確保済みのブロックの合計バイト数を取得します.
+//-----------------------------------------------------------------------------
+size_t CommandStream::GetCapacity() const
+{
+    size_t size = 0;
+    for(auto& block : m_Blocks)
+    { size += block.Size; }
+
+    return size;
+}
+
+//-----------------------------------------------------------------------------
+//      次のブロックに切り替えて領域を確保します.
+//-----------------------------------------------------------------------------
+uint8_t* CommandStream::AllocateSlow(size_t size)
+{
+    if (m_BlockSize == 0)
+    { m_BlockSize = CommandStreamDesc().BlockSize; }
+
+    // コマンドはブロックをまたがないため, 現在のブロックの残りは使用しない.
+    size_t next = 0;
+    if (m_pCursor != nullptr)
+    {
+        m_Blocks[m_Current].Used = size_t(m_pCursor - m_Blocks[m_Current].pData.get());
+        next = m_Current + 1;
+    }
+
+    // Reset() 前に確保したブロックを順に再利用し, 収まらない場合のみ新しく確保する.
+    if (next >= m_Blocks.size() || m_Blocks[next].Size < size)
+    {
+        Block block;
+        block.Size = (size > m_BlockSize) ? size : m_BlockSize;
+        block.Used = 0;
+        block.pData.reset(new uint8_t[block.Size]);
+        m_Blocks.insert(m_Blocks.begin() + next, std::move(block));
+    }
+
+    m_Current = next;
+
+    auto ptr  = m_Blocks[next].pData.get();
+    m_pCursor = ptr + size;
+    m_pEnd    = ptr + m_Blocks[next].Size;
+    return ptr;
+}
+
+} // namespace asf
@@ -0,0 +1,392 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfFenceDispatcher.cpp
+// Desc : Fence Completion Callback Dispatcher.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <chrono>
+#include <mutex>
+#include <asfFenceDispatcher.h>
+#include <asfFenceWait.h>
+#include <asfLogger.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// FenceDispatcher class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+FenceDispatcher::~FenceDispatcher()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool FenceDispatcher::Init(const FenceDispatcherDesc& desc)
+{
+    if (desc.MaxCallbacks == 0 || desc.MaxCallbacks == INVALID_NODE_INDEX)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    if (m_Thread.joinable())
+    {
+        ELOG("Error : Already Initialized.");
+        return false;
+    }
+
+    m_pNodes    = new Node[desc.MaxCallbacks];
+    m_NodeCount = desc.MaxCallbacks;
+    m_FreeNodes.Init(m_pNodes, m_NodeCount);
+    m_Pending.Reset();
+    m_Entries.reserve(MAX_WAIT_FENCE_COUNT);
+
+#if defined(_WIN32)
+    m_WakeEvent = CreateEventEx(nullptr, FALSE, FALSE, EVENT_ALL_ACCESS);
+    if (m_WakeEvent == nullptr)
+    {
+        ELOG("Error : CreateEventEx() Failed.");
+        delete[] m_pNodes;
+        m_pNodes    = nullptr;
+        m_NodeCount = 0;
+        return false;
+    }
+    m_Events.reserve(MAX_WAIT_FENCE_COUNT);
+#endif
+
+    m_PollIntervalUs = desc.PollIntervalUs;
+    m_WakeRequested  = false;
+    m_DispatchCount.store(0, std::memory_order_relaxed);
+    m_WakeCount    .store(0, std::memory_order_relaxed);
+    m_Running      .store(true);
+
+    m_Thread = std::thread(&FenceDispatcher::Run, this);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void FenceDispatcher::Term()
+{
+    if (!m_Thread.joinable())
+    { return; }
+
+    m_Running.store(false);
+    Wake();
+    m_Thread.join();
+
+    for(auto& entry : m_Entries)
+    { entry.pFence->Release(); }
+    m_Entries.clear();
+
+#if defined(_WIN32)
+    for(auto handle : m_Events)
+    { CloseHandle(handle); }
+    m_Events.clear();
+
+    CloseHandle(m_WakeEvent);
+    m_WakeEvent = nullptr;
+#endif
+
+    delete[] m_pNodes;
+    m_pNodes    = nullptr;
+    m_NodeCount = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      コールバックを登録します.
+//-----------------------------------------------------------------------------
+bool FenceDispatcher::Register(const WaitPoint& point, FenceCallback callback, void* pUser)
+{
+    if (point.pFence == nullptr || callback == nullptr)
+    {
+        ELOG_LIMIT("Error : Invalid Argument.");
+        return false;
+    }
+
+    if (!m_Running.load(std::memory_order_relaxed))
+    {
+        ELOG_LIMIT("Error : FenceDispatcher Is Not Running.");
+        return false;
+    }
+
+    auto index = m_FreeNodes.Alloc(m_pNodes);
+    if (index == INVALID_NODE_INDEX)
+    {
+        ELOG_LIMIT("Error : Callback Pool Exhausted. MaxCallbacks = %u", m_NodeCount);
+        return false;
+    }
+
+    auto& node = m_pNodes[index];
+    node.pFence   = point.pFence;
+    node.Value    = point.FenceValue;
+    node.Callback = callback;
+    node.pUser    = pUser;
+
+    // 登録待ちが空だった場合のみ起床させる. 空でなければディスパッチスレッドが回収前である.
+    if (m_Pending.Push(m_pNodes, index))
+    { Wake(); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ディスパッチスレッドを起床させます.
+//-----------------------------------------------------------------------------
+void FenceDispatcher::Wake()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_Listener.Mutex);
+        m_WakeRequested = true;
+    }
+    m_Listener.Cond.notify_one();
+
+#if defined(_WIN32)
+    SetEvent(m_WakeEvent);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      登録待ちのノードをフェンスごとのリストに移動します.
+//-----------------------------------------------------------------------------
+void FenceDispatcher::Collect()
+{
+    auto head = m_Pending.Steal();
+
+    // LIFO で積まれているため, 登録順に戻す.
+    auto list = INVALID_NODE_INDEX;
+    while(head != INVALID_NODE_INDEX)
+    {
+        auto next = m_pNodes[head].Next.load(std::memory_order_relaxed);
+        m_pNodes[head].Next.store(list, std::memory_order_relaxed);
+        list = head;
+        head = next;
+    }
+
+    while(list != INVALID_NODE_INDEX)
+    {
+        auto next = m_pNodes[list].Next.load(std::memory_order_relaxed);
+        Insert(list);
+        list = next;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ノードをフェンスごとのリストに値の昇順で挿入します.
+//-----------------------------------------------------------------------------
+void FenceDispatcher::Insert(uint32_t index)
+{
+    auto& node = m_pNodes[index];
+    node.Next.store(INVALID_NODE_INDEX, std::memory_order_relaxed);
+
+    FenceEntry* pEntry = nullptr;
+    for(auto& entry : m_Entries)
+    {
+        if (entry.pFence == node.pFence)
+        {
+            pEntry = &entry;
+            break;
+        }
+    }
+
+    if (pEntry == nullptr)
+    {
+        FenceEntry entry = {};
+        entry.pFence = node.pFence;
+        entry.Head   = index;
+        entry.Tail   = index;
+        entry.pFence->AddRef();
+        m_Entries.push_back(entry);
+        return;
+    }
+
+    // 通常は値の昇順に登録されるため, 末尾への追加を先に確認する.
+    if (m_pNodes[pEntry->Tail].Value <= node.Value)
+    {
+        m_pNodes[pEntry->Tail].Next.store(index, std::memory_order_relaxed);
+        pEntry->Tail = index;
+        return;
+    }
+
+    if (node.Value < m_pNodes[pEntry->Head].Value)
+    {
+        node.Next.store(pEntry->Head, std::memory_order_relaxed);
+        pEntry->Head = index;
+        return;
+    }
+
+    // 同じ値の場合は登録順を保つため, 後ろに挿入する.
+    auto prev = pEntry->Head;
+    for(;;)
+    {
+        auto next = m_pNodes[prev].Next.load(std::memory_order_relaxed);
+        if (m_pNodes[next].Value > node.Value)
+        {
+            node.Next.store(next, std::memory_order_relaxed);
+            m_pNodes[prev].Next.store(index, std::memory_order_relaxed);
+            return;
+        }
+        prev = next;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      完了したコールバックを呼び出します.
+//-----------------------------------------------------------------------------
+void FenceDispatcher::Dispatch()
+{
+    for(size_t i=0; i<m_Entries.size();)
+    {
+        auto& entry     = m_Entries[i];
+        auto  completed = entry.pFence->GetCompletedValue();
+
+        uint64_t count = 0;
+        while(entry.Head != INVALID_NODE_INDEX && m_pNodes[entry.Head].Value <= completed)
+        {
+            auto  index = entry.Head;
+            auto& node  = m_pNodes[index];
+            entry.Head = node.Next.load(std::memory_order_relaxed);
+
+            node.Callback(node.pUser);
+            m_FreeNodes.Free(m_pNodes, index);
+            count++;
+        }
+
+        if (count > 0)
+        { m_DispatchCount.fetch_add(count, std::memory_order_relaxed); }
+
+        if (entry.Head != INVALID_NODE_INDEX)
+        {
+            ++i;
+            continue;
+        }
+
+        // 待機するコールバックが無くなったフェンスは参照を解放する.
+        entry.pFence->Release();
+        m_Entries[i] = m_Entries.back();
+        m_Entries.pop_back();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      いずれかのフェンスが完了するか, 起床要求があるまで待機します.
+//-----------------------------------------------------------------------------
+void FenceDispatcher::WaitAny()
+{
+    m_WakeCount.fetch_add(1, std::memory_order_relaxed);
+
+    auto woken = [&]() { return m_WakeRequested || m_Listener.Pending.load() <= 0; };
+
+    // ソフトウェアフェンスはリスナーで1回の待機にまとめる.
+    m_Listener.Pending.store(1);
+
+    size_t registered = 0;
+    for(; registered<m_Entries.size(); ++registered)
+    {
+        auto& entry = m_Entries[registered];
+        if (!AddSoftFenceListener(entry.pFence, m_pNodes[entry.Head].Value, &m_Listener))
+        { break; }
+    }
+
+    if (registered == m_Entries.size())
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Listener.Mutex);
+            m_Listener.Cond.wait(lock, woken);
+            m_WakeRequested = false;
+        }
+
+        for(auto& entry : m_Entries)
+        { RemoveSoftFenceListener(entry.pFence, &m_Listener); }
+        return;
+    }
+
+    for(size_t i=0; i<registered; ++i)
+    { RemoveSoftFenceListener(m_Entries[i].pFence, &m_Listener); }
+
+#if defined(_WIN32)
+    // D3D12フェンスのみの場合はイベントで待機する.
+    auto native = (m_Entries.size() < MAX_WAIT_FENCE_COUNT);
+    for(auto& entry : m_Entries)
+    {
+        if (entry.pFence->GetD3D12Fence() == nullptr)
+        {
+            native = false;
+            break;
+        }
+    }
+
+    if (native)
+    {
+        while(m_Events.size() < m_Entries.size())
+        {
+            auto handle = CreateEventEx(nullptr, FALSE, FALSE, EVENT_ALL_ACCESS);
+            if (handle == nullptr)
+            {
+                ELOG_LIMIT("Error : CreateEventEx() Failed.");
+                native = false;
+                break;
+            }
+            m_Events.push_back(handle);
+        }
+    }
+
+    if (native)
+    {
+        HANDLE handles[MAX_WAIT_FENCE_COUNT] = {};
+        DWORD  count = 0;
+        for(auto& entry : m_Entries)
+        {
+            // 前回の登録による通知が残っていても, 起床後に完了値を再確認するため問題ない.
+            auto hr = entry.pFence->GetD3D12Fence()->SetEventOnCompletion(m_pNodes[entry.Head].Value, m_Events[count]);
+            if (FAILED(hr))
+            { ELOG_LIMIT("Error : ID3D12Fence::SetEventOnCompletion() Failed. errcode = 0x%x", hr); }
+            handles[count] = m_Events[count];
+            count++;
+        }
+        handles[count++] = m_WakeEvent;
+
+        WaitForMultipleObjects(count, handles, FALSE, INFINITE);
+
+        std::lock_guard<std::mutex> locker(m_Listener.Mutex);
+        m_WakeRequested = false;
+        return;
+    }
+#endif
+
+    // それ以外はポーリングで待機する.
+    std::unique_lock<std::mutex> lock(m_Listener.Mutex);
+    m_Listener.Cond.wait_for(lock, std::chrono::microseconds(m_PollIntervalUs), [&]() { return m_WakeRequested; });
+    m_WakeRequested = false;
+}
+
+//-----------------------------------------------------------------------------
+//      ディスパッチスレッドの処理です.
+//-----------------------------------------------------------------------------
+void FenceDispatcher::Run()
+{
+    while(m_Running.load())
+    {
+        Collect();
+        Dispatch();
+
+        if (!m_Running.load())
+        { break; }
+
+        WaitAny();
+    }
+
+    // 終了時に残っているノードは呼び出さずに破棄する.
+    Collect();
+}
+
+} // namespace asf
@@ -0,0 +1,303 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfFenceWait.cpp
+// Desc : Fence Wait Utilities.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <asfFenceWait.h>
+#include <asfSoftBackend.h>
+#include <asfLogger.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>     // for _mm_pause().
+#else
+#include <immintrin.h>  // for _mm_pause().
+#endif
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t MAX_BACKOFF     = 64;           // 1回のバックオフでの最大pause回数.
+static constexpr uint32_t POLL_SLEEP_USEC = 50;           // ポーリングで待機する場合の確認間隔(マイクロ秒).
+
+//-----------------------------------------------------------------------------
+//      待機条件を満たしているかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool IsSatisfied(uint32_t count, const asf::WaitPoint* pPoints, bool waitAll, uint32_t* pIndex)
+{
+    auto completed = 0u;
+    auto first     = count;
+    for(auto i=0u; i<count; ++i)
+    {
+        if (pPoints[i].pFence->GetCompletedValue() >= pPoints[i].FenceValue)
+        {
+            if (first == count)
+            { first = i; }
+            completed++;
+        }
+        else if (waitAll)
+        {
+            return false;
+        }
+    }
+
+    if (completed == 0)
+    { return false; }
+
+    if (pIndex != nullptr)
+    { *pIndex = first; }
+
+    return true;
+}
+
+#if defined(_WIN32)
+///////////////////////////////////////////////////////////////////////////////
+// WaitEvent class
+///////////////////////////////////////////////////////////////////////////////
+class WaitEvent
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    WaitEvent()
+    : m_Handle(CreateEventEx(nullptr, FALSE, FALSE, EVENT_ALL_ACCESS))
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~WaitEvent()
+    {
+        if (m_Handle != nullptr)
+        { CloseHandle(m_Handle); }
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ハンドルを取得します.
+    //-------------------------------------------------------------------------
+    HANDLE Get() const
+    { return m_Handle; }
+
+private:
+    HANDLE m_Handle;
+};
+
+//-----------------------------------------------------------------------------
+//      D3D12フェンスを1つのイベントで待機します.
+//-----------------------------------------------------------------------------
+bool WaitNative(uint32_t count, const asf::WaitPoint* pPoints, bool waitAll, uint32_t msec, uint32_t* pIndex)
+{
+    // タイムアウトしたイベントの登録は残るため, スレッドごとに使い回し, 起床後に条件を再確認する.
+    thread_local WaitEvent t_Event;
+    if (t_Event.Get() == nullptr)
+    {
+        ELOG_LIMIT("Error : CreateEventEx() Failed.");
+        return false;
+    }
+
+    ID3D12Fence* fences[asf::MAX_WAIT_FENCE_COUNT] = {};
+    UINT64       values[asf::MAX_WAIT_FENCE_COUNT] = {};
+    for(auto i=0u; i<count; ++i)
+    {
+        fences[i] = pPoints[i].pFence->GetD3D12Fence();
+        values[i] = pPoints[i].FenceValue;
+    }
+
+    ID3D12Device1* pDevice = nullptr;
+    auto hr = fences[0]->GetDevice(IID_PPV_ARGS(&pDevice));
+    if (FAILED(hr))
+    {
+        ELOG_LIMIT("Error : ID3D12Fence::GetDevice() Failed. errcode = 0x%x", hr);
+        return false;
+    }
+
+    const auto flags = waitAll ? D3D12_MULTIPLE_FENCE_WAIT_FLAG_ALL : D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY;
+    const auto begin = GetTickCount64();
+
+    auto result = false;
+    for(;;)
+    {
+        hr = pDevice->SetEventOnMultipleFenceCompletion(fences, values, count, flags, t_Event.Get());
+        if (FAILED(hr))
+        {
+            ELOG_LIMIT("Error : ID3D12Device1::SetEventOnMultipleFenceCompletion() Failed. errcode = 0x%x", hr);
+            break;
+        }
+
+        auto wait = msec;
+        if (msec != asf::WAIT_INFINITE)
+        {
+            auto elapsed = GetTickCount64() - begin;
+            wait = (elapsed < msec) ? DWORD(msec - elapsed) : 0;
+        }
+
+        auto ret = WaitForSingleObject(t_Event.Get(), wait);
+        if (IsSatisfied(count, pPoints, waitAll, pIndex))
+        {
+            result = true;
+            break;
+        }
+
+        if (ret == WAIT_TIMEOUT || wait == 0)
+        { break; }
+    }
+
+    pDevice->Release();
+    return result;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+//      ソフトウェアフェンスを1つの条件変数で待機します.
+//-----------------------------------------------------------------------------
+bool WaitSoft(uint32_t count, const asf::WaitPoint* pPoints, bool waitAll, uint32_t msec, uint32_t* pIndex, bool& supported)
+{
+    asf::SoftFenceListener listener;
+    listener.Pending = waitAll ? int32_t(count) : 1;
+
+    auto registered = 0u;
+    for(; registered<count; ++registered)
+    {
+        if (!asf::AddSoftFenceListener(pPoints[registered].pFence, pPoints[registered].FenceValue, &listener))
+        { break; }
+    }
+
+    auto result = false;
+    supported = (registered == count);
+    if (supported)
+    {
+        auto notified = [&]() { return listener.Pending.load() <= 0; };
+
+        std::unique_lock<std::mutex> lock(listener.Mutex);
+        if (msec == asf::WAIT_INFINITE)
+        { listener.Cond.wait(lock, notified); }
+        else
+        { listener.Cond.wait_for(lock, std::chrono::milliseconds(msec), notified); }
+
+        result = IsSatisfied(count, pPoints, waitAll, pIndex);
+    }
+
+    for(auto i=0u; i<registered; ++i)
+    { asf::RemoveSoftFenceListener(pPoints[i].pFence, &listener); }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      ポーリングで待機します.
+//-----------------------------------------------------------------------------
+bool WaitPoll(uint32_t count, const asf::WaitPoint* pPoints, bool waitAll, uint32_t msec, uint32_t* pIndex)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + std::chrono::milliseconds(msec);
+
+    for(;;)
+    {
+        if (IsSatisfied(count, pPoints, waitAll, pIndex))
+        { return true; }
+
+        if (msec != asf::WAIT_INFINITE && Clock::now() >= deadline)
+        { return false; }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(POLL_SLEEP_USEC));
+    }
+}
+
+} // namespace
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+//      フェンスが指定された値に達するまでポーリングします.
+//-----------------------------------------------------------------------------
+bool PollFence(const IFence* pFence, uint64_t fenceValue, uint64_t timeoutUsec)
+{
+    if (pFence == nullptr)
+    { return false; }
+
+    if (pFence->GetCompletedValue() >= fenceValue)
+    { return true; }
+
+    using Clock = std::chrono::steady_clock;
+    const auto begin = Clock::now();
+
+    uint32_t backoff = 1;
+    for(;;)
+    {
+        if (backoff < MAX_BACKOFF)
+        {
+            for(auto i=0u; i<backoff; ++i)
+            { _mm_pause(); }
+            backoff <<= 1;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+
+        if (pFence->GetCompletedValue() >= fenceValue)
+        { return true; }
+
+        if (timeoutUsec != UINT64_MAX)
+        {
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - begin).count();
+            if (uint64_t(elapsed) >= timeoutUsec)
+            { return false; }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      複数のフェンスが指定された値に達するまで待機します.
+//-----------------------------------------------------------------------------
+bool WaitForFences(uint32_t count, const WaitPoint* pPoints, bool waitAll, uint32_t msec, uint32_t* pIndex)
+{
+    if (count == 0 || count > MAX_WAIT_FENCE_COUNT || pPoints == nullptr)
+    {
+        ELOG_LIMIT("Error : Invalid Argument.");
+        return false;
+    }
+
+    auto native = true;
+    for(auto i=0u; i<count; ++i)
+    {
+        if (pPoints[i].pFence == nullptr)
+        {
+            ELOG_LIMIT("Error : Invalid Argument. index = %u", i);
+            return false;
+        }
+
+        if (pPoints[i].pFence->GetD3D12Fence() == nullptr)
+        { native = false; }
+    }
+
+    if (IsSatisfied(count, pPoints, waitAll, pIndex))
+    { return true; }
+
+#if defined(_WIN32)
+    if (native)
+    { return WaitNative(count, pPoints, waitAll, msec, pIndex); }
+#else
+    (void)native;
+#endif
+
+    auto supported = false;
+    auto result    = WaitSoft(count, pPoints, waitAll, msec, pIndex, supported);
+    if (supported)
+    { return result; }
+
+    return WaitPoll(count, pPoints, waitAll, msec, pIndex);
+}
+
+} // namespace asf
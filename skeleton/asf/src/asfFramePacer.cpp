@@ -0,0 +1,229 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfFramePacer.cpp
+// Desc : Frame-in-flight Pacing Controller.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfFramePacer.h>
+#include <asfLogger.h>
+#include <asfTime.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint64_t WAIT_THRESHOLD_NS     = 10 * 1000;    // これ以上待機したフレームを待機フレームとみなします.
+
+} // namespace
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// FramePacer class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+FramePacer::~FramePacer()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool FramePacer::Init(const FramePacerDesc& desc)
+{
+    if (desc.pQueue == nullptr
+     || desc.MaxFramesInFlight == 0
+     || desc.MaxFramesInFlight > MAX_FRAMES_IN_FLIGHT
+     || (desc.Adaptive && (desc.MinFramesInFlight == 0 || desc.MinFramesInFlight > desc.MaxFramesInFlight || desc.AdaptWindow == 0)))
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    if (m_pQueue != nullptr)
+    {
+        ELOG("Error : Already Initialized.");
+        return false;
+    }
+
+    m_pQueue            = desc.pQueue;
+    m_MaxFramesInFlight = desc.MaxFramesInFlight;
+    m_MinFramesInFlight = (desc.Adaptive) ? desc.MinFramesInFlight : desc.MaxFramesInFlight;
+    m_FramesInFlight    = desc.MaxFramesInFlight;
+    m_Adaptive          = desc.Adaptive;
+    m_AdaptWindow       = desc.AdaptWindow;
+    m_FrameNumber       = 0;
+    m_InFrame           = false;
+    m_BeginTime         = 0;
+    m_Stats             = FramePacerStats();
+
+    for(auto i=0u; i<MAX_FRAMES_IN_FLIGHT; ++i)
+    { m_Frames[i] = WaitPoint(); }
+
+    m_WindowFrames   = 0;
+    m_WindowWaits    = 0;
+    m_WindowStarves  = 0;
+    m_WindowWorkNs   = 0;
+    m_WindowPeriodNs = 0;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void FramePacer::Term()
+{
+    if (m_pQueue == nullptr)
+    { return; }
+
+    WaitIdle();
+
+    for(auto i=0u; i<MAX_FRAMES_IN_FLIGHT; ++i)
+    { m_Frames[i] = WaitPoint(); }
+
+    m_pQueue = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      フレームを開始します.
+//-----------------------------------------------------------------------------
+uint32_t FramePacer::BeginFrame()
+{
+    auto begin = GetSteadyTimeNs();
+
+    // 前フレームの周期から, CPUの処理時間 (待機時間を除く) を求める.
+    if (m_FrameNumber > 0 && m_BeginTime != 0)
+    {
+        auto period = begin - m_BeginTime;
+        auto work   = (period > m_Stats.LastWaitNs) ? period - m_Stats.LastWaitNs : 0;
+        m_WindowPeriodNs += period;
+        m_WindowWorkNs   += work;
+    }
+
+    // 先行フレーム数を超える場合のみ, 先行フレーム数前のフレームの完了を待つ.
+    // 調整により先行フレーム数が減った直後は, 複数フレーム分待機することがある.
+    uint64_t waitNs = 0;
+    if (m_FrameNumber >= m_FramesInFlight)
+    {
+        const auto& point = m_Frames[(m_FrameNumber - m_FramesInFlight) % m_MaxFramesInFlight];
+        if (point.pFence != nullptr && point.pFence->GetCompletedValue() < point.FenceValue)
+        {
+            point.pFence->Wait(point.FenceValue, WAIT_INFINITE);
+            waitNs = GetSteadyTimeNs() - begin;
+        }
+    }
+
+    // リソースを再利用するフレームは上記の待機対象以前であるため, 完了が保証される.
+    m_Stats.LastWaitNs   = waitNs;
+    m_Stats.TotalWaitNs += waitNs;
+    if (waitNs > 0)
+    { m_Stats.WaitCount++; }
+    if (waitNs >= WAIT_THRESHOLD_NS)
+    { m_WindowWaits++; }
+
+    m_BeginTime = begin;
+    m_InFrame   = true;
+    return uint32_t(m_FrameNumber % m_MaxFramesInFlight);
+}
+
+//-----------------------------------------------------------------------------
+//      フレームを終了します.
+//-----------------------------------------------------------------------------
+WaitPoint FramePacer::EndFrame()
+{
+    if (!m_InFrame)
+    {
+        ELOG("Error : BeginFrame() Not Called.");
+        return WaitPoint();
+    }
+
+    // シグナル前に前フレームが完了していれば, GPUはこのフレームの投入を待っていた.
+    if (m_FrameNumber > 0)
+    {
+        const auto& prev = m_Frames[(m_FrameNumber - 1) % m_MaxFramesInFlight];
+        if (prev.pFence != nullptr && prev.pFence->GetCompletedValue() >= prev.FenceValue)
+        {
+            m_Stats.StarveCount++;
+            m_WindowStarves++;
+        }
+    }
+
+    auto point = m_pQueue->Signal();
+    m_Frames[m_FrameNumber % m_MaxFramesInFlight] = point;
+
+    m_FrameNumber++;
+    m_Stats.FrameCount = m_FrameNumber;
+    m_InFrame = false;
+
+    if (m_Adaptive && ++m_WindowFrames >= m_AdaptWindow)
+    { Adapt(); }
+
+    return point;
+}
+
+//-----------------------------------------------------------------------------
+//      発行済みの全てのフレームが完了するまで待機します.
+//-----------------------------------------------------------------------------
+void FramePacer::WaitIdle()
+{
+    if (m_FrameNumber == 0)
+    { return; }
+
+    const auto& point = m_Frames[(m_FrameNumber - 1) % m_MaxFramesInFlight];
+    if (point.pFence != nullptr)
+    { point.pFence->Wait(point.FenceValue, WAIT_INFINITE); }
+}
+
+//-----------------------------------------------------------------------------
+//      リソースインデックスを最後に使用したフレームの待機点を取得します.
+//-----------------------------------------------------------------------------
+WaitPoint FramePacer::GetFrameWaitPoint(uint32_t index) const
+{
+    if (index >= m_MaxFramesInFlight)
+    { return WaitPoint(); }
+
+    return m_Frames[index];
+}
+
+//-----------------------------------------------------------------------------
+//      先行フレーム数を調整します.
+//-----------------------------------------------------------------------------
+void FramePacer::Adapt()
+{
+    // GPUが待機していた場合は, 先行フレーム数を増やしてスループットを優先する.
+    // CPUの処理時間のばらつきを吸収できるだけの余裕がないため.
+    if (m_WindowStarves > 0 && m_FramesInFlight < m_MaxFramesInFlight)
+    {
+        m_FramesInFlight++;
+    }
+    // 全フレームで待機しておりGPUが途切れていない場合は, 先行フレーム数を減らして遅延を短くする.
+    // 先行フレーム数 L で BeginFrame() を抜けた時点のキューには L - 1 フレームが残るため,
+    // CPUの処理時間が (L - 2) フレーム分のGPU時間に収まる場合のみ減らしてもGPUは途切れない.
+    else if (m_WindowStarves == 0
+          && m_WindowWaits >= m_WindowFrames
+          && m_FramesInFlight > m_MinFramesInFlight
+          && m_FramesInFlight > 2)
+    {
+        // 全フレームで待機しているため, フレーム周期はGPUの処理時間とみなせる. 1割の余裕を持たせる.
+        auto limit = m_WindowPeriodNs * (m_FramesInFlight - 2) * 9 / 10;
+        if (m_WindowWorkNs < limit)
+        { m_FramesInFlight--; }
+    }
+
+    m_WindowFrames   = 0;
+    m_WindowWaits    = 0;
+    m_WindowStarves  = 0;
+    m_WindowWorkNs   = 0;
+    m_WindowPeriodNs = 0;
+}
+
+} // namespace asf
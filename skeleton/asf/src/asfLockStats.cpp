@@ -0,0 +1,225 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfLockStats.cpp
+// Desc : Lock Contention Statistics.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfLockStats.h>
+#include <asfLogger.h>
+#include <asfBit.h>
+#include <mutex>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// LockStatsRegistry class
+///////////////////////////////////////////////////////////////////////////////
+class LockStatsRegistry
+{
+public:
+    //-------------------------------------------------------------------------
+    //      インスタンスを取得します.
+    //-------------------------------------------------------------------------
+    static LockStatsRegistry& Instance()
+    {
+        static LockStatsRegistry s_Instance;
+        return s_Instance;
+    }
+
+    //-------------------------------------------------------------------------
+    //      登録します.
+    //-------------------------------------------------------------------------
+    void Register(LockStats* pStats)
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        pStats->m_pPrev = nullptr;
+        pStats->m_pNext = m_pHead;
+        if (m_pHead != nullptr)
+        { m_pHead->m_pPrev = pStats; }
+        m_pHead = pStats;
+    }
+
+    //-------------------------------------------------------------------------
+    //      登録解除します.
+    //-------------------------------------------------------------------------
+    void Unregister(LockStats* pStats)
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        if (pStats->m_pPrev != nullptr)
+        { pStats->m_pPrev->m_pNext = pStats->m_pNext; }
+        else
+        { m_pHead = pStats->m_pNext; }
+
+        if (pStats->m_pNext != nullptr)
+        { pStats->m_pNext->m_pPrev = pStats->m_pPrev; }
+
+        pStats->m_pPrev = nullptr;
+        pStats->m_pNext = nullptr;
+    }
+
+    //-------------------------------------------------------------------------
+    //      登録されている全ロックに対して処理を行います.
+    //-------------------------------------------------------------------------
+    template<typename Func>
+    void ForEach(Func&& func)
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        for(auto pStats = m_pHead; pStats != nullptr; pStats = pStats->m_pNext)
+        { func(*pStats); }
+    }
+
+private:
+    std::mutex  m_Mutex;
+    LockStats*  m_pHead = nullptr;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LockStats class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+LockStats::LockStats(const char* name)
+: m_pName(name != nullptr ? name : "(unnamed)")
+{
+    for(auto& bin : m_Histogram)
+    { bin.store(0, std::memory_order_relaxed); }
+
+    LockStatsRegistry::Instance().Register(this);
+}
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+LockStats::~LockStats()
+{ LockStatsRegistry::Instance().Unregister(this); }
+
+//-----------------------------------------------------------------------------
+//      競合ありのロック取得を記録します.
+//-----------------------------------------------------------------------------
+void LockStats::RecordContended(uint64_t spinCount, uint64_t waitTimeNs)
+{
+    m_Acquisitions         .fetch_add(1,          std::memory_order_relaxed);
+    m_ContendedAcquisitions.fetch_add(1,          std::memory_order_relaxed);
+    m_SpinCount            .fetch_add(spinCount,  std::memory_order_relaxed);
+    m_WaitTimeNs           .fetch_add(waitTimeNs, std::memory_order_relaxed);
+
+    // マイクロ秒単位の log2 でビンを決定する.
+    auto usec  = waitTimeNs / 1000;
+    auto index = (usec == 0) ? 0u : uint32_t(FindOneL(usec) - 1);
+    if (index >= LOCK_STATS_HISTOGRAM_COUNT)
+    { index = LOCK_STATS_HISTOGRAM_COUNT - 1; }
+
+    m_Histogram[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//      統計情報を取得します.
+//-----------------------------------------------------------------------------
+void LockStats::GetSnapshot(LockStatsSnapshot& result) const
+{
+    result.Name                  = m_pName;
+    result.Acquisitions          = m_Acquisitions         .load(std::memory_order_relaxed);
+    result.ContendedAcquisitions = m_ContendedAcquisitions.load(std::memory_order_relaxed);
+    result.SpinCount             = m_SpinCount            .load(std::memory_order_relaxed);
+    result.WaitTimeNs            = m_WaitTimeNs           .load(std::memory_order_relaxed);
+
+    for(auto i=0u; i<LOCK_STATS_HISTOGRAM_COUNT; ++i)
+    { result.Histogram[i] = m_Histogram[i].load(std::memory_order_relaxed); }
+}
+
+//-----------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-----------------------------------------------------------------------------
+void LockStats::Reset()
+{
+    m_Acquisitions         .store(0, std::memory_order_relaxed);
+    m_ContendedAcquisitions.store(0, std::memory_order_relaxed);
+    m_SpinCount            .store(0, std::memory_order_relaxed);
+    m_WaitTimeNs           .store(0, std::memory_order_relaxed);
+
+    for(auto& bin : m_Histogram)
+    { bin.store(0, std::memory_order_relaxed); }
+}
+
+//-----------------------------------------------------------------------------
+//      登録されている全ロックの統計情報を取得します.
+//-----------------------------------------------------------------------------
+void SampleLockStats(std::vector<LockStatsSnapshot>& result)
+{
+    result.clear();
+    LockStatsRegistry::Instance().ForEach([&](const LockStats& stats)
+    {
+        LockStatsSnapshot snapshot;
+        stats.GetSnapshot(snapshot);
+        result.push_back(snapshot);
+    });
+}
+
+//-----------------------------------------------------------------------------
+//      登録されている全ロックの統計情報をリセットします.
+//-----------------------------------------------------------------------------
+void ResetLockStats()
+{
+    LockStatsRegistry::Instance().ForEach([](LockStats& stats)
+    { stats.Reset(); });
+}
+
+//-----------------------------------------------------------------------------
+//      登録されている全ロックの統計情報をログに出力します.
+//-----------------------------------------------------------------------------
+void DumpLockStats(ILogger* pLogger)
+{
+    if (pLogger == nullptr)
+    { pLogger = GetLogger(); }
+
+    std::vector<LockStatsSnapshot> snapshots;
+    SampleLockStats(snapshots);
+
+    for(auto& item : snapshots)
+    {
+        auto contended = (item.Acquisitions > 0)
+            ? double(item.ContendedAcquisitions) * 100.0 / double(item.Acquisitions)
+            : 0.0;
+
+        pLogger->WriteA(LOG_INFO,
+            "Lock : %s, acquire = %llu, contended = %llu (%.2f%%), spin = %llu, wait = %.3f ms\n",
+            item.Name,
+            static_cast<unsigned long long>(item.Acquisitions),
+            static_cast<unsigned long long>(item.ContendedAcquisitions),
+            contended,
+            static_cast<unsigned long long>(item.SpinCount),
+            double(item.WaitTimeNs) / 1e6);
+
+        if (item.ContendedAcquisitions == 0)
+        { continue; }
+
+        // 空でないビンのみ出力する.
+        for(auto i=0u; i<LOCK_STATS_HISTOGRAM_COUNT; ++i)
+        {
+            if (item.Histogram[i] == 0)
+            { continue; }
+
+            if (i == LOCK_STATS_HISTOGRAM_COUNT - 1)
+            {
+                pLogger->WriteA(LOG_INFO, "    wait >= %8llu us : %llu\n",
+                    1ull << i,
+                    static_cast<unsigned long long>(item.Histogram[i]));
+            }
+            else
+            {
+                pLogger->WriteA(LOG_INFO, "    wait <  %8llu us : %llu\n",
+                    2ull << i,
+                    static_cast<unsigned long long>(item.Histogram[i]));
+            }
+        }
+    }
+}
+
+} // namespace asf
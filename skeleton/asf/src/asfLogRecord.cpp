@@ -0,0 +1,502 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfLogRecord.cpp
+// Desc : Deferred-formatting Binary Log Record.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <asfLogRecord.h>
+#include <asfTime.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Global Variables.
+//-----------------------------------------------------------------------------
+std::atomic<uint32_t>               g_NextSiteId    = { 1 };
+std::atomic<asf::ILogRecordWriter*> g_pRecordWriter = { nullptr };
+
+///////////////////////////////////////////////////////////////////////////////
+// TextWriter class
+///////////////////////////////////////////////////////////////////////////////
+class TextWriter
+{
+public:
+    TextWriter(char* buffer, size_t size)
+    : m_Buffer(buffer)
+    , m_Size  (size)
+    { if (m_Size > 0) { m_Buffer[0] = '\0'; } }
+
+    void Put(char c)
+    {
+        if (m_Pos + 1 < m_Size)
+        {
+            m_Buffer[m_Pos++] = c;
+            m_Buffer[m_Pos]   = '\0';
+        }
+    }
+
+    void PutString(const char* value)
+    {
+        while (*value != '\0')
+        { Put(*value++); }
+    }
+
+    template<typename T>
+    void Print(const char* spec, T value)
+    {
+        if (m_Pos + 1 >= m_Size)
+        { return; }
+
+        auto ret = snprintf(m_Buffer + m_Pos, m_Size - m_Pos, spec, value);
+        if (ret < 0)
+        { return; }
+
+        m_Pos += (size_t(ret) < m_Size - m_Pos) ? size_t(ret) : (m_Size - m_Pos - 1);
+    }
+
+    size_t GetLength() const
+    { return m_Pos; }
+
+private:
+    char*   m_Buffer;
+    size_t  m_Size;
+    size_t  m_Pos = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ArgReader class
+///////////////////////////////////////////////////////////////////////////////
+class ArgReader
+{
+public:
+    ArgReader(const void* pArgs, uint32_t size)
+    : m_pData(static_cast<const uint8_t*>(pArgs))
+    , m_Size (size)
+    { /* DO_NOTHING */ }
+
+    bool Next(asf::LOG_ARG_TYPE& type, const uint8_t*& pValue, uint32_t& count)
+    {
+        if (m_Pos + 1 > m_Size)
+        { return false; }
+
+        type   = asf::LOG_ARG_TYPE(m_pData[m_Pos++]);
+        pValue = m_pData + m_Pos;
+        count  = 0;
+
+        switch(type)
+        {
+        case asf::LOG_ARG_INT:
+        case asf::LOG_ARG_UINT:
+        case asf::LOG_ARG_DOUBLE:
+        case asf::LOG_ARG_POINTER:
+            return Skip(8);
+
+        case asf::LOG_ARG_STRING:
+        case asf::LOG_ARG_WSTRING:
+            {
+                uint16_t length = 0;
+                if (m_Pos + sizeof(length) > m_Size)
+                { return false; }
+
+                memcpy(&length, m_pData + m_Pos, sizeof(length));
+                m_Pos += sizeof(length);
+                pValue = m_pData + m_Pos;
+                count  = length;
+                if (!Skip((type == asf::LOG_ARG_STRING) ? (length + 1u) : (length * 4u)))
+                { return false; }
+
+                // 壊れたレコードで終端文字の外側を読まないようにする.
+                return (type != asf::LOG_ARG_STRING) || (pValue[length] == '\0');
+            }
+
+        default:
+            return false;
+        }
+    }
+
+private:
+    const uint8_t*  m_pData;
+    uint32_t        m_Size;
+    uint32_t        m_Pos = 0;
+
+    bool Skip(uint32_t size)
+    {
+        if (m_Pos + size > m_Size)
+        { return false; }
+        m_Pos += size;
+        return true;
+    }
+};
+
+//-----------------------------------------------------------------------------
+//      読み取ります.
+//-----------------------------------------------------------------------------
+template<typename T>
+T Load(const uint8_t* pValue)
+{
+    T result;
+    memcpy(&result, pValue, sizeof(T));
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      UTF-32 を UTF-8 として出力します.
+//-----------------------------------------------------------------------------
+void PutUtf8(TextWriter& writer, uint32_t c)
+{
+    if (c < 0x80)
+    { writer.Put(char(c)); }
+    else if (c < 0x800)
+    {
+        writer.Put(char(0xC0 | (c >> 6)));
+        writer.Put(char(0x80 | (c & 0x3F)));
+    }
+    else if (c < 0x10000)
+    {
+        writer.Put(char(0xE0 | (c >> 12)));
+        writer.Put(char(0x80 | ((c >> 6) & 0x3F)));
+        writer.Put(char(0x80 | (c & 0x3F)));
+    }
+    else
+    {
+        writer.Put(char(0xF0 | (c >> 18)));
+        writer.Put(char(0x80 | ((c >> 12) & 0x3F)));
+        writer.Put(char(0x80 | ((c >> 6) & 0x3F)));
+        writer.Put(char(0x80 | (c & 0x3F)));
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      書式指定子を1つ出力します.
+//-----------------------------------------------------------------------------
+void PrintArg(TextWriter& writer, const char* spec, size_t specLength, char conversion, ArgReader& reader)
+{
+    asf::LOG_ARG_TYPE type;
+    const uint8_t*    pValue = nullptr;
+    uint32_t          count  = 0;
+    if (!reader.Next(type, pValue, count))
+    {
+        writer.PutString("<missing>");
+        return;
+    }
+
+    // 長さ修飾子は型タグに合わせて付け直す.
+    char fmt[32];
+    if (specLength > sizeof(fmt) - 4)
+    { specLength = sizeof(fmt) - 4; }
+    memcpy(fmt, spec, specLength);
+
+    auto isInteger = (strchr("diouxXc", conversion) != nullptr);
+    auto isFloat   = (strchr("eEfFgGaA", conversion) != nullptr);
+
+    switch(type)
+    {
+    case asf::LOG_ARG_INT:
+    case asf::LOG_ARG_UINT:
+        {
+            auto value = Load<uint64_t>(pValue);
+            if (isFloat)
+            {
+                fmt[specLength] = conversion; fmt[specLength + 1] = '\0';
+                writer.Print(fmt, (type == asf::LOG_ARG_INT) ? double(int64_t(value)) : double(value));
+            }
+            else if (conversion == 'c')
+            {
+                fmt[specLength] = 'c'; fmt[specLength + 1] = '\0';
+                writer.Print(fmt, int(value));
+            }
+            else
+            {
+                auto c = isInteger ? conversion : ((type == asf::LOG_ARG_INT) ? 'd' : 'u');
+                fmt[specLength] = 'l'; fmt[specLength + 1] = 'l'; fmt[specLength + 2] = c; fmt[specLength + 3] = '\0';
+                if (type == asf::LOG_ARG_INT)
+                { writer.Print(fmt, static_cast<long long>(int64_t(value))); }
+                else
+                { writer.Print(fmt, static_cast<unsigned long long>(value)); }
+            }
+        }
+        break;
+
+    case asf::LOG_ARG_DOUBLE:
+        {
+            fmt[specLength] = isFloat ? conversion : 'g'; fmt[specLength + 1] = '\0';
+            writer.Print(fmt, Load<double>(pValue));
+        }
+        break;
+
+    case asf::LOG_ARG_POINTER:
+        {
+            fmt[specLength] = 'l'; fmt[specLength + 1] = 'l'; fmt[specLength + 2] = 'x'; fmt[specLength + 3] = '\0';
+            writer.Put('0'); writer.Put('x');
+            writer.Print(fmt, static_cast<unsigned long long>(Load<uint64_t>(pValue)));
+        }
+        break;
+
+    case asf::LOG_ARG_STRING:
+        {
+            fmt[specLength] = 's'; fmt[specLength + 1] = '\0';
+            writer.Print(fmt, reinterpret_cast<const char*>(pValue));
+        }
+        break;
+
+    case asf::LOG_ARG_WSTRING:
+        {
+            for(auto i=0u; i<count; ++i)
+            { PutUtf8(writer, Load<uint32_t>(pValue + i * 4)); }
+        }
+        break;
+    }
+}
+
+} // namespace
+
+
+namespace asf {
+
+//-----------------------------------------------------------------------------
+//      ワイド文字をエンコードします.
+//-----------------------------------------------------------------------------
+void EncodeLogArg(LogArgBuffer& buffer, wchar_t value)
+{
+    // 1文字のワイド文字列として記録し, %c / %lc のどちらでも UTF-8 で出力する.
+    const wchar_t text[2] = { value, L'\0' };
+    EncodeLogArg(buffer, text);
+}
+
+//-----------------------------------------------------------------------------
+//      文字列をエンコードします.
+//-----------------------------------------------------------------------------
+void EncodeLogArg(LogArgBuffer& buffer, const char* value)
+{
+    if (value == nullptr)
+    { value = "(null)"; }
+
+    // 終端文字と長さ・型タグの分を残して切り詰める.
+    auto length = strlen(value);
+    auto remain = LOG_RECORD_ARGS_SIZE - buffer.Size;
+    if (remain < 4)
+    { return; }
+    if (length > remain - 4)
+    { length = remain - 4; }
+    if (length > UINT16_MAX)
+    { length = UINT16_MAX; }
+
+    auto count = uint16_t(length);
+    buffer.Data[buffer.Size++] = LOG_ARG_STRING;
+    buffer.Put(&count, sizeof(count));
+    buffer.Put(value, length);
+    buffer.Data[buffer.Size++] = '\0';
+}
+
+//-----------------------------------------------------------------------------
+//      ワイド文字列をエンコードします.
+//-----------------------------------------------------------------------------
+void EncodeLogArg(LogArgBuffer& buffer, const wchar_t* value)
+{
+    if (value == nullptr)
+    { value = L"(null)"; }
+
+    if (buffer.Size + 3 > LOG_RECORD_ARGS_SIZE)
+    { return; }
+
+    buffer.Data[buffer.Size++] = LOG_ARG_WSTRING;
+    auto countPos = buffer.Size;
+    buffer.Size += sizeof(uint16_t);
+
+    uint16_t count = 0;
+    for(auto p = value; *p != L'\0' && count < UINT16_MAX; ++p)
+    {
+        // Windows では UTF-16 のサロゲートペアを結合する.
+        auto c = uint32_t(*p);
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c < 0xDC00)
+        {
+            auto low = uint32_t(p[1]);
+            if (low >= 0xDC00 && low < 0xE000)
+            {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                ++p;
+            }
+        }
+
+        if (!buffer.Put(&c, sizeof(c)))
+        { break; }
+        count++;
+    }
+
+    memcpy(buffer.Data + countPos, &count, sizeof(count));
+}
+
+//-----------------------------------------------------------------------------
+//      呼び出し元を登録し, 識別番号を取得します.
+//-----------------------------------------------------------------------------
+uint32_t RegisterLogSite(LogSite& site)
+{
+    auto id = site.Id.load(std::memory_order_acquire);
+    if (id != 0)
+    { return id; }
+
+    // 同時に登録された場合は先に設定された番号を使う. 欠番が生じても問題ない.
+    auto newId    = g_NextSiteId.fetch_add(1, std::memory_order_relaxed);
+    uint32_t expected = 0;
+    if (site.Id.compare_exchange_strong(expected, newId, std::memory_order_acq_rel))
+    { return newId; }
+
+    return expected;
+}
+
+//-----------------------------------------------------------------------------
+//      エンコード済みの引数でログレコードを送信します.
+//-----------------------------------------------------------------------------
+void SubmitLogRecord(LogSite& site, const LogArgBuffer& args)
+{
+    RegisterLogSite(site);
+
+    auto timestamp = GetSteadyTimeNs();
+
+    auto pWriter = g_pRecordWriter.load(std::memory_order_acquire);
+    if (pWriter != nullptr)
+    {
+        pWriter->WriteRecord(site, timestamp, args.Data, args.Size);
+        return;
+    }
+
+    char msg[1024];
+    FormatLogRecord(site.Format, site.File, site.Line, site.Flags, args.Data, args.Size, msg, sizeof(msg));
+    GetLogger()->WriteA(site.Level, "%s", msg);
+}
+
+//-----------------------------------------------------------------------------
+//      ログレコードライターを設定します.
+//-----------------------------------------------------------------------------
+void SetLogRecordWriter(ILogRecordWriter* pWriter)
+{ g_pRecordWriter.store(pWriter, std::memory_order_release); }
+
+//-----------------------------------------------------------------------------
+//      ログレコードライターを取得します.
+//-----------------------------------------------------------------------------
+ILogRecordWriter* GetLogRecordWriter()
+{ return g_pRecordWriter.load(std::memory_order_acquire); }
+
+//-----------------------------------------------------------------------------
+//      エンコード済みの引数を使ってフォーマットします.
+//-----------------------------------------------------------------------------
+size_t FormatLogArgs(const char* format, const void* pArgs, uint32_t argSize, char* buffer, size_t bufferSize)
+{
+    TextWriter writer(buffer, bufferSize);
+    ArgReader  reader(pArgs, argSize);
+
+    auto p = format;
+    while (*p != '\0')
+    {
+        if (*p != '%')
+        {
+            writer.Put(*p++);
+            continue;
+        }
+
+        if (p[1] == '%')
+        {
+            writer.Put('%');
+            p += 2;
+            continue;
+        }
+
+        // フラグ, 幅, 精度は保持し, 長さ修飾子は読み捨てる.
+        char   spec[32] = "%";
+        size_t length   = 1;
+        auto append = [&](char c) { if (length < sizeof(spec) - 1) { spec[length++] = c; } };
+
+        auto q = p + 1;
+        while (*q != '\0' && strchr("-+ #0", *q) != nullptr)
+        { append(*q++); }
+
+        // '*' による幅・精度指定は, 引数から取り出して数値に置き換える.
+        auto appendNumber = [&](ArgReader& r)
+        {
+            LOG_ARG_TYPE   type;
+            const uint8_t* pValue = nullptr;
+            uint32_t       count  = 0;
+            int64_t        value  = 0;
+            if (r.Next(type, pValue, count) && (type == LOG_ARG_INT || type == LOG_ARG_UINT))
+            { value = Load<int64_t>(pValue); }
+
+            char digits[24];
+            snprintf(digits, sizeof(digits), "%lld", static_cast<long long>(value));
+            for(auto d = digits; *d != '\0'; ++d)
+            { append(*d); }
+        };
+
+        if (*q == '*')
+        { appendNumber(reader); q++; }
+        while (*q >= '0' && *q <= '9')
+        { append(*q++); }
+
+        if (*q == '.')
+        {
+            append(*q++);
+            if (*q == '*')
+            { appendNumber(reader); q++; }
+            while (*q >= '0' && *q <= '9')
+            { append(*q++); }
+        }
+
+        while (*q != '\0' && strchr("hljztLIw0123456789", *q) != nullptr)
+        { q++; }
+
+        if (*q == '\0')
+        { break; }
+
+        auto conversion = *q++;
+        if (conversion == 'S')
+        { conversion = 's'; }
+        else if (conversion == 'C')
+        { conversion = 'c'; }
+
+        if (conversion == 'n')
+        {
+            p = q;
+            continue;
+        }
+
+        PrintArg(writer, spec, length, conversion, reader);
+        p = q;
+    }
+
+    return writer.GetLength();
+}
+
+//-----------------------------------------------------------------------------
+//      ログレコードをフォーマットします.
+//-----------------------------------------------------------------------------
+size_t FormatLogRecord
+(
+    const char* format,
+    const char* file,
+    int         line,
+    uint32_t    flags,
+    const void* pArgs,
+    uint32_t    argSize,
+    char*       buffer,
+    size_t      bufferSize
+)
+{
+    if (bufferSize == 0)
+    { return 0; }
+
+    size_t offset = 0;
+    if (flags & LOG_SITE_FLAG_LOCATION)
+    {
+        auto ret = snprintf(buffer, bufferSize, "[File: %s, Line: %d] ", file, line);
+        if (ret > 0)
+        { offset = (size_t(ret) < bufferSize) ? size_t(ret) : bufferSize - 1; }
+    }
+
+    return offset + FormatLogArgs(format, pArgs, argSize, buffer + offset, bufferSize - offset);
+}
+
+} // namespace asf
@@ -7,17 +7,26 @@
 //-----------------------------------------------------------------------------
 // Includes
 //-----------------------------------------------------------------------------
+#include <cerrno>
 #include <cstdio>
 #include <cstdarg>
+#include <cstdint>
+#include <cwchar>
 #include <atomic>
-#include <Windows.h>
+#include <vector>
 #include <asfLogger.h>
+#include <asfTime.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
 
 
 namespace asf {
 
 namespace {
 
+#if defined(_WIN32)
 //-----------------------------------------------------------------------------
 // Global Variables.
 //-----------------------------------------------------------------------------
@@ -67,6 +76,151 @@ void SetDefaultColor()
     SetConsoleTextAttribute(handle, g_Info.wAttributes);
 }
 
+//-----------------------------------------------------------------------------
+//      コンソール情報を初期化します.
+//-----------------------------------------------------------------------------
+void InitConsole()
+{
+    if (!g_Init)
+    {
+        const auto handle = GetStdHandle(STD_OUTPUT_HANDLE);
+        GetConsoleScreenBufferInfo(handle, &g_Info);
+        g_Init = true;
+    }
+}
+
+#else
+//-----------------------------------------------------------------------------
+//      Windows 以外ではコンソールカラーとデバッガ出力は行いません.
+//-----------------------------------------------------------------------------
+void InitConsole        ()                  { /* DO_NOTHING */ }
+void SetColor           (LOG_LEVEL)         { /* DO_NOTHING */ }
+void SetDefaultColor    ()                  { /* DO_NOTHING */ }
+void OutputDebugStringA (const char*)       { /* DO_NOTHING */ }
+void OutputDebugStringW (const wchar_t*)    { /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      セキュア版フォーマット関数の代替です.
+//-----------------------------------------------------------------------------
+int fwprintf_s(FILE* stream, const wchar_t* format, ...)
+{
+    va_list arg;
+    va_start(arg, format);
+    auto ret = vfwprintf(stream, format, arg);
+    va_end(arg);
+    return ret;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr size_t MAX_SCRATCH_COUNT = size_t(1) << 20;   // 長いメッセージ用バッファの最大文字数.
+
+//-----------------------------------------------------------------------------
+// Thread Local Variables.
+//-----------------------------------------------------------------------------
+thread_local std::vector<char>      t_ScratchA;
+thread_local std::vector<wchar_t>   t_ScratchW;
+
+//-----------------------------------------------------------------------------
+//      フォーマットします.
+//
+//      スタック上のバッファに収まらない場合のみ, スレッドローカルのバッファを
+//      必要なサイズまで拡張して再度フォーマットします. バッファは呼び出し間で再利用されます.
+//-----------------------------------------------------------------------------
+template<size_t N>
+const char* FormatA(char (&buffer)[N], const char* format, va_list arg)
+{
+    va_list copy;
+    va_copy(copy, arg);
+    auto count = vsnprintf(buffer, N, format, copy);
+    va_end(copy);
+
+    if (count < 0)
+    {
+        buffer[0] = '\0';
+        return buffer;
+    }
+
+    if (size_t(count) < N)
+    { return buffer; }
+
+    auto required = size_t(count) + 1;
+    if (required > MAX_SCRATCH_COUNT)
+    { return buffer; }
+
+    if (t_ScratchA.size() < required)
+    { t_ScratchA.resize(required); }
+
+    vsnprintf(t_ScratchA.data(), t_ScratchA.size(), format, arg);
+    return t_ScratchA.data();
+}
+
+//-----------------------------------------------------------------------------
+//      フォーマットします.
+//
+//      vswprintf は必要な文字数を返さないため, Windows 以外ではバッファを倍々に拡張します.
+//      変換できない文字を含むなど, バッファサイズ以外の理由で失敗した場合は再試行しません.
+//-----------------------------------------------------------------------------
+template<size_t N>
+const wchar_t* FormatW(wchar_t (&buffer)[N], const wchar_t* format, va_list arg)
+{
+    va_list copy;
+    va_copy(copy, arg);
+    errno = 0;
+    auto count = vswprintf(buffer, N, format, copy);
+    va_end(copy);
+
+    if (count >= 0)
+    { return buffer; }
+
+    auto required = N * 2;
+#if defined(_WIN32)
+    va_copy(copy, arg);
+    auto length = _vscwprintf(format, copy);
+    va_end(copy);
+
+    if (length < 0)
+    { required = MAX_SCRATCH_COUNT + 1; }
+    else if (size_t(length) + 1 > required)
+    { required = size_t(length) + 1; }
+#else
+    if (errno == EILSEQ)
+    { required = MAX_SCRATCH_COUNT + 1; }
+    else if (t_ScratchW.size() > required)
+    { required = t_ScratchW.size(); }
+#endif
+
+    while (required <= MAX_SCRATCH_COUNT)
+    {
+        if (t_ScratchW.size() < required)
+        { t_ScratchW.resize(required); }
+
+        va_copy(copy, arg);
+        errno = 0;
+        count = vswprintf(t_ScratchW.data(), t_ScratchW.size(), format, copy);
+        va_end(copy);
+
+        if (count >= 0)
+        { return t_ScratchW.data(); }
+
+#if defined(_WIN32)
+        // 必要な文字数を確保済みのため, バッファサイズ以外の理由で失敗している.
+        break;
+#else
+        if (errno == EILSEQ)
+        { break; }
+#endif
+
+        required = t_ScratchW.size() * 2;
+    }
+
+    // 変換できない文字を含むか, 上限を超えた場合.
+    buffer[N - 1] = L'\0';
+    return buffer;
+}
+
 } // namespace
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -90,18 +244,13 @@ public:
     //-------------------------------------------------------------------------
     void WriteA(LOG_LEVEL level, const char* format, ...) override
     {
-        if (!g_Init)
-        {
-            const auto handle = GetStdHandle(STD_OUTPUT_HANDLE);
-            GetConsoleScreenBufferInfo(handle, &g_Info);
-            g_Init = true;
-        }
+        InitConsole();
 
-        char msg[1024] = "\0";
+        char buffer[1024];
         va_list arg;
 
         va_start(arg, format);
-        vsprintf_s(msg, format, arg);
+        auto msg = FormatA(buffer, format, arg);
         va_end(arg);
 
         SetColor(level);
@@ -116,22 +265,17 @@ public:
     //-------------------------------------------------------------------------
     void WriteW(LOG_LEVEL level, const wchar_t* format, ... ) override
     {
-        if (!g_Init)
-        {
-            const auto handle = GetStdHandle(STD_OUTPUT_HANDLE);
-            GetConsoleScreenBufferInfo(handle, &g_Info);
-            g_Init = true;
-        }
+        InitConsole();
 
-        wchar_t msg[1024] = L"\0";
+        wchar_t buffer[1024];
         va_list arg;
 
         va_start(arg, format);
-        vswprintf_s(msg, format, arg);
+        auto msg = FormatW(buffer, format, arg);
         va_end(arg);
 
         SetColor(level);
-        fwprintf_s((level == LOG_ERROR ? stderr : stdout), L"%s", msg);
+        fwprintf_s((level == LOG_ERROR ? stderr : stdout), L"%ls", msg);
         SetDefaultColor();
 
         OutputDebugStringW(msg);
@@ -139,9 +283,109 @@ public:
 } g_DefaultLogger;
 
 //-----------------------------------------------------------------------------
-//      デフォルトロガーを設定します.
+// Global Variables.
+//-----------------------------------------------------------------------------
+std::atomic<int> g_LogLevels[LOG_CATEGORY_COUNT] = {};
+std::atomic<ILogger*> g_pLogger = { nullptr };
+
+//-----------------------------------------------------------------------------
+//      デフォルトロガーを取得します.
 //-----------------------------------------------------------------------------
 ILogger* GetDefaultLogger()
 { return &g_DefaultLogger; }
 
+//-----------------------------------------------------------------------------
+//      ログマクロが使用するロガーを設定します.
+//-----------------------------------------------------------------------------
+void SetLogger(ILogger* pLogger)
+{ g_pLogger.store(pLogger, std::memory_order_release); }
+
+//-----------------------------------------------------------------------------
+//      ログマクロが使用するロガーを取得します.
+//-----------------------------------------------------------------------------
+ILogger* GetLogger()
+{
+    auto pLogger = g_pLogger.load(std::memory_order_acquire);
+    return (pLogger != nullptr) ? pLogger : &g_DefaultLogger;
+}
+
+//-----------------------------------------------------------------------------
+//      出力可否を判定します.
+//-----------------------------------------------------------------------------
+bool LogLimiter::Acquire(uint64_t& suppressed, uint64_t& elapsedNs)
+{
+    suppressed = 0;
+    elapsedNs  = 0;
+
+    const auto now = GetSteadyTimeNs();
+
+    // 区間を切り替えたスレッドのみが抑制数を報告する.
+    auto start = WindowStart.load(std::memory_order_relaxed);
+    if (start == 0 || now - start >= IntervalNs)
+    {
+        if (WindowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+        {
+            Count.store(1, std::memory_order_relaxed);
+            suppressed = Suppressed.exchange(0, std::memory_order_relaxed);
+            elapsedNs  = (start != 0) ? now - start : 0;
+            return true;
+        }
+    }
+
+    if (Count.fetch_add(1, std::memory_order_relaxed) < Burst)
+    { return true; }
+
+    Suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      抑制したログの件数を出力します.
+//-----------------------------------------------------------------------------
+void ReportSuppressedLog(LOG_LEVEL level, const char* file, int line, const char* format, uint64_t count, uint64_t elapsedNs)
+{
+    GetLogger()->WriteA(level, "[File: %s, Line: %d] Last message repeated %llu times in %.1f s : %s\n",
+        file, line, static_cast<unsigned long long>(count), double(elapsedNs) / 1e9, format);
+}
+
+//-----------------------------------------------------------------------------
+//      抑制したログの件数を出力します.
+//-----------------------------------------------------------------------------
+void ReportSuppressedLog(LOG_LEVEL level, const wchar_t* file, int line, const wchar_t* format, uint64_t count, uint64_t elapsedNs)
+{
+    GetLogger()->WriteW(level, L"[File: %ls, Line: %d] Last message repeated %llu times in %.1f s : %ls\n",
+        file, line, static_cast<unsigned long long>(count), double(elapsedNs) / 1e9, format);
+}
+
+//-----------------------------------------------------------------------------
+//      カテゴリの出力ログレベルを設定します.
+//-----------------------------------------------------------------------------
+void SetLogLevel(LOG_CATEGORY category, LOG_LEVEL level)
+{
+    if (uint32_t(category) >= LOG_CATEGORY_COUNT)
+    { return; }
+
+    g_LogLevels[category].store(int(level), std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//      全カテゴリの出力ログレベルを設定します.
+//-----------------------------------------------------------------------------
+void SetLogLevel(LOG_LEVEL level)
+{
+    for(auto& item : g_LogLevels)
+    { item.store(int(level), std::memory_order_relaxed); }
+}
+
+//-----------------------------------------------------------------------------
+//      カテゴリの出力ログレベルを取得します.
+//-----------------------------------------------------------------------------
+LOG_LEVEL GetLogLevel(LOG_CATEGORY category)
+{
+    if (uint32_t(category) >= LOG_CATEGORY_COUNT)
+    { return LOG_VERBOSE; }
+
+    return LOG_LEVEL(g_LogLevels[category].load(std::memory_order_relaxed));
+}
+
 } // namespace asf
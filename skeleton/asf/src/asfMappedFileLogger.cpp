@@ -0,0 +1,357 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfMappedFileLogger.cpp
+// Desc : Memory-mapped Structured Log File Sink.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <cwchar>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <asfMappedFileLogger.h>
+
+#if defined(_WIN32)
+  #include <Windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #if defined(__linux__)
+    #include <sys/syscall.h>
+  #endif
+#endif
+
+
+namespace {
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "std::atomic<uint64_t> Size Not Match");
+
+//-----------------------------------------------------------------------------
+//      レコードの書き込み番号をアトミック変数として取得します.
+//-----------------------------------------------------------------------------
+std::atomic<uint64_t>& GetSequence(asf::MappedLogRecord* pRecord)
+{ return *reinterpret_cast<std::atomic<uint64_t>*>(&pRecord->Sequence); }
+
+//-----------------------------------------------------------------------------
+//      現在のスレッドIDを取得します.
+//-----------------------------------------------------------------------------
+uint32_t GetThreadId()
+{
+    thread_local uint32_t s_ThreadId = 0;
+    if (s_ThreadId == 0)
+    {
+    #if defined(_WIN32)
+        s_ThreadId = uint32_t(GetCurrentThreadId());
+    #elif defined(__linux__)
+        s_ThreadId = uint32_t(syscall(SYS_gettid));
+    #else
+        s_ThreadId = uint32_t(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    #endif
+    }
+    return s_ThreadId;
+}
+
+//-----------------------------------------------------------------------------
+//      UNIX 時刻をナノ秒単位で取得します.
+//-----------------------------------------------------------------------------
+uint64_t GetTimestamp()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+//-----------------------------------------------------------------------------
+//      ワイド文字列を UTF-8 に変換します.
+//-----------------------------------------------------------------------------
+size_t ToUtf8(const wchar_t* src, char* dst, size_t size)
+{
+    size_t pos = 0;
+    while (*src != L'\0')
+    {
+        uint32_t c = uint32_t(*src++);
+
+        // UTF-16 のサロゲートペアを結合.
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDBFF && *src >= 0xDC00 && *src <= 0xDFFF)
+        { c = 0x10000 + ((c - 0xD800) << 10) + (uint32_t(*src++) - 0xDC00); }
+
+        char   bytes[4];
+        size_t count = 0;
+        if (c < 0x80)
+        {
+            bytes[count++] = char(c);
+        }
+        else if (c < 0x800)
+        {
+            bytes[count++] = char(0xC0 | (c >> 6));
+            bytes[count++] = char(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            bytes[count++] = char(0xE0 | (c >> 12));
+            bytes[count++] = char(0x80 | ((c >> 6) & 0x3F));
+            bytes[count++] = char(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            bytes[count++] = char(0xF0 | (c >> 18));
+            bytes[count++] = char(0x80 | ((c >> 12) & 0x3F));
+            bytes[count++] = char(0x80 | ((c >> 6) & 0x3F));
+            bytes[count++] = char(0x80 | (c & 0x3F));
+        }
+
+        // 文字の途中で切り詰めない.
+        if (pos + count + 1 > size)
+        { break; }
+
+        memcpy(dst + pos, bytes, count);
+        pos += count;
+    }
+
+    dst[pos] = '\0';
+    return pos;
+}
+
+} // namespace
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedFileLogger class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+MappedFileLogger::~MappedFileLogger()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool MappedFileLogger::Init(const MappedFileLoggerDesc& desc)
+{
+    if (desc.Path == nullptr || desc.RecordCount == 0)
+    {
+        ELOGA("Error : Invalid Argument.");
+        return false;
+    }
+
+    const auto size = uint64_t(sizeof(MappedLogHeader)) + uint64_t(desc.RecordCount) * sizeof(MappedLogRecord);
+
+#if defined(_WIN32)
+    auto hFile = CreateFileA(
+        desc.Path,
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        ELOGA("Error : CreateFileA() Failed. path = %s", desc.Path);
+        return false;
+    }
+
+    auto hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READWRITE, DWORD(size >> 32), DWORD(size & 0xFFFFFFFF), nullptr);
+    if (hMapping == nullptr)
+    {
+        ELOGA("Error : CreateFileMappingA() Failed. path = %s", desc.Path);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    auto pMapped = MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, SIZE_T(size));
+    if (pMapped == nullptr)
+    {
+        ELOGA("Error : MapViewOfFile() Failed. path = %s", desc.Path);
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    m_File    = hFile;
+    m_Mapping = hMapping;
+#else
+    auto fd = open(desc.Path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        ELOGA("Error : open() Failed. path = %s", desc.Path);
+        return false;
+    }
+
+    if (ftruncate(fd, off_t(size)) != 0)
+    {
+        ELOGA("Error : ftruncate() Failed. path = %s, size = %llu", desc.Path, static_cast<unsigned long long>(size));
+        close(fd);
+        return false;
+    }
+
+    auto pMapped = mmap(nullptr, size_t(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pMapped == MAP_FAILED)
+    {
+        ELOGA("Error : mmap() Failed. path = %s", desc.Path);
+        return false;
+    }
+#endif
+
+    m_pMapped     = static_cast<uint8_t*>(pMapped);
+    m_pRecords    = reinterpret_cast<MappedLogRecord*>(m_pMapped + sizeof(MappedLogHeader));
+    m_MappedSize  = size;
+    m_RecordCount = desc.RecordCount;
+    m_WriteIndex.store(0, std::memory_order_relaxed);
+
+    // 書き込み時にページフォールトが発生しないよう, 全ページを事前に確保しておく.
+    for(uint64_t offset=0; offset<size; offset+=4096)
+    { reinterpret_cast<volatile uint8_t*>(m_pMapped)[offset] = 0; }
+
+    // 新規作成したファイルの内容はゼロで初期化されているため, ヘッダのみ書き込む.
+    auto pHeader = reinterpret_cast<MappedLogHeader*>(m_pMapped);
+    pHeader->Magic       = MAPPED_LOG_MAGIC;
+    pHeader->Version     = MAPPED_LOG_VERSION;
+    pHeader->RecordSize  = uint32_t(sizeof(MappedLogRecord));
+    pHeader->RecordCount = desc.RecordCount;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void MappedFileLogger::Term()
+{
+    if (m_pMapped == nullptr)
+    { return; }
+
+    Flush();
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m_pMapped);
+    CloseHandle(static_cast<HANDLE>(m_Mapping));
+    CloseHandle(static_cast<HANDLE>(m_File));
+    m_Mapping = nullptr;
+    m_File    = nullptr;
+#else
+    munmap(m_pMapped, size_t(m_MappedSize));
+#endif
+
+    m_pMapped     = nullptr;
+    m_pRecords    = nullptr;
+    m_MappedSize  = 0;
+    m_RecordCount = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      ログを出力します.
+//-----------------------------------------------------------------------------
+void MappedFileLogger::WriteA(LOG_LEVEL level, const char* format, ...)
+{
+    uint64_t sequence = 0;
+    auto pRecord = Acquire(level, sequence);
+    if (pRecord == nullptr)
+    { return; }
+
+    va_list arg;
+    va_start(arg, format);
+    auto ret = vsnprintf(pRecord->Message, MAPPED_LOG_MESSAGE_SIZE, format, arg);
+    va_end(arg);
+
+    size_t length = 0;
+    if (ret > 0)
+    { length = (size_t(ret) < MAPPED_LOG_MESSAGE_SIZE) ? size_t(ret) : MAPPED_LOG_MESSAGE_SIZE - 1; }
+    else
+    { pRecord->Message[0] = '\0'; }
+
+    Publish(pRecord, sequence, length);
+}
+
+//-----------------------------------------------------------------------------
+//      ログを出力します.
+//-----------------------------------------------------------------------------
+void MappedFileLogger::WriteW(LOG_LEVEL level, const wchar_t* format, ...)
+{
+    uint64_t sequence = 0;
+    auto pRecord = Acquire(level, sequence);
+    if (pRecord == nullptr)
+    { return; }
+
+    wchar_t msg[MAPPED_LOG_MESSAGE_SIZE] = L"\0";
+
+    va_list arg;
+    va_start(arg, format);
+    vswprintf(msg, MAPPED_LOG_MESSAGE_SIZE, format, arg);
+    va_end(arg);
+    msg[MAPPED_LOG_MESSAGE_SIZE - 1] = L'\0';
+
+    auto length = ToUtf8(msg, pRecord->Message, MAPPED_LOG_MESSAGE_SIZE);
+    Publish(pRecord, sequence, length);
+}
+
+//-----------------------------------------------------------------------------
+//      書き込み済みのレコードをディスクに書き出します.
+//-----------------------------------------------------------------------------
+void MappedFileLogger::Flush()
+{
+    if (m_pMapped == nullptr)
+    { return; }
+
+#if defined(_WIN32)
+    FlushViewOfFile(m_pMapped, SIZE_T(m_MappedSize));
+    FlushFileBuffers(static_cast<HANDLE>(m_File));
+#else
+    msync(m_pMapped, size_t(m_MappedSize), MS_SYNC);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      書き込み先のレコードを確保します.
+//-----------------------------------------------------------------------------
+MappedLogRecord* MappedFileLogger::Acquire(LOG_LEVEL level, uint64_t& sequence)
+{
+    if (m_pRecords == nullptr)
+    { return nullptr; }
+
+    auto index = m_WriteIndex.fetch_add(1, std::memory_order_relaxed);
+    auto pRecord = &m_pRecords[index % m_RecordCount];
+    sequence = index + 1;
+
+    // 書き込み途中のビットを立ててレコードを占有する. 読み取り側は書き込み途中のレコードを無視する.
+    // リングが一周して他のスレッドが書き込み中か, より新しいレコードが書き込まれている場合は破棄する.
+    auto& current = GetSequence(pRecord);
+    auto  value   = current.load(std::memory_order_relaxed);
+    do
+    {
+        if ((value & MAPPED_LOG_SEQUENCE_BUSY) != 0 || value >= sequence)
+        {
+            m_DropCount.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+    while (!current.compare_exchange_weak(value, sequence | MAPPED_LOG_SEQUENCE_BUSY, std::memory_order_acquire, std::memory_order_relaxed));
+
+    pRecord->Timestamp = GetTimestamp();
+    pRecord->ThreadId  = GetThreadId();
+    pRecord->Level     = uint16_t(level);
+
+    return pRecord;
+}
+
+//-----------------------------------------------------------------------------
+//      レコードを公開します.
+//-----------------------------------------------------------------------------
+void MappedFileLogger::Publish(MappedLogRecord* pRecord, uint64_t sequence, size_t length)
+{
+    pRecord->Length = uint16_t(length);
+    GetSequence(pRecord).store(sequence, std::memory_order_release);
+}
+
+} // namespace asf
@@ -0,0 +1,524 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfMergingLogger.cpp
+// Desc : Per-thread Log Buffers Merged by Timestamp.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <cwchar>
+#include <chrono>
+#include <asfMergingLogger.h>
+#include <asfTime.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint8_t  RECORD_KIND_PAD     = 0;      // バッファ末尾の詰め物.
+static constexpr uint8_t  RECORD_KIND_TEXT_A  = 1;      // マルチバイト文字列.
+static constexpr uint8_t  RECORD_KIND_TEXT_W  = 2;      // ワイド文字列.
+static constexpr uint32_t RECORD_ALIGNMENT    = 16;     // レコードのアライメント.
+static constexpr uint32_t CACHE_ENTRY_COUNT   = 4;      // スレッドごとにキャッシュするバッファ数.
+static constexpr uint32_t BUSY_SPIN_COUNT     = 4096;   // 書き込み中のスレッドを待機する最大回数.
+static constexpr uint32_t MESSAGE_COUNT       = 1024;   // スタック上のフォーマットバッファの文字数.
+static constexpr uint32_t CRASH_WAIT_COUNT    = 65536;  // DumpOnCrash でマージの完了を待つ最大回数.
+
+///////////////////////////////////////////////////////////////////////////////
+// RecordHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct RecordHeader
+{
+    uint64_t    Timestamp;  // タイムスタンプ (ナノ秒).
+    uint32_t    Size;       // ペイロードのバイト数.
+    uint8_t     Kind;       // RECORD_KIND_XXX.
+    uint8_t     Level;      // LOG_LEVEL.
+    uint16_t    Reserved;
+};
+static_assert(sizeof(RecordHeader) == RECORD_ALIGNMENT, "RecordHeader Size Not Match");
+
+///////////////////////////////////////////////////////////////////////////////
+// CacheEntry structure
+///////////////////////////////////////////////////////////////////////////////
+struct CacheEntry
+{
+    uint64_t    Id;
+    void*       pBuffer;
+};
+
+//-----------------------------------------------------------------------------
+// Global Variables.
+//-----------------------------------------------------------------------------
+std::atomic<uint64_t> g_NextLoggerId = { 1 };
+
+//-----------------------------------------------------------------------------
+// Thread Local Variables.
+//-----------------------------------------------------------------------------
+thread_local CacheEntry             t_Cache[CACHE_ENTRY_COUNT] = {};
+thread_local uint32_t               t_CacheIndex = 0;
+thread_local std::vector<char>      t_ScratchA;
+thread_local std::vector<wchar_t>   t_ScratchW;
+
+//-----------------------------------------------------------------------------
+//      2のべき乗に切り上げます.
+//-----------------------------------------------------------------------------
+uint64_t RoundUpPow2(uint64_t value)
+{
+    uint64_t result = 1;
+    while (result < value)
+    { result <<= 1; }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      アライメントに切り上げます.
+//-----------------------------------------------------------------------------
+uint64_t AlignUp(uint64_t value)
+{ return (value + RECORD_ALIGNMENT - 1) & ~uint64_t(RECORD_ALIGNMENT - 1); }
+
+} // namespace
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// MergingLogger class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+MergingLogger::~MergingLogger()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool MergingLogger::Init(const MergingLoggerDesc& desc)
+{
+    if (desc.BufferSize < 1024)
+    {
+        ELOGA("Error : Invalid Argument. BufferSize = %u", desc.BufferSize);
+        return false;
+    }
+
+    // Init() ごとに識別番号を変えて, 以前のスレッドローカルキャッシュを無効にする.
+    m_Id            = g_NextLoggerId.fetch_add(1, std::memory_order_relaxed);
+    m_BufferSize    = RoundUpPow2(desc.BufferSize);
+    m_pSink         = (desc.pSink != nullptr) ? desc.pSink : GetDefaultLogger();
+    m_IntervalMs    = desc.IntervalMs;
+
+    if (m_IntervalMs > 0)
+    {
+        m_Running.store(true, std::memory_order_release);
+        m_Thread = std::thread(&MergingLogger::Run, this);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void MergingLogger::Term()
+{
+    if (m_Thread.joinable())
+    {
+        m_Running.store(false, std::memory_order_release);
+        m_Thread.join();
+    }
+
+    if (m_Id == 0)
+    { return; }
+
+    LockAndMerge(UINT64_MAX, false);
+
+    {
+        std::lock_guard<std::mutex> locker(m_BufferLock);
+        for(auto pBuffer : m_Buffers)
+        { delete pBuffer; }
+        m_Buffers.clear();
+    }
+
+    m_Id    = 0;
+    m_pSink = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      ログを出力します.
+//-----------------------------------------------------------------------------
+void MergingLogger::WriteA(LOG_LEVEL level, const char* format, ...)
+{
+    char buffer[MESSAGE_COUNT];
+    const char* msg = buffer;
+
+    va_list arg;
+    va_start(arg, format);
+
+    va_list copy;
+    va_copy(copy, arg);
+    auto count = vsnprintf(buffer, MESSAGE_COUNT, format, copy);
+    va_end(copy);
+
+    // 収まらない場合のみスレッドローカルのバッファで再度フォーマットする.
+    auto limit = size_t(m_BufferSize / 4);
+    if (count >= int(MESSAGE_COUNT) && size_t(count) < limit)
+    {
+        if (t_ScratchA.size() < size_t(count) + 1)
+        { t_ScratchA.resize(size_t(count) + 1); }
+
+        vsnprintf(t_ScratchA.data(), t_ScratchA.size(), format, arg);
+        msg = t_ScratchA.data();
+    }
+    else if (count < 0)
+    {
+        buffer[0] = '\0';
+        count = 0;
+    }
+    else if (count >= int(MESSAGE_COUNT))
+    { count = int(MESSAGE_COUNT) - 1; }
+    va_end(arg);
+
+    Append(level, RECORD_KIND_TEXT_A, msg, size_t(count) + 1);
+}
+
+//-----------------------------------------------------------------------------
+//      ログを出力します.
+//-----------------------------------------------------------------------------
+void MergingLogger::WriteW(LOG_LEVEL level, const wchar_t* format, ...)
+{
+    wchar_t buffer[MESSAGE_COUNT];
+    const wchar_t* msg = buffer;
+
+    va_list arg;
+    va_start(arg, format);
+
+    va_list copy;
+    va_copy(copy, arg);
+    auto count = vswprintf(buffer, MESSAGE_COUNT, format, copy);
+    va_end(copy);
+
+    // vswprintf は必要な文字数を返さないため, バッファを倍々に拡張する.
+    auto limit = size_t(m_BufferSize / 4) / sizeof(wchar_t);
+    auto size  = size_t(MESSAGE_COUNT) * 2;
+    while (count < 0 && size <= limit)
+    {
+        if (t_ScratchW.size() < size)
+        { t_ScratchW.resize(size); }
+
+        va_copy(copy, arg);
+        count = vswprintf(t_ScratchW.data(), t_ScratchW.size(), format, copy);
+        va_end(copy);
+
+        msg   = t_ScratchW.data();
+        size *= 2;
+    }
+    va_end(arg);
+
+    if (count < 0)
+    {
+        buffer[MESSAGE_COUNT - 1] = L'\0';
+        msg   = buffer;
+        count = int(wcslen(buffer));
+    }
+
+    Append(level, RECORD_KIND_TEXT_W, msg, (size_t(count) + 1) * sizeof(wchar_t));
+}
+
+//-----------------------------------------------------------------------------
+//      呼び出し時点より前に書き込まれたログを出力します.
+//-----------------------------------------------------------------------------
+void MergingLogger::Flush()
+{ LockAndMerge(GetSteadyTimeNs(), true); }
+
+//-----------------------------------------------------------------------------
+//      バッファに残っている全てのログを出力します.
+//-----------------------------------------------------------------------------
+void MergingLogger::Dump()
+{ LockAndMerge(UINT64_MAX, false); }
+
+//-----------------------------------------------------------------------------
+//      致命的なエラーの報告時に, 残っているログを可能な範囲で出力します.
+//-----------------------------------------------------------------------------
+void MergingLogger::DumpOnCrash()
+{
+    if (m_Id == 0)
+    { return; }
+
+    // このスレッドのマージ中に呼び出された場合は, ロックを保持したまま続きを出力する.
+    if (m_MergeOwner.load(std::memory_order_relaxed) == std::this_thread::get_id())
+    {
+        Merge(UINT64_MAX, false);
+        return;
+    }
+
+    // 他のスレッドのマージが終わるのを一定時間だけ待つ. 終わらない場合は同時に出力しない.
+    for(auto i=0u; i<CRASH_WAIT_COUNT; ++i)
+    {
+        if (m_MergeLock.try_lock())
+        {
+            std::lock_guard<std::mutex> locker(m_MergeLock, std::adopt_lock);
+            m_MergeOwner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+            Merge(UINT64_MAX, false);
+            m_MergeOwner.store(std::thread::id(), std::memory_order_relaxed);
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      破棄されたログ数を取得します.
+//-----------------------------------------------------------------------------
+uint64_t MergingLogger::GetDropCount() const
+{
+    std::lock_guard<std::mutex> locker(m_BufferLock);
+
+    uint64_t result = 0;
+    for(auto pBuffer : m_Buffers)
+    { result += pBuffer->DropCount.load(std::memory_order_relaxed); }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      呼び出しスレッドのバッファを取得します.
+//-----------------------------------------------------------------------------
+MergingLogger::ThreadBuffer* MergingLogger::GetBuffer()
+{
+    if (m_Id == 0)
+    { return nullptr; }
+
+    for(auto& entry : t_Cache)
+    {
+        if (entry.Id == m_Id)
+        { return static_cast<ThreadBuffer*>(entry.pBuffer); }
+    }
+
+    // 初回のみバッファを確保して登録する.
+    ThreadBuffer* pResult = nullptr;
+    {
+        std::lock_guard<std::mutex> locker(m_BufferLock);
+
+        const auto threadId = std::this_thread::get_id();
+        for(auto pBuffer : m_Buffers)
+        {
+            if (pBuffer->ThreadId == threadId)
+            {
+                pResult = pBuffer;
+                break;
+            }
+        }
+
+        if (pResult == nullptr)
+        {
+            pResult = new ThreadBuffer();
+            pResult->Tail     .store(0, std::memory_order_relaxed);
+            pResult->Busy     .store(0, std::memory_order_relaxed);
+            pResult->DropCount.store(0, std::memory_order_relaxed);
+            pResult->Head     .store(0, std::memory_order_relaxed);
+            pResult->ThreadId = threadId;
+            pResult->Data.resize(size_t(m_BufferSize));
+            m_Buffers.push_back(pResult);
+        }
+    }
+
+    auto& entry = t_Cache[t_CacheIndex];
+    entry.Id      = m_Id;
+    entry.pBuffer = pResult;
+    t_CacheIndex  = (t_CacheIndex + 1) % CACHE_ENTRY_COUNT;
+
+    return pResult;
+}
+
+//-----------------------------------------------------------------------------
+//      レコードを追記します.
+//-----------------------------------------------------------------------------
+void MergingLogger::Append(LOG_LEVEL level, uint8_t kind, const void* pData, size_t size)
+{
+    auto pBuffer = GetBuffer();
+    if (pBuffer == nullptr)
+    { return; }
+
+    // マージ側が書き込み中であることを検出できるよう, 時刻取得より前に設定する.
+    pBuffer->Busy.store(1, std::memory_order_seq_cst);
+
+    RecordHeader header = {};
+    header.Timestamp = GetSteadyTimeNs();
+    header.Size      = uint32_t(size);
+    header.Kind      = kind;
+    header.Level     = uint8_t(level);
+
+    const auto mask  = m_BufferSize - 1;
+    const auto total = AlignUp(sizeof(RecordHeader) + size);
+
+    auto tail   = pBuffer->Tail.load(std::memory_order_relaxed);
+    auto head   = pBuffer->Head.load(std::memory_order_acquire);
+    auto offset = tail & mask;
+    auto rest   = m_BufferSize - offset;
+    auto need   = (rest < total) ? rest + total : total;
+
+    if (tail + need - head > m_BufferSize)
+    {
+        pBuffer->DropCount.fetch_add(1, std::memory_order_relaxed);
+        pBuffer->Busy.store(0, std::memory_order_seq_cst);
+        return;
+    }
+
+    auto pData8 = pBuffer->Data.data();
+
+    // 末尾に収まらない場合は詰め物を置いて先頭から書き込む.
+    if (rest < total)
+    {
+        RecordHeader pad = {};
+        pad.Timestamp = header.Timestamp;
+        pad.Size      = uint32_t(rest - sizeof(RecordHeader));
+        pad.Kind      = RECORD_KIND_PAD;
+        memcpy(pData8 + offset, &pad, sizeof(pad));
+
+        tail  += rest;
+        offset = 0;
+    }
+
+    memcpy(pData8 + offset, &header, sizeof(header));
+    memcpy(pData8 + offset + sizeof(header), pData, size);
+
+    pBuffer->Tail.store(tail + total, std::memory_order_seq_cst);
+    pBuffer->Busy.store(0, std::memory_order_seq_cst);
+}
+
+//-----------------------------------------------------------------------------
+//      バッファの先頭レコードを取得します.
+//-----------------------------------------------------------------------------
+const uint8_t* MergingLogger::Peek(ThreadBuffer* pBuffer)
+{
+    const auto mask = m_BufferSize - 1;
+
+    for(;;)
+    {
+        auto head = pBuffer->Head.load(std::memory_order_relaxed);
+        auto tail = pBuffer->Tail.load(std::memory_order_seq_cst);
+        if (head == tail)
+        { return nullptr; }
+
+        auto pRecord = pBuffer->Data.data() + (head & mask);
+
+        RecordHeader header;
+        memcpy(&header, pRecord, sizeof(header));
+        if (header.Kind != RECORD_KIND_PAD)
+        { return pRecord; }
+
+        pBuffer->Head.store(head + sizeof(RecordHeader) + header.Size, std::memory_order_release);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ロックを取得してバッファのログを時刻順に出力します.
+//-----------------------------------------------------------------------------
+void MergingLogger::LockAndMerge(uint64_t limit, bool waitBusy)
+{
+    std::lock_guard<std::mutex> locker(m_MergeLock);
+    m_MergeOwner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    Merge(limit, waitBusy);
+    m_MergeOwner.store(std::thread::id(), std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//      バッファのログを時刻順に出力します.
+//-----------------------------------------------------------------------------
+void MergingLogger::Merge(uint64_t limit, bool waitBusy)
+{
+    if (m_pSink == nullptr)
+    { return; }
+
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> locker(m_BufferLock);
+        buffers = m_Buffers;
+    }
+
+    // 各スレッドのバッファは時刻順のため, 先頭同士を比較して最も古いものから出力する.
+    // 空のバッファは書き込み中でないことを確認してから除外する.
+    // 書き込み中でなければ, 以降に書き込まれるレコードは limit より新しいことが保証される.
+    for(;;)
+    {
+        ThreadBuffer*  pBest   = nullptr;
+        const uint8_t* pRecord = nullptr;
+        uint64_t       bestTime = limit;
+        bool           blocked  = false;
+
+        for(auto pBuffer : buffers)
+        {
+            auto pHead = Peek(pBuffer);
+            if (pHead == nullptr)
+            {
+                if (!waitBusy)
+                { continue; }
+
+                auto spin = 0u;
+                while (pBuffer->Busy.load(std::memory_order_seq_cst) != 0 && spin < BUSY_SPIN_COUNT)
+                {
+                    std::this_thread::yield();
+                    spin++;
+                }
+
+                pHead = Peek(pBuffer);
+                if (pHead == nullptr)
+                {
+                    if (pBuffer->Busy.load(std::memory_order_seq_cst) != 0)
+                    {
+                        blocked = true;
+                        break;
+                    }
+                    continue;
+                }
+            }
+
+            RecordHeader header;
+            memcpy(&header, pHead, sizeof(header));
+            if (header.Timestamp < bestTime)
+            {
+                bestTime = header.Timestamp;
+                pBest    = pBuffer;
+                pRecord  = pHead;
+            }
+        }
+
+        if (blocked || pBest == nullptr)
+        { break; }
+
+        RecordHeader header;
+        memcpy(&header, pRecord, sizeof(header));
+
+        auto pPayload = pRecord + sizeof(RecordHeader);
+        if (header.Kind == RECORD_KIND_TEXT_A)
+        { m_pSink->WriteA(LOG_LEVEL(header.Level), "%s", reinterpret_cast<const char*>(pPayload)); }
+        else if (header.Kind == RECORD_KIND_TEXT_W)
+        { m_pSink->WriteW(LOG_LEVEL(header.Level), L"%ls", reinterpret_cast<const wchar_t*>(pPayload)); }
+
+        auto head = pBest->Head.load(std::memory_order_relaxed);
+        pBest->Head.store(head + AlignUp(sizeof(RecordHeader) + header.Size), std::memory_order_release);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      マージスレッドの処理です.
+//-----------------------------------------------------------------------------
+void MergingLogger::Run()
+{
+    const auto interval = std::chrono::milliseconds(m_IntervalMs);
+
+    while (m_Running.load(std::memory_order_acquire))
+    {
+        std::this_thread::sleep_for(interval);
+        LockAndMerge(GetSteadyTimeNs(), true);
+    }
+}
+
+} // namespace asf
@@ -12,8 +12,12 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <cassert>
+#if defined(_MSC_VER)
 #include <intrin.h> // for _BitScanReverse, _BitScanForward
+#endif
 #include <asfOffsetAllocator.h>
+#include <asfAdaptiveLock.h>
+#include <asfQueueLock.h>
 #include <asfBit.h>
 
 
@@ -548,49 +552,54 @@ OffsetAllocator::Node OffsetAllocator::GenNode(uint32_t offset, uint32_t size, u
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// ThreadSafeOffsetAllocator class
+// LockedOffsetAllocator class
 ///////////////////////////////////////////////////////////////////////////////
 
 //-----------------------------------------------------------------------------
 //      初期化処理です.
 //-----------------------------------------------------------------------------
-void ThreadSafeOffsetAllocator::Init(uint32_t size, uint32_t maxAllocatableCount)
+template<typename LockType>
+void LockedOffsetAllocator<LockType>::Init(uint32_t size, uint32_t maxAllocatableCount)
 {
-    ScopedLock locker(m_Lock);
+    LockGuard<LockType> locker(m_Lock);
     m_Allocator.Init(size, maxAllocatableCount);
 }
 
 //-----------------------------------------------------------------------------
 //      終了処理です.
 //-----------------------------------------------------------------------------
-void ThreadSafeOffsetAllocator::Term()
+template<typename LockType>
+void LockedOffsetAllocator<LockType>::Term()
 {
-    ScopedLock locker(m_Lock);
+    LockGuard<LockType> locker(m_Lock);
     m_Allocator.Term();
 }
 
 //-----------------------------------------------------------------------------
 //      リセットします.
 //-----------------------------------------------------------------------------
-void ThreadSafeOffsetAllocator::Reset()
+template<typename LockType>
+void LockedOffsetAllocator<LockType>::Reset()
 {
-    ScopedLock locker(m_Lock);
+    LockGuard<LockType> locker(m_Lock);
     m_Allocator.Reset();
 }
 
 //-----------------------------------------------------------------------------
 //      メモリを確保します.
 //-----------------------------------------------------------------------------
-OffsetHandle ThreadSafeOffsetAllocator::Alloc(uint32_t size)
+template<typename LockType>
+OffsetHandle LockedOffsetAllocator<LockType>::Alloc(uint32_t size)
 {
-    ScopedLock locker(m_Lock);
+    LockGuard<LockType> locker(m_Lock);
     return m_Allocator.Alloc(size);
 }
 
 //-----------------------------------------------------------------------------
 //      アライメントを指定してメモリを確保します.
 //-----------------------------------------------------------------------------
-OffsetHandle ThreadSafeOffsetAllocator::Alloc(uint32_t size, uint32_t alignment)
+template<typename LockType>
+OffsetHandle LockedOffsetAllocator<LockType>::Alloc(uint32_t size, uint32_t alignment)
 {
     uint32_t alignSize = (size + (alignment - 1)) & ~(alignment - 1);
     return Alloc(alignSize);
@@ -599,23 +608,33 @@ OffsetHandle ThreadSafeOffsetAllocator::Alloc(uint32_t size, uint32_t alignment)
 //-----------------------------------------------------------------------------
 //      メモリを解放します.
 //-----------------------------------------------------------------------------
-void ThreadSafeOffsetAllocator::Free(OffsetHandle& handle)
+template<typename LockType>
+void LockedOffsetAllocator<LockType>::Free(OffsetHandle& handle)
 {
-    ScopedLock locker(m_Lock);
+    LockGuard<LockType> locker(m_Lock);
     m_Allocator.Free(handle);
 }
 
 //-----------------------------------------------------------------------------
 //      使用サイズを取得します.
 //-----------------------------------------------------------------------------
-uint32_t ThreadSafeOffsetAllocator::GetUsedSize() const
+template<typename LockType>
+uint32_t LockedOffsetAllocator<LockType>::GetUsedSize() const
 { return m_Allocator.GetUsedSize(); }
 
 //-----------------------------------------------------------------------------
 //      未使用サイズを取得します.
 //-----------------------------------------------------------------------------
-uint32_t ThreadSafeOffsetAllocator::GetFreeSize() const
+template<typename LockType>
+uint32_t LockedOffsetAllocator<LockType>::GetFreeSize() const
 { return m_Allocator.GetFreeSize(); }
 
+//-----------------------------------------------------------------------------
+// Explicit Instantiation.
+//-----------------------------------------------------------------------------
+template class LockedOffsetAllocator<SpinLock>;
+template class LockedOffsetAllocator<AdaptiveLock>;
+template class LockedOffsetAllocator<TicketLock>;
+template class LockedOffsetAllocator<McsLock>;
 
 } // namespace asf
@@ -0,0 +1,291 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfParallelRecorder.cpp
+// Desc : Parallel Command List Recording.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfParallelRecorder.h>
+#include <asfSoftBackend.h>
+#include <asfLogger.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// ParallelRecorder class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+ParallelRecorder::~ParallelRecorder()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool ParallelRecorder::Init(const ParallelRecorderDesc& desc)
+{
+    if (desc.pPool == nullptr || desc.ThreadCount == 0 || desc.MaxChunks == 0)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    if (m_pPool != nullptr)
+    {
+        ELOG("Error : Already Initialized.");
+        return false;
+    }
+
+    m_pDevice     = desc.pDevice;
+    m_pPool       = desc.pPool;
+    m_Class       = desc.AllocatorClass;
+    m_ThreadCount = desc.ThreadCount;
+    m_MaxChunks   = desc.MaxChunks;
+    m_Generation  = 0;
+    m_ActiveCount = 0;
+    m_Running     = true;
+    m_Lists   .reserve(desc.MaxChunks);
+    m_Recorded.reserve(desc.MaxChunks);
+
+    // 呼び出しスレッドも記録するため, ワーカーは1つ少なくてよい.
+    m_Threads.reserve(desc.ThreadCount - 1);
+    for(auto i=1u; i<desc.ThreadCount; ++i)
+    { m_Threads.emplace_back(&ParallelRecorder::Run, this); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void ParallelRecorder::Term()
+{
+    if (m_pPool == nullptr)
+    { return; }
+
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        m_Running = false;
+    }
+    m_StartCond.notify_all();
+
+    for(auto& thread : m_Threads)
+    { thread.join(); }
+    m_Threads.clear();
+
+    for(auto pList : m_Lists)
+    { pList->Release(); }
+    m_Lists.clear();
+    m_Recorded.clear();
+
+    m_pDevice     = nullptr;
+    m_pPool       = nullptr;
+    m_ThreadCount = 0;
+    m_MaxChunks   = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      作業項目を分割し, 並列に記録します.
+//-----------------------------------------------------------------------------
+bool ParallelRecorder::Record(uint32_t itemCount, uint32_t chunkCount, RecordFunc func, void* pUser)
+{
+    if (func == nullptr || chunkCount > m_MaxChunks)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    if (m_pPool == nullptr)
+    {
+        ELOG("Error : ParallelRecorder Is Not Initialized.");
+        return false;
+    }
+
+    if (chunkCount == 0)
+    { chunkCount = (m_ThreadCount < m_MaxChunks) ? m_ThreadCount : m_MaxChunks; }
+
+    // 空の範囲は記録しない.
+    if (chunkCount > itemCount)
+    { chunkCount = itemCount; }
+
+    // 前回の記録を投入していない場合は, 実行されていないのでそのまま再利用できる.
+    ReleaseRecorded();
+    if (chunkCount == 0)
+    { return true; }
+
+    // リストの生成は呼び出しスレッドで済ませておき, ワーカーは配列を変更しない.
+    while(m_Lists.size() < chunkCount)
+    {
+        ICommandList* pList = nullptr;
+        if (!CreateList(&pList))
+        {
+            ELOG("Error : ParallelRecorder::CreateList() Failed.");
+            return false;
+        }
+        m_Lists.push_back(pList);
+    }
+
+    m_Recorded.resize(chunkCount, nullptr);
+    m_Func       = func;
+    m_pUser      = pUser;
+    m_ItemCount  = itemCount;
+    m_ChunkCount = chunkCount;
+    m_NextChunk.store(0, std::memory_order_relaxed);
+    m_Failed   .store(false, std::memory_order_relaxed);
+
+    if (!m_Threads.empty())
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_Mutex);
+            m_Generation++;
+            m_ActiveCount = uint32_t(m_Threads.size());
+        }
+        m_StartCond.notify_all();
+    }
+
+    RecordChunks();
+
+    if (!m_Threads.empty())
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_DoneCond.wait(lock, [&]() { return m_ActiveCount == 0; });
+    }
+
+    if (m_Failed.load(std::memory_order_relaxed))
+    {
+        ReleaseRecorded();
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      記録したコマンドリストを投入します.
+//-----------------------------------------------------------------------------
+WaitPoint ParallelRecorder::Submit(ICommandQueue* pQueue)
+{
+    if (pQueue == nullptr)
+    {
+        ELOG("Error : Invalid Argument.");
+        return WaitPoint();
+    }
+
+    if (m_Recorded.empty())
+    { return WaitPoint(); }
+
+    pQueue->Execute(uint32_t(m_Recorded.size()), m_Recorded.data());
+    auto point = pQueue->Signal();
+
+    for(size_t i=0; i<m_Recorded.size(); ++i)
+    { m_Lists[i]->SetFencePoint(point); }
+
+    m_Recorded.clear();
+    return point;
+}
+
+//-----------------------------------------------------------------------------
+//      コマンドリストを生成します.
+//-----------------------------------------------------------------------------
+bool ParallelRecorder::CreateList(ICommandList** ppCmdList)
+{
+#if defined(_WIN32)
+    if (m_pDevice != nullptr)
+    { return CreateCommandList(m_pDevice, m_pPool, m_Class, ppCmdList); }
+#endif
+
+    SoftCommandListDesc desc;
+    desc.Type           = m_pPool->GetType();
+    desc.LatencyUs      = 0;
+    desc.pPool          = m_pPool;
+    desc.AllocatorClass = m_Class;
+    return CreateSoftCommandList(desc, ppCmdList);
+}
+
+//-----------------------------------------------------------------------------
+//      未記録の範囲がなくなるまで記録します.
+//-----------------------------------------------------------------------------
+void ParallelRecorder::RecordChunks()
+{
+    for(;;)
+    {
+        auto index = m_NextChunk.fetch_add(1, std::memory_order_relaxed);
+        if (index >= m_ChunkCount)
+        { break; }
+
+        auto begin = uint32_t(uint64_t(m_ItemCount) * index       / m_ChunkCount);
+        auto end   = uint32_t(uint64_t(m_ItemCount) * (index + 1) / m_ChunkCount);
+
+        auto pList    = m_Lists[index];
+        auto pCmdList = pList->Reset();
+        if (pCmdList == nullptr)
+        {
+            m_Failed.store(true, std::memory_order_relaxed);
+            continue;
+        }
+        m_Recorded[index] = pCmdList;
+
+        // 他の範囲が失敗していても記録とクローズは行い, リストを開いたまま残さない.
+        m_Func(pList, begin, end, m_pUser);
+
+    #if defined(_WIN32)
+        if (m_pDevice != nullptr)
+        {
+            auto hr = pCmdList->Close();
+            if (FAILED(hr))
+            {
+                ELOG_LIMIT("Error : ID3D12GraphicsCommandList::Close() Failed. errcode = 0x%x", hr);
+                m_Failed.store(true, std::memory_order_relaxed);
+                continue;
+            }
+        }
+    #endif
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      投入せずに破棄する記録のアロケータを再利用可能にします.
+//-----------------------------------------------------------------------------
+void ParallelRecorder::ReleaseRecorded()
+{
+    for(size_t i=0; i<m_Recorded.size(); ++i)
+    {
+        if (m_Recorded[i] != nullptr)
+        { m_Lists[i]->SetFencePoint(WaitPoint()); }
+    }
+    m_Recorded.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      ワーカースレッドの処理です.
+//-----------------------------------------------------------------------------
+void ParallelRecorder::Run()
+{
+    uint64_t generation = 0;
+    for(;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_StartCond.wait(lock, [&]() { return m_Generation != generation || !m_Running; });
+            if (!m_Running)
+            { return; }
+            generation = m_Generation;
+        }
+
+        RecordChunks();
+
+        {
+            std::lock_guard<std::mutex> locker(m_Mutex);
+            m_ActiveCount--;
+            if (m_ActiveCount == 0)
+            { m_DoneCond.notify_one(); }
+        }
+    }
+}
+
+} // namespace asf
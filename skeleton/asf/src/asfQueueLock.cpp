@@ -0,0 +1,188 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfQueueLock.cpp
+// Desc : Fair Queue Locks (Ticket Lock / MCS Lock).
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfQueueLock.h>
+#include <asfLogger.h>
+#include <cassert>
+#include <exception>
+#include <thread>
+
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// NodePool structure
+///////////////////////////////////////////////////////////////////////////////
+struct NodePool
+{
+    asf::McsLock::Node  Nodes[asf::McsLock::MAX_NODES];
+    asf::McsLock::Node* pFree = nullptr;
+
+    NodePool()
+    {
+        for(auto i=0u; i<asf::McsLock::MAX_NODES; ++i)
+        {
+            Nodes[i].pFree = pFree;
+            pFree = &Nodes[i];
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Global Variables.
+//-----------------------------------------------------------------------------
+thread_local NodePool   g_NodePool;
+
+static_assert(sizeof(asf::McsLock::Node) == asf::CACHE_LINE_SIZE, "McsLock::Node Size Not Match");
+
+//-----------------------------------------------------------------------------
+//      ノードを取得します.
+//-----------------------------------------------------------------------------
+asf::McsLock::Node* AcquireNode()
+{
+    auto pNode = g_NodePool.pFree;
+    if (pNode == nullptr)
+    {
+        ELOGA("Error : McsLock nesting exceeds MAX_NODES.");
+        assert(false);
+        std::terminate();
+    }
+
+    g_NodePool.pFree = pNode->pFree;
+    pNode->pNext.store(nullptr, std::memory_order_relaxed);
+    pNode->Waiting.store(true, std::memory_order_relaxed);
+    return pNode;
+}
+
+//-----------------------------------------------------------------------------
+//      ノードを返却します.
+//-----------------------------------------------------------------------------
+void ReleaseNode(asf::McsLock::Node* pNode)
+{
+    pNode->pFree = g_NodePool.pFree;
+    g_NodePool.pFree = pNode;
+}
+
+} // namespace
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// TicketLock class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      自分の番になるまで待機します.
+//-----------------------------------------------------------------------------
+void TicketLock::LockSlow(uint32_t ticket)
+{
+    uint32_t spin = 0;
+    for(;;)
+    {
+        auto serving = m_Serving.load(std::memory_order_acquire);
+        if (serving == ticket)
+        { return; }
+
+        // 自分より前にいる待機数に比例してバックオフし, m_Serving への読み取りを減らす.
+        auto distance = ticket - serving;
+        auto backoff  = distance * BACKOFF_PER_WAITER;
+        for(auto i=0u; i<backoff; ++i)
+        { _mm_pause(); }
+
+        // 保持スレッドや先行スレッドがプリエンプトされている場合に備えて譲る.
+        spin += backoff;
+        if (spin >= YIELD_THRESHOLD)
+        {
+            std::this_thread::yield();
+            spin = 0;
+        }
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// McsLock class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      ロックします.
+//-----------------------------------------------------------------------------
+void McsLock::lock()
+{
+    auto pNode = AcquireNode();
+
+    auto pPrev = m_pTail.exchange(pNode, std::memory_order_acq_rel);
+    if (pPrev != nullptr)
+    {
+        pPrev->pNext.store(pNode, std::memory_order_release);
+
+        // 自分のノードのみを監視するため, 待機スレッド間でキャッシュラインを奪い合わない.
+        uint32_t spin = 0;
+        while (pNode->Waiting.load(std::memory_order_acquire))
+        {
+            _mm_pause();
+            if (++spin >= YIELD_THRESHOLD)
+            {
+                std::this_thread::yield();
+                spin = 0;
+            }
+        }
+    }
+
+    m_pOwner = pNode;
+}
+
+//-----------------------------------------------------------------------------
+//      ロックを試みます.
+//-----------------------------------------------------------------------------
+bool McsLock::try_lock()
+{
+    auto pNode = AcquireNode();
+
+    Node* pExpected = nullptr;
+    if (!m_pTail.compare_exchange_strong(pExpected, pNode, std::memory_order_acquire, std::memory_order_relaxed))
+    {
+        ReleaseNode(pNode);
+        return false;
+    }
+
+    m_pOwner = pNode;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ロックを解除します.
+//-----------------------------------------------------------------------------
+void McsLock::unlock()
+{
+    auto pNode = m_pOwner;
+    auto pNext = pNode->pNext.load(std::memory_order_acquire);
+
+    if (pNext == nullptr)
+    {
+        // 後続がいなければキューを空にして終了.
+        auto pExpected = pNode;
+        if (m_pTail.compare_exchange_strong(pExpected, nullptr, std::memory_order_release, std::memory_order_relaxed))
+        {
+            ReleaseNode(pNode);
+            return;
+        }
+
+        // 後続が連結中なので完了を待つ.
+        while ((pNext = pNode->pNext.load(std::memory_order_acquire)) == nullptr)
+        { _mm_pause(); }
+    }
+
+    // 後続にロックを引き渡す. m_pOwner は後続が設定する.
+    pNext->Waiting.store(false, std::memory_order_release);
+    ReleaseNode(pNode);
+}
+
+} // namespace asf
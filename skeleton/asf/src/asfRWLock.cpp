@@ -0,0 +1,150 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfRWLock.cpp
+// Desc : Reader-Writer Spin Locks.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfRWLock.h>
+#include <thread>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t YIELD_THRESHOLD = 1024;   // スレッドを譲るまでのスピン回数.
+
+//-----------------------------------------------------------------------------
+// Global Variables.
+//-----------------------------------------------------------------------------
+std::atomic<uint32_t>   g_SlotCounter = { 0 };
+thread_local uint32_t   g_SlotIndex   = UINT32_MAX;
+
+//-----------------------------------------------------------------------------
+//      スピン待機します.
+//-----------------------------------------------------------------------------
+inline void Pause(uint32_t& spin)
+{
+    _mm_pause();
+    if (++spin >= YIELD_THRESHOLD)
+    {
+        std::this_thread::yield();
+        spin = 0;
+    }
+}
+
+} // namespace
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// RWSpinLock class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      競合時の書き込みロック処理を行います.
+//-----------------------------------------------------------------------------
+void RWSpinLock::LockSlow()
+{
+    uint32_t spin = 0;
+    for(;;)
+    {
+        auto state = m_State.load(std::memory_order_relaxed);
+        if ((state & ~WRITER_WAITING) == 0)
+        {
+            // 読み取りも書き込みもいない. 他の書き込み待ちのフラグは取得後に再設定される.
+            if (m_State.compare_exchange_weak(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed))
+            { return; }
+            continue;
+        }
+
+        if ((state & WRITER_WAITING) == 0)
+        { m_State.fetch_or(WRITER_WAITING, std::memory_order_relaxed); }
+
+        Pause(spin);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      競合時の読み取りロック処理を行います.
+//-----------------------------------------------------------------------------
+void RWSpinLock::LockSharedSlow()
+{
+    uint32_t spin = 0;
+    for(;;)
+    {
+        auto state = m_State.load(std::memory_order_relaxed);
+        if ((state & (WRITER | WRITER_WAITING)) == 0)
+        {
+            if (m_State.compare_exchange_weak(state, state + READER, std::memory_order_acquire, std::memory_order_relaxed))
+            { return; }
+            continue;
+        }
+
+        Pause(spin);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DistributedRWLock class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      呼び出しスレッドのスロット番号を取得します.
+//-----------------------------------------------------------------------------
+uint32_t DistributedRWLock::GetSlotIndex()
+{
+    if (g_SlotIndex == UINT32_MAX)
+    { g_SlotIndex = g_SlotCounter.fetch_add(1, std::memory_order_relaxed) % SLOT_COUNT; }
+
+    return g_SlotIndex;
+}
+
+//-----------------------------------------------------------------------------
+//      書き込みロックします.
+//-----------------------------------------------------------------------------
+void DistributedRWLock::lock()
+{
+    // 書き込みスレッド間の排他. フラグが立った時点で新たな読み取りは抑止される.
+    uint32_t spin = 0;
+    bool expected = false;
+    while (!m_Writer.compare_exchange_weak(expected, true, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        expected = false;
+        Pause(spin);
+    }
+
+    // 読み取り中のスレッドが抜けるのを待つ.
+    for(auto i=0u; i<SLOT_COUNT; ++i)
+    {
+        while (m_Slots[i].Readers.load(std::memory_order_seq_cst) != 0)
+        { Pause(spin); }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      競合時の読み取りロック処理を行います.
+//-----------------------------------------------------------------------------
+void DistributedRWLock::LockSharedSlow(Slot& slot)
+{
+    uint32_t spin = 0;
+    for(;;)
+    {
+        // 書き込みを優先させるため, 一旦カウンタを戻して書き込み完了を待つ.
+        slot.Readers.fetch_sub(1, std::memory_order_relaxed);
+        while (m_Writer.load(std::memory_order_relaxed))
+        { Pause(spin); }
+
+        slot.Readers.fetch_add(1, std::memory_order_seq_cst);
+        if (!m_Writer.load(std::memory_order_seq_cst))
+        { return; }
+    }
+}
+
+} // namespace asf
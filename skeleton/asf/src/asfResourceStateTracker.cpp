@@ -0,0 +1,460 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfResourceStateTracker.cpp
+// Desc : Resource State Tracking and Barrier Batching.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfResourceStateTracker.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t READ_STATES =
+      uint32_t(D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER)
+    | uint32_t(D3D12_RESOURCE_STATE_INDEX_BUFFER)
+    | uint32_t(D3D12_RESOURCE_STATE_DEPTH_READ)
+    | uint32_t(D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+    | uint32_t(D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE)
+    | uint32_t(D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT)
+    | uint32_t(D3D12_RESOURCE_STATE_COPY_SOURCE)
+    | uint32_t(D3D12_RESOURCE_STATE_RESOLVE_SOURCE);
+
+static constexpr size_t MIN_SLOT_COUNT = 64;
+
+//-----------------------------------------------------------------------------
+//      読み取り専用の状態かどうかチェックします.
+//-----------------------------------------------------------------------------
+inline bool IsReadState(D3D12_RESOURCE_STATES state)
+{ return uint32_t(state) != 0 && (uint32_t(state) & ~READ_STATES) == 0; }
+
+//-----------------------------------------------------------------------------
+//      current の状態のまま requested として使用できるかチェックします.
+//      読み取り状態は組み合わせて保持できるため, 含まれていれば遷移は不要です.
+//-----------------------------------------------------------------------------
+inline bool IsCompatible(D3D12_RESOURCE_STATES current, D3D12_RESOURCE_STATES requested)
+{
+    if (current == requested)
+    { return true; }
+
+    return IsReadState(current)
+        && IsReadState(requested)
+        && (uint32_t(current) & uint32_t(requested)) == uint32_t(requested);
+}
+
+//-----------------------------------------------------------------------------
+//      ハッシュ値を求めます.
+//-----------------------------------------------------------------------------
+inline size_t HashPointer(const void* ptr)
+{
+    auto value = uint64_t(uintptr_t(ptr)) * 0x9E3779B97F4A7C15ull;
+    return size_t(value >> 32);
+}
+
+//-----------------------------------------------------------------------------
+//      遷移バリアを作成します.
+//-----------------------------------------------------------------------------
+D3D12_RESOURCE_BARRIER MakeTransition
+(
+    ID3D12Resource*                 pResource,
+    D3D12_RESOURCE_STATES           before,
+    D3D12_RESOURCE_STATES           after,
+    D3D12_RESOURCE_BARRIER_FLAGS    flags
+)
+{
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type                    = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags                   = flags;
+    barrier.Transition.pResource    = pResource;
+    barrier.Transition.Subresource  = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    barrier.Transition.StateBefore  = before;
+    barrier.Transition.StateAfter   = after;
+    return barrier;
+}
+
+} // namespace
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// ResourceStateTracker class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      記録した状態を破棄します.
+//-----------------------------------------------------------------------------
+void ResourceStateTracker::Reset()
+{
+    m_Entries.clear();
+    m_Batch.clear();
+    m_Slots.assign(m_Slots.size(), -1);
+}
+
+//-----------------------------------------------------------------------------
+//      リソースの状態遷移を要求します.
+//-----------------------------------------------------------------------------
+void ResourceStateTracker::Transition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state)
+{
+    if (pResource == nullptr)
+    { return; }
+
+    m_Stats.RequestCount++;
+
+    bool created = false;
+    auto& entry = FindOrAdd(pResource, created);
+    if (created)
+    {
+        entry.FirstState = state;
+        entry.State      = state;
+        m_Stats.DeferCount++;
+        return;
+    }
+
+    if (entry.Split)
+    {
+        if (entry.BatchIndex >= 0)
+        {
+            // 開始バリアが未発行の場合は分割する意味がないため, 通常の遷移に変更する.
+            m_Batch[entry.BatchIndex].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            entry.State = entry.SplitState;
+            entry.Split = false;
+            m_Stats.SplitCount--;
+        }
+        else
+        {
+            Push(entry, entry.State, entry.SplitState, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+            entry.State      = entry.SplitState;
+            entry.Split      = false;
+            entry.BatchIndex = -1;
+        }
+    }
+
+    if (IsCompatible(entry.State, state))
+    {
+        m_Stats.SkipCount++;
+        return;
+    }
+
+    if (entry.BatchIndex >= 0)
+    {
+        // 未発行の遷移の遷移後の状態を書き換える.
+        auto& barrier = m_Batch[entry.BatchIndex];
+        m_Stats.MergeCount++;
+
+        if (IsCompatible(barrier.Transition.StateBefore, state))
+        {
+            // 元の状態に戻ったため, バリアは不要.
+            entry.State = barrier.Transition.StateBefore;
+            entry.BatchIndex = -1;
+            barrier.Transition.pResource = nullptr;
+            return;
+        }
+
+        barrier.Transition.StateAfter = state;
+        entry.State = state;
+        return;
+    }
+
+    Push(entry, entry.State, state, D3D12_RESOURCE_BARRIER_FLAG_NONE);
+    entry.State = state;
+}
+
+//-----------------------------------------------------------------------------
+//      分割バリアによる状態遷移を開始します.
+//-----------------------------------------------------------------------------
+void ResourceStateTracker::BeginTransition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state)
+{
+    if (pResource == nullptr)
+    { return; }
+
+    auto index = FindIndex(pResource);
+    if (index >= 0 && m_Entries[index].Split && m_Entries[index].SplitState == state)
+    {
+        m_Stats.RequestCount++;
+        m_Stats.SkipCount++;
+        return;
+    }
+
+    if (index < 0 || m_Entries[index].BatchIndex >= 0 || m_Entries[index].Split)
+    {
+        // 遷移前の状態が未確定か, 同じバッチで発行されるため通常の遷移として扱う.
+        Transition(pResource, state);
+        return;
+    }
+
+    m_Stats.RequestCount++;
+
+    auto& entry = m_Entries[index];
+    if (IsCompatible(entry.State, state))
+    {
+        m_Stats.SkipCount++;
+        return;
+    }
+
+    Push(entry, entry.State, state, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+    entry.Split      = true;
+    entry.SplitState = state;
+    m_Stats.SplitCount++;
+}
+
+//-----------------------------------------------------------------------------
+//      UAVバリアを要求します.
+//-----------------------------------------------------------------------------
+void ResourceStateTracker::UAVBarrier(ID3D12Resource* pResource)
+{
+    m_Stats.RequestCount++;
+
+    for(auto& barrier : m_Batch)
+    {
+        if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_UAV && barrier.UAV.pResource == pResource)
+        {
+            m_Stats.SkipCount++;
+            return;
+        }
+    }
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type          = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+    barrier.Flags         = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.UAV.pResource = pResource;
+    m_Batch.push_back(barrier);
+}
+
+//-----------------------------------------------------------------------------
+//      記録中の状態を取得します.
+//-----------------------------------------------------------------------------
+bool ResourceStateTracker::GetState(ID3D12Resource* pResource, D3D12_RESOURCE_STATES& state) const
+{
+    auto index = FindIndex(pResource);
+    if (index < 0)
+    { return false; }
+
+    const auto& entry = m_Entries[index];
+    state = (entry.Split) ? entry.SplitState : entry.State;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      リソースのエントリを検索します.
+//-----------------------------------------------------------------------------
+ResourceStateTracker::Entry& ResourceStateTracker::FindOrAdd(ID3D12Resource* pResource, bool& created)
+{
+    if ((m_Entries.size() + 1) * 2 > m_Slots.size())
+    { Rehash((m_Slots.empty()) ? MIN_SLOT_COUNT : m_Slots.size() * 2); }
+
+    const auto mask = m_Slots.size() - 1;
+    for(auto slot = HashPointer(pResource) & mask;; slot = (slot + 1) & mask)
+    {
+        auto index = m_Slots[slot];
+        if (index < 0)
+        {
+            Entry entry = {};
+            entry.pResource  = pResource;
+            entry.BatchIndex = -1;
+            entry.Split      = false;
+
+            m_Slots[slot] = int32_t(m_Entries.size());
+            m_Entries.push_back(entry);
+
+            created = true;
+            return m_Entries.back();
+        }
+
+        if (m_Entries[index].pResource == pResource)
+        {
+            created = false;
+            return m_Entries[index];
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      リソースのエントリの位置を検索します.
+//-----------------------------------------------------------------------------
+int32_t ResourceStateTracker::FindIndex(ID3D12Resource* pResource) const
+{
+    if (m_Slots.empty())
+    { return -1; }
+
+    const auto mask = m_Slots.size() - 1;
+    for(auto slot = HashPointer(pResource) & mask;; slot = (slot + 1) & mask)
+    {
+        auto index = m_Slots[slot];
+        if (index < 0 || m_Entries[index].pResource == pResource)
+        { return index; }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ハッシュテーブルを再構築します.
+//-----------------------------------------------------------------------------
+void ResourceStateTracker::Rehash(size_t slotCount)
+{
+    m_Slots.assign(slotCount, -1);
+
+    const auto mask = slotCount - 1;
+    for(size_t i=0; i<m_Entries.size(); ++i)
+    {
+        auto slot = HashPointer(m_Entries[i].pResource) & mask;
+        while (m_Slots[slot] >= 0)
+        { slot = (slot + 1) & mask; }
+
+        m_Slots[slot] = int32_t(i);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      遷移バリアを追加します.
+//-----------------------------------------------------------------------------
+void ResourceStateTracker::Push
+(
+    Entry&                          entry,
+    D3D12_RESOURCE_STATES           before,
+    D3D12_RESOURCE_STATES           after,
+    D3D12_RESOURCE_BARRIER_FLAGS    flags
+)
+{
+    entry.BatchIndex = int32_t(m_Batch.size());
+    m_Batch.push_back(MakeTransition(entry.pResource, before, after, flags));
+}
+
+//-----------------------------------------------------------------------------
+//      終了していない分割バリアを終了させます.
+//-----------------------------------------------------------------------------
+void ResourceStateTracker::EndSplits()
+{
+    for(auto& entry : m_Entries)
+    {
+        if (!entry.Split)
+        { continue; }
+
+        if (entry.BatchIndex >= 0)
+        {
+            m_Batch[entry.BatchIndex].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            m_Stats.SplitCount--;
+        }
+        else
+        {
+            Push(entry, entry.State, entry.SplitState, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+            entry.BatchIndex = -1;
+        }
+
+        entry.State = entry.SplitState;
+        entry.Split = false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      発行するバリアを返却します.
+//-----------------------------------------------------------------------------
+const D3D12_RESOURCE_BARRIER* ResourceStateTracker::Prepare(uint32_t& count)
+{
+    size_t w = 0;
+    for(size_t r=0; r<m_Batch.size(); ++r)
+    {
+        const auto& barrier = m_Batch[r];
+        if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+        {
+            // 統合により取り消されたバリア.
+            if (barrier.Transition.pResource == nullptr)
+            { continue; }
+
+            auto index = FindIndex(barrier.Transition.pResource);
+            if (index >= 0)
+            { m_Entries[index].BatchIndex = -1; }
+        }
+
+        m_Batch[w++] = barrier;
+    }
+
+    count = uint32_t(w);
+    if (count > 0)
+    {
+        m_Stats.BarrierCount += count;
+        m_Stats.CallCount++;
+    }
+
+    return m_Batch.data();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ResourceStateRegistry class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      リソースを登録します.
+//-----------------------------------------------------------------------------
+void ResourceStateRegistry::Register(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state)
+{
+    if (pResource == nullptr)
+    { return; }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_States[pResource] = state;
+}
+
+//-----------------------------------------------------------------------------
+//      リソースの登録を解除します.
+//-----------------------------------------------------------------------------
+void ResourceStateRegistry::Unregister(ID3D12Resource* pResource)
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_States.erase(pResource);
+}
+
+//-----------------------------------------------------------------------------
+//      投入済みのコマンドリストの実行後の状態を取得します.
+//-----------------------------------------------------------------------------
+bool ResourceStateRegistry::GetState(ID3D12Resource* pResource, D3D12_RESOURCE_STATES& state) const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    auto itr = m_States.find(pResource);
+    if (itr == m_States.end())
+    { return false; }
+
+    state = itr->second;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      遷移バリアを作成します.
+//-----------------------------------------------------------------------------
+uint32_t ResourceStateRegistry::Resolve(const ResourceStateTracker& tracker)
+{
+    m_Fixups.clear();
+
+    for(const auto& entry : tracker.m_Entries)
+    {
+        const auto last = (entry.Split) ? entry.SplitState : entry.State;
+
+        auto itr = m_States.find(entry.pResource);
+        if (itr == m_States.end())
+        {
+            m_States[entry.pResource] = last;
+            continue;
+        }
+
+        // 記録したバリアは FirstState を遷移前の状態としているため, 完全に一致させる.
+        if (itr->second != entry.FirstState)
+        {
+            m_Fixups.push_back(MakeTransition(
+                entry.pResource,
+                itr->second,
+                entry.FirstState,
+                D3D12_RESOURCE_BARRIER_FLAG_NONE));
+        }
+
+        itr->second = last;
+    }
+
+    return uint32_t(m_Fixups.size());
+}
+
+} // namespace asf
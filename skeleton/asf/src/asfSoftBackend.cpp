@@ -0,0 +1,996 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfSoftBackend.cpp
+// Desc : CPU-emulated Command Queue / Fence / Command List.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <asfSoftBackend.h>
+#include <asfCommandStream.h>
+#include <asfFenceWait.h>
+#include <asfLogger.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using Clock = std::chrono::steady_clock;
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t SPIN_MARGIN_US    = 200;          //!< 仮想GPUがスリープせずにスピン待機する区間 (マイクロ秒).
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftListHandle structure
+///////////////////////////////////////////////////////////////////////////////
+struct SoftListHandle
+{
+    std::atomic<uint32_t>   LatencyUs;  //!< 1回の実行に掛かる時間 (マイクロ秒).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftListRegistry structure
+///////////////////////////////////////////////////////////////////////////////
+struct SoftListRegistry
+{
+    std::mutex                                  Mutex;      //!< 登録と参照を排他します.
+    std::unordered_set<const SoftListHandle*>   Handles;    //!< 生存中のハンドル.
+};
+
+//-----------------------------------------------------------------------------
+// Global Variables.
+//-----------------------------------------------------------------------------
+SoftListRegistry    g_SoftLists;
+
+} // namespace
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftFence class
+///////////////////////////////////////////////////////////////////////////////
+class SoftFence : public IFence
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Listener structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Listener
+    {
+        SoftFenceListener*  pListener;
+        uint64_t            Value;
+    };
+
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      生成処理を行います.
+    //-------------------------------------------------------------------------
+    static bool Create(IFence** ppFence)
+    {
+        if (ppFence == nullptr)
+        {
+            ELOG("Error : Invalid Argument.");
+            return false;
+        }
+
+        *ppFence = new SoftFence();
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      参照カウントを増やします.
+    //-------------------------------------------------------------------------
+    void AddRef() override
+    { m_RefCount++; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      解放処理を行います.
+    //-------------------------------------------------------------------------
+    void Release() override
+    {
+        m_RefCount--;
+        if (m_RefCount == 0)
+        { delete this; }
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      フェンスが指定された値に達するまで待機します.
+    //-------------------------------------------------------------------------
+    void Wait(uint64_t fenceValue, uint32_t msec) override
+    {
+        if (m_Completed.load(std::memory_order_acquire) >= fenceValue)
+        { return; }
+
+        if (m_Policy == FENCE_WAIT_POLICY_POLL)
+        {
+            PollFence(this, fenceValue, (msec == WAIT_INFINITE) ? UINT64_MAX : uint64_t(msec) * 1000);
+            return;
+        }
+
+        if (m_Policy == FENCE_WAIT_POLICY_SPIN_THEN_BLOCK)
+        {
+            auto spinUsec = uint64_t(m_SpinUsec);
+            if (msec != WAIT_INFINITE && spinUsec > uint64_t(msec) * 1000)
+            { spinUsec = uint64_t(msec) * 1000; }
+
+            if (PollFence(this, fenceValue, spinUsec))
+            { return; }
+        }
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Waiters++;
+
+        auto completed = [&]() { return m_Completed.load() >= fenceValue; };
+        if (msec == WAIT_INFINITE)
+        { m_Cond.wait(lock, completed); }
+        else
+        { m_Cond.wait_for(lock, std::chrono::milliseconds(msec), completed); }
+
+        m_Waiters--;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      待機方法を設定します.
+    //-------------------------------------------------------------------------
+    void SetWaitPolicy(FENCE_WAIT_POLICY policy, uint32_t spinUsec) override
+    {
+        m_Policy   = policy;
+        m_SpinUsec = spinUsec;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      完了したフェンス値を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetCompletedValue() const override
+    { return m_Completed.load(std::memory_order_acquire); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      D3D12フェンスを取得します. 常に nullptr を返却します.
+    //-------------------------------------------------------------------------
+    ID3D12Fence* GetD3D12Fence() const override
+    { return nullptr; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      完了値を更新し, 待機しているスレッドを起床させます.
+    //-------------------------------------------------------------------------
+    void Signal(uint64_t value)
+    {
+        // 待機スレッドの登録と完了値の確認が入れ違わないように, どちらも seq_cst で行う.
+        m_Completed.store(value);
+        if (m_Waiters.load() == 0)
+        { return; }
+
+        {
+            std::lock_guard<std::mutex> locker(m_Mutex);
+            for(size_t i=0; i<m_Listeners.size();)
+            {
+                if (m_Listeners[i].Value <= value)
+                {
+                    Notify(m_Listeners[i].pListener);
+                    m_Listeners[i] = m_Listeners.back();
+                    m_Listeners.pop_back();
+                    m_Waiters--;
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+        m_Cond.notify_all();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      リスナーを登録します.
+    //!
+    //! @note       ロックはフェンス, リスナーの順で取得するため, リスナーのロックを
+    //!             保持したまま呼び出してはいけません.
+    //-------------------------------------------------------------------------
+    void AddListener(uint64_t fenceValue, SoftFenceListener* pListener)
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        m_Waiters++;
+
+        // 登録前に完了していた場合は直ちに通知する.
+        if (m_Completed.load() >= fenceValue)
+        {
+            m_Waiters--;
+            Notify(pListener);
+            return;
+        }
+
+        Listener item = {};
+        item.pListener = pListener;
+        item.Value     = fenceValue;
+        m_Listeners.push_back(item);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      リスナーの登録を解除します.
+    //-------------------------------------------------------------------------
+    void RemoveListener(SoftFenceListener* pListener)
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        for(size_t i=0; i<m_Listeners.size();)
+        {
+            if (m_Listeners[i].pListener == pListener)
+            {
+                m_Listeners[i] = m_Listeners.back();
+                m_Listeners.pop_back();
+                m_Waiters--;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::atomic<uint32_t>   m_RefCount  = {};
+    std::atomic<uint64_t>   m_Completed = {};
+    std::atomic<uint32_t>   m_Waiters   = {};
+    FENCE_WAIT_POLICY       m_Policy    = FENCE_WAIT_POLICY_BLOCK;
+    uint32_t                m_SpinUsec  = 0;
+    std::mutex              m_Mutex;
+    std::condition_variable m_Cond;
+    std::vector<Listener>   m_Listeners;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      リスナーの残りのフェンス数を減らし, 0 になったら通知します.
+    //-------------------------------------------------------------------------
+    static void Notify(SoftFenceListener* pListener)
+    {
+        if (pListener->Pending.fetch_sub(1) != 1)
+        { return; }
+
+        {
+            std::lock_guard<std::mutex> locker(pListener->Mutex);
+        }
+        pListener->Cond.notify_all();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SoftFence()
+    : m_RefCount (1)
+    , m_Completed(0)
+    , m_Waiters  (0)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~SoftFence()
+    { /* DO_NOTHING */ }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftCommandQueue class
+///////////////////////////////////////////////////////////////////////////////
+class SoftCommandQueue : public ICommandQueue
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      生成処理を行います.
+    //-------------------------------------------------------------------------
+    static bool Create(const SoftCommandQueueDesc& desc, ICommandQueue** ppQueue)
+    {
+        if (ppQueue == nullptr)
+        {
+            ELOG("Error : Invalid Argument.");
+            return false;
+        }
+
+        auto instance = new SoftCommandQueue();
+        if (!instance->Init(desc))
+        {
+            instance->Release();
+            ELOG("Error : SoftCommandQueue::Init() Failed.");
+            return false;
+        }
+
+        *ppQueue = instance;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      参照カウンタを増やします.
+    //-------------------------------------------------------------------------
+    void AddRef() override
+    { m_RefCount++; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      解放処理を行います.
+    //-------------------------------------------------------------------------
+    void Release() override
+    {
+        m_RefCount--;
+        if (m_RefCount == 0)
+        { delete this; }
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コマンドリストを実行します.
+    //-------------------------------------------------------------------------
+    void Execute(uint32_t count, ID3D12CommandList** ppLists) override
+    {
+        if(count == 0 || ppLists == nullptr)
+        { return; }
+
+        // 投入ごとの固定コストは, リスト数によらず呼び出しスレッドで消費する.
+        if (m_SubmitCostUs > 0)
+        {
+            auto end = Clock::now() + std::chrono::microseconds(m_SubmitCostUs);
+            while(Clock::now() < end)
+            { /* DO_NOTHING */ }
+        }
+
+        // 1回の呼び出しで渡されたリストは連続して実行されるため, 実行時間を合算しておく.
+        uint64_t latencyUs = 0;
+        for(auto i=0u; i<count; ++i)
+        { latencyUs += GetLatency(ppLists[i]); }
+
+        Command cmd = {};
+        cmd.Type       = COMMAND_EXECUTE;
+        cmd.Value      = latencyUs;
+        cmd.SubmitTime = Clock::now();
+        Push(cmd);
+
+        m_IsExecuted = true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      フェンス値を更新します.
+    //-------------------------------------------------------------------------
+    WaitPoint Signal() override
+    {
+        Command cmd = {};
+        cmd.Type   = COMMAND_SIGNAL;
+
+        // Push() 内でロックを取得した順序と値の順序を一致させる.
+        {
+            std::lock_guard<std::mutex> locker(m_Mutex);
+            cmd.Value = m_FenceValue++;
+            m_Commands.push_back(cmd);
+        }
+        m_Cond.notify_one();
+
+        WaitPoint result = {};
+        result.FenceValue = cmd.Value;
+        result.pFence     = m_pFence;
+        return result;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      GPUでの待機点を設定します.
+    //-------------------------------------------------------------------------
+    bool Wait(const WaitPoint& value) override
+    {
+        // 他のキューのフェンスは待機が完了するまで参照を保持する.
+        Command cmd = {};
+        cmd.Type   = COMMAND_WAIT;
+        cmd.pFence = (value.pFence != nullptr) ? value.pFence : m_pFence;
+        cmd.Value  = value.FenceValue;
+        cmd.pFence->AddRef();
+        Push(cmd);
+
+        // キュー間の待機のみを投入した場合も Sync() で完了を待てるようにする.
+        m_IsExecuted = true;
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      CPU上でコマンドの完了を待機します.
+    //-------------------------------------------------------------------------
+    void Sync(const WaitPoint& value, uint32_t msec) override
+    {
+        auto pFence = (value.pFence != nullptr) ? value.pFence : m_pFence;
+        if (pFence == m_pFence && !m_IsExecuted)
+        { return; }
+
+        pFence->Wait(value.FenceValue, msec);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      タイムスタンプ周波数を取得します.
+    //!
+    //! @note       仮想GPUタイムラインはナノ秒単位です.
+    //-------------------------------------------------------------------------
+    uint64_t GetTimeStampFrequency() const override
+    { return 1000 * 1000 * 1000; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      フェンスを取得します.
+    //-------------------------------------------------------------------------
+    IFence* GetFence() const override
+    { return m_pFence; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      D3D12コマンドキューを取得します. 常に nullptr を返却します.
+    //-------------------------------------------------------------------------
+    ID3D12CommandQueue* GetD3D12CommandQueue() const override
+    { return nullptr; }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // COMMAND_TYPE enum
+    ///////////////////////////////////////////////////////////////////////////
+    enum COMMAND_TYPE
+    {
+        COMMAND_EXECUTE = 0,    //!< コマンドリストの実行 (Value = 実行時間(マイクロ秒)).
+        COMMAND_SIGNAL,         //!< フェンスの更新 (Value = フェンス値).
+        COMMAND_WAIT,           //!< フェンスの待機 (Value = フェンス値). 任意の IFence を待機できます.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Command structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Command
+    {
+        COMMAND_TYPE        Type;
+        uint64_t            Value;
+        IFence*             pFence;
+        Clock::time_point   SubmitTime;
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::atomic<uint32_t>   m_RefCount      = {};
+    SoftFence*              m_pFence        = nullptr;
+    uint32_t                m_LatencyUs     = 0;
+    uint32_t                m_SubmitCostUs  = 0;
+    std::atomic<bool>       m_IsExecuted    = {};
+    uint64_t                m_FenceValue    = 0;
+    std::mutex              m_Mutex;
+    std::condition_variable m_Cond;
+    std::deque<Command>     m_Commands;
+    bool                    m_Running       = false;
+    std::thread             m_Thread;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SoftCommandQueue()
+    : m_RefCount    (1)
+    , m_pFence      (nullptr)
+    , m_LatencyUs   (0)
+    , m_SubmitCostUs(0)
+    , m_IsExecuted  (false)
+    , m_FenceValue  (0)
+    , m_Running     (false)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~SoftCommandQueue()
+    { Term(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //-------------------------------------------------------------------------
+    bool Init(const SoftCommandQueueDesc& desc)
+    {
+        IFence* pFence = nullptr;
+        if (!SoftFence::Create(&pFence))
+        { return false; }
+
+        m_pFence        = static_cast<SoftFence*>(pFence);
+        m_LatencyUs     = desc.LatencyUs;
+        m_SubmitCostUs  = desc.SubmitCostUs;
+        m_IsExecuted    = false;
+        m_FenceValue    = 1;
+        m_Running       = true;
+        m_Thread        = std::thread(&SoftCommandQueue::Run, this);
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います. 投入済みのコマンドは全て処理されます.
+    //-------------------------------------------------------------------------
+    void Term()
+    {
+        if (m_Thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> locker(m_Mutex);
+                m_Running = false;
+            }
+            m_Cond.notify_one();
+            m_Thread.join();
+        }
+
+        if (m_pFence != nullptr)
+        {
+            m_pFence->Release();
+            m_pFence = nullptr;
+        }
+
+        m_Commands.clear();
+        m_IsExecuted = false;
+        m_FenceValue = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コマンドリストの実行時間を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetLatency(ID3D12CommandList* pList) const
+    {
+        if (pList == nullptr)
+        { return m_LatencyUs; }
+
+        // 登録済みのハンドルのみを参照する. 解放と競合しないようロックを保持したまま読み取る.
+        auto pHandle = reinterpret_cast<const SoftListHandle*>(pList);
+        std::lock_guard<std::mutex> locker(g_SoftLists.Mutex);
+        if (g_SoftLists.Handles.find(pHandle) == g_SoftLists.Handles.end())
+        {
+            ELOG_LIMIT("Error : Not a Software Command List.");
+            return m_LatencyUs;
+        }
+
+        return pHandle->LatencyUs.load(std::memory_order_relaxed);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コマンドを投入します.
+    //-------------------------------------------------------------------------
+    void Push(const Command& cmd)
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_Mutex);
+            m_Commands.push_back(cmd);
+        }
+        m_Cond.notify_one();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      仮想GPUタイムラインの処理です.
+    //-------------------------------------------------------------------------
+    void Run()
+    {
+        // 仮想GPUが直前のコマンドを完了した時刻.
+        auto gpuTime = Clock::now();
+
+        for(;;)
+        {
+            Command cmd;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Cond.wait(lock, [&]() { return !m_Commands.empty() || !m_Running; });
+
+                if (m_Commands.empty())
+                { break; }
+
+                cmd = m_Commands.front();
+                m_Commands.pop_front();
+            }
+
+            switch(cmd.Type)
+            {
+            case COMMAND_EXECUTE:
+                {
+                    // 投入前には実行を開始できず, 先行するコマンドの完了も待つ.
+                    // 絶対時刻で待機するため, スリープの誤差は後続のリストに蓄積しない.
+                    if (gpuTime < cmd.SubmitTime)
+                    { gpuTime = cmd.SubmitTime; }
+                    gpuTime += std::chrono::microseconds(cmd.Value);
+                    WaitUntil(gpuTime);
+                }
+                break;
+
+            case COMMAND_SIGNAL:
+                {
+                    m_pFence->Signal(cmd.Value);
+                }
+                break;
+
+            case COMMAND_WAIT:
+                {
+                    // 終了処理中は満たされない待機を打ち切る.
+                    while(cmd.pFence->GetCompletedValue() < cmd.Value && IsRunning())
+                    { cmd.pFence->Wait(cmd.Value, 1); }
+
+                    cmd.pFence->Release();
+
+                    auto now = Clock::now();
+                    if (gpuTime < now)
+                    { gpuTime = now; }
+                }
+                break;
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定時刻まで待機します.
+    //!
+    //! @details    スリープは数十マイクロ秒単位で遅れるため, 直前の区間はスピン待機します.
+    //-------------------------------------------------------------------------
+    static void WaitUntil(const Clock::time_point& deadline)
+    {
+        const auto margin = std::chrono::microseconds(SPIN_MARGIN_US);
+        if (Clock::now() + margin < deadline)
+        { std::this_thread::sleep_until(deadline - margin); }
+
+        while(Clock::now() < deadline)
+        { std::this_thread::yield(); }
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理中でないかどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsRunning()
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        return m_Running;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftCommandList class
+///////////////////////////////////////////////////////////////////////////////
+class SoftCommandList : public ICommandList
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      生成処理を行います.
+    //-------------------------------------------------------------------------
+    static bool Create(const SoftCommandListDesc& desc, ICommandList** ppCmdList)
+    {
+        if (ppCmdList == nullptr)
+        {
+            ELOG("Error : Invalid Argument.");
+            return false;
+        }
+
+        auto instance = new SoftCommandList();
+        instance->SetLatency(desc.LatencyUs);
+
+        if (desc.pPool != nullptr)
+        {
+            instance->m_pAllocator = desc.pPool->Acquire(desc.AllocatorClass);
+            if (instance->m_pAllocator == nullptr)
+            {
+                instance->Release();
+                ELOG("Error : CommandAllocatorPool::Acquire() Failed.");
+                return false;
+            }
+
+            instance->m_pPool = desc.pPool;
+            instance->m_Class = desc.AllocatorClass;
+        }
+
+        *ppCmdList = instance;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      参照カウントを増やします.
+    //-------------------------------------------------------------------------
+    void AddRef() override
+    { m_RefCount++; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      解放処理を行います.
+    //-------------------------------------------------------------------------
+    void Release() override
+    {
+        m_RefCount--;
+        if (m_RefCount == 0)
+        { delete this; }
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      リセット処理を行います.
+    //-------------------------------------------------------------------------
+    ID3D12GraphicsCommandList6* Reset() override
+    {
+        if (m_pPool != nullptr)
+        {
+            // 投入したかどうか分からないアロケータは再利用できない.
+            if (!m_FenceSet)
+            {
+                ELOG_LIMIT("Error : Fence Point Is Not Set. Call SetFencePoint() Before Reset().");
+                return nullptr;
+            }
+
+            auto pAllocator = m_pPool->Acquire(m_Class);
+            if (pAllocator == nullptr)
+            {
+                ELOG_LIMIT("Error : CommandAllocatorPool::Acquire() Failed.");
+                return nullptr;
+            }
+
+            m_pPool->Release(m_pAllocator, m_Class, m_FencePoint);
+            m_pAllocator = pAllocator;
+            m_FencePoint = WaitPoint();
+            m_FenceSet   = false;
+        }
+
+        m_Tracker.Reset();
+        m_StateCache.Invalidate();
+        return GetD3D12GraphicsCommandList();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      記録した内容を実行した Signal() の待機点を設定します.
+    //-------------------------------------------------------------------------
+    void SetFencePoint(const WaitPoint& point) override
+    {
+        m_FencePoint = point;
+        m_FenceSet   = true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ソフトウェアコマンドキューに渡すハンドルを取得します.
+    //-------------------------------------------------------------------------
+    ID3D12GraphicsCommandList6* GetD3D12GraphicsCommandList() const override
+    { return reinterpret_cast<ID3D12GraphicsCommandList6*>(const_cast<SoftListHandle*>(&m_Handle)); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      リソースステートトラッカーを取得します.
+    //-------------------------------------------------------------------------
+    ResourceStateTracker* GetStateTracker() override
+    { return &m_Tracker; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      パイプラインステートを設定します.
+    //-------------------------------------------------------------------------
+    void SetPipelineState(ID3D12PipelineState* pPipelineState) override
+    { m_StateCache.SetPipelineState(pPipelineState); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフィックス用ルートシグニチャを設定します.
+    //-------------------------------------------------------------------------
+    void SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature) override
+    { m_StateCache.SetGraphicsRootSignature(pRootSignature); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンピュート用ルートシグニチャを設定します.
+    //-------------------------------------------------------------------------
+    void SetComputeRootSignature(ID3D12RootSignature* pRootSignature) override
+    { m_StateCache.SetComputeRootSignature(pRootSignature); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディスクリプタヒープを設定します.
+    //-------------------------------------------------------------------------
+    void SetDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* ppHeaps) override
+    { m_StateCache.SetDescriptorHeaps(count, ppHeaps); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      レンダーターゲットと深度ステンシルを設定します.
+    //-------------------------------------------------------------------------
+    void OMSetRenderTargets
+    (
+        uint32_t                            count,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pRenderTargets,
+        bool                                singleHandle,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*  pDepthStencil
+    ) override
+    { m_StateCache.OMSetRenderTargets(count, pRenderTargets, singleHandle, pDepthStencil); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフィックス用ルート定数を設定します.
+    //-------------------------------------------------------------------------
+    void SetGraphicsRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset) override
+    { m_StateCache.SetGraphicsRoot32BitConstants(rootIndex, count, pData, destOffset); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンピュート用ルート定数を設定します.
+    //-------------------------------------------------------------------------
+    void SetComputeRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* pData, uint32_t destOffset) override
+    { m_StateCache.SetComputeRoot32BitConstants(rootIndex, count, pData, destOffset); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      状態キャッシュを無効化します.
+    //-------------------------------------------------------------------------
+    void InvalidateStateCache() override
+    { m_StateCache.Invalidate(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      状態キャッシュの統計情報を取得します.
+    //-------------------------------------------------------------------------
+    const CommandStateCacheStats& GetStateCacheStats() const override
+    { return m_StateCache.GetStats(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      実行時間を設定します.
+    //-------------------------------------------------------------------------
+    void SetLatency(uint32_t latencyUs)
+    { m_Handle.LatencyUs.store(latencyUs, std::memory_order_relaxed); }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::atomic<uint32_t>                  m_RefCount      = {};
+    SoftListHandle                         m_Handle;
+    CommandAllocatorPool*                  m_pPool         = nullptr;
+    ID3D12CommandAllocator*                m_pAllocator    = nullptr;
+    COMMAND_ALLOCATOR_CLASS                m_Class         = COMMAND_ALLOCATOR_CLASS_SMALL;
+    WaitPoint                              m_FencePoint;
+    bool                                   m_FenceSet      = true;
+    ResourceStateTracker                   m_Tracker;
+    HeadlessCommandList                    m_Headless;
+    CommandStateCache<HeadlessCommandList> m_StateCache;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SoftCommandList()
+    : m_RefCount    (1)
+    , m_pPool       (nullptr)
+    , m_pAllocator  (nullptr)
+    , m_Class       (COMMAND_ALLOCATOR_CLASS_SMALL)
+    {
+        m_Handle.LatencyUs.store(0, std::memory_order_relaxed);
+        m_StateCache.SetTarget(&m_Headless);
+
+        std::lock_guard<std::mutex> locker(g_SoftLists.Mutex);
+        g_SoftLists.Handles.insert(&m_Handle);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~SoftCommandList()
+    {
+        if (m_pAllocator != nullptr)
+        { m_pPool->Release(m_pAllocator, m_Class, m_FencePoint); }
+
+        std::lock_guard<std::mutex> locker(g_SoftLists.Mutex);
+        g_SoftLists.Handles.erase(&m_Handle);
+    }
+};
+
+//-----------------------------------------------------------------------------
+//      ソフトウェアコマンドキューを生成します.
+//-----------------------------------------------------------------------------
+bool CreateSoftCommandQueue(const SoftCommandQueueDesc& desc, ICommandQueue** ppQueue)
+{ return SoftCommandQueue::Create(desc, ppQueue); }
+
+//-----------------------------------------------------------------------------
+//      ソフトウェアフェンスを生成します.
+//-----------------------------------------------------------------------------
+bool CreateSoftFence(IFence** ppFence)
+{ return SoftFence::Create(ppFence); }
+
+//-----------------------------------------------------------------------------
+//      ソフトウェアコマンドリストを生成します.
+//-----------------------------------------------------------------------------
+bool CreateSoftCommandList(const SoftCommandListDesc& desc, ICommandList** ppCmdList)
+{ return SoftCommandList::Create(desc, ppCmdList); }
+
+//-----------------------------------------------------------------------------
+//      ソフトウェアコマンドリストの実行時間を設定します.
+//-----------------------------------------------------------------------------
+bool SetSoftCommandListLatency(ICommandList* pCmdList, uint32_t latencyUs)
+{
+    auto pSoft = dynamic_cast<SoftCommandList*>(pCmdList);
+    if (pSoft == nullptr)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    pSoft->SetLatency(latencyUs);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      フェンスの完了値をCPUから更新します.
+//-----------------------------------------------------------------------------
+bool SignalSoftFence(IFence* pFence, uint64_t value)
+{
+    auto pSoft = dynamic_cast<SoftFence*>(pFence);
+    if (pSoft == nullptr)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    pSoft->Signal(value);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ソフトウェアフェンスにリスナーを登録します.
+//-----------------------------------------------------------------------------
+bool AddSoftFenceListener(IFence* pFence, uint64_t fenceValue, SoftFenceListener* pListener)
+{
+    auto pSoft = dynamic_cast<SoftFence*>(pFence);
+    if (pSoft == nullptr || pListener == nullptr)
+    { return false; }
+
+    pSoft->AddListener(fenceValue, pListener);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ソフトウェアフェンスからリスナーの登録を解除します.
+//-----------------------------------------------------------------------------
+void RemoveSoftFenceListener(IFence* pFence, SoftFenceListener* pListener)
+{
+    auto pSoft = dynamic_cast<SoftFence*>(pFence);
+    if (pSoft == nullptr || pListener == nullptr)
+    { return; }
+
+    pSoft->RemoveListener(pListener);
+}
+
+} // namespace asf
@@ -0,0 +1,127 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfSubmitBatcher.cpp
+// Desc : Command List Submission Batcher.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfSubmitBatcher.h>
+#include <asfLogger.h>
+#include <asfTime.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// SubmitBatcher class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+SubmitBatcher::~SubmitBatcher()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool SubmitBatcher::Init(const SubmitBatcherDesc& desc)
+{
+    if (desc.pQueue == nullptr || desc.MaxLists == 0)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    if (m_pQueue != nullptr)
+    {
+        ELOG("Error : Already Initialized.");
+        return false;
+    }
+
+    m_pQueue   = desc.pQueue;
+    m_MaxLists = desc.MaxLists;
+    m_Stats    = SubmitBatcherStats();
+    m_Pending.clear();
+    m_Pending.reserve(desc.MaxLists);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void SubmitBatcher::Term()
+{
+    if (m_pQueue == nullptr)
+    { return; }
+
+    Flush();
+    m_pQueue = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      クローズ済みのコマンドリストを溜めます.
+//-----------------------------------------------------------------------------
+void SubmitBatcher::Execute(uint32_t count, ID3D12CommandList** ppLists)
+{
+    if (count == 0 || ppLists == nullptr)
+    { return; }
+
+    m_Pending.insert(m_Pending.end(), ppLists, ppLists + count);
+    m_Stats.RequestCount++;
+    m_Stats.ListCount += count;
+
+    if (m_Pending.size() >= m_MaxLists)
+    {
+        m_Stats.SizeFlushCount++;
+        Flush();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      溜まっているリストを投入してから, フェンスの値を更新します.
+//-----------------------------------------------------------------------------
+WaitPoint SubmitBatcher::Signal()
+{
+    Flush();
+    return m_pQueue->Signal();
+}
+
+//-----------------------------------------------------------------------------
+//      溜まっているリストを投入してから, GPUでの待機点を設定します.
+//-----------------------------------------------------------------------------
+bool SubmitBatcher::Wait(const WaitPoint& value)
+{
+    Flush();
+    return m_pQueue->Wait(value);
+}
+
+//-----------------------------------------------------------------------------
+//      溜まっているリストを投入してから, CPU上で完了を待機します.
+//-----------------------------------------------------------------------------
+void SubmitBatcher::Sync(const WaitPoint& value, uint32_t msec)
+{
+    Flush();
+    m_pQueue->Sync(value, msec);
+}
+
+//-----------------------------------------------------------------------------
+//      溜まっているリストを投入します.
+//-----------------------------------------------------------------------------
+void SubmitBatcher::Flush()
+{
+    if (m_Pending.empty())
+    { return; }
+
+    auto begin = GetSteadyTimeNs();
+    m_pQueue->Execute(uint32_t(m_Pending.size()), m_Pending.data());
+    m_Stats.SubmitTimeNs += GetSteadyTimeNs() - begin;
+    m_Stats.SubmitCount++;
+
+    m_Pending.clear();
+}
+
+} // namespace asf
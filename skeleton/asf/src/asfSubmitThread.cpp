@@ -0,0 +1,284 @@
+﻿//-----------------------------------------------------------------------------
+// File : asfSubmitThread.cpp
+// Desc : Dedicated Command List Submission Thread.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfSubmitThread.h>
+#include <asfLogger.h>
+
+
+namespace asf {
+
+///////////////////////////////////////////////////////////////////////////////
+// SubmitThread class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+SubmitThread::~SubmitThread()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool SubmitThread::Init(const SubmitThreadDesc& desc)
+{
+    if (desc.pQueue == nullptr
+     || desc.MaxRequests == 0
+     || desc.MaxRequests == INVALID_NODE_INDEX
+     || desc.MaxLists == 0)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    if (m_Thread.joinable())
+    {
+        ELOG("Error : Already Initialized.");
+        return false;
+    }
+
+    m_pNodes    = new Node[desc.MaxRequests];
+    m_NodeCount = desc.MaxRequests;
+    m_FreeNodes.Init(m_pNodes, m_NodeCount);
+
+    m_pQueue   = desc.pQueue;
+    m_MaxLists = desc.MaxLists;
+    m_Reorder.assign(m_NodeCount, INVALID_NODE_INDEX);
+    m_Batch.clear();
+    m_Batch.reserve(desc.MaxLists + MAX_SUBMIT_LISTS);
+
+    m_Pending.Reset();
+    m_WakeRequested = false;
+    m_LastPoint     = WaitPoint();
+    m_NextKey    .store(0, std::memory_order_relaxed);
+    m_SubmitCount.store(0, std::memory_order_relaxed);
+    m_Running    .store(true);
+
+    m_Thread = std::thread(&SubmitThread::Run, this);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void SubmitThread::Term()
+{
+    if (!m_Thread.joinable())
+    { return; }
+
+    m_Running.store(false);
+    Wake();
+    m_Thread.join();
+
+    uint32_t dropCount = 0;
+    for(auto index : m_Reorder)
+    {
+        if (index != INVALID_NODE_INDEX)
+        { dropCount++; }
+    }
+    if (dropCount > 0)
+    { ELOG("Error : Submit Requests Dropped. Missing Key = %llu, Count = %u", static_cast<unsigned long long>(m_NextKey.load()), dropCount); }
+
+    m_Reorder.clear();
+    m_Batch.clear();
+
+    delete[] m_pNodes;
+    m_pNodes    = nullptr;
+    m_NodeCount = 0;
+    m_pQueue    = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      クローズ済みのコマンドリストの投入を要求します.
+//-----------------------------------------------------------------------------
+bool SubmitThread::Submit(uint64_t key, uint32_t count, ID3D12CommandList* const* ppLists)
+{
+    if (count > MAX_SUBMIT_LISTS || (count > 0 && ppLists == nullptr))
+    {
+        ELOG_LIMIT("Error : Invalid Argument.");
+        return false;
+    }
+
+    if (!m_Running.load(std::memory_order_relaxed))
+    {
+        ELOG_LIMIT("Error : SubmitThread Is Not Running.");
+        return false;
+    }
+
+    // 並べ替え用の配列はキーの剰余で参照するため, 範囲外のキーは受け付けない.
+    auto nextKey = m_NextKey.load(std::memory_order_acquire);
+    if (key < nextKey || key - nextKey >= m_NodeCount)
+    {
+        ELOG_LIMIT("Error : Key Out Of Range. key = %llu, next = %llu",
+            static_cast<unsigned long long>(key), static_cast<unsigned long long>(nextKey));
+        return false;
+    }
+
+    auto index = m_FreeNodes.Alloc(m_pNodes);
+    if (index == INVALID_NODE_INDEX)
+    {
+        ELOG_LIMIT("Error : Request Pool Exhausted. MaxRequests = %u", m_NodeCount);
+        return false;
+    }
+
+    auto& node = m_pNodes[index];
+    node.Key   = key;
+    node.Count = count;
+    for(auto i=0u; i<count; ++i)
+    { node.pLists[i] = ppLists[i]; }
+
+    // 投入待ちが空だった場合のみ起床させる. 空でなければ投入スレッドが回収前である.
+    if (m_Pending.Push(m_pNodes, index))
+    { Wake(); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      指定した順序キーまでが投入されるまで待機します.
+//-----------------------------------------------------------------------------
+WaitPoint SubmitThread::WaitSubmitted(uint64_t key)
+{
+    std::unique_lock<std::mutex> lock(m_DoneMutex);
+    m_DoneCond.wait(lock, [&]()
+    {
+        return m_NextKey.load(std::memory_order_acquire) > key
+            || !m_Running.load(std::memory_order_acquire);
+    });
+
+    if (m_NextKey.load(std::memory_order_acquire) <= key)
+    {
+        ELOG("Error : Key Not Submitted. key = %llu", static_cast<unsigned long long>(key));
+        return WaitPoint();
+    }
+
+    return m_LastPoint;
+}
+
+//-----------------------------------------------------------------------------
+//      投入スレッドを起床させます.
+//-----------------------------------------------------------------------------
+void SubmitThread::Wake()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_WakeMutex);
+        m_WakeRequested = true;
+    }
+    m_WakeCond.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+//      投入待ちのノードをキー順に並べます.
+//-----------------------------------------------------------------------------
+void SubmitThread::Collect()
+{
+    auto head = m_Pending.Steal();
+    while(head != INVALID_NODE_INDEX)
+    {
+        auto next = m_pNodes[head].Next.load(std::memory_order_relaxed);
+        auto slot = m_pNodes[head].Key % m_NodeCount;
+        if (m_Reorder[slot] != INVALID_NODE_INDEX)
+        {
+            ELOG_LIMIT("Error : Duplicated Key. key = %llu", static_cast<unsigned long long>(m_pNodes[head].Key));
+            m_FreeNodes.Free(m_pNodes, head);
+        }
+        else
+        {
+            m_Reorder[slot] = head;
+        }
+        head = next;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      連続したキーのリストをまとめて投入し, シグナルを発行します.
+//-----------------------------------------------------------------------------
+bool SubmitThread::Drain()
+{
+    auto key   = m_NextKey.load(std::memory_order_relaxed);
+    auto first = key;
+
+    for(;;)
+    {
+        auto slot  = key % m_NodeCount;
+        auto index = m_Reorder[slot];
+        if (index == INVALID_NODE_INDEX)
+        { break; }
+
+        auto& node = m_pNodes[index];
+        m_Batch.insert(m_Batch.end(), node.pLists, node.pLists + node.Count);
+        m_Reorder[slot] = INVALID_NODE_INDEX;
+        m_FreeNodes.Free(m_pNodes, index);
+        key++;
+
+        if (m_Batch.size() >= m_MaxLists)
+        {
+            m_pQueue->Execute(uint32_t(m_Batch.size()), m_Batch.data());
+            m_SubmitCount.fetch_add(1, std::memory_order_relaxed);
+            m_Batch.clear();
+        }
+    }
+
+    if (key == first)
+    { return false; }
+
+    if (!m_Batch.empty())
+    {
+        m_pQueue->Execute(uint32_t(m_Batch.size()), m_Batch.data());
+        m_SubmitCount.fetch_add(1, std::memory_order_relaxed);
+        m_Batch.clear();
+    }
+
+    auto point = m_pQueue->Signal();
+    {
+        std::lock_guard<std::mutex> locker(m_DoneMutex);
+        m_LastPoint = point;
+        m_NextKey.store(key, std::memory_order_release);
+    }
+    m_DoneCond.notify_all();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      投入スレッドの処理です.
+//-----------------------------------------------------------------------------
+void SubmitThread::Run()
+{
+    for(;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_WakeMutex);
+            m_WakeCond.wait(lock, [&]() { return m_WakeRequested; });
+            m_WakeRequested = false;
+        }
+
+        // 回収後に積まれた要求は, 空の状態から積んだスレッドが再度起床させる.
+        do
+        {
+            Collect();
+        }
+        while(Drain());
+
+        if (!m_Running.load())
+        {
+            Collect();
+            Drain();
+            break;
+        }
+    }
+
+    // 投入されずに残ったキーを待機しているスレッドを起床させる.
+    {
+        std::lock_guard<std::mutex> locker(m_DoneMutex);
+    }
+    m_DoneCond.notify_all();
+}
+
+} // namespace asf
@@ -0,0 +1,528 @@
+﻿//-----------------------------------------------------------------------------
+// File : Bench.h
+// Desc : Micro Benchmark Harness.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <utility>
+#include <asfSoftBackend.h>
+
+
+namespace bench {
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using Metrics = std::vector<std::pair<std::string, double>>;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Config structure
+///////////////////////////////////////////////////////////////////////////////
+struct Config
+{
+    uint32_t    Samples         = 101;      //!< 計測サンプル数.
+    uint32_t    WarmupSamples   = 5;        //!< ウォームアップサンプル数.
+    double      SampleTimeUsec  = 200.0;    //!< 1サンプルあたりの目標計測時間(マイクロ秒).
+    uint32_t    MaxThreads      = 0;        //!< 最大スレッド数 (0 の場合はハードウェアスレッド数).
+    bool        Quick           = false;    //!< 短時間モード.
+    std::string Filter;                     //!< 名前フィルター (部分一致).
+    std::string JsonPath;                   //!< JSON出力先 (空の場合は出力しない).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Stats structure
+///////////////////////////////////////////////////////////////////////////////
+struct Stats
+{
+    uint32_t    Count   = 0;
+    double      Min     = 0.0;
+    double      Median  = 0.0;
+    double      Mean    = 0.0;
+    double      P99     = 0.0;
+    double      P999    = 0.0;
+    double      Max     = 0.0;
+    double      StdDev  = 0.0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Result structure
+///////////////////////////////////////////////////////////////////////////////
+struct Result
+{
+    std::string Name;       //!< ベンチマーク名.
+    std::string Unit;       //!< サンプルの単位.
+    Stats       Stat;       //!< 統計値.
+    Metrics     Extra;      //!< 追加の計測値.
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      現在時刻をナノ秒単位で取得します.
+//-----------------------------------------------------------------------------
+inline uint64_t Now()
+{
+    using namespace std::chrono;
+    return uint64_t(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+//-----------------------------------------------------------------------------
+//! @brief      プロセスが消費したCPU時間をナノ秒単位で取得します.
+//!
+//! @note       スピン待機によるCPU消費を計測するために使用します.
+//-----------------------------------------------------------------------------
+uint64_t ProcessCpuTime();
+
+//-----------------------------------------------------------------------------
+//! @brief      プロセス開始からのヒープ確保回数を取得します.
+//!
+//! @note       グローバルな operator new を置き換えて計数しています.
+//-----------------------------------------------------------------------------
+uint64_t AllocationCount();
+
+//-----------------------------------------------------------------------------
+//! @brief      最適化による値の削除を抑止します.
+//-----------------------------------------------------------------------------
+template<typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* s_Sink;
+    s_Sink = &value;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Random class
+///////////////////////////////////////////////////////////////////////////////
+class Random
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    explicit Random(uint64_t seed = 0x9E3779B97F4A7C15ull)
+    : m_State(seed != 0 ? seed : 1)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      64bit乱数を生成します (xorshift64*).
+    //-------------------------------------------------------------------------
+    uint64_t Next()
+    {
+        m_State ^= m_State >> 12;
+        m_State ^= m_State << 25;
+        m_State ^= m_State >> 27;
+        return m_State * 0x2545F4914F6CDD1Dull;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      [minValue, maxValue] の範囲の乱数を生成します.
+    //-------------------------------------------------------------------------
+    uint32_t Range(uint32_t minValue, uint32_t maxValue)
+    { return minValue + uint32_t(Next() % (uint64_t(maxValue) - minValue + 1)); }
+
+private:
+    uint64_t m_State;
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      統計値を計算します.
+//!
+//! @param[in]      samples     サンプル列 (ソートされます).
+//-----------------------------------------------------------------------------
+Stats ComputeStats(std::vector<double>& samples);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Context class
+///////////////////////////////////////////////////////////////////////////////
+class Context
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    explicit Context(const Config& config);
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~Context();
+
+    Context(const Context&) = delete;
+    Context& operator = (const Context&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      結果の出力先を取得します.
+    //!
+    //! @note       標準出力の複製であり, ScopedNullOutput の影響を受けません.
+    //-------------------------------------------------------------------------
+    FILE* GetOutput() const
+    { return m_pOutput; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      設定を取得します.
+    //-------------------------------------------------------------------------
+    const Config& GetConfig() const
+    { return m_Config; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      フィルターに一致するかどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsEnabled(const std::string& name) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測に使用するスレッド数の一覧を取得します.
+    //!
+    //! @details    1, 2, 4, ... と倍々にハードウェアスレッド数までを返却します.
+    //-------------------------------------------------------------------------
+    std::vector<uint32_t> GetThreadCounts() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      1操作あたりの時間を計測します.
+    //!
+    //! @param[in]      name        ベンチマーク名.
+    //! @param[in]      func        func(iterations) の形式で呼び出される計測関数.
+    //!                             指定回数の操作を実行し, 戻り値は無視されます.
+    //-------------------------------------------------------------------------
+    template<typename Func>
+    void Run(const std::string& name, Func&& func)
+    {
+        if (!IsEnabled(name))
+        { return; }
+
+        // 1サンプルが目標時間に達するまで反復回数を増やす.
+        uint64_t iterations = 1;
+        const auto targetNs = m_Config.SampleTimeUsec * 1000.0;
+        for(;;)
+        {
+            auto begin = Now();
+            func(iterations);
+            auto elapsed = double(Now() - begin);
+            if (elapsed >= targetNs || iterations >= (uint64_t(1) << 32))
+            { break; }
+
+            iterations *= 2;
+        }
+
+        for(auto i=0u; i<m_Config.WarmupSamples; ++i)
+        { func(iterations); }
+
+        std::vector<double> samples;
+        samples.reserve(m_Config.Samples);
+
+        auto allocBegin = AllocationCount();
+        for(auto i=0u; i<m_Config.Samples; ++i)
+        {
+            auto begin = Now();
+            func(iterations);
+            auto end = Now();
+            samples.push_back(double(end - begin) / double(iterations));
+        }
+        auto allocCount = AllocationCount() - allocBegin;
+
+        Report(name, "ns/op", samples, {
+            { "iterations",    double(iterations) },
+            { "allocs_per_op", double(allocCount) / (double(iterations) * double(m_Config.Samples)) },
+        });
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測結果を登録します.
+    //!
+    //! @param[in]      name        ベンチマーク名.
+    //! @param[in]      unit        サンプルの単位.
+    //! @param[in]      samples     サンプル列.
+    //! @param[in]      extra       追加の計測値.
+    //-------------------------------------------------------------------------
+    void Report(const std::string& name, const char* unit, std::vector<double>& samples, const Metrics& extra = Metrics());
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測結果を取得します.
+    //-------------------------------------------------------------------------
+    const std::vector<Result>& GetResults() const
+    { return m_Results; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測結果をJSON形式で書き出します.
+    //!
+    //! @param[in]      path        出力ファイルパス.
+    //! @retval true    書き出しに成功.
+    //! @retval false   書き出しに失敗.
+    //-------------------------------------------------------------------------
+    bool WriteJson(const char* path) const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    Config              m_Config;
+    std::vector<Result> m_Results;
+    FILE*               m_pOutput = nullptr;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    /* NOTHING */
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      複数スレッドで同時に処理を実行します.
+//!
+//! @param[in]      threadCount     スレッド数.
+//! @param[in]      func            func(threadIndex) の形式で呼び出される関数.
+//! @return     全スレッドが開始してから終了するまでの経過時間(ナノ秒)を返却します.
+//-----------------------------------------------------------------------------
+template<typename Func>
+uint64_t RunParallel(uint32_t threadCount, Func&& func)
+{
+    std::atomic<uint32_t> ready(0);
+    std::atomic<bool>     start(false);
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for(auto i=0u; i<threadCount; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            ready.fetch_add(1);
+            while(!start.load(std::memory_order_acquire))
+            { std::this_thread::yield(); }
+            func(i);
+        });
+    }
+
+    while(ready.load() != threadCount)
+    { std::this_thread::yield(); }
+
+    auto begin = Now();
+    start.store(true, std::memory_order_release);
+
+    for(auto& thread : threads)
+    { thread.join(); }
+
+    return Now() - begin;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief      複数スレッドで同時に処理を実行し, 関数が返却した区間のレイテンシを計測します.
+//!
+//! @param[in]      context         ベンチマークコンテキスト.
+//! @param[in]      name            ベンチマーク名.
+//! @param[in]      threadCount     スレッド数.
+//! @param[in]      opsPerThread    1スレッドあたりの操作回数.
+//! @param[in]      func            func(threadIndex) の形式で呼び出される1操作分の関数.
+//!                                 計測対象区間のナノ秒を返却します.
+//! @note       ロック取得のみなど, 操作の一部のレイテンシを計測する場合に使用します.
+//!             スループットは操作全体から算出します.
+//-----------------------------------------------------------------------------
+template<typename Func>
+void RunContendedTimed
+(
+    Context&            context,
+    const std::string&  name,
+    uint32_t            threadCount,
+    uint32_t            opsPerThread,
+    Func&&              func
+)
+{
+    if (!context.IsEnabled(name))
+    { return; }
+
+    std::vector<std::vector<double>> latencies(threadCount);
+    for(auto& item : latencies)
+    { item.resize(opsPerThread); }
+
+    auto cpuBegin = ProcessCpuTime();
+    auto elapsed  = RunParallel(threadCount, [&](uint32_t threadIndex)
+    {
+        auto& samples = latencies[threadIndex];
+        for(auto i=0u; i<opsPerThread; ++i)
+        { samples[i] = double(func(threadIndex)); }
+    });
+    auto cpuTime = ProcessCpuTime() - cpuBegin;
+
+    std::vector<double> samples;
+    samples.reserve(size_t(threadCount) * opsPerThread);
+    for(auto& item : latencies)
+    { samples.insert(samples.end(), item.begin(), item.end()); }
+
+    auto totalOps = double(threadCount) * double(opsPerThread);
+    context.Report(name, "ns", samples,
+    {
+        { "threads",     double(threadCount) },
+        { "ops_per_sec", totalOps * 1e9 / double(elapsed) },
+        { "cpu_ns_per_op", double(cpuTime) / totalOps },
+    });
+}
+
+//-----------------------------------------------------------------------------
+//! @brief      複数スレッドで同時に処理を実行し, 1操作ごとのレイテンシを計測します.
+//!
+//! @param[in]      context         ベンチマークコンテキスト.
+//! @param[in]      name            ベンチマーク名.
+//! @param[in]      threadCount     スレッド数.
+//! @param[in]      opsPerThread    1スレッドあたりの操作回数.
+//! @param[in]      func            func(threadIndex) の形式で呼び出される1操作分の関数.
+//-----------------------------------------------------------------------------
+template<typename Func>
+void RunContended
+(
+    Context&            context,
+    const std::string&  name,
+    uint32_t            threadCount,
+    uint32_t            opsPerThread,
+    Func&&              func
+)
+{
+    RunContendedTimed(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+    {
+        auto begin = Now();
+        func(threadIndex);
+        return Now() - begin;
+    });
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ScopedNullOutput class
+///////////////////////////////////////////////////////////////////////////////
+class ScopedNullOutput
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです. 標準出力と標準エラー出力を破棄先へ切り替えます.
+    //-------------------------------------------------------------------------
+    ScopedNullOutput();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです. 出力先を元に戻します.
+    //-------------------------------------------------------------------------
+    ~ScopedNullOutput();
+
+private:
+    int m_Stdout = -1;
+    int m_Stderr = -1;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftQueue class
+///////////////////////////////////////////////////////////////////////////////
+class SoftQueue
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SoftQueue() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです. キューとコマンドリストを解放します.
+    //-------------------------------------------------------------------------
+    ~SoftQueue();
+
+    SoftQueue(const SoftQueue&) = delete;
+    SoftQueue& operator = (const SoftQueue&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ソフトウェアバックエンドのキューと, 投入用のコマンドリストを作成します.
+    //!
+    //! @param[in]      latencyUs       コマンドリストの1回の実行時間 (マイクロ秒).
+    //! @param[in]      submitCostUs    Execute() 1回当たりに呼び出しスレッドで消費するCPU時間 (マイクロ秒).
+    //! @param[in]      type            キューとコマンドリストのタイプ.
+    //! @retval true    作成に成功しました.
+    //! @retval false   作成に失敗しました.
+    //-------------------------------------------------------------------------
+    bool Init(uint32_t latencyUs, uint32_t submitCostUs = 0, D3D12_COMMAND_LIST_TYPE type = D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    //-------------------------------------------------------------------------
+    //! @brief      キューとコマンドリストを解放します.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      キューを取得します.
+    //-------------------------------------------------------------------------
+    asf::ICommandQueue* GetQueue() const
+    { return m_pQueue; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      コマンドリストを取得します.
+    //-------------------------------------------------------------------------
+    asf::ICommandList* GetCommandList() const
+    { return m_pCmdList; }
+
+private:
+    asf::ICommandQueue* m_pQueue   = nullptr;
+    asf::ICommandList*  m_pCmdList = nullptr;
+};
+
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using BenchFunc = void (*)(Context& context);
+
+///////////////////////////////////////////////////////////////////////////////
+// Registrar class
+///////////////////////////////////////////////////////////////////////////////
+class Registrar
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      ベンチマークを登録します.
+    //-------------------------------------------------------------------------
+    Registrar(const char* name, BenchFunc func);
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      登録されているベンチマークを全て実行します.
+//!
+//! @param[in]      context     ベンチマークコンテキスト.
+//-----------------------------------------------------------------------------
+void RunAll(Context& context);
+
+//-----------------------------------------------------------------------------
+//! @brief      登録されているベンチマークスイート名を列挙します.
+//-----------------------------------------------------------------------------
+std::vector<std::string> GetSuiteNames();
+
+} // namespace bench
+
+
+//-----------------------------------------------------------------------------
+// Macros
+//-----------------------------------------------------------------------------
+#ifndef BENCH_SUITE
+#define BENCH_SUITE( _name )                                                \
+    static void BenchSuite_##_name(bench::Context& context);                \
+    static bench::Registrar g_BenchRegistrar_##_name(#_name, BenchSuite_##_name); \
+    static void BenchSuite_##_name(bench::Context& context)
+#endif//BENCH_SUITE
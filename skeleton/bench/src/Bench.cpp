@@ -0,0 +1,498 @@
+﻿//-----------------------------------------------------------------------------
+// File : Bench.cpp
+// Desc : Micro Benchmark Harness.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <new>
+#include <algorithm>
+#include <Bench.h>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <io.h>
+#include <fcntl.h>
+#define dup     _dup
+#define dup2    _dup2
+#define close   _close
+#define fileno  _fileno
+#define fdopen  _fdopen
+#define NULL_DEVICE "NUL"
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#define NULL_DEVICE "/dev/null"
+#endif
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Global Variables.
+//-----------------------------------------------------------------------------
+std::atomic<uint64_t> g_AllocationCount = { 0 };
+
+//-----------------------------------------------------------------------------
+//      計数付きでメモリを確保します.
+//-----------------------------------------------------------------------------
+void* CountedAlloc(size_t size)
+{
+    g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size != 0 ? size : 1);
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+//      ヒープ確保回数を計数するため, グローバルな operator new/delete を置き換えます.
+//-----------------------------------------------------------------------------
+void* operator new(size_t size)
+{
+    auto ptr = CountedAlloc(size);
+    if (ptr == nullptr)
+    { throw std::bad_alloc(); }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{ return operator new(size); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{ return CountedAlloc(size); }
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{ return CountedAlloc(size); }
+
+void operator delete  (void* ptr) noexcept                          { free(ptr); }
+void operator delete[](void* ptr) noexcept                          { free(ptr); }
+void operator delete  (void* ptr, size_t) noexcept                  { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept                  { free(ptr); }
+void operator delete  (void* ptr, const std::nothrow_t&) noexcept   { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept   { free(ptr); }
+
+
+namespace bench {
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// Entry structure
+///////////////////////////////////////////////////////////////////////////////
+struct Entry
+{
+    const char* Name;
+    BenchFunc   Func;
+};
+
+//-----------------------------------------------------------------------------
+//      登録済みベンチマークを取得します.
+//-----------------------------------------------------------------------------
+std::vector<Entry>& GetEntries()
+{
+    static std::vector<Entry> s_Entries;
+    return s_Entries;
+}
+
+//-----------------------------------------------------------------------------
+//      パーセンタイル値を求めます.
+//-----------------------------------------------------------------------------
+double Percentile(const std::vector<double>& sorted, double percent)
+{
+    if (sorted.empty())
+    { return 0.0; }
+
+    // Nearest-rank 法.
+    auto rank = size_t(std::ceil(percent / 100.0 * double(sorted.size())));
+    if (rank > 0)
+    { rank--; }
+
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+//-----------------------------------------------------------------------------
+//      JSON文字列としてエスケープして出力します.
+//-----------------------------------------------------------------------------
+void WriteString(FILE* pFile, const std::string& value)
+{
+    fputc('"', pFile);
+    for(auto c : value)
+    {
+        switch(c)
+        {
+        case '"':  fputs("\\\"", pFile); break;
+        case '\\': fputs("\\\\", pFile); break;
+        case '\n': fputs("\\n",  pFile); break;
+        case '\t': fputs("\\t",  pFile); break;
+        default:   fputc(c, pFile);      break;
+        }
+    }
+    fputc('"', pFile);
+}
+
+//-----------------------------------------------------------------------------
+//      数値を出力します.
+//-----------------------------------------------------------------------------
+void WriteNumber(FILE* pFile, double value)
+{
+    if (std::isfinite(value))
+    { fprintf(pFile, "%.6g", value); }
+    else
+    { fputs("null", pFile); }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      プロセスが消費したCPU時間を取得します.
+//-----------------------------------------------------------------------------
+uint64_t ProcessCpuTime()
+{
+#if defined(_WIN32)
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+    { return 0; }
+
+    auto kernel = (uint64_t(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+    auto user   = (uint64_t(userTime  .dwHighDateTime) << 32) | userTime  .dwLowDateTime;
+    return (kernel + user) * 100;   // 100ns単位.
+#else
+    timespec ts = {};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      プロセス開始からのヒープ確保回数を取得します.
+//-----------------------------------------------------------------------------
+uint64_t AllocationCount()
+{ return g_AllocationCount.load(std::memory_order_relaxed); }
+
+//-----------------------------------------------------------------------------
+//      統計値を計算します.
+//-----------------------------------------------------------------------------
+Stats ComputeStats(std::vector<double>& samples)
+{
+    Stats result = {};
+    if (samples.empty())
+    { return result; }
+
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0.0;
+    for(auto& value : samples)
+    { sum += value; }
+
+    result.Count  = uint32_t(samples.size());
+    result.Min    = samples.front();
+    result.Max    = samples.back();
+    result.Mean   = sum / double(samples.size());
+    result.Median = Percentile(samples, 50.0);
+    result.P99    = Percentile(samples, 99.0);
+    result.P999   = Percentile(samples, 99.9);
+
+    double variance = 0.0;
+    for(auto& value : samples)
+    {
+        auto diff = value - result.Mean;
+        variance += diff * diff;
+    }
+    result.StdDev = std::sqrt(variance / double(samples.size()));
+
+    return result;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Context class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+Context::Context(const Config& config)
+: m_Config(config)
+{
+    if (m_Config.Quick)
+    {
+        m_Config.Samples        = std::min(m_Config.Samples, 21u);
+        m_Config.WarmupSamples  = std::min(m_Config.WarmupSamples, 2u);
+        m_Config.SampleTimeUsec = std::min(m_Config.SampleTimeUsec, 50.0);
+    }
+
+    if (m_Config.MaxThreads == 0)
+    { m_Config.MaxThreads = std::max(1u, std::thread::hardware_concurrency()); }
+
+    // 計測中に標準出力を差し替えても結果を表示できるように複製しておく.
+    auto handle = dup(fileno(stdout));
+    if (handle >= 0)
+    { m_pOutput = fdopen(handle, "w"); }
+
+    if (m_pOutput == nullptr)
+    { m_pOutput = stdout; }
+}
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+Context::~Context()
+{
+    if (m_pOutput != nullptr && m_pOutput != stdout)
+    { fclose(m_pOutput); }
+
+    m_pOutput = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      フィルターに一致するかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool Context::IsEnabled(const std::string& name) const
+{
+    if (m_Config.Filter.empty())
+    { return true; }
+
+    return name.find(m_Config.Filter) != std::string::npos;
+}
+
+//-----------------------------------------------------------------------------
+//      計測に使用するスレッド数の一覧を取得します.
+//-----------------------------------------------------------------------------
+std::vector<uint32_t> Context::GetThreadCounts() const
+{
+    std::vector<uint32_t> result;
+    for(auto count=1u; count<m_Config.MaxThreads; count *= 2)
+    { result.push_back(count); }
+    result.push_back(m_Config.MaxThreads);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      計測結果を登録します.
+//-----------------------------------------------------------------------------
+void Context::Report(const std::string& name, const char* unit, std::vector<double>& samples, const Metrics& extra)
+{
+    Result result;
+    result.Name  = name;
+    result.Unit  = unit;
+    result.Stat  = ComputeStats(samples);
+    result.Extra = extra;
+
+    fprintf(m_pOutput, "%-56s %12.2f %12.2f %12.2f %12.2f  %-8s n=%u",
+        result.Name.c_str(),
+        result.Stat.Median,
+        result.Stat.P99,
+        result.Stat.Mean,
+        result.Stat.Min,
+        result.Unit.c_str(),
+        result.Stat.Count);
+
+    for(auto& item : result.Extra)
+    { fprintf(m_pOutput, "  %s=%.4g", item.first.c_str(), item.second); }
+
+    fprintf(m_pOutput, "\n");
+    fflush(m_pOutput);
+
+    m_Results.push_back(result);
+}
+
+//-----------------------------------------------------------------------------
+//      計測結果をJSON形式で書き出します.
+//-----------------------------------------------------------------------------
+bool Context::WriteJson(const char* path) const
+{
+    auto pFile = fopen(path, "w");
+    if (pFile == nullptr)
+    { return false; }
+
+    fprintf(pFile, "{\n");
+    fprintf(pFile, "  \"schema\": 1,\n");
+    fprintf(pFile, "  \"timestamp\": %lld,\n", static_cast<long long>(time(nullptr)));
+    fprintf(pFile, "  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(pFile, "  \"samples\": %u,\n", m_Config.Samples);
+    fprintf(pFile, "  \"results\": [\n");
+
+    for(size_t i=0; i<m_Results.size(); ++i)
+    {
+        auto& result = m_Results[i];
+
+        fprintf(pFile, "    { \"name\": ");
+        WriteString(pFile, result.Name);
+        fprintf(pFile, ", \"unit\": ");
+        WriteString(pFile, result.Unit);
+        fprintf(pFile, ", \"count\": %u", result.Stat.Count);
+        fprintf(pFile, ", \"min\": ");      WriteNumber(pFile, result.Stat.Min);
+        fprintf(pFile, ", \"median\": ");   WriteNumber(pFile, result.Stat.Median);
+        fprintf(pFile, ", \"mean\": ");     WriteNumber(pFile, result.Stat.Mean);
+        fprintf(pFile, ", \"p99\": ");      WriteNumber(pFile, result.Stat.P99);
+        fprintf(pFile, ", \"p999\": ");     WriteNumber(pFile, result.Stat.P999);
+        fprintf(pFile, ", \"max\": ");      WriteNumber(pFile, result.Stat.Max);
+        fprintf(pFile, ", \"stddev\": ");   WriteNumber(pFile, result.Stat.StdDev);
+
+        fprintf(pFile, ", \"extra\": {");
+        for(size_t j=0; j<result.Extra.size(); ++j)
+        {
+            fprintf(pFile, (j == 0) ? " " : ", ");
+            WriteString(pFile, result.Extra[j].first);
+            fprintf(pFile, ": ");
+            WriteNumber(pFile, result.Extra[j].second);
+        }
+        fprintf(pFile, " } }%s\n", (i + 1 < m_Results.size()) ? "," : "");
+    }
+
+    fprintf(pFile, "  ]\n");
+    fprintf(pFile, "}\n");
+    fclose(pFile);
+
+    return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ScopedNullOutput class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+ScopedNullOutput::ScopedNullOutput()
+{
+    fflush(stdout);
+    fflush(stderr);
+
+    auto nullFile = open(NULL_DEVICE, O_WRONLY);
+    if (nullFile < 0)
+    { return; }
+
+    m_Stdout = dup(fileno(stdout));
+    m_Stderr = dup(fileno(stderr));
+    dup2(nullFile, fileno(stdout));
+    dup2(nullFile, fileno(stderr));
+    close(nullFile);
+}
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+ScopedNullOutput::~ScopedNullOutput()
+{
+    fflush(stdout);
+    fflush(stderr);
+
+    if (m_Stdout >= 0)
+    {
+        dup2(m_Stdout, fileno(stdout));
+        close(m_Stdout);
+    }
+
+    if (m_Stderr >= 0)
+    {
+        dup2(m_Stderr, fileno(stderr));
+        close(m_Stderr);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SoftQueue class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+SoftQueue::~SoftQueue()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      キューとコマンドリストを作成します.
+//-----------------------------------------------------------------------------
+bool SoftQueue::Init(uint32_t latencyUs, uint32_t submitCostUs, D3D12_COMMAND_LIST_TYPE type)
+{
+    Term();
+
+    asf::SoftCommandQueueDesc queueDesc;
+    queueDesc.Type         = type;
+    queueDesc.SubmitCostUs = submitCostUs;
+
+    asf::SoftCommandListDesc listDesc;
+    listDesc.Type      = type;
+    listDesc.LatencyUs = latencyUs;
+
+    if (!asf::CreateSoftCommandQueue(queueDesc, &m_pQueue)
+     || !asf::CreateSoftCommandList(listDesc, &m_pCmdList))
+    {
+        Term();
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      キューとコマンドリストを解放します.
+//-----------------------------------------------------------------------------
+void SoftQueue::Term()
+{
+    if (m_pCmdList != nullptr)
+    {
+        m_pCmdList->Release();
+        m_pCmdList = nullptr;
+    }
+
+    if (m_pQueue != nullptr)
+    {
+        m_pQueue->Release();
+        m_pQueue = nullptr;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Registrar class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      ベンチマークを登録します.
+//-----------------------------------------------------------------------------
+Registrar::Registrar(const char* name, BenchFunc func)
+{ GetEntries().push_back({ name, func }); }
+
+//-----------------------------------------------------------------------------
+//      登録されているベンチマークを全て実行します.
+//-----------------------------------------------------------------------------
+void RunAll(Context& context)
+{
+    auto entries = GetEntries();
+    std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs)
+    { return std::string(lhs.Name) < std::string(rhs.Name); });
+
+    fprintf(context.GetOutput(), "%-56s %12s %12s %12s %12s  %-8s\n", "name", "median", "p99", "mean", "min", "unit");
+    for(auto& entry : entries)
+    { entry.Func(context); }
+}
+
+//-----------------------------------------------------------------------------
+//      登録されているベンチマークスイート名を列挙します.
+//-----------------------------------------------------------------------------
+std::vector<std::string> GetSuiteNames()
+{
+    std::vector<std::string> result;
+    for(auto& entry : GetEntries())
+    { result.push_back(entry.Name); }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+} // namespace bench
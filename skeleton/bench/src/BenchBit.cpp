@@ -0,0 +1,140 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchBit.cpp
+// Desc : Benchmark for Bit Operations.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfBit.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t INPUT_COUNT = 4096;    // 2のべき乗.
+static constexpr uint32_t INPUT_MASK  = INPUT_COUNT - 1;
+
+//-----------------------------------------------------------------------------
+//      入力データを生成します. ゼロは含みません.
+//-----------------------------------------------------------------------------
+template<typename T>
+std::vector<T> MakeInput(uint64_t seed)
+{
+    bench::Random random(seed);
+    std::vector<T> result(INPUT_COUNT);
+    for(auto& value : result)
+    {
+        // 先頭のゼロビット数が偏らないようにランダムにシフトする.
+        auto bits = T(T(random.Next()) >> random.Range(0, sizeof(T) * 8 - 1));
+        value = T(bits != 0 ? bits : 1);
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      単項演算のベンチマークを実行します.
+//-----------------------------------------------------------------------------
+template<typename T, typename Func>
+void RunUnary(bench::Context& context, const char* name, const std::vector<T>& input, Func func)
+{
+    context.Run(name, [&](uint64_t iterations)
+    {
+        int sum = 0;
+        for(uint64_t i=0; i<iterations; ++i)
+        { sum += func(input[i & INPUT_MASK]); }
+        bench::DoNotOptimize(sum);
+    });
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      ビットカウント・ビットスキャンのベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(Bit)
+{
+    auto input8  = MakeInput<uint8_t >(1);
+    auto input16 = MakeInput<uint16_t>(2);
+    auto input32 = MakeInput<uint32_t>(3);
+    auto input64 = MakeInput<uint64_t>(4);
+
+    RunUnary(context, "Bit.CountBit/u8",    input8,  [](uint8_t  v) { return asf::CountBit(v); });
+    RunUnary(context, "Bit.CountBit/u16",   input16, [](uint16_t v) { return asf::CountBit(v); });
+    RunUnary(context, "Bit.CountBit/u32",   input32, [](uint32_t v) { return asf::CountBit(v); });
+    RunUnary(context, "Bit.CountBit/u64",   input64, [](uint64_t v) { return asf::CountBit(v); });
+
+    RunUnary(context, "Bit.CountZeroL/u8",  input8,  [](uint8_t  v) { return asf::CountZeroL(v); });
+    RunUnary(context, "Bit.CountZeroL/u16", input16, [](uint16_t v) { return asf::CountZeroL(v); });
+    RunUnary(context, "Bit.CountZeroL/u32", input32, [](uint32_t v) { return asf::CountZeroL(v); });
+    RunUnary(context, "Bit.CountZeroL/u64", input64, [](uint64_t v) { return asf::CountZeroL(v); });
+
+    RunUnary(context, "Bit.CountZeroR/u8",  input8,  [](uint8_t  v) { return asf::CountZeroR(v); });
+    RunUnary(context, "Bit.CountZeroR/u16", input16, [](uint16_t v) { return asf::CountZeroR(v); });
+    RunUnary(context, "Bit.CountZeroR/u32", input32, [](uint32_t v) { return asf::CountZeroR(v); });
+    RunUnary(context, "Bit.CountZeroR/u64", input64, [](uint64_t v) { return asf::CountZeroR(v); });
+
+    RunUnary(context, "Bit.FindOneL/u32",   input32, [](uint32_t v) { return asf::FindOneL(v); });
+    RunUnary(context, "Bit.FindOneR/u32",   input32, [](uint32_t v) { return asf::FindOneR(v); });
+    RunUnary(context, "Bit.FindZeroL/u32",  input32, [](uint32_t v) { return asf::FindZeroL(v); });
+    RunUnary(context, "Bit.FindZeroR/u32",  input32, [](uint32_t v) { return asf::FindZeroR(v); });
+}
+
+//-----------------------------------------------------------------------------
+//      モートンコードのベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(Morton)
+{
+    auto input = MakeInput<uint32_t>(5);
+
+    context.Run("Morton.Encode2", [&](uint64_t iterations)
+    {
+        uint32_t sum = 0;
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            auto v = input[i & INPUT_MASK];
+            sum += asf::EncodeMorton2(v & 0xffff, v >> 16);
+        }
+        bench::DoNotOptimize(sum);
+    });
+
+    context.Run("Morton.Encode3", [&](uint64_t iterations)
+    {
+        uint32_t sum = 0;
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            auto v = input[i & INPUT_MASK];
+            sum += asf::EncodeMorton3(v & 0x3ff, (v >> 10) & 0x3ff, (v >> 20) & 0x3ff);
+        }
+        bench::DoNotOptimize(sum);
+    });
+
+    context.Run("Morton.Decode2", [&](uint64_t iterations)
+    {
+        uint32_t sum = 0;
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            uint32_t x, y;
+            asf::DecodeMorton2(input[i & INPUT_MASK], x, y);
+            sum += x ^ y;
+        }
+        bench::DoNotOptimize(sum);
+    });
+
+    context.Run("Morton.Decode3", [&](uint64_t iterations)
+    {
+        uint32_t sum = 0;
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            uint32_t x, y, z;
+            asf::DecodeMorton3(input[i & INPUT_MASK], x, y, z);
+            sum += x ^ y ^ z;
+        }
+        bench::DoNotOptimize(sum);
+    });
+}
@@ -0,0 +1,134 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchCommandAllocatorPool.cpp
+// Desc : Benchmark for Fence-tracked Command Allocator Pool.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <asfCommandAllocatorPool.h>
+#include <asfFramePacer.h>
+#include <asfSoftBackend.h>
+#include <Bench.h>
+
+
+//-----------------------------------------------------------------------------
+//      CommandAllocatorPool のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(CommandAllocatorPool)
+{
+    // 完了済みのアロケータを取得して返却するまでのコスト.
+    {
+        asf::CommandAllocatorPoolDesc desc;
+        desc.InitialCount[asf::COMMAND_ALLOCATOR_CLASS_SMALL] = 4;
+
+        asf::CommandAllocatorPool pool;
+        if (pool.Init(desc))
+        {
+            context.Run("CommandAllocatorPool.AcquireRelease", [&](uint64_t iterations)
+            {
+                for(uint64_t i=0; i<iterations; ++i)
+                {
+                    auto pAllocator = pool.Acquire(asf::COMMAND_ALLOCATOR_CLASS_SMALL);
+                    pool.Release(pAllocator, asf::COMMAND_ALLOCATOR_CLASS_SMALL, asf::WaitPoint());
+                }
+            });
+            pool.Term();
+        }
+    }
+
+    // 先行フレーム数ごとのアロケータ数と待機回数. 1フレームで小さなリスト4つと大きなリスト1つを記録する.
+    // リストはアロケータプールを指定して個別に作成するため, キューのみを使用する.
+    bench::SoftQueue queue;
+    if (!queue.Init(0))
+    { return; }
+
+    auto pQueue = queue.GetQueue();
+
+    const uint32_t smallCount  = 4;
+    const uint32_t frameCount  = 16;
+
+    for(auto framesInFlight=1u; framesInFlight<=3; ++framesInFlight)
+    {
+        const auto name = "CommandAllocatorPool.Frame/frames:" + std::to_string(framesInFlight);
+        if (!context.IsEnabled(name))
+        { continue; }
+
+        asf::CommandAllocatorPoolDesc poolDesc;
+        asf::CommandAllocatorPool pool;
+        if (!pool.Init(poolDesc))
+        { continue; }
+
+        asf::ICommandList* pLists[smallCount + 1] = {};
+        auto ready = true;
+        for(auto i=0u; i<=smallCount; ++i)
+        {
+            asf::SoftCommandListDesc listDesc;
+            listDesc.LatencyUs      = (i < smallCount) ? 20 : 200;
+            listDesc.pPool          = &pool;
+            listDesc.AllocatorClass = (i < smallCount) ? asf::COMMAND_ALLOCATOR_CLASS_SMALL : asf::COMMAND_ALLOCATOR_CLASS_LARGE;
+            ready &= asf::CreateSoftCommandList(listDesc, &pLists[i]);
+        }
+
+        asf::FramePacerDesc pacerDesc;
+        pacerDesc.pQueue            = pQueue;
+        pacerDesc.MaxFramesInFlight = framesInFlight;
+
+        asf::FramePacer pacer;
+        if (ready && pacer.Init(pacerDesc))
+        {
+            std::vector<double> samples;
+            samples.reserve(context.GetConfig().Samples);
+            for(auto i=0u; i<context.GetConfig().Samples && ready; ++i)
+            {
+                auto begin = bench::Now();
+                for(auto frame=0u; frame<frameCount && ready; ++frame)
+                {
+                    pacer.BeginFrame();
+
+                    // リセットできたリストのみ投入し, 待機点を設定する.
+                    ID3D12CommandList* pCmds[smallCount + 1] = {};
+                    asf::ICommandList* pRecorded[smallCount + 1] = {};
+                    auto count = 0u;
+                    for(auto j=0u; j<=smallCount; ++j)
+                    {
+                        pCmds[count] = pLists[j]->Reset();
+                        if (pCmds[count] == nullptr)
+                        {
+                            ready = false;
+                            continue;
+                        }
+                        pRecorded[count++] = pLists[j];
+                    }
+
+                    pQueue->Execute(count, pCmds);
+                    auto point = pacer.EndFrame();
+
+                    for(auto j=0u; j<count; ++j)
+                    { pRecorded[j]->SetFencePoint(point); }
+                }
+                samples.push_back(double(bench::Now() - begin) / double(frameCount));
+            }
+            pacer.Term();
+
+            if (ready)
+            {
+                const auto stats = pool.GetStats();
+                context.Report(name, "ns/frame", samples, {
+                    { "allocators", double(stats.CreateCount) },
+                    { "stalls",     double(stats.StallCount) },
+                });
+            }
+        }
+
+        for(auto pList : pLists)
+        {
+            if (pList != nullptr)
+            { pList->Release(); }
+        }
+        pool.Term();
+    }
+}
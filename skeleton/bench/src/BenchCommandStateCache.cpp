@@ -0,0 +1,166 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchCommandStateCache.cpp
+// Desc : Benchmark for Redundant State Filtering.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <asfCommandStateCache.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t DRIVER_WORK           = 32;   // 1回のAPI呼び出しでドライバが行う演算回数.
+static constexpr uint32_t DRAWS_PER_MATERIAL    = 32;   // マテリアルを切り替える間隔.
+
+///////////////////////////////////////////////////////////////////////////////
+// DriverCommandList class
+// API呼び出しごとに一定量の演算を行い, ドライバの検証とステート更新を模擬します.
+///////////////////////////////////////////////////////////////////////////////
+class DriverCommandList
+{
+public:
+    void SetPipelineState(ID3D12PipelineState*)
+    { Work(); }
+
+    void SetGraphicsRootSignature(ID3D12RootSignature*)
+    { Work(); }
+
+    void SetComputeRootSignature(ID3D12RootSignature*)
+    { Work(); }
+
+    void SetDescriptorHeaps(uint32_t, ID3D12DescriptorHeap* const*)
+    { Work(); }
+
+    void OMSetRenderTargets(uint32_t, const D3D12_CPU_DESCRIPTOR_HANDLE*, bool, const D3D12_CPU_DESCRIPTOR_HANDLE*)
+    { Work(); }
+
+    void SetGraphicsRoot32BitConstants(uint32_t, uint32_t, const void*, uint32_t)
+    { Work(); }
+
+    void SetComputeRoot32BitConstants(uint32_t, uint32_t, const void*, uint32_t)
+    { Work(); }
+
+    void DrawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t)
+    { Work(); }
+
+    uint64_t GetCallCount() const
+    { return m_CallCount; }
+
+    uint64_t GetState() const
+    { return m_State; }
+
+private:
+    uint64_t    m_State     = 1;
+    uint64_t    m_CallCount = 0;
+
+    void Work()
+    {
+        auto state = m_State;
+        for(auto i=0u; i<DRIVER_WORK; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+        }
+        m_State = state;
+        m_CallCount++;
+    }
+};
+
+//-----------------------------------------------------------------------------
+//      描画ごとに全ての状態を設定する記録処理です.
+//      マテリアル順にソートされた描画を想定し, 変化する状態はパイプラインと定数のみです.
+//-----------------------------------------------------------------------------
+template<typename T>
+void RecordDraw(T* pTarget, uint64_t index)
+{
+    static ID3D12RootSignature*  s_pRootSignature = reinterpret_cast<ID3D12RootSignature*>(uintptr_t(0x100));
+    static ID3D12DescriptorHeap* s_pHeaps[2] = {
+        reinterpret_cast<ID3D12DescriptorHeap*>(uintptr_t(0x200)),
+        reinterpret_cast<ID3D12DescriptorHeap*>(uintptr_t(0x300)),
+    };
+    static const D3D12_CPU_DESCRIPTOR_HANDLE s_RenderTargets[3] = { { 0x1000 }, { 0x1040 }, { 0x1080 } };
+    static const D3D12_CPU_DESCRIPTOR_HANDLE s_DepthStencil = { 0x2000 };
+
+    const auto material = uint32_t(index / DRAWS_PER_MATERIAL);
+    const uint32_t materialConstants[4] = { material, material * 3, material * 5, material * 7 };
+    const uint32_t objectConstants[4]   = { uint32_t(index), 0, 0, 0 };
+
+    pTarget->SetGraphicsRootSignature(s_pRootSignature);
+    pTarget->SetDescriptorHeaps(2, s_pHeaps);
+    pTarget->OMSetRenderTargets(3, s_RenderTargets, false, &s_DepthStencil);
+    pTarget->SetPipelineState(reinterpret_cast<ID3D12PipelineState*>(uintptr_t(0x10000 + material * 0x100)));
+    pTarget->SetGraphicsRoot32BitConstants(0, 4, materialConstants, 0);
+    pTarget->SetGraphicsRoot32BitConstants(1, 4, objectConstants, 0);
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      CommandStateCache のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(CommandStateCache)
+{
+    // 状態設定を全てドライバに渡す場合の1描画あたりの時間.
+    context.Run("CommandStateCache.Draw/direct", [&](uint64_t iterations)
+    {
+        DriverCommandList driver;
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            RecordDraw(&driver, i);
+            driver.DrawIndexedInstanced(36, 1, 0, 0, 0);
+        }
+        bench::DoNotOptimize(driver.GetState());
+    });
+
+    // 状態キャッシュで冗長な呼び出しを破棄する場合の1描画あたりの時間.
+    context.Run("CommandStateCache.Draw/filtered", [&](uint64_t iterations)
+    {
+        DriverCommandList driver;
+        asf::CommandStateCache<DriverCommandList> cache;
+        cache.SetTarget(&driver);
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            RecordDraw(&cache, i);
+            driver.DrawIndexedInstanced(36, 1, 0, 0, 0);
+        }
+        bench::DoNotOptimize(driver.GetState());
+    });
+
+    // ドライバに到達した呼び出し数.
+    if (context.IsEnabled("CommandStateCache.Calls"))
+    {
+        const uint64_t drawCount = 4096;
+
+        DriverCommandList direct;
+        for(uint64_t i=0; i<drawCount; ++i)
+        { RecordDraw(&direct, i); }
+
+        DriverCommandList driver;
+        asf::CommandStateCache<DriverCommandList> cache;
+        cache.SetTarget(&driver);
+        for(uint64_t i=0; i<drawCount; ++i)
+        { RecordDraw(&cache, i); }
+
+        const auto& stats = cache.GetStats();
+        std::vector<double> samples = { double(driver.GetCallCount()) / double(drawCount) };
+        context.Report("CommandStateCache.Calls", "calls/draw", samples, {
+            { "direct",          double(direct.GetCallCount()) / double(drawCount) },
+            { "filtered",        double(stats.GetFilterCount()) },
+            { "pipeline_state",  double(stats.PipelineStateCount) },
+            { "root_signature",  double(stats.RootSignatureCount) },
+            { "descriptor_heap", double(stats.DescriptorHeapsCount) },
+            { "render_targets",  double(stats.RenderTargetsCount) },
+            { "root_constants",  double(stats.RootConstantsCount) },
+        });
+    }
+}
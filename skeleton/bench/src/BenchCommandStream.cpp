@@ -0,0 +1,157 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchCommandStream.cpp
+// Desc : Benchmark for Recorded Command Stream.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <asfCommandStream.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t DRAW_COUNT         = 1024;    // 1フレームの描画数.
+static constexpr uint32_t DRAWS_PER_PIPELINE = 16;      // パイプラインを切り替える間隔.
+static constexpr uint32_t COMMANDS_PER_FRAME = DRAW_COUNT * 5 + DRAW_COUNT / DRAWS_PER_PIPELINE;
+
+//-----------------------------------------------------------------------------
+//      1フレーム分の描画コマンドを記録します.
+//      CommandStream と HeadlessCommandList のどちらにも同じ内容を記録できます.
+//-----------------------------------------------------------------------------
+template<typename T>
+void RecordFrame(T* pTarget, uint32_t seed)
+{
+    for(auto i=0u; i<DRAW_COUNT; ++i)
+    {
+        if ((i % DRAWS_PER_PIPELINE) == 0)
+        { pTarget->SetPipelineState(reinterpret_cast<ID3D12PipelineState*>(uintptr_t(0x1000 + i))); }
+
+        const uint32_t constants[4] = { i, seed, i * 3, i ^ seed };
+
+        D3D12_GPU_DESCRIPTOR_HANDLE table = { 0x10000 + uint64_t(i) * 64 };
+
+        D3D12_VERTEX_BUFFER_VIEW vbv = {};
+        vbv.BufferLocation = 0x100000 + uint64_t(i) * 4096;
+        vbv.SizeInBytes    = 4096;
+        vbv.StrideInBytes  = 32;
+
+        D3D12_INDEX_BUFFER_VIEW ibv = {};
+        ibv.BufferLocation = 0x800000 + uint64_t(i) * 1024;
+        ibv.SizeInBytes    = 1024;
+        ibv.Format         = DXGI_FORMAT_R16_UINT;
+
+        pTarget->SetGraphicsRootDescriptorTable(0, table);
+        pTarget->SetGraphicsRoot32BitConstants(1, 4, constants, 0);
+        pTarget->IASetVertexBuffers(0, 1, &vbv);
+        pTarget->IASetIndexBuffer(&ibv);
+        pTarget->DrawIndexedInstanced(512, 1, 0, 0, 0);
+    }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      CommandStream のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(CommandStream)
+{
+    asf::CommandStreamDesc desc;
+
+    // 基準値: 仮想呼び出しを伴わない HeadlessCommandList への直接呼び出し.
+    context.Run("CommandStream.Direct/draws:" + std::to_string(DRAW_COUNT), [&](uint64_t iterations)
+    {
+        asf::HeadlessCommandList target;
+        for(uint64_t i=0; i<iterations; ++i)
+        { RecordFrame(&target, uint32_t(i)); }
+        bench::DoNotOptimize(target.GetChecksum());
+    });
+
+    // ストリームへの記録. 2フレーム目以降はブロックを再利用するためヒープ確保は発生しません.
+    {
+        asf::CommandStream stream;
+        if (stream.Init(desc))
+        {
+            context.Run("CommandStream.Record/draws:" + std::to_string(DRAW_COUNT), [&](uint64_t iterations)
+            {
+                for(uint64_t i=0; i<iterations; ++i)
+                {
+                    stream.Reset();
+                    RecordFrame(&stream, uint32_t(i));
+                }
+                bench::DoNotOptimize(stream.GetSize());
+            });
+            stream.Term();
+        }
+    }
+
+    // 記録済みの静的なストリームの再生.
+    {
+        asf::CommandStream stream;
+        if (stream.Init(desc))
+        {
+            RecordFrame(&stream, 0);
+
+            context.Run("CommandStream.Replay/draws:" + std::to_string(DRAW_COUNT), [&](uint64_t iterations)
+            {
+                asf::HeadlessCommandList target;
+                for(uint64_t i=0; i<iterations; ++i)
+                { stream.Replay(&target); }
+                bench::DoNotOptimize(target.GetChecksum());
+            });
+
+            std::vector<double> samples = { double(stream.GetSize()) / double(stream.GetCommandCount()) };
+            context.Report("CommandStream.Size/draws:" + std::to_string(DRAW_COUNT), "bytes/command", samples, {
+                { "commands",  double(stream.GetCommandCount()) },
+                { "bytes",     double(stream.GetSize()) },
+                { "capacity",  double(stream.GetCapacity()) },
+            });
+            stream.Term();
+        }
+    }
+
+    // スレッドごとに別のストリームへ記録. ストリーム間で共有するデータはありません.
+    const uint32_t frameCount = 16;
+    for(auto threadCount : context.GetThreadCounts())
+    {
+        const auto name = "CommandStream.Record/threads:" + std::to_string(threadCount);
+        if (!context.IsEnabled(name))
+        { continue; }
+
+        std::vector<asf::CommandStream> streams(threadCount);
+        for(auto& stream : streams)
+        { stream.Init(desc); }
+
+        std::vector<double> samples;
+        samples.reserve(context.GetConfig().Samples);
+
+        for(auto i=0u; i<context.GetConfig().Samples; ++i)
+        {
+            auto elapsed = bench::RunParallel(threadCount, [&](uint32_t threadIndex)
+            {
+                auto& stream = streams[threadIndex];
+                for(auto frame=0u; frame<frameCount; ++frame)
+                {
+                    stream.Reset();
+                    RecordFrame(&stream, frame);
+                }
+                bench::DoNotOptimize(stream.GetSize());
+            });
+
+            const auto commandCount = double(threadCount) * double(frameCount) * double(COMMANDS_PER_FRAME);
+            samples.push_back(double(elapsed) / commandCount);
+        }
+
+        context.Report(name, "ns/command", samples, {
+            { "threads", double(threadCount) },
+        });
+    }
+}
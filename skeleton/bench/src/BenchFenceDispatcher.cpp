@@ -0,0 +1,113 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchFenceDispatcher.cpp
+// Desc : Benchmark for Fence Completion Callback Dispatcher.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <asfFenceDispatcher.h>
+#include <asfSoftBackend.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      呼び出し回数を数えるコールバックです.
+//-----------------------------------------------------------------------------
+void CountCallback(void* pUser)
+{ static_cast<std::atomic<uint64_t>*>(pUser)->fetch_add(1, std::memory_order_relaxed); }
+
+//-----------------------------------------------------------------------------
+//      呼び出された時刻を記録するコールバックです.
+//-----------------------------------------------------------------------------
+void TimeCallback(void* pUser)
+{ static_cast<std::atomic<uint64_t>*>(pUser)->store(bench::Now(), std::memory_order_release); }
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      FenceDispatcher のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(FenceDispatcher)
+{
+    asf::IFence* pFence = nullptr;
+    if (!asf::CreateSoftFence(&pFence))
+    { return; }
+
+    asf::FenceDispatcherDesc desc;
+    desc.MaxCallbacks = 1 << 16;
+
+    asf::FenceDispatcher dispatcher;
+    if (!dispatcher.Init(desc))
+    {
+        pFence->Release();
+        return;
+    }
+
+    // 登録から呼び出しまでのスループット. 登録はプールから行うためヒープ確保は発生しない.
+    {
+        std::atomic<uint64_t> called = { 0 };
+        asf::SignalSoftFence(pFence, 1);
+
+        asf::WaitPoint point;
+        point.pFence     = pFence;
+        point.FenceValue = 1;
+
+        context.Run("FenceDispatcher.Register", [&](uint64_t iterations)
+        {
+            auto target = called.load() + iterations;
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                while(!dispatcher.Register(point, CountCallback, &called))
+                { std::this_thread::yield(); }
+            }
+
+            while(called.load() < target)
+            { std::this_thread::yield(); }
+        });
+    }
+
+    // フェンスの更新からコールバックが呼び出されるまでの遅延.
+    const auto name = std::string("FenceDispatcher.Latency");
+    if (context.IsEnabled(name))
+    {
+        std::vector<double> samples;
+        samples.reserve(context.GetConfig().Samples);
+
+        std::atomic<uint64_t> calledTime = { 0 };
+        uint64_t value = pFence->GetCompletedValue();
+        for(auto i=0u; i<context.GetConfig().Samples; ++i)
+        {
+            asf::WaitPoint point;
+            point.pFence     = pFence;
+            point.FenceValue = ++value;
+
+            calledTime.store(0, std::memory_order_relaxed);
+            dispatcher.Register(point, TimeCallback, &calledTime);
+
+            // ディスパッチスレッドが待機に入るまで待つ.
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+            auto begin = bench::Now();
+            asf::SignalSoftFence(pFence, value);
+
+            while(calledTime.load(std::memory_order_acquire) == 0)
+            { std::this_thread::yield(); }
+
+            samples.push_back(double(calledTime.load() - begin));
+        }
+
+        context.Report(name, "ns", samples);
+    }
+
+    dispatcher.Term();
+    pFence->Release();
+}
@@ -0,0 +1,145 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchFramePacer.cpp
+// Desc : Benchmark for Frame-in-flight Pacing Controller.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <asfFramePacer.h>
+#include <asfSoftBackend.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      指定時間だけCPUを使用します.
+//-----------------------------------------------------------------------------
+void BusyWork(uint64_t usec)
+{
+    auto end = bench::Now() + usec * 1000;
+    while(bench::Now() < end)
+    { /* DO_NOTHING */ }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      FramePacer のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(FramePacer)
+{
+    // 1フレーム当たりのGPU時間は 400us.
+    bench::SoftQueue queue;
+    if (!queue.Init(400))
+    { return; }
+
+    auto pQueue   = queue.GetQueue();
+    auto pCmdList = queue.GetCommandList();
+
+    // steady : CPU 150us / GPU 400us の GPU 律速.
+    // spike  : 8フレームに1回 CPU が 900us かかる. 先行フレーム数が少ないとGPUが途切れる.
+    struct Scenario
+    {
+        const char* Name;
+        uint32_t    CpuUs;
+        uint32_t    SpikeUs;
+    };
+    const Scenario scenarios[] = {
+        { "steady", 150, 150 },
+        { "spike",  150, 900 },
+    };
+
+    struct Config
+    {
+        const char* Name;
+        uint32_t    MaxFrames;
+        bool        Adaptive;
+    };
+    const Config configs[] = {
+        { "frames:1", 1, false },
+        { "frames:2", 2, false },
+        { "frames:3", 3, false },
+        { "adaptive", 4, true  },
+    };
+
+    const uint32_t frameCount  = 32;
+    const uint32_t warmupCount = 64;
+
+    for(auto& scenario : scenarios)
+    {
+        for(auto& config : configs)
+        {
+            const auto name = std::string("FramePacer.Frame/") + scenario.Name + "/" + config.Name;
+            if (!context.IsEnabled(name))
+            { continue; }
+
+            asf::FramePacerDesc desc;
+            desc.pQueue            = pQueue;
+            desc.MaxFramesInFlight = config.MaxFrames;
+            desc.MinFramesInFlight = 1;
+            desc.Adaptive          = config.Adaptive;
+            desc.AdaptWindow       = 16;
+
+            asf::FramePacer pacer;
+            if (!pacer.Init(desc))
+            { continue; }
+
+            uint64_t frame  = 0;
+            uint64_t queued = 0;
+            auto runFrame = [&]()
+            {
+                pacer.BeginFrame();
+
+                // 未完了のフレーム数. 入力からGPU完了までの遅延の目安になります.
+                for(auto i=0u; i<config.MaxFrames; ++i)
+                {
+                    auto point = pacer.GetFrameWaitPoint(i);
+                    if (point.pFence != nullptr && point.pFence->GetCompletedValue() < point.FenceValue)
+                    { queued++; }
+                }
+
+                BusyWork((frame % 8 == 7) ? scenario.SpikeUs : scenario.CpuUs);
+
+                ID3D12CommandList* pList = pCmdList->Reset();
+                if (pList != nullptr)
+                { pQueue->Execute(1, &pList); }
+                pacer.EndFrame();
+                frame++;
+            };
+
+            for(auto i=0u; i<warmupCount; ++i)
+            { runFrame(); }
+
+            const auto base = pacer.GetStats();
+            queued = 0;
+
+            std::vector<double> samples;
+            samples.reserve(context.GetConfig().Samples);
+            for(auto i=0u; i<context.GetConfig().Samples; ++i)
+            {
+                auto begin = bench::Now();
+                for(auto j=0u; j<frameCount; ++j)
+                { runFrame(); }
+                samples.push_back(double(bench::Now() - begin) / double(frameCount));
+            }
+
+            const auto& stats  = pacer.GetStats();
+            const auto  frames = double(stats.FrameCount - base.FrameCount);
+            const auto  framesInFlight = pacer.GetFramesInFlight();
+            pacer.Term();
+
+            context.Report(name, "ns/frame", samples, {
+                { "cpu_wait_us_per_frame", double(stats.TotalWaitNs - base.TotalWaitNs) / 1000.0 / frames },
+                { "starve_ratio",          double(stats.StarveCount - base.StarveCount) / frames },
+                { "queued_frames",         double(queued) / frames },
+                { "frames_in_flight",      double(framesInFlight) },
+            });
+        }
+    }
+}
@@ -0,0 +1,458 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchLogger.cpp
+// Desc : Benchmark for Logger.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdarg>
+#include <cwchar>
+#include <chrono>
+#include <asfLogger.h>
+#include <asfAsyncLogger.h>
+#include <asfLogRecord.h>
+#include <asfMappedFileLogger.h>
+#include <asfMergingLogger.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      DefaultLogger::WriteA() と同じ条件でフォーマットのみを行います.
+//-----------------------------------------------------------------------------
+int FormatA(char (&msg)[1024], const char* format, ...)
+{
+    va_list arg;
+    va_start(arg, format);
+    auto ret = vsnprintf(msg, sizeof(msg), format, arg);
+    va_end(arg);
+    return ret;
+}
+
+//-----------------------------------------------------------------------------
+//      DefaultLogger::WriteW() と同じ条件でフォーマットのみを行います.
+//-----------------------------------------------------------------------------
+int FormatW(wchar_t (&msg)[1024], const wchar_t* format, ...)
+{
+    va_list arg;
+    va_start(arg, format);
+    auto ret = vswprintf(msg, 1024, format, arg);
+    va_end(arg);
+    return ret;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      Logger のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(Logger)
+{
+    const std::string  longText (900,  'x');
+    const std::string  hugeText (8000, 'y');
+    const std::wstring hugeTextW(8000, L'z');
+
+    // フォーマット処理のみ.
+    context.Run("Logger.Format/short", [&](uint64_t iterations)
+    {
+        char msg[1024] = "\0";
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            FormatA(msg, "Frame %u : %s = %.3f\n", uint32_t(i), "GpuTime", 16.6667);
+            bench::DoNotOptimize(msg);
+        }
+    });
+
+    context.Run("Logger.Format/error", [&](uint64_t iterations)
+    {
+        char msg[1024] = "\0";
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            FormatA(msg, "[File: %s, Line: %d] Error : ID3D12CommandQueue::Signal() Failed. errcode = 0x%x\n",
+                __FILE__, __LINE__, 0x887a0005u);
+            bench::DoNotOptimize(msg);
+        }
+    });
+
+    context.Run("Logger.Format/long", [&](uint64_t iterations)
+    {
+        char msg[1024] = "\0";
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            FormatA(msg, "%s %u\n", longText.c_str(), uint32_t(i));
+            bench::DoNotOptimize(msg);
+        }
+    });
+
+    context.Run("Logger.FormatW/short", [&](uint64_t iterations)
+    {
+        wchar_t msg[1024] = L"\0";
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            FormatW(msg, L"Frame %u : %ls = %.3f\n", uint32_t(i), L"GpuTime", 16.6667);
+            bench::DoNotOptimize(msg);
+        }
+    });
+
+    // 出力まで含めた処理. 出力先は破棄する.
+    {
+        bench::ScopedNullOutput nullOutput;
+        auto pLogger = asf::GetDefaultLogger();
+
+        context.Run("Logger.WriteA/info", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { pLogger->WriteA(asf::LOG_INFO, "Frame %u : %s = %.3f\n", uint32_t(i), "GpuTime", 16.6667); }
+        });
+
+        context.Run("Logger.WriteA/error", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { pLogger->WriteA(asf::LOG_ERROR, "Error : Invalid Argument. %u\n", uint32_t(i)); }
+        });
+
+        context.Run("Logger.WriteA/long", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { pLogger->WriteA(asf::LOG_INFO, "%s %u\n", longText.c_str(), uint32_t(i)); }
+        });
+
+        // 1024文字を超えるメッセージ. 2回目以降はスレッドローカルのバッファを再利用するため確保は発生しない.
+        context.Run("Logger.WriteA/huge", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { pLogger->WriteA(asf::LOG_INFO, "%s %s %u\n", longText.c_str(), hugeText.c_str(), uint32_t(i)); }
+        });
+
+        context.Run("Logger.WriteW/huge", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { pLogger->WriteW(asf::LOG_INFO, L"%ls %u\n", hugeTextW.c_str(), uint32_t(i)); }
+        });
+
+        context.Run("Logger.ILOGA", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { ILOGA("Frame %u : %s = %.3f", uint32_t(i), "GpuTime", 16.6667); }
+        });
+    }
+
+    // 出力対象外のログのコスト. 引数が評価されないことも確認する.
+    {
+        bench::ScopedNullOutput nullOutput;
+        uint64_t evaluated = 0;
+        auto argument = [&]() { ++evaluated; return 16.6667; };
+
+        // コンパイル時に除去された場合と同等.
+        context.Run("Logger.Disabled/baseline", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { bench::DoNotOptimize(i); }
+        });
+
+        asf::SetLogLevel(asf::LOG_CATEGORY_GENERAL, asf::LOG_WARNING);
+        context.Run("Logger.Disabled/runtime", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                ILOGA("Frame %u : %s = %.3f", uint32_t(i), "GpuTime", argument());
+                bench::DoNotOptimize(i);
+            }
+        });
+
+        asf::SetLogLevel(asf::LOG_CATEGORY_GRAPHICS, asf::LOG_ERROR);
+        context.Run("Logger.Disabled/category", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                ASF_LOGA(asf::LOG_CATEGORY_GRAPHICS, asf::LOG_WARNING, "Frame %u : %s = %.3f", uint32_t(i), "GpuTime", argument());
+                bench::DoNotOptimize(i);
+            }
+        });
+        asf::SetLogLevel(asf::LOG_VERBOSE);
+
+        if (evaluated != 0)
+        { fprintf(stderr, "Warning : Arguments of disabled log were evaluated. count = %llu\n", static_cast<unsigned long long>(evaluated)); }
+    }
+
+    // 呼び出し元ごとの出力制限. 区間内の上限に達した後の抑制時のコストを計測する.
+    {
+        bench::ScopedNullOutput nullOutput;
+
+        context.Run("Logger.Limited/suppressed", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { ELOGA_LIMIT("Error : ID3D12CommandQueue::Signal() Failed. errcode = 0x%x", 0x887a0005u); }
+        });
+
+        const auto opsPerThread = context.GetConfig().Quick ? 2000u : 20000u;
+        for(auto threadCount : context.GetThreadCounts())
+        {
+            auto name = "Logger.Limited/suppressed/threads:" + std::to_string(threadCount);
+            bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+            { ELOGA_LIMIT("Error : ID3D12CommandQueue::Wait() Failed. thread = %u", threadIndex); });
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      AsyncLogger の書き込み側のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(AsyncLogger)
+{
+    bench::ScopedNullOutput nullOutput;
+    const auto opsPerThread = context.GetConfig().Quick ? 2000u : 20000u;
+
+    // 比較対象として, 同期出力のデフォルトロガーを複数スレッドから呼び出す.
+    for(auto threadCount : context.GetThreadCounts())
+    {
+        auto pLogger = asf::GetDefaultLogger();
+        auto name    = "AsyncLogger.Baseline/DefaultLogger/threads:" + std::to_string(threadCount);
+        bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+        { pLogger->WriteA(asf::LOG_INFO, "Frame %u : %s = %.3f\n", threadIndex, "GpuTime", 16.6667); });
+    }
+
+    const struct
+    {
+        asf::ASYNC_LOG_POLICY   Policy;
+        const char*             Tag;
+    } policies[] = {
+        { asf::ASYNC_LOG_POLICY_DROP,  "drop"  },
+        { asf::ASYNC_LOG_POLICY_BLOCK, "block" },
+    };
+
+    for(auto& item : policies)
+    {
+        asf::AsyncLoggerDesc desc;
+        desc.Capacity            = 4096;
+        desc.Policy              = item.Policy;
+        desc.InstallCrashHandler = false;
+
+        asf::AsyncLogger logger;
+        if (!logger.Init(desc))
+        { continue; }
+
+        const std::string prefix = std::string("AsyncLogger.WriteA/") + item.Tag;
+
+        context.Run(prefix, [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { logger.WriteA(asf::LOG_INFO, "Frame %u : %s = %.3f\n", uint32_t(i), "GpuTime", 16.6667); }
+        });
+        logger.Flush();
+
+        // ログマクロの出力先として設定した場合.
+        asf::SetLogger(&logger);
+        context.Run(std::string("AsyncLogger.ILOGA/") + item.Tag, [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { ILOGA("Frame %u : %s = %.3f", uint32_t(i), "GpuTime", 16.6667); }
+        });
+        asf::SetLogger(nullptr);
+        logger.Flush();
+
+        for(auto threadCount : context.GetThreadCounts())
+        {
+            auto name = prefix + "/threads:" + std::to_string(threadCount);
+            bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+            { logger.WriteA(asf::LOG_INFO, "Frame %u : %s = %.3f\n", threadIndex, "GpuTime", 16.6667); });
+            logger.Flush();
+        }
+
+        logger.Term();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ログレコード (遅延フォーマット) の書き込み側のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(LogRecord)
+{
+    bench::ScopedNullOutput nullOutput;
+    const auto opsPerThread = context.GetConfig().Quick ? 2000u : 20000u;
+    const auto recordPath   = "asf_bench_log_record.bin";
+
+    static asf::LogSite s_Site(asf::LOG_INFO, "Frame %u : %s = %.3f\n", __FILE__, __LINE__, asf::LOG_SITE_FLAG_NONE);
+
+    // 引数のエンコードのみ.
+    context.Run("LogRecord.Encode", [&](uint64_t iterations)
+    {
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            asf::LogArgBuffer buffer;
+            asf::EncodeLogArg(buffer, uint32_t(i));
+            asf::EncodeLogArg(buffer, "GpuTime");
+            asf::EncodeLogArg(buffer, 16.6667);
+            bench::DoNotOptimize(buffer);
+        }
+    });
+
+    // ライター未設定の場合はその場でフォーマットしてデフォルトロガーに出力する.
+    context.Run("LogRecord.Write/sync", [&](uint64_t iterations)
+    {
+        for(uint64_t i=0; i<iterations; ++i)
+        { asf::WriteLogRecord(s_Site, uint32_t(i), "GpuTime", 16.6667); }
+    });
+
+    const struct
+    {
+        const char* Path;
+        const char* Tag;
+    } modes[] = {
+        { nullptr,    "async-text"   },
+        { recordPath, "async-binary" },
+    };
+
+    for(auto& item : modes)
+    {
+        asf::AsyncLoggerDesc desc;
+        desc.Capacity            = 4096;
+        desc.Policy              = asf::ASYNC_LOG_POLICY_BLOCK;
+        desc.InstallCrashHandler = false;
+        desc.RecordPath          = item.Path;
+
+        asf::AsyncLogger logger;
+        if (!logger.Init(desc))
+        { continue; }
+
+        asf::SetLogRecordWriter(&logger);
+
+        const std::string prefix = std::string("LogRecord.Write/") + item.Tag;
+
+        context.Run(prefix, [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { asf::WriteLogRecord(s_Site, uint32_t(i), "GpuTime", 16.6667); }
+        });
+        logger.Flush();
+
+        for(auto threadCount : context.GetThreadCounts())
+        {
+            auto name = prefix + "/threads:" + std::to_string(threadCount);
+            bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+            { asf::WriteLogRecord(s_Site, threadIndex, "GpuTime", 16.6667); });
+            logger.Flush();
+        }
+
+        logger.Term();
+    }
+
+    remove(recordPath);
+}
+
+//-----------------------------------------------------------------------------
+//      MappedFileLogger と fprintf によるファイル出力のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(MappedFileLogger)
+{
+    const auto opsPerThread = context.GetConfig().Quick ? 2000u : 20000u;
+    const auto mappedPath   = "asf_bench_mapped.log";
+    const auto textPath     = "asf_bench_fprintf.log";
+
+    // 比較対象として, 同じ項目を fprintf でファイルに出力する.
+    {
+        auto pFile = fopen(textPath, "w");
+        if (pFile != nullptr)
+        {
+            auto write = [&](uint32_t value)
+            {
+                auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                fprintf(pFile, "%lld [%u] [INFO] Frame %u : %s = %.3f\n",
+                    static_cast<long long>(timestamp), 0u, value, "GpuTime", 16.6667);
+            };
+
+            context.Run("MappedFileLogger.Baseline/fprintf", [&](uint64_t iterations)
+            {
+                for(uint64_t i=0; i<iterations; ++i)
+                { write(uint32_t(i)); }
+            });
+
+            for(auto threadCount : context.GetThreadCounts())
+            {
+                auto name = "MappedFileLogger.Baseline/fprintf/threads:" + std::to_string(threadCount);
+                bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+                { write(threadIndex); });
+            }
+
+            fclose(pFile);
+        }
+        remove(textPath);
+    }
+
+    {
+        asf::MappedFileLoggerDesc desc;
+        desc.Path        = mappedPath;
+        desc.RecordCount = 16384;
+
+        asf::MappedFileLogger logger;
+        if (logger.Init(desc))
+        {
+            context.Run("MappedFileLogger.WriteA", [&](uint64_t iterations)
+            {
+                for(uint64_t i=0; i<iterations; ++i)
+                { logger.WriteA(asf::LOG_INFO, "Frame %u : %s = %.3f\n", uint32_t(i), "GpuTime", 16.6667); }
+            });
+
+            for(auto threadCount : context.GetThreadCounts())
+            {
+                auto name = "MappedFileLogger.WriteA/threads:" + std::to_string(threadCount);
+                bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+                { logger.WriteA(asf::LOG_INFO, "Frame %u : %s = %.3f\n", threadIndex, "GpuTime", 16.6667); });
+            }
+
+            logger.Term();
+        }
+        remove(mappedPath);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      MergingLogger の書き込み側のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(MergingLogger)
+{
+    bench::ScopedNullOutput nullOutput;
+    const auto opsPerThread = context.GetConfig().Quick ? 2000u : 20000u;
+
+    // 比較対象として, 標準出力のロックを共有するデフォルトロガーを複数スレッドから呼び出す.
+    for(auto threadCount : context.GetThreadCounts())
+    {
+        auto pLogger = asf::GetDefaultLogger();
+        auto name    = "MergingLogger.Baseline/DefaultLogger/threads:" + std::to_string(threadCount);
+        bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+        { pLogger->WriteA(asf::LOG_INFO, "Frame %u : %s = %.3f\n", threadIndex, "GpuTime", 16.6667); });
+    }
+
+    asf::MergingLoggerDesc desc;
+    desc.BufferSize = 1024 * 1024;
+
+    asf::MergingLogger logger;
+    if (!logger.Init(desc))
+    { return; }
+
+    // スレッドごとのバッファ確保を計測から除外する.
+    logger.WriteA(asf::LOG_INFO, "Warmup\n");
+
+    context.Run("MergingLogger.WriteA", [&](uint64_t iterations)
+    {
+        for(uint64_t i=0; i<iterations; ++i)
+        { logger.WriteA(asf::LOG_INFO, "Frame %u : %s = %.3f\n", uint32_t(i), "GpuTime", 16.6667); }
+    });
+    logger.Flush();
+
+    for(auto threadCount : context.GetThreadCounts())
+    {
+        auto name = "MergingLogger.WriteA/threads:" + std::to_string(threadCount);
+        bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+        { logger.WriteA(asf::LOG_INFO, "Frame %u : %s = %.3f\n", threadIndex, "GpuTime", 16.6667); });
+        logger.Flush();
+    }
+
+    logger.Term();
+}
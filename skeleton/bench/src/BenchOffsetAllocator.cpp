@@ -0,0 +1,214 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchOffsetAllocator.cpp
+// Desc : Benchmark for Offset Allocator.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfOffsetAllocator.h>
+#include <asfAdaptiveLock.h>
+#include <asfQueueLock.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t HEAP_SIZE     = 256 * 1024 * 1024;
+static constexpr uint32_t MAX_ALLOCS    = 128 * 1024;
+static constexpr uint32_t LIVE_COUNT    = 4096;     // 2のべき乗.
+static constexpr uint32_t SIZE_COUNT    = 4096;     // 2のべき乗.
+
+//-----------------------------------------------------------------------------
+//      確保サイズ列を生成します.
+//-----------------------------------------------------------------------------
+std::vector<uint32_t> MakeSizes(uint64_t seed, uint32_t minSize, uint32_t maxSize)
+{
+    bench::Random random(seed);
+    std::vector<uint32_t> result(SIZE_COUNT);
+    for(auto& value : result)
+    { value = random.Range(minSize, maxSize); }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      スレッドセーフなオフセットアロケータのベンチマークを実行します.
+//-----------------------------------------------------------------------------
+template<typename AllocatorType>
+void RunLockedAllocator(bench::Context& context, const char* allocatorName)
+{
+    const std::string prefix = allocatorName;
+
+    // 競合なし.
+    {
+        AllocatorType allocator;
+        allocator.Init(HEAP_SIZE, MAX_ALLOCS);
+
+        context.Run(prefix + ".AllocFree/uncontended", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                auto handle = allocator.Alloc(256);
+                allocator.Free(handle);
+            }
+        });
+
+        allocator.Term();
+    }
+
+    // 競合あり.
+    const auto opsPerThread = context.GetConfig().Quick ? 2000u : 20000u;
+    auto sizes = MakeSizes(4, 1, 64 * 1024);
+
+    for(auto threadCount : context.GetThreadCounts())
+    {
+        AllocatorType allocator;
+        allocator.Init(HEAP_SIZE, MAX_ALLOCS);
+
+        std::vector<uint32_t> cursors(threadCount * 16);
+
+        auto name = prefix + ".AllocFree/threads:" + std::to_string(threadCount);
+        bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+        {
+            auto& cursor = cursors[threadIndex * 16];
+            auto handle = allocator.Alloc(sizes[cursor++ & (SIZE_COUNT - 1)]);
+            allocator.Free(handle);
+        });
+
+        allocator.Term();
+    }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      OffsetAllocator のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(OffsetAllocator)
+{
+    // 同一サイズの確保・解放を繰り返す.
+    {
+        asf::OffsetAllocator allocator;
+        allocator.Init(HEAP_SIZE, MAX_ALLOCS);
+
+        context.Run("OffsetAllocator.AllocFree/fixed", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                auto handle = allocator.Alloc(256);
+                allocator.Free(handle);
+            }
+        });
+
+        allocator.Term();
+    }
+
+    // ランダムサイズで LIVE_COUNT 個を保持したまま確保・解放を入れ替える.
+    {
+        auto sizes = MakeSizes(1, 1, 64 * 1024);
+
+        asf::OffsetAllocator allocator;
+        allocator.Init(HEAP_SIZE, MAX_ALLOCS);
+
+        std::vector<asf::OffsetHandle> handles(LIVE_COUNT);
+        for(auto i=0u; i<LIVE_COUNT; ++i)
+        { handles[i] = allocator.Alloc(sizes[i & (SIZE_COUNT - 1)]); }
+
+        bench::Random random(2);
+        context.Run("OffsetAllocator.AllocFree/random", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                auto index = uint32_t(random.Next() & (LIVE_COUNT - 1));
+                allocator.Free(handles[index]);
+                handles[index] = allocator.Alloc(sizes[i & (SIZE_COUNT - 1)]);
+            }
+        });
+
+        allocator.Term();
+    }
+
+    // アライメント指定付きの確保.
+    {
+        auto sizes = MakeSizes(3, 1, 4096);
+
+        asf::OffsetAllocator allocator;
+        allocator.Init(HEAP_SIZE, MAX_ALLOCS);
+
+        context.Run("OffsetAllocator.AllocFree/aligned", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                auto handle = allocator.Alloc(sizes[i & (SIZE_COUNT - 1)], 256);
+                allocator.Free(handle);
+            }
+        });
+
+        allocator.Term();
+    }
+
+    // 確保のみを行い, 満杯になったらリセットする (フレームアロケータ用途).
+    {
+        asf::OffsetAllocator allocator;
+        allocator.Init(HEAP_SIZE, MAX_ALLOCS);
+
+        context.Run("OffsetAllocator.AllocOnly", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                auto handle = allocator.Alloc(64);
+                if (!handle.IsValid())
+                { allocator.Reset(); }
+                bench::DoNotOptimize(handle);
+            }
+        });
+
+        allocator.Term();
+    }
+
+    // リセットのコスト.
+    const uint32_t resetCounts[] = { 1024, MAX_ALLOCS };
+    for(auto count : resetCounts)
+    {
+        asf::OffsetAllocator allocator;
+        allocator.Init(HEAP_SIZE, count);
+
+        auto name = "OffsetAllocator.Reset/" + std::to_string(count);
+        context.Run(name, [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            { allocator.Reset(); }
+        });
+
+        allocator.Term();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ThreadSafeOffsetAllocator のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(ThreadSafeOffsetAllocator)
+{ RunLockedAllocator<asf::ThreadSafeOffsetAllocator>(context, "ThreadSafeOffsetAllocator"); }
+
+//-----------------------------------------------------------------------------
+//      AdaptiveOffsetAllocator のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(AdaptiveOffsetAllocator)
+{ RunLockedAllocator<asf::AdaptiveOffsetAllocator>(context, "AdaptiveOffsetAllocator"); }
+
+//-----------------------------------------------------------------------------
+//      TicketOffsetAllocator のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(TicketOffsetAllocator)
+{ RunLockedAllocator<asf::TicketOffsetAllocator>(context, "TicketOffsetAllocator"); }
+
+//-----------------------------------------------------------------------------
+//      McsOffsetAllocator のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(McsOffsetAllocator)
+{ RunLockedAllocator<asf::McsOffsetAllocator>(context, "McsOffsetAllocator"); }
@@ -0,0 +1,101 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchParallelRecorder.cpp
+// Desc : Benchmark for Parallel Command List Recording.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <asfParallelRecorder.h>
+#include <asfSoftBackend.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t ITEM_WORK = 512;  // 1項目の記録で行う演算回数.
+
+//-----------------------------------------------------------------------------
+//      作業項目ごとに一定量の演算を行う記録関数です.
+//      時間で待機すると, プリエンプトされている間も進んだことになるため演算量で模擬します.
+//-----------------------------------------------------------------------------
+void RecordItems(asf::ICommandList*, uint32_t begin, uint32_t end, void*)
+{
+    uint64_t state = begin + 1;
+    for(auto i=begin; i<end; ++i)
+    {
+        for(auto j=0u; j<ITEM_WORK; ++j)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+        }
+        bench::DoNotOptimize(state);
+    }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      ParallelRecorder のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(ParallelRecorder)
+{
+    // 投入するリストは ParallelRecorder が作成するため, キューのみを使用する.
+    bench::SoftQueue queue;
+    if (!queue.Init(0))
+    { return; }
+
+    auto pQueue = queue.GetQueue();
+
+    // 2048項目の記録と投入に掛かる時間. ハードウェアスレッド数を超える場合は過剰割り当てになります.
+    const uint32_t itemCount      = 2048;
+    const uint32_t threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+
+    for(auto threadCount : threadCounts)
+    {
+        const auto name = "ParallelRecorder.Record/threads:" + std::to_string(threadCount);
+        if (!context.IsEnabled(name))
+        { continue; }
+
+        asf::CommandAllocatorPoolDesc poolDesc;
+        asf::CommandAllocatorPool pool;
+        if (!pool.Init(poolDesc))
+        { continue; }
+
+        asf::ParallelRecorderDesc desc;
+        desc.pPool       = &pool;
+        desc.ThreadCount = threadCount;
+
+        asf::ParallelRecorder recorder;
+        if (recorder.Init(desc))
+        {
+            std::vector<double> samples;
+            samples.reserve(context.GetConfig().Samples);
+
+            asf::WaitPoint point = {};
+            for(auto i=0u; i<context.GetConfig().Samples; ++i)
+            {
+                auto begin = bench::Now();
+                recorder.Record(itemCount, 0, RecordItems, nullptr);
+                point = recorder.Submit(pQueue);
+                samples.push_back(double(bench::Now() - begin));
+            }
+            pQueue->Sync(point, asf::WAIT_INFINITE);
+            recorder.Term();
+
+            context.Report(name, "ns/frame", samples, {
+                { "threads", double(threadCount) },
+            });
+        }
+
+        pool.Term();
+    }
+}
@@ -0,0 +1,105 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchRWLock.cpp
+// Desc : Benchmark for Reader-Writer Locks.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfSpinLock.h>
+#include <asfRWLock.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t TABLE_SIZE = 256;     // 2のべき乗.
+static constexpr uint32_t READ_COUNT = 8;       // 1回の読み取りで参照する要素数.
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ExclusiveLock class
+///////////////////////////////////////////////////////////////////////////////
+template<typename LockType>
+class ExclusiveLock
+{
+public:
+    void lock()          { m_Lock.lock(); }
+    void unlock()        { m_Lock.unlock(); }
+    void lock_shared()   { m_Lock.lock(); }
+    void unlock_shared() { m_Lock.unlock(); }
+
+private:
+    LockType m_Lock;
+};
+
+//-----------------------------------------------------------------------------
+//      読み取り/書き込み比率を変えてベンチマークを実行します.
+//-----------------------------------------------------------------------------
+template<typename LockType>
+void RunRWLock(bench::Context& context, const char* lockName)
+{
+    const std::string prefix = std::string("RWLock.") + lockName;
+    const auto opsPerThread = context.GetConfig().Quick ? 2000u : 20000u;
+
+    // 読み取り割合 (千分率).
+    const uint32_t readPermilles[] = { 500, 900, 990, 999, 1000 };
+
+    for(auto permille : readPermilles)
+    {
+        for(auto threadCount : context.GetThreadCounts())
+        {
+            LockType lock;
+            uint64_t table[TABLE_SIZE] = {};
+
+            // スレッド間で乱数状態のキャッシュラインを共有しないよう間隔を空ける.
+            std::vector<bench::Random> randoms;
+            for(auto i=0u; i<threadCount * 8; ++i)
+            { randoms.emplace_back(i + 1); }
+
+            auto ratio = std::to_string(permille / 10);
+            if (permille % 10)
+            { ratio += "." + std::to_string(permille % 10); }
+
+            auto name = prefix + "/read:" + ratio + "%/threads:" + std::to_string(threadCount);
+
+            bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t threadIndex)
+            {
+                auto& random = randoms[threadIndex * 8];
+                auto  value  = random.Next();
+                auto  index  = uint32_t(value >> 32) & (TABLE_SIZE - 1);
+
+                if ((value % 1000) < permille)
+                {
+                    asf::SharedLockGuard<LockType> locker(lock);
+                    uint64_t sum = 0;
+                    for(auto i=0u; i<READ_COUNT; ++i)
+                    { sum += table[(index + i) & (TABLE_SIZE - 1)]; }
+                    bench::DoNotOptimize(sum);
+                }
+                else
+                {
+                    asf::LockGuard<LockType> locker(lock);
+                    table[index]++;
+                }
+            });
+        }
+    }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      読み取り主体のテーブル参照を想定したロックのベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(RWLock)
+{
+    RunRWLock<ExclusiveLock<asf::SpinLock>>(context, "SpinLock");
+    RunRWLock<asf::RWSpinLock>             (context, "RWSpinLock");
+    RunRWLock<asf::DistributedRWLock>      (context, "DistributedRWLock");
+}
@@ -0,0 +1,309 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchResourceStateTracker.cpp
+// Desc : Benchmark for Resource State Tracking and Barrier Batching.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <asfResourceStateTracker.h>
+#include <asfCommandStream.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+enum RESOURCE_ID
+{
+    RESOURCE_SHADOW = 1,
+    RESOURCE_GBUFFER0,
+    RESOURCE_GBUFFER1,
+    RESOURCE_GBUFFER2,
+    RESOURCE_DEPTH,
+    RESOURCE_AO,
+    RESOURCE_HDR,
+    RESOURCE_BLOOM0,
+    RESOURCE_BLOOM1,
+    RESOURCE_BLOOM2,
+    RESOURCE_BLOOM3,
+    RESOURCE_BACKBUFFER,
+    RESOURCE_COUNT,
+};
+
+static constexpr D3D12_RESOURCE_STATES STATE_SRV = D3D12_RESOURCE_STATES(
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+//-----------------------------------------------------------------------------
+//      リソースを取得します.
+//-----------------------------------------------------------------------------
+inline ID3D12Resource* GetResource(RESOURCE_ID id)
+{ return reinterpret_cast<ID3D12Resource*>(uintptr_t(id) * 0x100); }
+
+//-----------------------------------------------------------------------------
+//      各リソースの既定の状態を取得します.
+//-----------------------------------------------------------------------------
+D3D12_RESOURCE_STATES GetHomeState(uint32_t id)
+{
+    switch(id)
+    {
+    case RESOURCE_DEPTH:        return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+    case RESOURCE_BACKBUFFER:   return D3D12_RESOURCE_STATE_PRESENT;
+    default:                    return STATE_SRV;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ManualBarriers class
+// 既定の状態を前提に, 使用前後の遷移を1つずつ発行する手書きのバリアです.
+///////////////////////////////////////////////////////////////////////////////
+class ManualBarriers
+{
+public:
+    explicit ManualBarriers(asf::HeadlessCommandList* pList)
+    : m_pList(pList)
+    {
+        for(auto i=0u; i<RESOURCE_COUNT; ++i)
+        { m_States[i] = GetHomeState(i); }
+    }
+
+    void Transition(RESOURCE_ID id, D3D12_RESOURCE_STATES state)
+    {
+        if (m_States[id] == state)
+        { return; }
+
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type                    = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Transition.pResource    = GetResource(id);
+        barrier.Transition.Subresource  = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        barrier.Transition.StateBefore  = m_States[id];
+        barrier.Transition.StateAfter   = state;
+        m_pList->ResourceBarrier(1, &barrier);
+
+        m_States[id] = state;
+        m_BarrierCount++;
+    }
+
+    void BeginTransition(RESOURCE_ID id, D3D12_RESOURCE_STATES state)
+    { Transition(id, state); }
+
+    void UAVBarrier(RESOURCE_ID id)
+    {
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type          = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        barrier.UAV.pResource = GetResource(id);
+        m_pList->ResourceBarrier(1, &barrier);
+        m_BarrierCount++;
+    }
+
+    void Draw()
+    { m_pList->DrawInstanced(3, 1, 0, 0); }
+
+    void Dispatch()
+    { m_pList->Dispatch(8, 8, 1); }
+
+    uint64_t GetBarrierCount() const
+    { return m_BarrierCount; }
+
+private:
+    asf::HeadlessCommandList*   m_pList;
+    D3D12_RESOURCE_STATES       m_States[RESOURCE_COUNT];
+    uint64_t                    m_BarrierCount = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TrackedBarriers class
+// ResourceStateTracker に要求し, 描画の直前にまとめて発行します.
+///////////////////////////////////////////////////////////////////////////////
+class TrackedBarriers
+{
+public:
+    TrackedBarriers(asf::ResourceStateTracker* pTracker, asf::HeadlessCommandList* pList)
+    : m_pTracker(pTracker)
+    , m_pList(pList)
+    { /* DO_NOTHING */ }
+
+    void Transition(RESOURCE_ID id, D3D12_RESOURCE_STATES state)
+    { m_pTracker->Transition(GetResource(id), state); }
+
+    void BeginTransition(RESOURCE_ID id, D3D12_RESOURCE_STATES state)
+    { m_pTracker->BeginTransition(GetResource(id), state); }
+
+    void UAVBarrier(RESOURCE_ID id)
+    { m_pTracker->UAVBarrier(GetResource(id)); }
+
+    void Draw()
+    {
+        m_pTracker->Flush(m_pList);
+        m_pList->DrawInstanced(3, 1, 0, 0);
+    }
+
+    void Dispatch()
+    {
+        m_pTracker->Flush(m_pList);
+        m_pList->Dispatch(8, 8, 1);
+    }
+
+private:
+    asf::ResourceStateTracker*  m_pTracker;
+    asf::HeadlessCommandList*   m_pList;
+};
+
+//-----------------------------------------------------------------------------
+//      遅延シェーディングの1フレームを記録します.
+//      各パスは使用するリソースを必要な状態に遷移させ, 使用後に既定の状態へ戻します.
+//      手書きのバリアは分割できないため, BeginTransition() は通常の遷移として発行します.
+//-----------------------------------------------------------------------------
+template<typename T>
+void RecordFrame(T& barriers)
+{
+    // バックバッファは最後のパスまで使用しないため, 先に遷移を開始しておく.
+    barriers.BeginTransition(RESOURCE_BACKBUFFER, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+    // シャドウ.
+    barriers.Transition(RESOURCE_SHADOW, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    barriers.Draw();
+    barriers.BeginTransition(RESOURCE_SHADOW, STATE_SRV);
+
+    // Gバッファ.
+    barriers.Transition(RESOURCE_GBUFFER0, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    barriers.Transition(RESOURCE_GBUFFER1, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    barriers.Transition(RESOURCE_GBUFFER2, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    barriers.Transition(RESOURCE_DEPTH,    D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    barriers.Draw();
+    barriers.Transition(RESOURCE_GBUFFER0, STATE_SRV);
+    barriers.Transition(RESOURCE_GBUFFER1, STATE_SRV);
+    barriers.Transition(RESOURCE_GBUFFER2, STATE_SRV);
+
+    // アンビエントオクルージョン.
+    barriers.Transition(RESOURCE_DEPTH,  D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    barriers.Transition(RESOURCE_AO,     D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    barriers.Dispatch();
+    barriers.UAVBarrier(RESOURCE_AO);
+    barriers.Dispatch();
+    barriers.Transition(RESOURCE_AO,     STATE_SRV);
+    barriers.Transition(RESOURCE_DEPTH,  D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+    // ライティング.
+    barriers.Transition(RESOURCE_SHADOW,   D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    barriers.Transition(RESOURCE_GBUFFER0, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    barriers.Transition(RESOURCE_GBUFFER1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    barriers.Transition(RESOURCE_GBUFFER2, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    barriers.Transition(RESOURCE_AO,       D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    barriers.Transition(RESOURCE_DEPTH,    D3D12_RESOURCE_STATE_DEPTH_READ);
+    barriers.Transition(RESOURCE_HDR,      D3D12_RESOURCE_STATE_RENDER_TARGET);
+    barriers.Draw();
+    barriers.Transition(RESOURCE_HDR,      STATE_SRV);
+    barriers.Transition(RESOURCE_DEPTH,    D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+    // ブルーム.
+    const RESOURCE_ID bloom[] = { RESOURCE_BLOOM0, RESOURCE_BLOOM1, RESOURCE_BLOOM2, RESOURCE_BLOOM3 };
+    auto src = RESOURCE_HDR;
+    for(auto dst : bloom)
+    {
+        barriers.Transition(src, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        barriers.Transition(dst, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        barriers.Draw();
+        barriers.Transition(dst, STATE_SRV);
+        src = dst;
+    }
+
+    // トーンマップ.
+    barriers.Transition(RESOURCE_HDR,        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    barriers.Transition(RESOURCE_BLOOM3,     D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    barriers.Transition(RESOURCE_BACKBUFFER, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    barriers.Draw();
+    barriers.Transition(RESOURCE_BACKBUFFER, D3D12_RESOURCE_STATE_PRESENT);
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      ResourceStateTracker のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(ResourceStateTracker)
+{
+    // 手書きのバリアと比較した1フレームのバリア数と ResourceBarrier() の呼び出し回数.
+    if (context.IsEnabled("ResourceStateTracker.Frame"))
+    {
+        asf::HeadlessCommandList manualList;
+        ManualBarriers manual(&manualList);
+        RecordFrame(manual);
+
+        asf::ResourceStateRegistry registry;
+        for(auto i=1u; i<RESOURCE_COUNT; ++i)
+        { registry.Register(GetResource(RESOURCE_ID(i)), GetHomeState(i)); }
+
+        // 2フレーム目以降はレジストリに前フレーム終了時の状態が残っている.
+        asf::ResourceStateTracker tracker;
+        asf::HeadlessCommandList  trackedList;
+        asf::HeadlessCommandList  fixupList;
+        asf::ResourceStateTrackerStats before;
+        uint32_t fixupCount = 0;
+        for(auto frame=0; frame<2; ++frame)
+        {
+            before = tracker.GetStats();
+            tracker.Reset();
+            trackedList.Reset();
+            fixupList.Reset();
+
+            TrackedBarriers tracked(&tracker, &trackedList);
+            RecordFrame(tracked);
+            tracker.Close(&trackedList);
+            fixupCount = registry.Resolve(tracker, &fixupList);
+        }
+
+        const auto& stats = tracker.GetStats();
+        const auto manualBarriers  = double(manual.GetBarrierCount());
+        const auto manualCalls     = double(manualList.GetCount(asf::COMMAND_TYPE_RESOURCE_BARRIER));
+        const auto trackedBarriers = double(stats.BarrierCount - before.BarrierCount) + double(fixupCount);
+        const auto trackedCalls    = double(trackedList.GetCount(asf::COMMAND_TYPE_RESOURCE_BARRIER) + fixupList.GetCount(asf::COMMAND_TYPE_RESOURCE_BARRIER));
+
+        std::vector<double> samples = { trackedBarriers };
+        context.Report("ResourceStateTracker.Frame", "barriers/frame", samples, {
+            { "manual_barriers", manualBarriers },
+            { "manual_calls",    manualCalls },
+            { "calls",           trackedCalls },
+            { "fixups",          double(fixupCount) },
+            { "merged",          double(stats.MergeCount - before.MergeCount) },
+            { "skipped",         double(stats.SkipCount - before.SkipCount) },
+            { "split",           double(stats.SplitCount - before.SplitCount) },
+            { "saved",           manualBarriers - trackedBarriers },
+        });
+    }
+
+    // 記録にかかるCPU時間.
+    context.Run("ResourceStateTracker.Record/manual", [&](uint64_t iterations)
+    {
+        asf::HeadlessCommandList list;
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            ManualBarriers manual(&list);
+            RecordFrame(manual);
+        }
+        bench::DoNotOptimize(list.GetChecksum());
+    });
+
+    {
+        asf::ResourceStateRegistry registry;
+        asf::ResourceStateTracker  tracker;
+        asf::HeadlessCommandList   list;
+        context.Run("ResourceStateTracker.Record/tracked", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                tracker.Reset();
+                TrackedBarriers tracked(&tracker, &list);
+                RecordFrame(tracked);
+                tracker.Close(&list);
+                registry.Resolve(tracker, &list);
+            }
+            bench::DoNotOptimize(list.GetChecksum());
+        });
+    }
+}
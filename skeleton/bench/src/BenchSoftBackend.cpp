@@ -0,0 +1,248 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchSoftBackend.cpp
+// Desc : Benchmark for CPU-emulated Command Queue.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <asfSoftBackend.h>
+#include <asfFenceWait.h>
+#include <Bench.h>
+
+
+//-----------------------------------------------------------------------------
+//      SoftCommandQueue のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(SoftCommandQueue)
+{
+    bench::SoftQueue queue;
+    if (!queue.Init(0))
+    { return; }
+
+    auto pQueue   = queue.GetQueue();
+    auto pCmdList = queue.GetCommandList();
+
+    ID3D12CommandList* pLists[] = { pCmdList->Reset() };
+    if (pLists[0] == nullptr)
+    { return; }
+
+    // 投入側のCPUコスト. 完了はサンプルの最後にまとめて待つ.
+    context.Run("SoftCommandQueue.Submit", [&](uint64_t iterations)
+    {
+        asf::WaitPoint waitPoint = {};
+        for(uint64_t i=0; i<iterations; ++i)
+        {
+            pQueue->Execute(1, pLists);
+            waitPoint = pQueue->Signal();
+        }
+        pQueue->Sync(waitPoint, asf::WAIT_INFINITE);
+    });
+
+    // 投入から完了通知を受け取るまでの往復時間. 実行時間を除いたものがエミュレーションの誤差になります.
+    const uint32_t latencies[] = { 0, 50, 500 };
+    for(auto latency : latencies)
+    {
+        asf::SetSoftCommandListLatency(pCmdList, latency);
+
+        context.Run("SoftCommandQueue.RoundTrip/latency_us:" + std::to_string(latency), [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                pQueue->Execute(1, pLists);
+                pQueue->Sync(pQueue->Signal(), asf::WAIT_INFINITE);
+            }
+        });
+    }
+
+    // キュー間の依存関係. CPUで完了を待ってから次のキューに投入する場合との比較です.
+    // 1フレーム前の完了のみを待機し, フレーム間でキューの実行を重ねます.
+    bench::SoftQueue computeQueue;
+    if (computeQueue.Init(0, 0, D3D12_COMMAND_LIST_TYPE_COMPUTE))
+    {
+        auto pComputeQueue = computeQueue.GetQueue();
+        asf::SetSoftCommandListLatency(pCmdList, 50);
+
+        auto runFrames = [&](const std::string& name, bool gpuWait)
+        {
+            if (!context.IsEnabled(name))
+            { return; }
+
+            const uint32_t frameCount = 32;
+
+            std::vector<double> samples;
+            samples.reserve(context.GetConfig().Samples);
+            for(auto i=0u; i<context.GetConfig().Samples; ++i)
+            {
+                asf::WaitPoint prev = {};
+                auto begin = bench::Now();
+                for(auto frame=0u; frame<frameCount; ++frame)
+                {
+                    pQueue->Execute(1, pLists);
+                    if (gpuWait)
+                    { pComputeQueue->Wait(pQueue->Signal()); }
+                    else
+                    { pQueue->Sync(pQueue->Signal(), asf::WAIT_INFINITE); }
+
+                    pComputeQueue->Execute(1, pLists);
+                    auto waitPoint = pComputeQueue->Signal();
+                    pComputeQueue->Sync(prev, asf::WAIT_INFINITE);
+                    prev = waitPoint;
+                }
+                pComputeQueue->Sync(prev, asf::WAIT_INFINITE);
+                samples.push_back(double(bench::Now() - begin) / double(frameCount));
+            }
+
+            context.Report(name, "ns/frame", samples);
+        };
+
+        runFrames("SoftCommandQueue.Dependency/gpu_wait", true);
+        runFrames("SoftCommandQueue.Dependency/cpu_sync", false);
+    }
+
+    // フレーム終端での複数キューの同期. 完了が早い順にキューを並べ, 逐次待機では毎回起床が発生するようにしています.
+    {
+        const uint32_t frameLatencies[] = { 30, 60, 100 };
+
+        bench::SoftQueue queues[3];
+        auto ready = true;
+        for(auto i=0; i<3; ++i)
+        { ready &= queues[i].Init(frameLatencies[i], 0, D3D12_COMMAND_LIST_TYPE_COMPUTE); }
+
+        auto submit = [&](asf::WaitPoint (&points)[3])
+        {
+            for(auto i=0; i<3; ++i)
+            {
+                ID3D12CommandList* pList = queues[i].GetCommandList()->Reset();
+                if (pList != nullptr)
+                { queues[i].GetQueue()->Execute(1, &pList); }
+                points[i] = queues[i].GetQueue()->Signal();
+            }
+        };
+
+        if (ready)
+        {
+            context.Run("SoftCommandQueue.FrameEnd/sequential_sync", [&](uint64_t iterations)
+            {
+                for(uint64_t i=0; i<iterations; ++i)
+                {
+                    asf::WaitPoint points[3];
+                    submit(points);
+                    for(auto j=0; j<3; ++j)
+                    { queues[j].GetQueue()->Sync(points[j], asf::WAIT_INFINITE); }
+                }
+            });
+
+            context.Run("SoftCommandQueue.FrameEnd/wait_for_fences", [&](uint64_t iterations)
+            {
+                for(uint64_t i=0; i<iterations; ++i)
+                {
+                    asf::WaitPoint points[3];
+                    submit(points);
+                    asf::WaitForFences(3, points, true, asf::WAIT_INFINITE);
+                }
+            });
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      フェンス待機方法ごとの起床遅延のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(FenceWait)
+{
+    asf::IFence* pFence = nullptr;
+    if (!asf::CreateSoftFence(&pFence))
+    { return; }
+
+    // 待機開始から delayUsec 後にフェンスを更新するスレッド.
+    std::mutex              mutex;
+    std::condition_variable cond;
+    uint64_t                request    = 0;
+    uint32_t                delayUsec  = 0;
+    bool                    quit       = false;
+    std::atomic<uint64_t>   signalTime = { 0 };
+
+    std::thread signaler([&]()
+    {
+        uint64_t value = 0;
+        for(;;)
+        {
+            uint32_t delay = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [&]() { return request != value || quit; });
+                if (quit)
+                { break; }
+                value = request;
+                delay = delayUsec;
+            }
+
+            std::this_thread::sleep_for(std::chrono::microseconds(delay));
+            signalTime.store(bench::Now(), std::memory_order_relaxed);
+            asf::SignalSoftFence(pFence, value);
+        }
+    });
+
+    struct Policy
+    {
+        const char*             Name;
+        asf::FENCE_WAIT_POLICY  Value;
+    };
+    const Policy policies[] = {
+        { "block",           asf::FENCE_WAIT_POLICY_BLOCK },
+        { "spin_then_block", asf::FENCE_WAIT_POLICY_SPIN_THEN_BLOCK },
+        { "poll",            asf::FENCE_WAIT_POLICY_POLL },
+    };
+    const uint32_t delays[] = { 20, 1000 };
+
+    uint64_t value = 0;
+    for(auto delay : delays)
+    {
+        for(auto& policy : policies)
+        {
+            auto name = std::string("FenceWait.WakeLatency/") + policy.Name + "/delay_us:" + std::to_string(delay);
+            if (!context.IsEnabled(name))
+            { continue; }
+
+            pFence->SetWaitPolicy(policy.Value, 200);
+
+            std::vector<double> samples;
+            samples.reserve(context.GetConfig().Samples);
+
+            auto cpuBegin = bench::ProcessCpuTime();
+            for(auto i=0u; i<context.GetConfig().Samples; ++i)
+            {
+                {
+                    std::lock_guard<std::mutex> locker(mutex);
+                    request   = ++value;
+                    delayUsec = delay;
+                }
+                cond.notify_one();
+
+                pFence->Wait(value, asf::WAIT_INFINITE);
+                auto now = bench::Now();
+                samples.push_back(double(now - signalTime.load(std::memory_order_relaxed)));
+            }
+            auto cpuTime = bench::ProcessCpuTime() - cpuBegin;
+
+            context.Report(name, "ns", samples, {
+                { "cpu_us_per_wait", double(cpuTime) / 1000.0 / double(context.GetConfig().Samples) },
+            });
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> locker(mutex);
+        quit = true;
+    }
+    cond.notify_one();
+    signaler.join();
+
+    pFence->Release();
+}
@@ -0,0 +1,121 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchSpinLock.cpp
+// Desc : Benchmark for Locks.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asfSpinLock.h>
+#include <asfAdaptiveLock.h>
+#include <asfQueueLock.h>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      クリティカルセクション内の処理を模擬します.
+//-----------------------------------------------------------------------------
+inline void Work(uint64_t& counter, uint32_t amount)
+{
+    for(auto i=0u; i<amount; ++i)
+    {
+        counter = counter * 6364136223846793005ull + 1442695040888963407ull;
+        bench::DoNotOptimize(counter);
+    }
+    counter++;
+}
+
+//-----------------------------------------------------------------------------
+//      ロックのベンチマークを実行します.
+//-----------------------------------------------------------------------------
+template<typename LockType>
+void RunLock(bench::Context& context, const char* lockName)
+{
+    const std::string prefix = lockName;
+
+    // 競合なし.
+    {
+        LockType lock;
+        uint64_t counter = 0;
+
+        context.Run(prefix + ".LockUnlock/uncontended", [&](uint64_t iterations)
+        {
+            for(uint64_t i=0; i<iterations; ++i)
+            {
+                asf::LockGuard<LockType> locker(lock);
+                counter++;
+            }
+        });
+        bench::DoNotOptimize(counter);
+    }
+
+    // 競合あり. クリティカルセクション内の処理量とスレッド数を変えて計測する.
+    // ハードウェアスレッド数を超えるスレッド数では, 保持スレッドのプリエンプションが発生する.
+    const auto opsPerThread  = context.GetConfig().Quick ? 2000u : 20000u;
+    const uint32_t holdWorks[] = { 0, 50, 500 };
+
+    auto threadCounts = context.GetThreadCounts();
+    threadCounts.push_back(context.GetConfig().MaxThreads * 2);
+
+    for(auto hold : holdWorks)
+    {
+        for(auto threadCount : threadCounts)
+        {
+            LockType lock;
+            uint64_t counter = 0;
+
+            auto name = prefix + ".Contended/hold:" + std::to_string(hold)
+                      + "/threads:" + std::to_string(threadCount);
+
+            bench::RunContended(context, name, threadCount, opsPerThread, [&](uint32_t)
+            {
+                asf::LockGuard<LockType> locker(lock);
+                Work(counter, hold);
+            });
+
+            // ロック取得までの待ち時間のみを計測する. 公平性の差は p99/p999 に現れる.
+            auto acquireName = prefix + ".Acquire/hold:" + std::to_string(hold)
+                             + "/threads:" + std::to_string(threadCount);
+
+            bench::RunContendedTimed(context, acquireName, threadCount, opsPerThread, [&](uint32_t)
+            {
+                auto begin = bench::Now();
+                lock.lock();
+                auto wait = bench::Now() - begin;
+                Work(counter, hold);
+                lock.unlock();
+                return wait;
+            });
+        }
+    }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      SpinLock のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(SpinLock)
+{ RunLock<asf::SpinLock>(context, "SpinLock"); }
+
+//-----------------------------------------------------------------------------
+//      AdaptiveLock のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(AdaptiveLock)
+{ RunLock<asf::AdaptiveLock>(context, "AdaptiveLock"); }
+
+//-----------------------------------------------------------------------------
+//      TicketLock のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(TicketLock)
+{ RunLock<asf::TicketLock>(context, "TicketLock"); }
+
+//-----------------------------------------------------------------------------
+//      McsLock のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(McsLock)
+{ RunLock<asf::McsLock>(context, "McsLock"); }
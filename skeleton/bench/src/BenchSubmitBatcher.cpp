@@ -0,0 +1,91 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchSubmitBatcher.cpp
+// Desc : Benchmark for Command List Submission Batcher.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <asfSubmitBatcher.h>
+#include <asfSoftBackend.h>
+#include <Bench.h>
+
+
+//-----------------------------------------------------------------------------
+//      SubmitBatcher のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(SubmitBatcher)
+{
+    // バッチ化で削減される Execute() の固定費として, 投入1回当たり 20us のドライバコストを模擬する.
+    bench::SoftQueue queue;
+    if (!queue.Init(0, 20))
+    { return; }
+
+    auto pQueue = queue.GetQueue();
+    ID3D12CommandList* pList = queue.GetCommandList()->Reset();
+    if (pList == nullptr)
+    { return; }
+
+    // 1フレームで16パスがそれぞれ1リストを投入し, フレーム終端でシグナルする.
+    // サンプルは投入側のCPU時間で, 完了待ちは含まない.
+    const uint32_t passCount = 16;
+
+    struct Config
+    {
+        const char* Name;
+        uint32_t    MaxLists;   // 0 の場合はバッチ化しない.
+    };
+    const Config configs[] = {
+        { "direct",        0 },
+        { "max_lists:4",   4 },
+        { "max_lists:32", 32 },
+    };
+
+    for(auto& config : configs)
+    {
+        const auto name = std::string("SubmitBatcher.Frame/") + config.Name;
+        if (!context.IsEnabled(name))
+        { continue; }
+
+        asf::SubmitBatcher batcher;
+        if (config.MaxLists > 0)
+        {
+            asf::SubmitBatcherDesc desc;
+            desc.pQueue   = pQueue;
+            desc.MaxLists = config.MaxLists;
+            if (!batcher.Init(desc))
+            { continue; }
+        }
+
+        std::vector<double> samples;
+        samples.reserve(context.GetConfig().Samples);
+        for(auto i=0u; i<context.GetConfig().Samples; ++i)
+        {
+            asf::WaitPoint point = {};
+
+            auto begin = bench::Now();
+            for(auto j=0u; j<passCount; ++j)
+            {
+                if (config.MaxLists > 0)
+                { batcher.Execute(1, &pList); }
+                else
+                { pQueue->Execute(1, &pList); }
+            }
+            point = (config.MaxLists > 0) ? batcher.Signal() : pQueue->Signal();
+            samples.push_back(double(bench::Now() - begin));
+
+            pQueue->Sync(point, asf::WAIT_INFINITE);
+        }
+
+        const auto frames  = double(context.GetConfig().Samples);
+        const auto submits = (config.MaxLists > 0) ? double(batcher.GetStats().SubmitCount) : frames * passCount;
+        batcher.Term();
+
+        context.Report(name, "ns/frame", samples, {
+            { "submits_per_frame", submits / frames },
+        });
+    }
+}
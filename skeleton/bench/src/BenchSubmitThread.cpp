@@ -0,0 +1,68 @@
+﻿//-----------------------------------------------------------------------------
+// File : BenchSubmitThread.cpp
+// Desc : Benchmark for Dedicated Command List Submission Thread.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <string>
+#include <thread>
+#include <asfSubmitThread.h>
+#include <asfSoftBackend.h>
+#include <Bench.h>
+
+
+//-----------------------------------------------------------------------------
+//      SubmitThread のベンチマークです.
+//-----------------------------------------------------------------------------
+BENCH_SUITE(SubmitThread)
+{
+    // 記録スレッド側のレイテンシを見るため, 投入1回当たり 20us のドライバコストを模擬し, GPU時間は 0 とする.
+    bench::SoftQueue queue;
+    if (!queue.Init(0, 20))
+    { return; }
+
+    auto pQueue = queue.GetQueue();
+    ID3D12CommandList* pList = queue.GetCommandList()->Reset();
+    if (pList == nullptr)
+    { return; }
+
+    // 記録スレッドから見た投入1回当たりのレイテンシ.
+    // direct は各スレッドがキューの Execute() を直接呼び出し, ドライバコストを記録スレッドで負担する.
+    const uint32_t opsPerThread = 64;
+    for(auto threadCount : context.GetThreadCounts())
+    {
+        const auto suffix = "/threads:" + std::to_string(threadCount);
+
+        bench::RunContended(context, "SubmitThread.Submit/direct" + suffix, threadCount, opsPerThread, [&](uint32_t)
+        {
+            pQueue->Execute(1, &pList);
+        });
+        pQueue->Sync(pQueue->Signal(), asf::WAIT_INFINITE);
+
+        asf::SubmitThreadDesc desc;
+        desc.pQueue = pQueue;
+
+        asf::SubmitThread submitThread;
+        if (!submitThread.Init(desc))
+        { continue; }
+
+        // 順序キーは記録の完了順に採番する.
+        std::atomic<uint64_t> nextKey = { 0 };
+        bench::RunContended(context, "SubmitThread.Submit/submit_thread" + suffix, threadCount, opsPerThread, [&](uint32_t)
+        {
+            auto key = nextKey.fetch_add(1, std::memory_order_relaxed);
+            while(!submitThread.Submit(key, 1, &pList))
+            { std::this_thread::yield(); }
+        });
+
+        auto lastKey = nextKey.load();
+        if (lastKey > 0)
+        { pQueue->Sync(submitThread.WaitSubmitted(lastKey - 1), asf::WAIT_INFINITE); }
+
+        submitThread.Term();
+    }
+}
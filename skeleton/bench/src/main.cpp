@@ -0,0 +1,95 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Benchmark Main Entry Point.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <Bench.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      使用方法を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage(const char* program)
+{
+    printf("Usage : %s [options]\n", program);
+    printf("  --filter=<text>    名前に <text> を含むベンチマークのみ実行します.\n");
+    printf("  --json=<path>      計測結果をJSON形式で <path> に出力します.\n");
+    printf("  --samples=<count>  サンプル数を指定します (既定値 101).\n");
+    printf("  --threads=<count>  最大スレッド数を指定します (既定値 ハードウェアスレッド数).\n");
+    printf("  --quick            サンプル数を減らして短時間で実行します.\n");
+    printf("  --list             ベンチマークスイートの一覧を表示します.\n");
+}
+
+//-----------------------------------------------------------------------------
+//      オプション値を取得します.
+//-----------------------------------------------------------------------------
+const char* GetValue(const char* arg, const char* option)
+{
+    auto length = strlen(option);
+    if (strncmp(arg, option, length) == 0)
+    { return arg + length; }
+
+    return nullptr;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    bench::Config config;
+
+    for(auto i=1; i<argc; ++i)
+    {
+        const char* value = nullptr;
+
+        if ((value = GetValue(argv[i], "--filter=")) != nullptr)
+        { config.Filter = value; }
+        else if ((value = GetValue(argv[i], "--json=")) != nullptr)
+        { config.JsonPath = value; }
+        else if ((value = GetValue(argv[i], "--samples=")) != nullptr)
+        { config.Samples = uint32_t(std::max(1, atoi(value))); }
+        else if ((value = GetValue(argv[i], "--threads=")) != nullptr)
+        { config.MaxThreads = uint32_t(std::max(1, atoi(value))); }
+        else if (strcmp(argv[i], "--quick") == 0)
+        { config.Quick = true; }
+        else if (strcmp(argv[i], "--list") == 0)
+        {
+            for(auto& name : bench::GetSuiteNames())
+            { printf("%s\n", name.c_str()); }
+            return 0;
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return (strcmp(argv[i], "--help") == 0) ? 0 : -1;
+        }
+    }
+
+    bench::Context context(config);
+    bench::RunAll(context);
+
+    if (!config.JsonPath.empty())
+    {
+        if (!context.WriteJson(config.JsonPath.c_str()))
+        {
+            fprintf(stderr, "Error : Failed to write %s\n", config.JsonPath.c_str());
+            return -1;
+        }
+    }
+
+    return 0;
+}
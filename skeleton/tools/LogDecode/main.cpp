@@ -0,0 +1,183 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Binary Log Decoder.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <asfLogRecord.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t MAX_SITE_COUNT = 1u << 20;   // 受け付ける呼び出し元の最大数. 壊れた id で巨大な確保をしないための上限.
+
+///////////////////////////////////////////////////////////////////////////////
+// SiteInfo structure
+///////////////////////////////////////////////////////////////////////////////
+struct SiteInfo
+{
+    bool            Valid   = false;
+    uint32_t        Level   = 0;
+    uint32_t        Line    = 0;
+    uint32_t        Flags   = 0;
+    std::string     File;
+    std::string     Format;
+};
+
+//-----------------------------------------------------------------------------
+//      値を読み込みます.
+//-----------------------------------------------------------------------------
+template<typename T>
+bool Read(FILE* pFile, T& value)
+{ return fread(&value, sizeof(T), 1, pFile) == 1; }
+
+//-----------------------------------------------------------------------------
+//      文字列を読み込みます.
+//-----------------------------------------------------------------------------
+bool ReadString(FILE* pFile, uint16_t length, std::string& value)
+{
+    value.resize(length);
+    return (length == 0) || (fread(&value[0], 1, length, pFile) == length);
+}
+
+//-----------------------------------------------------------------------------
+//      ログレベルのタグを取得します.
+//-----------------------------------------------------------------------------
+const char* GetLevelTag(uint32_t level)
+{
+    switch(level)
+    {
+    case asf::LOG_VERBOSE:  return "VERBOSE";
+    case asf::LOG_INFO:     return "INFO";
+    case asf::LOG_DEBUG:    return "DEBUG";
+    case asf::LOG_WARNING:  return "WARNING";
+    case asf::LOG_ERROR:    return "ERROR";
+    }
+
+    return "UNKNOWN";
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("Usage : %s <binary log file>\n", argv[0]);
+        return 1;
+    }
+
+    auto pFile = fopen(argv[1], "rb");
+    if (pFile == nullptr)
+    {
+        fprintf(stderr, "Error : File Open Failed. path = %s\n", argv[1]);
+        return 1;
+    }
+
+    uint32_t header[2] = {};
+    if (!Read(pFile, header) || header[0] != asf::LOG_FILE_MAGIC || header[1] != asf::LOG_FILE_VERSION)
+    {
+        fprintf(stderr, "Error : Invalid File. path = %s\n", argv[1]);
+        fclose(pFile);
+        return 1;
+    }
+
+    std::vector<SiteInfo>   sites;
+    std::vector<uint8_t>    args(asf::LOG_RECORD_ARGS_SIZE);
+    std::vector<char>       msg (4096);
+    uint64_t                baseTime = 0;
+    bool                    first    = true;
+    auto                    result   = 0;
+
+    uint8_t chunk = 0;
+    while (Read(pFile, chunk))
+    {
+        uint32_t id = 0;
+        if (!Read(pFile, id))
+        { result = 1; break; }
+
+        if (chunk == asf::LOG_FILE_CHUNK_SITE)
+        {
+            SiteInfo info;
+            uint16_t fileLength   = 0;
+            uint16_t formatLength = 0;
+            if (!Read(pFile, info.Level)
+             || !Read(pFile, info.Line)
+             || !Read(pFile, info.Flags)
+             || !Read(pFile, fileLength)
+             || !Read(pFile, formatLength)
+             || !ReadString(pFile, fileLength, info.File)
+             || !ReadString(pFile, formatLength, info.Format))
+            { result = 1; break; }
+
+            if (id >= MAX_SITE_COUNT)
+            { result = 1; break; }
+
+            info.Valid = true;
+            if (id >= sites.size())
+            { sites.resize(id + 1); }
+            sites[id] = std::move(info);
+        }
+        else if (chunk == asf::LOG_FILE_CHUNK_RECORD)
+        {
+            uint64_t timestamp = 0;
+            uint16_t argSize   = 0;
+            if (!Read(pFile, timestamp)
+             || !Read(pFile, argSize)
+             || argSize > args.size()
+             || (argSize > 0 && fread(args.data(), 1, argSize, pFile) != argSize))
+            { result = 1; break; }
+
+            if (id >= sites.size() || !sites[id].Valid)
+            {
+                fprintf(stderr, "Error : Unknown Site. id = %u\n", id);
+                continue;
+            }
+
+            if (first)
+            {
+                baseTime = timestamp;
+                first    = false;
+            }
+
+            auto& site = sites[id];
+            asf::FormatLogRecord(
+                site.Format.c_str(),
+                site.File.c_str(),
+                int(site.Line),
+                site.Flags,
+                args.data(),
+                argSize,
+                msg.data(),
+                msg.size());
+
+            // 先頭レコードからの経過時間をマイクロ秒で表示.
+            printf("[%12.3f] [%-7s] %s",
+                double(timestamp - baseTime) / 1000.0,
+                GetLevelTag(site.Level),
+                msg.data());
+        }
+        else
+        { result = 1; break; }
+    }
+
+    if (result != 0)
+    { fprintf(stderr, "Error : Broken Chunk Detected. offset = %ld\n", ftell(pFile)); }
+
+    fclose(pFile);
+    return result;
+}
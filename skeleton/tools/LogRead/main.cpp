@@ -0,0 +1,128 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Memory-mapped Log File Reader.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdint>
+#include <ctime>
+#include <algorithm>
+#include <vector>
+#include <asfMappedFileLogger.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      ログレベルのタグを取得します.
+//-----------------------------------------------------------------------------
+const char* GetLevelTag(uint32_t level)
+{
+    switch(level)
+    {
+    case asf::LOG_VERBOSE:  return "VERBOSE";
+    case asf::LOG_INFO:     return "INFO";
+    case asf::LOG_DEBUG:    return "DEBUG";
+    case asf::LOG_WARNING:  return "WARNING";
+    case asf::LOG_ERROR:    return "ERROR";
+    }
+
+    return "UNKNOWN";
+}
+
+//-----------------------------------------------------------------------------
+//      タイムスタンプを文字列に変換します.
+//-----------------------------------------------------------------------------
+void FormatTime(uint64_t timestamp, char (&buffer)[64])
+{
+    auto seconds = time_t(timestamp / 1000000000);
+    auto micro   = unsigned(timestamp % 1000000000 / 1000);
+
+    tm local = {};
+#if defined(_WIN32)
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+
+    char date[32] = "\0";
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(buffer, sizeof(buffer), "%s.%06u", date, micro);
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("Usage : %s <mapped log file>\n", argv[0]);
+        return 1;
+    }
+
+    auto pFile = fopen(argv[1], "rb");
+    if (pFile == nullptr)
+    {
+        fprintf(stderr, "Error : File Open Failed. path = %s\n", argv[1]);
+        return 1;
+    }
+
+    asf::MappedLogHeader header = {};
+    if (fread(&header, sizeof(header), 1, pFile) != 1
+     || header.Magic      != asf::MAPPED_LOG_MAGIC
+     || header.Version    != asf::MAPPED_LOG_VERSION
+     || header.RecordSize != sizeof(asf::MappedLogRecord))
+    {
+        fprintf(stderr, "Error : Invalid File. path = %s\n", argv[1]);
+        fclose(pFile);
+        return 1;
+    }
+
+    // 未書き込みと書き込み途中のレコードは除外する.
+    std::vector<asf::MappedLogRecord> records;
+    records.reserve(header.RecordCount);
+
+    asf::MappedLogRecord record;
+    for(uint32_t i=0; i<header.RecordCount; ++i)
+    {
+        if (fread(&record, sizeof(record), 1, pFile) != 1)
+        { break; }
+
+        if (record.Sequence == 0 || (record.Sequence & asf::MAPPED_LOG_SEQUENCE_BUSY) != 0)
+        { continue; }
+
+        record.Message[asf::MAPPED_LOG_MESSAGE_SIZE - 1] = '\0';
+        records.push_back(record);
+    }
+    fclose(pFile);
+
+    std::sort(records.begin(), records.end(), [](const asf::MappedLogRecord& lhs, const asf::MappedLogRecord& rhs)
+    { return lhs.Sequence < rhs.Sequence; });
+
+    uint64_t expected = records.empty() ? 0 : records.front().Sequence;
+    for(auto& item : records)
+    {
+        if (item.Sequence != expected)
+        { printf("--- %llu records missing ---\n", static_cast<unsigned long long>(item.Sequence - expected)); }
+        expected = item.Sequence + 1;
+
+        char time[64] = "\0";
+        FormatTime(item.Timestamp, time);
+
+        auto length = std::min<size_t>(item.Length, asf::MAPPED_LOG_MESSAGE_SIZE - 1);
+        while (length > 0 && item.Message[length - 1] == '\n')
+        { length--; }
+
+        printf("%s [%6u] [%-7s] %.*s\n", time, item.ThreadId, GetLevelTag(item.Level), int(length), item.Message);
+    }
+
+    return 0;
+}